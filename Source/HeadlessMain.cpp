@@ -0,0 +1,958 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+// Capture engine without GUI, used on display-less nodes and as throughput benchmark.
+// All results are printed as one JSON object on stdout.
+
+#include "Camera.h"
+#include "FrameObserver.h"
+#include "FrameObserverMMAP.h"
+#include "FrameObserverSynthetic.h"
+#include "ImageTransform.h"
+#include "LatencyStatistics.h"
+#include "Logger.h"
+#include "PixelKernels.h"
+#include "PlaneLayout.h"
+#include "StripePool.h"
+#include "ThreadConfig.h"
+#include "q_v4l2_ext_ctrl.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QImage>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct HeadlessOptions
+{
+    std::string device = "/dev/video0";
+    uint32_t pixelFormat = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t fps = 0;
+    double durationSeconds = 10.0;
+    uint64_t frameLimit = 0;
+    uint32_t bufferCount = 5;
+    // the pool starts with bufferCount buffers and grows up to this count, 0 keeps it fixed
+    uint32_t maxBufferCount = 0;
+    uint64_t bufferBudget = 0;
+    IO_METHOD_TYPE ioMethod = IO_METHOD_USERPTR;
+    // memory of the userptr buffers
+    bool hugePages = false;
+    bool lockBuffers = false;
+    // cache behaviour of MMAP buffers
+    MMAP_CACHE_MODE mmapCacheMode = MMAP_CACHE_COHERENT;
+    // sample how fast the CPU reads the captured frames
+    bool measureRead = false;
+    bool blockingMode = true;
+    bool convert = false;
+    std::string recordFile;
+    bool enableLogging = false;
+    // frames come from FrameObserverSynthetic instead of the device
+    bool synthetic = false;
+    SYNTHETIC_PATTERN_TYPE pattern = SYNTHETIC_PATTERN_BARS;
+    std::string replayFile;
+    // thread roles in the V4L2VIEWER_THREADS syntax, applied on top of the environment
+    std::string threads;
+    // restart the stream after stalls and error storms
+    bool watchdog = true;
+    // stall timeout while the frame interval is unknown, 0 detects no stalls then
+    uint32_t stallTimeoutMs = 0;
+    // released buffers are requeued in batches of this size, 0 or 1 requeues each one at once
+    uint32_t requeueBatch = 0;
+    uint32_t requeueDelayUs = 2000;
+    // instruction set of the conversion kernels, empty for the detected one
+    std::string kernels;
+    // time the conversion kernels instead of streaming
+    bool benchmarkKernels = false;
+    // threads which convert one frame together, 0 for StripePool::DefaultThreadCount()
+    uint32_t conversionThreads = 0;
+};
+
+uint32_t ParseFourcc(const QString &text)
+{
+    std::string const fourcc = text.toStdString();
+    if (fourcc.size() != 4)
+    {
+        return 0;
+    }
+
+    return v4l2_fourcc(fourcc[0], fourcc[1], fourcc[2], fourcc[3]);
+}
+
+std::string FourccToString(uint32_t pixelFormat)
+{
+    std::string text(4, ' ');
+    for (int i = 0; i < 4; ++i)
+    {
+        text[i] = static_cast<char>((pixelFormat >> (8 * i)) & 0xff);
+    }
+    return text;
+}
+
+// This function escapes a string for a JSON string literal, e.g. a device
+// path or a fourcc may contain quotes, backslashes or control characters
+std::string EscapeJson(const std::string &text)
+{
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char const character : text)
+    {
+        switch (character)
+        {
+            case '"':  escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\b': escaped += "\\b"; break;
+            case '\f': escaped += "\\f"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(character) < 0x20)
+                {
+                    char code[8];
+                    snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned char>(character));
+                    escaped += code;
+                }
+                else
+                {
+                    escaped += character;
+                }
+                break;
+        }
+    }
+    return escaped;
+}
+
+int ParseOptions(QCoreApplication &app, HeadlessOptions &options)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless V4L2 capture and benchmark");
+    parser.addHelpOption();
+
+    QCommandLineOption deviceOption("device", "Video device to open.", "path", "/dev/video0");
+    QCommandLineOption formatOption("format", "Pixel format as fourcc, e.g. YUYV or RG12.", "fourcc");
+    QCommandLineOption widthOption("width", "Frame width.", "pixels");
+    QCommandLineOption heightOption("height", "Frame height.", "pixels");
+    QCommandLineOption fpsOption("fps", "Frame rate.", "fps");
+    QCommandLineOption durationOption("duration", "Stream duration (default 10).", "seconds", "10");
+    QCommandLineOption framesOption("frames", "Stop after this number of frames.", "count");
+    QCommandLineOption buffersOption("buffers", "Number of capture buffers (default 5).", "count", "5");
+    QCommandLineOption ioOption("io", "Buffer I/O: userptr, mmap, dmabuf or dmabuf-import.", "method", "userptr");
+    QCommandLineOption adaptiveBuffersOption("adaptive-buffers", "Grow the buffer pool up to this count while frames are dropped, "
+                                             "shrink it back to --buffers when quiet.", "count");
+    QCommandLineOption bufferBudgetOption("buffer-budget", "Memory limit of the adaptive buffer pool.", "MiB");
+    QCommandLineOption hugePagesOption("hugepages", "Back userptr buffers with huge pages.");
+    QCommandLineOption lockBuffersOption("lock-buffers", "Lock userptr buffers in memory.");
+    QCommandLineOption mmapCacheOption("mmap-cache", "Cache behaviour of mmap buffers: coherent, non-coherent or no-sync "
+                                       "(no cache maintenance, the CPU may read stale frames).", "mode", "coherent");
+    QCommandLineOption measureReadOption("measure-read", "Measure once a second how fast a frame is read from its buffer.");
+    QCommandLineOption nonBlockingOption("non-blocking", "Open the device in non-blocking mode.");
+    QCommandLineOption convertOption("convert", "Convert every frame like the software renderer does.");
+    QCommandLineOption recordOption("record", "Append the raw frames to this file.", "file");
+    QCommandLineOption logOption("log", "Write the V4L2Viewer log file.");
+    QCommandLineOption syntheticOption("synthetic", "Generate frames instead of opening a device: bars, gradient or noise.", "pattern");
+    QCommandLineOption replayOption("replay", "Generate frames by replaying a file of raw frames in the given format.", "file");
+    QCommandLineOption noWatchdogOption("no-watchdog", "Do not restart the stream after stalls or error storms.");
+    QCommandLineOption requeueBatchOption("requeue-batch", "Requeue released buffers in batches of this size.", "buffers");
+    QCommandLineOption requeueDelayOption("requeue-delay", "Longest time a released buffer waits for its batch.", "us", "2000");
+    QCommandLineOption stallTimeoutOption("stall-timeout", "Stall timeout if the frame rate of the device is unknown (default: no stall detection then).", "ms");
+    QCommandLineOption kernelsOption("kernels", "Instruction set of the conversion kernels: scalar, sse4.1, avx2 or neon.", "isa");
+    QCommandLineOption benchmarkKernelsOption("benchmark-kernels", "Time the conversion kernels of every instruction set on random frames, "
+                                              "check them against the scalar ones and exit. --width and --height select one resolution.");
+    QCommandLineOption conversionThreadsOption("conversion-threads", "Threads which convert one frame in stripes, 1 converts on one thread "
+                                               "(default: one less than the CPUs).", "threads");
+    QCommandLineOption threadsOption("threads", "Scheduling of the thread roles, e.g. \"capture=fifo:80:3:mlock;conversion=other:-5:1-2\".", "roles");
+
+    parser.addOptions({ deviceOption, formatOption, widthOption, heightOption, fpsOption, durationOption,
+                        framesOption, buffersOption, adaptiveBuffersOption, bufferBudgetOption, ioOption, hugePagesOption, lockBuffersOption, mmapCacheOption, measureReadOption, nonBlockingOption, convertOption, recordOption, logOption,
+                        syntheticOption, replayOption, noWatchdogOption, stallTimeoutOption, requeueBatchOption, requeueDelayOption, threadsOption,
+                        kernelsOption, benchmarkKernelsOption, conversionThreadsOption });
+    parser.process(app);
+
+    options.device = parser.value(deviceOption).toStdString();
+    if (parser.isSet(formatOption))
+    {
+        options.pixelFormat = ParseFourcc(parser.value(formatOption));
+        if (options.pixelFormat == 0)
+        {
+            fprintf(stderr, "Invalid pixel format '%s'\n", parser.value(formatOption).toStdString().c_str());
+            return -1;
+        }
+    }
+    options.width = parser.value(widthOption).toUInt();
+    options.height = parser.value(heightOption).toUInt();
+    options.fps = parser.value(fpsOption).toUInt();
+    options.durationSeconds = parser.value(durationOption).toDouble();
+    options.frameLimit = parser.value(framesOption).toULongLong();
+    options.bufferCount = parser.value(buffersOption).toUInt();
+    options.maxBufferCount = parser.value(adaptiveBuffersOption).toUInt();
+    options.bufferBudget = parser.value(bufferBudgetOption).toULongLong() * 1024 * 1024;
+    options.hugePages = parser.isSet(hugePagesOption);
+    options.lockBuffers = parser.isSet(lockBuffersOption);
+    options.measureRead = parser.isSet(measureReadOption);
+    if (FrameObserverMMAP::ParseCacheMode(parser.value(mmapCacheOption).toStdString(), options.mmapCacheMode) != 0)
+    {
+        fprintf(stderr, "Invalid mmap cache mode '%s'\n", parser.value(mmapCacheOption).toStdString().c_str());
+        return -1;
+    }
+    options.blockingMode = !parser.isSet(nonBlockingOption);
+    options.convert = parser.isSet(convertOption);
+    options.recordFile = parser.value(recordOption).toStdString();
+    options.enableLogging = parser.isSet(logOption);
+    options.threads = parser.value(threadsOption).toStdString();
+    options.watchdog = !parser.isSet(noWatchdogOption);
+    options.stallTimeoutMs = parser.value(stallTimeoutOption).toUInt();
+    options.requeueBatch = parser.value(requeueBatchOption).toUInt();
+    options.requeueDelayUs = parser.value(requeueDelayOption).toUInt();
+    options.kernels = parser.value(kernelsOption).toStdString();
+    options.benchmarkKernels = parser.isSet(benchmarkKernelsOption);
+    options.conversionThreads = parser.value(conversionThreadsOption).toUInt();
+
+    QString const ioMethod = parser.value(ioOption);
+    if (ioMethod == "userptr")
+    {
+        options.ioMethod = IO_METHOD_USERPTR;
+    }
+    else if (ioMethod == "mmap")
+    {
+        options.ioMethod = IO_METHOD_MMAP;
+    }
+    else if (ioMethod == "dmabuf")
+    {
+        options.ioMethod = IO_METHOD_DMABUF;
+    }
+    else if (ioMethod == "dmabuf-import")
+    {
+        options.ioMethod = IO_METHOD_DMABUF_IMPORT;
+    }
+    else
+    {
+        fprintf(stderr, "Invalid I/O method '%s'\n", ioMethod.toStdString().c_str());
+        return -1;
+    }
+
+    if (parser.isSet(syntheticOption))
+    {
+        QString const pattern = parser.value(syntheticOption);
+        options.synthetic = true;
+        if (pattern == "bars")
+        {
+            options.pattern = SYNTHETIC_PATTERN_BARS;
+        }
+        else if (pattern == "gradient")
+        {
+            options.pattern = SYNTHETIC_PATTERN_GRADIENT;
+        }
+        else if (pattern == "noise")
+        {
+            options.pattern = SYNTHETIC_PATTERN_NOISE;
+        }
+        else
+        {
+            fprintf(stderr, "Invalid pattern '%s'\n", pattern.toStdString().c_str());
+            return -1;
+        }
+    }
+    if (parser.isSet(replayOption))
+    {
+        options.synthetic = true;
+        options.replayFile = parser.value(replayOption).toStdString();
+    }
+
+    if (options.bufferCount == 0 || options.bufferCount > MAX_VIEWER_USER_BUFFER_COUNT)
+    {
+        fprintf(stderr, "Buffer count must be between 1 and %d\n", MAX_VIEWER_USER_BUFFER_COUNT);
+        return -1;
+    }
+    if (options.maxBufferCount != 0 && (options.maxBufferCount < options.bufferCount || options.maxBufferCount > MAX_VIEWER_USER_BUFFER_COUNT))
+    {
+        fprintf(stderr, "Adaptive buffer count must be between %u and %d\n", options.bufferCount, MAX_VIEWER_USER_BUFFER_COUNT);
+        return -1;
+    }
+
+    return 0;
+}
+
+BufferPoolPolicy GetBufferPoolPolicy(const HeadlessOptions &options)
+{
+    BufferPoolPolicy policy;
+    policy.adaptive = options.maxBufferCount != 0;
+    policy.minimumCount = options.bufferCount;
+    policy.maximumCount = options.maxBufferCount;
+    policy.memoryBudget = options.bufferBudget;
+    return policy;
+}
+
+CaptureWatchdogPolicy GetCaptureWatchdogPolicy(const HeadlessOptions &options)
+{
+    CaptureWatchdogPolicy policy;
+    policy.enabled = options.watchdog;
+    policy.defaultStallMilliseconds = options.stallTimeoutMs;
+    return policy;
+}
+
+BufferRequeuePolicy GetBufferRequeuePolicy(const HeadlessOptions &options)
+{
+    BufferRequeuePolicy policy;
+    policy.batching = options.requeueBatch > 1;
+    policy.batchSize = std::max<uint32_t>(options.requeueBatch, 1);
+    policy.maximumDelayMicroseconds = options.requeueDelayUs;
+    return policy;
+}
+
+void PrintProcessorStatistics(FILE *pFile, const char *name, const RawDataProcessorStatistics &statistics, bool last)
+{
+    fprintf(pFile, "    {\"name\": \"%s\", \"policy\": %d, \"processed\": %llu, \"dropped\": %llu, \"maxQueueDepth\": %u, \"capacity\": %u}%s\n",
+            EscapeJson(name).c_str(), statistics.policy, (unsigned long long)statistics.processed, (unsigned long long)statistics.dropped,
+            statistics.maxQueueDepth, statistics.capacity, last ? "" : ",");
+}
+
+void PrintLatencyStatistics(FILE *pFile, LatencyStatistics &latencyStatistics)
+{
+    fprintf(pFile, "  \"latencyMicroseconds\": {\n");
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; ++stage)
+    {
+        LatencySummary const summary = latencyStatistics.GetSummary(static_cast<LATENCY_STAGE>(stage));
+        fprintf(pFile, "    \"%s\": {\"count\": %llu, \"mean\": %.1f, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"max\": %llu}%s\n",
+                EscapeJson(LatencyStatistics::GetStageName(static_cast<LATENCY_STAGE>(stage))).c_str(),
+                (unsigned long long)summary.count, summary.meanMicroseconds,
+                (unsigned long long)summary.p50Microseconds, (unsigned long long)summary.p90Microseconds,
+                (unsigned long long)summary.p99Microseconds, (unsigned long long)summary.maxMicroseconds,
+                stage + 1 < LATENCY_STAGE_COUNT ? "," : "");
+    }
+    fprintf(pFile, "  }");
+}
+
+void PrintWatchdogStatistics(FILE *pFile, const CaptureWatchdog &watchdog)
+{
+    CaptureWatchdogStatistics const statistics = watchdog.GetStatistics();
+    fprintf(pFile, "  \"watchdog\": {\"enabled\": %s, \"stallTimeoutMicroseconds\": %llu, \"stalls\": %u, \"errorStorms\": %u, "
+            "\"recoveries\": %u, \"failedRecoveries\": %u, \"gaveUp\": %s, \"lostMicroseconds\": %llu, \"dequeueErrors\": %llu, \"lastErrno\": %d,\n",
+            watchdog.GetPolicy().enabled ? "true" : "false", (unsigned long long)statistics.stallTimeoutMicroseconds,
+            statistics.stalls, statistics.errorStorms, statistics.recoveries, statistics.failedRecoveries,
+            statistics.gaveUp ? "true" : "false", (unsigned long long)statistics.lostMicroseconds,
+            (unsigned long long)statistics.dequeueErrors, statistics.lastErrno);
+
+    // durations relative to the detection, 0 if the step did not happen
+    std::vector<CaptureIncident> const incidents = watchdog.GetIncidents();
+    fprintf(pFile, "    \"incidents\": [\n");
+    for (size_t i = 0; i < incidents.size(); ++i)
+    {
+        CaptureIncident const &incident = incidents[i];
+        uint64_t const lastFrame = incident.lastFrameTimestamp != 0 ? incident.lastFrameTimestamp : incident.detectedTimestamp;
+        fprintf(pFile, "      {\"type\": \"%s\", \"attempt\": %u, \"errorCount\": %u, \"lastErrno\": %d, \"withoutFrameMicroseconds\": %llu, "
+                "\"restartMicroseconds\": %llu, \"firstFrameMicroseconds\": %llu}%s\n",
+                EscapeJson(CaptureWatchdog::GetIncidentName(incident.type)).c_str(), incident.attempt, incident.errorCount, incident.lastErrno,
+                (unsigned long long)(incident.detectedTimestamp - lastFrame),
+                (unsigned long long)(incident.restartedTimestamp != 0 ? incident.restartedTimestamp - incident.detectedTimestamp : 0),
+                (unsigned long long)(incident.firstFrameTimestamp != 0 ? incident.firstFrameTimestamp - incident.detectedTimestamp : 0),
+                i + 1 < incidents.size() ? "," : "");
+    }
+    fprintf(pFile, "    ]\n  }");
+}
+
+void PrintThreadSettings(FILE *pFile)
+{
+    fprintf(pFile, "  \"threads\": {\n");
+    for (int role = 0; role < THREAD_ROLE_COUNT; ++role)
+    {
+        fprintf(pFile, "    \"%s\": \"%s\"%s\n",
+                EscapeJson(threadconfig::GetRoleName(static_cast<THREAD_ROLE>(role))).c_str(),
+                EscapeJson(threadconfig::GetEffectiveSettings(static_cast<THREAD_ROLE>(role))).c_str(),
+                role + 1 < THREAD_ROLE_COUNT ? "," : "");
+    }
+    fprintf(pFile, "  }");
+}
+
+// Random frames, the same in every run
+void FillRandom(std::vector<uint8_t> &data)
+{
+    uint32_t state = 0x12345678;
+    for (auto &value : data)
+    {
+        state = state * 1664525 + 1013904223;
+        value = static_cast<uint8_t>(state >> 24);
+    }
+}
+
+struct KernelBenchmark
+{
+    const char *name;
+    // bytes per source pixel
+    uint32_t bytesPerPixel;
+    // source layouts, all are checked, the first one is timed
+    int variantCount;
+    void (*convert)(const uint8_t *pSource, uint32_t sourceBytesPerLine, uint8_t *pDestination,
+                    uint32_t destinationBytesPerLine, uint32_t width, uint32_t height, int variant);
+};
+
+void ConvertYuv422(const uint8_t *pSource, uint32_t sourceBytesPerLine, uint8_t *pDestination,
+                   uint32_t destinationBytesPerLine, uint32_t width, uint32_t height, int variant)
+{
+    pixelkernels::Yuv422ToRgb24(pSource, sourceBytesPerLine, pDestination, destinationBytesPerLine,
+                                width, height, static_cast<YUV422_LAYOUT>(variant));
+}
+
+// 4:2:0 with the luma in the first half of every source line and the chroma
+// rows in the second half, the variants are the chroma layouts
+void ConvertYuvPlanar(const uint8_t *pSource, uint32_t sourceBytesPerLine, uint8_t *pDestination,
+                      uint32_t destinationBytesPerLine, uint32_t width, uint32_t height, int variant)
+{
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        const uint8_t *pChroma = pSource + size_t(y / 2) * sourceBytesPerLine + width;
+        pixelkernels::YuvPlanarLineToRgb24(pSource + size_t(y) * sourceBytesPerLine, pChroma, pChroma + width / 2,
+                                           pDestination + size_t(y) * destinationBytesPerLine, width,
+                                           static_cast<YUV_CHROMA_LAYOUT>(variant));
+    }
+}
+
+void ConvertBayer8(const uint8_t *pSource, uint32_t sourceBytesPerLine, uint8_t *pDestination,
+                   uint32_t destinationBytesPerLine, uint32_t width, uint32_t height, int variant)
+{
+    pixelkernels::Bayer8ToRgb24(pSource, sourceBytesPerLine, pDestination, destinationBytesPerLine,
+                                width, height, static_cast<BAYER_ORDER>(variant));
+}
+
+// The same kernels in stripes on the threads ConvertFrame uses
+void ConvertYuv422Striped(const uint8_t *pSource, uint32_t sourceBytesPerLine, uint8_t *pDestination,
+                          uint32_t destinationBytesPerLine, uint32_t width, uint32_t height, int variant)
+{
+    ImageTransform::GetStripePool()->Run(height, 1, [=](uint32_t firstRow, uint32_t rowCount) {
+        pixelkernels::Yuv422ToRgb24(pSource + size_t(firstRow) * sourceBytesPerLine, sourceBytesPerLine,
+                                    pDestination + size_t(firstRow) * destinationBytesPerLine, destinationBytesPerLine,
+                                    width, rowCount, static_cast<YUV422_LAYOUT>(variant));
+    });
+}
+
+void ConvertBayer8Striped(const uint8_t *pSource, uint32_t sourceBytesPerLine, uint8_t *pDestination,
+                          uint32_t destinationBytesPerLine, uint32_t width, uint32_t height, int variant)
+{
+    ImageTransform::GetStripePool()->Run(height, 1, [=](uint32_t firstRow, uint32_t rowCount) {
+        pixelkernels::Bayer8ToRgb24Lines(pSource, sourceBytesPerLine, pDestination, destinationBytesPerLine,
+                                         width, height, static_cast<BAYER_ORDER>(variant), firstRow, rowCount);
+    });
+}
+
+// This function times every kernel with every supported instruction set and
+// compares the results with the scalar kernels, which are the reference
+//
+// Returns:
+// (int) - 1 if a vectorized kernel differs from the scalar one
+int RunKernelBenchmark(const HeadlessOptions &options)
+{
+    KernelBenchmark const kernels[] = {
+        { "yuv422", 2, 3, ConvertYuv422 },
+        { "bayer8", 1, 4, ConvertBayer8 },
+        { "yuv420", 2, 3, ConvertYuvPlanar },
+        { "yuv422-striped", 2, 3, ConvertYuv422Striped },
+        { "bayer8-striped", 1, 4, ConvertBayer8Striped },
+    };
+    std::vector<std::pair<uint32_t, uint32_t>> resolutions = { { 640, 480 }, { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 } };
+    if (options.width != 0 && options.height != 0)
+    {
+        resolutions = { { options.width, options.height } };
+    }
+
+    KERNEL_ISA const activeIsa = pixelkernels::GetActiveIsa();
+    int result = 0;
+
+    FILE *pOut = stdout;
+    fprintf(pOut, "{\n  \"detectedKernels\": \"%s\",\n  \"conversionThreads\": %u,\n  \"benchmarks\": [\n",
+            EscapeJson(pixelkernels::GetIsaName(pixelkernels::GetDetectedIsa())).c_str(), ImageTransform::GetConversionThreads());
+    bool firstBenchmark = true;
+    for (auto const &kernel : kernels)
+    {
+        for (auto const &resolution : resolutions)
+        {
+            uint32_t const width = resolution.first;
+            uint32_t const height = resolution.second;
+            // odd padding, so the kernels can't rely on aligned lines
+            uint32_t const sourceBytesPerLine = width * kernel.bytesPerPixel + 24;
+            uint32_t const destinationBytesPerLine = width * 3;
+            std::vector<uint8_t> source(size_t(sourceBytesPerLine) * height);
+            std::vector<uint8_t> destination(size_t(destinationBytesPerLine) * height);
+            std::vector<std::vector<uint8_t>> reference(kernel.variantCount);
+            FillRandom(source);
+
+            fprintf(pOut, "%s    {\"kernel\": \"%s\", \"width\": %u, \"height\": %u, \"results\": [",
+                    firstBenchmark ? "" : ",\n", EscapeJson(kernel.name).c_str(), width, height);
+            firstBenchmark = false;
+
+            double scalarMilliseconds = 0.0;
+            bool firstResult = true;
+            for (int isa = 0; isa < KERNEL_ISA_COUNT; ++isa)
+            {
+                if (pixelkernels::SetActiveIsa(static_cast<KERNEL_ISA>(isa)) != 0)
+                {
+                    continue;
+                }
+
+                bool bitExact = true;
+                for (int variant = 0; variant < kernel.variantCount; ++variant)
+                {
+                    std::fill(destination.begin(), destination.end(), 0);
+                    kernel.convert(source.data(), sourceBytesPerLine, destination.data(), destinationBytesPerLine,
+                                   width, height, variant);
+                    if (isa == KERNEL_ISA_SCALAR)
+                    {
+                        reference[variant] = destination;
+                    }
+                    else if (destination != reference[variant])
+                    {
+                        bitExact = false;
+                    }
+                }
+
+                // at least 5 runs and a quarter of a second, the fastest run counts
+                double bestMilliseconds = 0.0;
+                auto const start = std::chrono::steady_clock::now();
+                for (int run = 0; run < 5 || std::chrono::steady_clock::now() - start < std::chrono::milliseconds(250); ++run)
+                {
+                    auto const runStart = std::chrono::steady_clock::now();
+                    kernel.convert(source.data(), sourceBytesPerLine, destination.data(), destinationBytesPerLine,
+                                   width, height, 0);
+                    double const milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - runStart).count();
+                    bestMilliseconds = (run == 0) ? milliseconds : std::min(bestMilliseconds, milliseconds);
+                }
+                if (isa == KERNEL_ISA_SCALAR)
+                {
+                    scalarMilliseconds = bestMilliseconds;
+                }
+                if (!bitExact)
+                {
+                    result = 1;
+                }
+
+                fprintf(pOut, "%s\n      {\"kernels\": \"%s\", \"milliseconds\": %.3f, \"megapixelsPerSecond\": %.1f, \"speedup\": %.2f, \"bitExact\": %s}",
+                        firstResult ? "" : ",", EscapeJson(pixelkernels::GetIsaName(static_cast<KERNEL_ISA>(isa))).c_str(), bestMilliseconds,
+                        bestMilliseconds > 0.0 ? width * double(height) / (bestMilliseconds * 1000.0) : 0.0,
+                        bestMilliseconds > 0.0 ? scalarMilliseconds / bestMilliseconds : 0.0, bitExact ? "true" : "false");
+                firstResult = false;
+            }
+            fprintf(pOut, "\n    ]}");
+        }
+    }
+    fprintf(pOut, "\n  ],\n  \"result\": %d\n}\n", result);
+
+    pixelkernels::SetActiveIsa(activeIsa);
+
+    return result;
+}
+
+// Hides whether the frames come from a device or from the synthetic generator
+class HeadlessFrameSource
+{
+public:
+    int Open(HeadlessOptions &options)
+    {
+        if (options.synthetic)
+        {
+            return OpenSynthetic(options);
+        }
+
+        m_pCamera = std::make_unique<Camera>();
+        m_pCamera->SetUserBufferPoolOptions(options.hugePages, options.lockBuffers);
+        m_pCamera->SetMmapCacheMode(options.mmapCacheMode);
+        m_pCamera->SetReadBandwidthSampling(options.measureRead);
+        m_pCamera->SetBufferPoolPolicy(GetBufferPoolPolicy(options));
+        m_pCamera->SetCaptureWatchdogPolicy(GetCaptureWatchdogPolicy(options));
+        m_pCamera->SetBufferRequeuePolicy(GetBufferRequeuePolicy(options));
+        QVector<QString> subDevices;
+        if (m_pCamera->OpenDevice(options.device, subDevices, options.blockingMode, options.ioMethod, true) != 0)
+        {
+            fprintf(stderr, "Opening %s failed\n", options.device.c_str());
+            return -1;
+        }
+        m_Name = options.device;
+
+        if (options.pixelFormat != 0 && m_pCamera->SetPixelFormat(options.pixelFormat, "") < 0)
+        {
+            fprintf(stderr, "Setting pixel format %s failed\n", FourccToString(options.pixelFormat).c_str());
+        }
+        if (options.width != 0 && options.height != 0 && m_pCamera->SetFrameSize(options.width, options.height) < 0)
+        {
+            fprintf(stderr, "Setting frame size %ux%u failed\n", options.width, options.height);
+        }
+        if (options.fps != 0 && m_pCamera->SetFrameRate(1, options.fps) < 0)
+        {
+            fprintf(stderr, "Setting frame rate %u failed\n", options.fps);
+        }
+
+        QString pixelFormatText;
+        m_pCamera->ReadPayloadSize(m_PayloadSize);
+        m_pCamera->ReadFrameSize(m_Width, m_Height);
+        if (m_pCamera->ReadPixelFormat(m_PixelFormat, m_BytesPerLine, pixelFormatText) != 0)
+        {
+            fprintf(stderr, "Reading the format of %s failed\n", options.device.c_str());
+            Close();
+            return -1;
+        }
+
+        return 0;
+    }
+
+    int Start(const HeadlessOptions &options)
+    {
+        if (m_pSynthetic)
+        {
+            if (m_pSynthetic->CreateAllUserBuffer(options.bufferCount, m_PayloadSize) != 0 ||
+                m_pSynthetic->QueueAllUserBuffer() != 0 ||
+                m_pSynthetic->StartStream(options.blockingMode, m_pSynthetic->GetFileDescriptor(), m_PixelFormat,
+                                          m_PayloadSize, m_Width, m_Height, m_BytesPerLine, options.enableLogging) != 0)
+            {
+                return -1;
+            }
+            return m_pSynthetic->StartGenerator();
+        }
+
+        if (m_pCamera->CreateUserBuffer(options.bufferCount, m_PayloadSize) != 0 ||
+            m_pCamera->QueueAllUserBuffer() != 0 ||
+            m_pCamera->StartStreaming() != 0 ||
+            m_pCamera->StartStreamChannel(m_PixelFormat, m_PayloadSize, m_Width, m_Height, m_BytesPerLine, NULL, options.enableLogging) != 0)
+        {
+            return -1;
+        }
+
+        return 0;
+    }
+
+    void Stop()
+    {
+        if (m_pSynthetic)
+        {
+            m_pSynthetic->StopStream();
+            m_pSynthetic->StopGenerator();
+        }
+        else if (m_pCamera)
+        {
+            m_pCamera->StopStreamChannel();
+            m_pCamera->StopStreaming();
+        }
+    }
+
+    void Close()
+    {
+        if (m_pSynthetic)
+        {
+            m_pSynthetic->DeleteAllUserBuffer();
+        }
+        else if (m_pCamera)
+        {
+            m_pCamera->DeleteUserBuffer();
+            m_pCamera->CloseDevice();
+        }
+    }
+
+    FrameObserver* GetFrameObserver() const
+    {
+        return m_pSynthetic ? m_pSynthetic.get() : m_pCamera->GetFrameObserver();
+    }
+
+    const std::string& GetName() const { return m_Name; }
+    uint32_t GetWidth() const { return m_Width; }
+    uint32_t GetHeight() const { return m_Height; }
+    uint32_t GetPixelFormat() const { return m_PixelFormat; }
+    uint32_t GetBytesPerLine() const { return m_BytesPerLine; }
+    uint32_t GetPayloadSize() const { return m_PayloadSize; }
+
+private:
+    int OpenSynthetic(const HeadlessOptions &options)
+    {
+        m_PixelFormat = options.pixelFormat != 0 ? options.pixelFormat : V4L2_PIX_FMT_YUYV;
+        m_Width = options.width != 0 ? options.width : 1920;
+        m_Height = options.height != 0 ? options.height : 1080;
+
+        m_pSynthetic = std::make_unique<FrameObserverSynthetic>(true);
+        if (m_pSynthetic->SetFormat(m_PixelFormat, m_Width, m_Height) != 0)
+        {
+            fprintf(stderr, "Format %s with %ux%u cannot be generated\n", FourccToString(m_PixelFormat).c_str(), m_Width, m_Height);
+            return -1;
+        }
+        m_pSynthetic->SetFrameRate(options.fps != 0 ? options.fps : 30);
+        m_pSynthetic->SetPattern(options.pattern);
+        m_pSynthetic->SetReplayFile(options.replayFile);
+        m_pSynthetic->SetBufferPoolPolicy(GetBufferPoolPolicy(options));
+        m_pSynthetic->SetCaptureWatchdogPolicy(GetCaptureWatchdogPolicy(options));
+        m_pSynthetic->SetBufferRequeuePolicy(GetBufferRequeuePolicy(options));
+        m_pSynthetic->SetReadBandwidthSampling(options.measureRead);
+        FrameObserverSynthetic::GetFrameLayout(m_PixelFormat, m_Width, m_Height, m_BytesPerLine, m_PayloadSize);
+
+        m_Name = options.replayFile.empty() ? "synthetic" : options.replayFile;
+
+        return 0;
+    }
+
+    std::unique_ptr<Camera> m_pCamera;
+    std::unique_ptr<FrameObserverSynthetic> m_pSynthetic;
+    std::string m_Name;
+    uint32_t m_Width = 0;
+    uint32_t m_Height = 0;
+    uint32_t m_PixelFormat = 0;
+    uint32_t m_BytesPerLine = 0;
+    uint32_t m_PayloadSize = 0;
+};
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    qRegisterMetaType<v4l2_ext_control>();
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("V4L2ViewerHeadless");
+
+    HeadlessOptions options;
+    if (ParseOptions(app, options) != 0)
+    {
+        return 1;
+    }
+
+    Logger::InitializeLogger("V4L2ViewerHeadless.log");
+    Logger::LogSwitch(options.enableLogging);
+
+    if (!options.threads.empty() && threadconfig::Parse(options.threads) != 0)
+    {
+        fprintf(stderr, "Invalid thread configuration '%s'\n", options.threads.c_str());
+        return 1;
+    }
+
+    if (!options.kernels.empty())
+    {
+        int isa = 0;
+        while (isa < KERNEL_ISA_COUNT && options.kernels != pixelkernels::GetIsaName(static_cast<KERNEL_ISA>(isa)))
+        {
+            ++isa;
+        }
+        if (isa == KERNEL_ISA_COUNT || pixelkernels::SetActiveIsa(static_cast<KERNEL_ISA>(isa)) != 0)
+        {
+            fprintf(stderr, "Kernels '%s' are not supported, the CPU supports %s\n", options.kernels.c_str(),
+                    pixelkernels::GetIsaName(pixelkernels::GetDetectedIsa()));
+            return 1;
+        }
+    }
+
+    if (options.conversionThreads != 0)
+    {
+        ImageTransform::SetConversionThreads(options.conversionThreads);
+    }
+
+    if (options.benchmarkKernels)
+    {
+        return RunKernelBenchmark(options);
+    }
+
+    HeadlessFrameSource source;
+    if (source.Open(options) != 0)
+    {
+        return 1;
+    }
+
+    uint32_t const width = source.GetWidth();
+    uint32_t const height = source.GetHeight();
+    uint32_t const pixelFormat = source.GetPixelFormat();
+    uint32_t const bytesPerLine = source.GetBytesPerLine();
+    uint32_t const payloadSize = source.GetPayloadSize();
+
+    if (options.convert && !ImageTransform::CanConvert(pixelFormat))
+    {
+        fprintf(stderr, "Pixel format %s cannot be converted\n", FourccToString(pixelFormat).c_str());
+        source.Close();
+        return 1;
+    }
+
+    FrameObserver *pObserver = source.GetFrameObserver();
+
+    // Counting processor, decides when the run is complete
+    std::mutex doneMutex;
+    std::condition_variable doneCondition;
+    std::atomic<uint64_t> frameCount{0};
+    bool frameLimitReached = false;
+    int const countIndex = pObserver->AddRawDataProcessor([&] (BufferWrapper const&, FrameLease) {
+        uint64_t const count = ++frameCount;
+        if (options.frameLimit != 0 && count == options.frameLimit)
+        {
+            std::lock_guard<std::mutex> lock(doneMutex);
+            frameLimitReached = true;
+            doneCondition.notify_all();
+        }
+    });
+
+    int convertIndex = -1;
+    if (options.convert)
+    {
+        // Same mailbox semantics as the software renderer, the image is reused by every frame
+        convertIndex = pObserver->AddRawDataProcessor([convertedImage = QImage()] (BufferWrapper const& buffer, FrameLease) mutable {
+            uint64_t const conversionStart = LatencyStatistics::Now();
+            ImageTransform::ConvertFrame(buffer, convertedImage);
+            uint64_t const conversionEnd = LatencyStatistics::Now();
+            if (buffer.latencyStatistics)
+            {
+                buffer.latencyStatistics->Record(LATENCY_DISPATCH_TO_CONVERSION, buffer.timestamps.dispatched, conversionStart);
+                buffer.latencyStatistics->Record(LATENCY_CONVERSION, conversionStart, conversionEnd);
+                buffer.latencyStatistics->Record(LATENCY_DRIVER_TO_DISPLAY, buffer.timestamps.Origin(), conversionEnd);
+            }
+        }, PROCESSOR_QUEUE_LATEST_ONLY);
+    }
+
+    FILE *pRecordFile = nullptr;
+    int recordIndex = -1;
+    uint64_t recordedBytes = 0;
+    if (!options.recordFile.empty())
+    {
+        pRecordFile = fopen(options.recordFile.c_str(), "wb");
+        if (pRecordFile == nullptr)
+        {
+            fprintf(stderr, "Opening %s for recording failed\n", options.recordFile.c_str());
+            source.Close();
+            return 1;
+        }
+        // A recording must not lose frames to a slow disk silently, so let it push back
+        recordIndex = pObserver->AddRawDataProcessor([&] (BufferWrapper const& buffer, FrameLease) {
+            PlanarFormat format;
+            if (planelayout::GetPlanarFormat(buffer.pixelFormat, format) && format.memoryPlaneCount > 1)
+            {
+                // the planes of one frame follow each other in the file
+                for (uint32_t i = 0; i < buffer.planeCount; ++i)
+                {
+                    recordedBytes += fwrite(buffer.planes[i].data, 1, buffer.planes[i].length, pRecordFile);
+                }
+                return;
+            }
+            size_t const size = std::min<size_t>(buffer.payloadSize, buffer.length);
+            recordedBytes += fwrite(buffer.data, 1, size, pRecordFile);
+        }, PROCESSOR_QUEUE_BLOCK, std::max<uint32_t>(options.bufferCount / 2, 1));
+    }
+
+    int result = 0;
+    auto const startTime = std::chrono::steady_clock::now();
+
+    if (source.Start(options) != 0)
+    {
+        fprintf(stderr, "Starting the stream failed\n");
+        result = 1;
+    }
+    else
+    {
+        auto const deadline = startTime + std::chrono::microseconds(static_cast<int64_t>(options.durationSeconds * 1e6));
+        std::unique_lock<std::mutex> lock(doneMutex);
+        while (!frameLimitReached && std::chrono::steady_clock::now() < deadline)
+        {
+            // Camera still delivers control events through queued connections
+            lock.unlock();
+            QCoreApplication::processEvents();
+            lock.lock();
+            doneCondition.wait_for(lock, std::chrono::milliseconds(50));
+        }
+    }
+
+    auto const stopTime = std::chrono::steady_clock::now();
+    double const elapsedSeconds = std::chrono::duration<double>(stopTime - startTime).count();
+
+    source.Stop();
+
+    // gather before the buffers are released, StopStream has flushed the queues already
+    RawDataProcessorStatistics countStatistics = {};
+    RawDataProcessorStatistics convertStatistics = {};
+    RawDataProcessorStatistics recordStatistics = {};
+    pObserver->GetRawDataProcessorStatistics(countIndex, countStatistics);
+    pObserver->GetRawDataProcessorStatistics(convertIndex, convertStatistics);
+    pObserver->GetRawDataProcessorStatistics(recordIndex, recordStatistics);
+
+    FrameDropCounters const dropTotals = pObserver->GetDropStatistics().GetTotals();
+    BufferPoolStatistics const bufferPool = pObserver->GetBufferPoolStatistics();
+
+    FILE *pOut = stdout;
+    fprintf(pOut, "{\n");
+    fprintf(pOut, "  \"device\": \"%s\",\n", EscapeJson(source.GetName()).c_str());
+    fprintf(pOut, "  \"pixelFormat\": \"%s\",\n", EscapeJson(FourccToString(pixelFormat)).c_str());
+    fprintf(pOut, "  \"width\": %u,\n  \"height\": %u,\n  \"bytesPerLine\": %u,\n  \"payloadSize\": %u,\n", width, height, bytesPerLine, payloadSize);
+    fprintf(pOut, "  \"buffers\": %u,\n", options.bufferCount);
+    fprintf(pOut, "  \"kernels\": \"%s\",\n", EscapeJson(pixelkernels::GetIsaName(pixelkernels::GetActiveIsa())).c_str());
+    std::shared_ptr<StripePool> const pStripePool = ImageTransform::GetStripePool();
+    StripePoolStatistics const stripes = pStripePool->GetStatistics();
+    fprintf(pOut, "  \"conversion\": {\"threads\": %u, \"stripedFrames\": %llu, \"stripes\": %llu, \"pooledStripes\": %llu},\n",
+            pStripePool->GetThreadCount(), (unsigned long long)stripes.frames, (unsigned long long)stripes.stripes,
+            (unsigned long long)stripes.pooledStripes);
+    fprintf(pOut, "  \"bufferPool\": {\"adaptive\": %s, \"active\": %u, \"peak\": %u, \"allocated\": %u, \"grown\": %u, \"shrunk\": %u, \"activeBytes\": %llu},\n",
+            options.maxBufferCount != 0 ? "true" : "false", bufferPool.activeCount, bufferPool.peakCount, bufferPool.allocatedCount,
+            bufferPool.grownCount, bufferPool.shrunkCount, (unsigned long long)bufferPool.activeBytes);
+    fprintf(pOut, "  \"elapsedSeconds\": %.3f,\n", elapsedSeconds);
+    fprintf(pOut, "  \"frames\": %llu,\n", (unsigned long long)frameCount.load());
+    fprintf(pOut, "  \"framesPerSecond\": %.2f,\n", elapsedSeconds > 0.0 ? frameCount.load() / elapsedSeconds : 0.0);
+    fprintf(pOut, "  \"drops\": {\"sequenceGaps\": %llu, \"errorFrames\": %llu, \"starvations\": %llu, \"starvedMicroseconds\": %llu},\n",
+            (unsigned long long)dropTotals.sequenceGaps, (unsigned long long)dropTotals.errorFrames,
+            (unsigned long long)dropTotals.starvations, (unsigned long long)dropTotals.starvedMicroseconds);
+    if (options.measureRead)
+    {
+        // the cache mode the driver has granted, it falls back to coherent without cache hints
+        FrameObserverMMAP const *pMmapObserver = dynamic_cast<FrameObserverMMAP const*>(pObserver);
+        BufferReadStatistics const bufferRead = pObserver->GetBufferReadStatistics();
+        fprintf(pOut, "  \"bufferRead\": {\"mmapCache\": \"%s\", \"samples\": %llu, \"meanMegabytesPerSecond\": %.1f, \"bestMegabytesPerSecond\": %.1f},\n",
+                EscapeJson(pMmapObserver ? FrameObserverMMAP::GetCacheModeName(pMmapObserver->GetCacheMode()) : "none").c_str(),
+                (unsigned long long)bufferRead.samples,
+                bufferRead.nanoseconds != 0 ? 1000.0 * bufferRead.bytes / bufferRead.nanoseconds : 0.0,
+                bufferRead.bestMegabytesPerSecond);
+    }
+    CaptureLoopStatistics const captureLoop = pObserver->GetCaptureLoopStatistics();
+    fprintf(pOut, "  \"captureLoop\": {\"requeueBatch\": %u, \"wakeups\": %llu, \"wakeupsPerSecond\": %.1f, \"dequeueCalls\": %llu, "
+            "\"queueCalls\": %llu, \"otherCalls\": %llu, \"syscallsPerFrame\": %.2f, \"requeueBatches\": %llu, \"largestBatch\": %u},\n",
+            options.requeueBatch > 1 ? options.requeueBatch : 1, (unsigned long long)captureLoop.wakeups, captureLoop.wakeupsPerSecond,
+            (unsigned long long)captureLoop.dequeueCalls, (unsigned long long)captureLoop.queueCalls, (unsigned long long)captureLoop.otherCalls,
+            captureLoop.syscallsPerFrame, (unsigned long long)captureLoop.requeueBatches, captureLoop.largestBatch);
+    if (pRecordFile != nullptr)
+    {
+        fprintf(pOut, "  \"recordedBytes\": %llu,\n", (unsigned long long)recordedBytes);
+    }
+    fprintf(pOut, "  \"processors\": [\n");
+    PrintProcessorStatistics(pOut, "count", countStatistics, convertIndex < 0 && recordIndex < 0);
+    if (convertIndex >= 0)
+    {
+        PrintProcessorStatistics(pOut, "convert", convertStatistics, recordIndex < 0);
+    }
+    if (recordIndex >= 0)
+    {
+        PrintProcessorStatistics(pOut, "record", recordStatistics, true);
+    }
+    fprintf(pOut, "  ],\n");
+    PrintLatencyStatistics(pOut, pObserver->GetLatencyStatistics());
+    fprintf(pOut, ",\n");
+    PrintWatchdogStatistics(pOut, pObserver->GetCaptureWatchdog());
+    fprintf(pOut, ",\n");
+    PrintThreadSettings(pOut);
+    fprintf(pOut, ",\n  \"result\": %d\n}\n", result);
+
+    source.Close();
+
+    if (pRecordFile != nullptr)
+    {
+        fclose(pRecordFile);
+    }
+
+    return result;
+}
@@ -17,14 +17,87 @@
 
 
 #include "V4L2Viewer.h"
+#include "MultiCameraViewer.h"
+#include <QCommandLineParser>
 #include <QDebug>
 #include "q_v4l2_ext_ctrl.h"
 
+// Options of the tiled view, returns false if there is nothing to show tiled
+static bool ParseMultiCameraOptions(QApplication &app, MultiCameraOptions &options)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Allied Vision V4L2 Viewer");
+    parser.addHelpOption();
+
+    QCommandLineOption multiOption("multi", "Stream several devices at once in a tiled view, e.g. /dev/video0,/dev/video2.", "devices");
+    QCommandLineOption ioOption("io", "Buffer I/O of the tiled view: userptr, mmap, dmabuf or dmabuf-import.", "method", "userptr");
+    QCommandLineOption buffersOption("buffers", "Capture buffers per camera of the tiled view (default 5).", "count", "5");
+    QCommandLineOption threadsOption("conversion-threads", "Threads converting the frames of all cameras (default: CPUs - 1).", "count", "0");
+    QCommandLineOption syncOption("sync", "Show only frames whose driver timestamps match within this tolerance.", "microseconds");
+    QCommandLineOption watchdogOption("watchdog", "Restart streams of the tiled view after stalls or error storms, not for triggered cameras.");
+    parser.addOptions({ multiOption, ioOption, buffersOption, threadsOption, syncOption, watchdogOption });
+    parser.process(app);
+
+    if (!parser.isSet(multiOption))
+    {
+        return false;
+    }
+
+    QStringList const devices = parser.value(multiOption).split(',',
+        #if QT_VERSION >= QT_VERSION_CHECK(5,14,0)
+          Qt::SkipEmptyParts
+        #else
+          QString::SkipEmptyParts
+        #endif
+    );
+    for (QString const &device : devices)
+    {
+        options.devices.push_back(device.trimmed().toStdString());
+    }
+
+    QString const ioMethod = parser.value(ioOption);
+    if (ioMethod == "mmap")
+    {
+        options.ioMethod = IO_METHOD_MMAP;
+    }
+    else if (ioMethod == "dmabuf")
+    {
+        options.ioMethod = IO_METHOD_DMABUF;
+    }
+    else if (ioMethod == "dmabuf-import")
+    {
+        options.ioMethod = IO_METHOD_DMABUF_IMPORT;
+    }
+
+    uint32_t const bufferCount = parser.value(buffersOption).toUInt();
+    if (bufferCount > 0 && bufferCount <= MAX_VIEWER_USER_BUFFER_COUNT)
+    {
+        options.bufferCount = bufferCount;
+    }
+    options.conversionThreads = parser.value(threadsOption).toUInt();
+    options.syncToleranceMicroseconds = parser.value(syncOption).toULongLong();
+    options.watchdog = parser.isSet(watchdogOption);
+
+    return !options.devices.empty();
+}
+
 int main( int argc, char *argv[] )
 {
     qRegisterMetaType<v4l2_ext_control>();
     QApplication a( argc, argv );
     Q_INIT_RESOURCE(V4L2Viewer);
+
+    MultiCameraOptions multiCameraOptions;
+    if (ParseMultiCameraOptions(a, multiCameraOptions))
+    {
+        MultiCameraViewer viewer(multiCameraOptions);
+        viewer.show();
+        viewer.StartStreams();
+        int const result = a.exec();
+        viewer.StopStreams();
+        return result;
+    }
+
     V4L2Viewer w;
     w.show();
     return a.exec();
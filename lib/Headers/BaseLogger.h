@@ -80,6 +80,8 @@ private:
     void PrintDumpExitMessage();
     // This function prints buffer exit message
     void PrintBufferExitMessage();
+    // This function applies the logging thread role to the calling thread and logs the result
+    void ApplyThreadConfig();
 
 private:
     // This function converts timestamp to string
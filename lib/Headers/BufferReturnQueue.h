@@ -0,0 +1,131 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#ifndef BUFFERRETURNQUEUE_H
+#define BUFFERRETURNQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Indices of buffers whose last lease has been released, on their way back to
+// the capture thread. Any thread may push, only the capture thread pops, so the
+// threads finishing a frame neither wait for each other nor for VIDIOC_QBUF.
+// A bounded ring after D. Vyukov: the sequence of a cell tells whether it is
+// free for the push of a given round or filled for the pop.
+template <size_t Capacity>
+class BufferReturnQueue
+{
+    static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "the capacity has to be a power of two");
+
+public:
+    BufferReturnQueue()
+    {
+        Reset();
+    }
+
+    BufferReturnQueue(const BufferReturnQueue&) = delete;
+    BufferReturnQueue& operator=(const BufferReturnQueue&) = delete;
+
+    // This function adds an index, it may be called from any thread
+    //
+    // Parameters:
+    // [in] (uint32_t) index - index of the buffer
+    //
+    // Returns:
+    // (bool) - false if the queue is full
+    bool Push(uint32_t index)
+    {
+        size_t position = m_Tail.load(std::memory_order_relaxed);
+        Cell *pCell;
+        for (;;)
+        {
+            pCell = &m_Cells[position & (Capacity - 1)];
+            size_t const sequence = pCell->sequence.load(std::memory_order_acquire);
+            intptr_t const difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0)
+            {
+                if (m_Tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                // the consumer has not freed this cell of the previous round yet
+                return false;
+            }
+            else
+            {
+                position = m_Tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        pCell->index = index;
+        pCell->sequence.store(position + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // This function takes the oldest index, only the capture thread calls it
+    //
+    // Parameters:
+    // [out] (uint32_t &) index - index of the buffer
+    //
+    // Returns:
+    // (bool) - false if the queue is empty
+    bool Pop(uint32_t &index)
+    {
+        Cell &cell = m_Cells[m_Head & (Capacity - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != m_Head + 1)
+        {
+            return false;
+        }
+
+        index = cell.index;
+        cell.sequence.store(m_Head + Capacity, std::memory_order_release);
+        ++m_Head;
+
+        return true;
+    }
+
+    // This function forgets all indices, no other thread may use the queue meanwhile
+    void Reset()
+    {
+        for (size_t i = 0; i < Capacity; ++i)
+        {
+            m_Cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        m_Head = 0;
+        m_Tail.store(0, std::memory_order_release);
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        uint32_t            index;
+    };
+
+    Cell                m_Cells[Capacity];
+    // producers and consumer work on different cache lines
+    alignas(64) std::atomic<size_t> m_Tail;
+    alignas(64) size_t              m_Head;
+};
+
+#endif // BUFFERRETURNQUEUE_H
@@ -5,6 +5,19 @@
 #include <cstdlib>
 #include <linux/videodev2.h>
 
+#include "LatencyStatistics.h"
+
+// Y, UV or Y, U, V of the planar YUV formats
+#define BUFFER_MAX_PLANES 3
+
+// One colour plane of a frame, it may share its memory with the other planes
+struct FramePlane
+{
+    uint8_t const* data = nullptr;
+    size_t length = 0;
+    uint32_t bytesPerLine = 0;
+};
+
 struct BufferWrapper
 {
     v4l2_buffer buffer;
@@ -16,6 +29,17 @@ struct BufferWrapper
     uint32_t payloadSize;
     uint32_t bytesPerLine;
     uint64_t frameID;
+    // dmabuf file descriptor of the buffer or -1 if the I/O method has none.
+    // It stays owned by the frame observer and is only valid until the buffer is released.
+    int dmabufFd = -1;
+    // Stages downstream of the capture thread record their timing against these
+    FrameTimestamps timestamps;
+    LatencyStatistics *latencyStatistics = nullptr;
+    // Colour planes of the frame, pointing into the captured memory, nothing is repacked.
+    // data and length above are the first memory plane, which holds all colour
+    // planes unless the driver delivers them in separate memory planes.
+    uint32_t planeCount = 1;
+    FramePlane planes[BUFFER_MAX_PLANES];
 };
 
 #endif
@@ -20,6 +20,7 @@
 #define CAMERA_H
 
 #include "FrameObserver.h"
+#include "FrameObserverMMAP.h"
 #include "CameraObserver.h"
 #include "AutoReader.h"
 #include "V4L2EventHandler.h"
@@ -38,6 +39,8 @@ enum IO_METHOD_TYPE
 {
     IO_METHOD_MMAP,
     IO_METHOD_USERPTR,
+    IO_METHOD_DMABUF,           // MMAP buffers exported as dmabuf
+    IO_METHOD_DMABUF_IMPORT,    // driver writes into imported dmabufs
 };
 
 class IPixFormat;
@@ -580,6 +583,15 @@ public:
     // Returns:
     // (int) - result of deleting
     int DeleteUserBuffer();
+    // This function sets the dmabufs the driver writes into with IO_METHOD_DMABUF_IMPORT.
+    // Missing buffers are allocated locally with udmabuf.
+    //
+    // Parameters:
+    // [in] (const std::vector<int> &) fileDescriptors - dmabuf file descriptors, owned by the caller
+    //
+    // Returns:
+    // (int) - -1 if the current I/O method does not import dmabufs
+    int SetDmabufImportFileDescriptors(const std::vector<int> &fileDescriptors);
 
     // This function returns camera driver name
     //
@@ -649,12 +661,96 @@ public:
     // Returns:
     // (double) - received framerate
     double GetReceivedFPS();
+    // This function returns the drop counters of the current stream
+    //
+    // Parameters:
+    // [out] (FrameDropCounters &) totals - counters since the stream start
+    // [out] (FrameDropCounters &) lastSecond - counters of the last completed second
+    void GetFrameDropCounters(FrameDropCounters &totals, FrameDropCounters &lastSecond);
+    // This function returns the latency histograms of the current stream
+    //
+    // Returns:
+    // (LatencyStatistics &) - histograms of all pipeline stages
+    LatencyStatistics& GetLatencyStatistics();
 
     // This function switches frame transfer to gui
     //
     // Parameters:
     // [in] (bool) showFrames - state of frames visibility
     void SwitchFrameTransfer2GUI(bool showFrames);
+    // This function configures the memory of user pointer buffers,
+    // it takes effect with the next OpenDevice
+    //
+    // Parameters:
+    // [in] (bool) hugePages - back the buffers with huge pages
+    // [in] (bool) lockMemory - lock the buffers in memory
+    void SetUserBufferPoolOptions(bool hugePages, bool lockMemory);
+    // This function selects the cache behaviour of MMAP buffers,
+    // it takes effect with the next OpenDevice
+    //
+    // Parameters:
+    // [in] (MMAP_CACHE_MODE) mode
+    void SetMmapCacheMode(MMAP_CACHE_MODE mode);
+    // This function returns the cache behaviour the driver has granted
+    //
+    // Returns:
+    // (MMAP_CACHE_MODE) - mode of the current MMAP buffers, coherent for other I/O methods
+    MMAP_CACHE_MODE GetMmapCacheMode();
+    // This function returns whether the frames are captured with the MMAP I/O method.
+    // OpenDevice falls back to another method if the requested one is not supported.
+    //
+    // Returns:
+    // (bool) - true if the current frame observer uses MMAP buffers
+    bool UsesMmap();
+    // This function switches the sampling of the buffer read speed on or off,
+    // it takes effect with the next OpenDevice
+    //
+    // Parameters:
+    // [in] (bool) enable
+    void SetReadBandwidthSampling(bool enable);
+    // This function returns the sampled read speed of the buffers
+    //
+    // Returns:
+    // (BufferReadStatistics) - samples and speed of the current stream
+    BufferReadStatistics GetBufferReadStatistics();
+    // This function sets how the buffer pool adapts while streaming,
+    // it takes effect with the next OpenDevice
+    //
+    // Parameters:
+    // [in] (const BufferPoolPolicy &) policy
+    void SetBufferPoolPolicy(const BufferPoolPolicy &policy);
+    // This function returns the size of the buffer pool of the current stream
+    //
+    // Returns:
+    // (BufferPoolStatistics) - current and peak buffer count
+    BufferPoolStatistics GetBufferPoolStatistics();
+    // This function sets when a failing stream is restarted,
+    // it takes effect with the next OpenDevice
+    //
+    // Parameters:
+    // [in] (const CaptureWatchdogPolicy &) policy
+    void SetCaptureWatchdogPolicy(const CaptureWatchdogPolicy &policy);
+    // This function returns the stall and recovery counters of the current stream
+    //
+    // Returns:
+    // (CaptureWatchdogStatistics) - counters
+    CaptureWatchdogStatistics GetCaptureWatchdogStatistics();
+    // This function returns the stalls and error storms of the current stream
+    //
+    // Returns:
+    // (std::vector<CaptureIncident>) - incidents with timing, oldest first
+    std::vector<CaptureIncident> GetCaptureIncidents();
+    // This function sets when released buffers are requeued,
+    // it takes effect with the next OpenDevice
+    //
+    // Parameters:
+    // [in] (const BufferRequeuePolicy &) policy
+    void SetBufferRequeuePolicy(const BufferRequeuePolicy &policy);
+    // This function returns the syscalls and wakeups of the capture thread
+    //
+    // Returns:
+    // (CaptureLoopStatistics) - counters and rates of the current stream
+    CaptureLoopStatistics GetCaptureLoopStatistics();
 
     // This function returns AVT Device firmware version
     //
@@ -754,6 +850,13 @@ private:
     std::map<uint32_t, std::string> m_ControlIdToControlNameMap;
     bool                            m_BlockingMode;
     bool                            m_ShowFrames;
+    bool                            m_UserBufferHugePages;
+    bool                            m_UserBufferLockMemory;
+    MMAP_CACHE_MODE                 m_MmapCacheMode;
+    bool                            m_SampleReadBandwidth;
+    BufferPoolPolicy                m_BufferPoolPolicy;
+    CaptureWatchdogPolicy           m_CaptureWatchdogPolicy;
+    BufferRequeuePolicy             m_BufferRequeuePolicy;
     bool                            m_UseV4L2TryFmt;
     bool                            m_Recording;
     bool                            m_IsAvtCamera;
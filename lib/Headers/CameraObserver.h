@@ -20,9 +20,11 @@
 #define CAMERAOBSERVER_H
 
 #include <QImage>
+#include <QMutex>
 #include <QObject>
 #include <QSharedPointer>
 #include <QThread>
+#include <QWaitCondition>
 
 #include <stdint.h>
 
@@ -131,6 +133,9 @@ private:
     bool                                        m_bTerminate;
     // Variable to abort the running thread
     bool                                        m_bAbort;
+    // wakes the thread from its polling interval when it shall abort
+    QMutex                                      m_AbortMutex;
+    QWaitCondition                              m_AbortCondition;
     std::map<int, std::string>                  m_DeviceList;
     std::map<int, std::string>                  m_SubDeviceList;
 };
@@ -0,0 +1,210 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#ifndef CAPTUREWATCHDOG_H
+#define CAPTUREWATCHDOG_H
+
+#include <QMutex>
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+enum CAPTURE_INCIDENT_TYPE
+{
+    // no frame for longer than the stall timeout
+    CAPTURE_INCIDENT_STALL,
+    // only error flagged buffers or failing VIDIOC_DQBUF calls in a row
+    CAPTURE_INCIDENT_ERROR_STORM,
+};
+
+struct CaptureWatchdogPolicy
+{
+    // off unless requested, cameras in trigger mode get no frames between the triggers
+    bool     enabled = false;
+    // frame intervals without a frame which make a stall
+    uint32_t stallFrameIntervals = 10;
+    // lower bound of the stall timeout, so scheduling hiccups of fast streams don't count
+    uint32_t minimumStallMilliseconds = 500;
+    // stall timeout while the frame interval is unknown, 0 disables stall detection then
+    uint32_t defaultStallMilliseconds = 0;
+    // bad buffers in a row which make an error storm
+    uint32_t errorStormCount = 30;
+    // recoveries without a good frame in between before the watchdog gives up
+    uint32_t maximumRecoveries = 5;
+};
+
+// One detected failure of the stream and what the recovery achieved.
+// All timestamps are microseconds of CLOCK_MONOTONIC, 0 if unknown.
+struct CaptureIncident
+{
+    CAPTURE_INCIDENT_TYPE type;
+    // 1 for the first recovery since the last good frame
+    uint32_t attempt;
+    // bad buffers in a row when it was detected
+    uint32_t errorCount;
+    // errno of the last failed VIDIOC_DQBUF, 0 if none failed
+    int32_t  lastErrno;
+    // last good frame before the incident
+    uint64_t lastFrameTimestamp;
+    uint64_t detectedTimestamp;
+    // stream restarted, 0 if the restart failed
+    uint64_t restartedTimestamp;
+    // first good frame after the restart, 0 if none arrived yet
+    uint64_t firstFrameTimestamp;
+};
+
+struct CaptureWatchdogStatistics
+{
+    uint32_t stalls = 0;
+    uint32_t errorStorms = 0;
+    // restarts which brought frames back
+    uint32_t recoveries = 0;
+    // restarts which failed or were followed by another incident
+    uint32_t failedRecoveries = 0;
+    // set after maximumRecoveries in a row, cleared by the next good frame
+    bool     gaveUp = false;
+    // time without frames over all recovered incidents
+    uint64_t lostMicroseconds = 0;
+    uint64_t dequeueErrors = 0;
+    int32_t  lastErrno = 0;
+    // current stall timeout, 0 if stalls are not detected
+    uint64_t stallTimeoutMicroseconds = 0;
+};
+
+// Supervision of a stream. The capture thread reports every dequeued buffer
+// and asks regularly whether the stream has to be restarted. The stall timeout
+// follows the configured frame interval, or the measured one if frames come
+// slower, e.g. because of a long exposure. Incidents are kept with their timing,
+// they may be read from any thread.
+class CaptureWatchdog
+{
+public:
+    CaptureWatchdog();
+
+    // This function sets the thresholds
+    //
+    // Parameters:
+    // [in] (const CaptureWatchdogPolicy &) policy
+    void SetPolicy(const CaptureWatchdogPolicy &policy);
+    // This function returns the thresholds
+    //
+    // Returns:
+    // (CaptureWatchdogPolicy) - current policy
+    CaptureWatchdogPolicy GetPolicy() const;
+    // This function sets the configured frame interval of the stream
+    //
+    // Parameters:
+    // [in] (uint64_t) microseconds - 0 if unknown
+    void SetFrameInterval(uint64_t microseconds);
+
+    // This function forgets the incidents of a previous stream
+    //
+    // Parameters:
+    // [in] (uint64_t) now - start of the stream
+    void Start(uint64_t now);
+    // This function accounts a good frame
+    //
+    // Parameters:
+    // [in] (uint64_t) now - dequeue time
+    void OnFrame(uint64_t now);
+    // This function accounts a buffer flagged with V4L2_BUF_FLAG_ERROR
+    void OnErrorFrame();
+    // This function accounts a failed VIDIOC_DQBUF
+    //
+    // Parameters:
+    // [in] (int) errorNumber - errno of the call
+    void OnDequeueError(int errorNumber);
+    // This function tells that the driver has no buffer queued. It can't
+    // deliver frames then, so the time does not count as stall.
+    //
+    // Parameters:
+    // [in] (uint64_t) now
+    void OnStarved(uint64_t now);
+
+    // This function checks whether the stream has to be restarted
+    //
+    // Parameters:
+    // [in] (uint64_t) now
+    // [out] (CAPTURE_INCIDENT_TYPE &) type - kind of the incident
+    //
+    // Returns:
+    // (bool) - true if a recovery is due
+    bool Check(uint64_t now, CAPTURE_INCIDENT_TYPE &type);
+    // This function records the incident together with the result of its recovery
+    //
+    // Parameters:
+    // [in] (CAPTURE_INCIDENT_TYPE) type - as returned by Check
+    // [in] (uint64_t) detected - time Check reported the incident
+    // [in] (uint64_t) restarted - time the stream was running again, 0 if the restart failed
+    //
+    // Returns:
+    // (CaptureIncident) - the recorded incident
+    CaptureIncident OnRecovery(CAPTURE_INCIDENT_TYPE type, uint64_t detected, uint64_t restarted);
+
+    // This function returns the recorded incidents, oldest first
+    //
+    // Returns:
+    // (std::vector<CaptureIncident>) - the last MAX_INCIDENTS incidents
+    std::vector<CaptureIncident> GetIncidents() const;
+    // This function returns the counters since the start of the stream
+    //
+    // Returns:
+    // (CaptureWatchdogStatistics) - counters
+    CaptureWatchdogStatistics GetStatistics() const;
+    // This function returns the current stall timeout
+    //
+    // Returns:
+    // (uint64_t) - microseconds, 0 if stalls are not detected
+    uint64_t GetStallTimeout() const;
+
+    // This function returns a short name of an incident type
+    //
+    // Parameters:
+    // [in] (CAPTURE_INCIDENT_TYPE) type
+    //
+    // Returns:
+    // (const char *) - name
+    static const char* GetIncidentName(CAPTURE_INCIDENT_TYPE type);
+
+    static const size_t MAX_INCIDENTS = 100;
+
+private:
+    uint64_t StallTimeout() const;
+
+    mutable QMutex m_Mutex;
+    CaptureWatchdogPolicy m_Policy;
+    uint64_t m_FrameInterval;
+    // smoothed distance of the good frames
+    uint64_t m_MeasuredInterval;
+    uint64_t m_StreamStart;
+    uint64_t m_LastFrame;
+    // last good frame or (re)start of the stream, stalls are measured from here
+    uint64_t m_LastActivity;
+    uint32_t m_ErrorsInRow;
+    // errno of the last failed dequeue since the last good frame
+    int32_t m_ErrnoInRow;
+    // recoveries since the last good frame
+    uint32_t m_Attempts;
+    // the newest incident still waits for its first frame
+    bool m_AwaitingFrame;
+    std::deque<CaptureIncident> m_Incidents;
+    CaptureWatchdogStatistics m_Statistics;
+};
+
+#endif // CAPTUREWATCHDOG_H
@@ -0,0 +1,137 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#ifndef CONVERSIONPOOL_H
+#define CONVERSIONPOOL_H
+
+#include "BufferWrapper.h"
+#include "FrameLease.h"
+
+#include <QImage>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct ConversionSourceStatistics
+{
+    uint64_t converted = 0;
+    // frames replaced in the mailbox by a newer one before a thread was free
+    uint64_t replaced = 0;
+    // frames ImageTransform could not convert
+    uint64_t failed = 0;
+};
+
+// Converts the frames of several streams on one set of threads. Every source
+// has a mailbox of one frame, a newer frame replaces a waiting one and
+// thereby releases its lease, so a slow source never holds back the others.
+// Waiting sources are served round-robin and a source is converted by one
+// thread at a time, its results arrive in order.
+class ConversionPool
+{
+public:
+    // Called on a conversion thread, the lease of the frame is released afterwards
+    using ResultFunc = std::function<void(QImage &image, BufferWrapper const& buffer)>;
+
+    // Parameters:
+    // [in] (uint32_t) threadCount - number of conversion threads, 0 for DefaultThreadCount()
+    explicit ConversionPool(uint32_t threadCount);
+    ~ConversionPool();
+
+    ConversionPool(const ConversionPool &) = delete;
+    ConversionPool& operator=(const ConversionPool &) = delete;
+
+    // This function returns a thread count which leaves one CPU for capturing and the GUI
+    //
+    // Returns:
+    // (uint32_t) - number of threads
+    static uint32_t DefaultThreadCount();
+
+    // This function registers a stream
+    //
+    // Parameters:
+    // [in] (ResultFunc) result - function which receives the converted images
+    //
+    // Returns:
+    // (int) - id of the source
+    int AddSource(ResultFunc result);
+    // This function unregisters a stream. A waiting frame is released and a
+    // running conversion of the source is waited for, frames submitted
+    // afterwards are dropped.
+    //
+    // Parameters:
+    // [in] (int) id - id returned by AddSource
+    void RemoveSource(int id);
+
+    // This function hands a frame to the pool, it is called from the capture thread
+    //
+    // Parameters:
+    // [in] (int) id - id of the source
+    // [in] (BufferWrapper const &) buffer - frame description
+    // [in] (FrameLease) lease - lease which keeps the frame alive
+    void Submit(int id, BufferWrapper const& buffer, FrameLease lease);
+    // This function releases the waiting frame of a source
+    //
+    // Parameters:
+    // [in] (int) id - id of the source
+    void Flush(int id);
+
+    // This function returns the counters of a source
+    //
+    // Parameters:
+    // [in] (int) id - id of the source
+    //
+    // Returns:
+    // (ConversionSourceStatistics) - counters since AddSource
+    ConversionSourceStatistics GetStatistics(int id) const;
+    // This function returns the number of conversion threads
+    uint32_t GetThreadCount() const;
+
+private:
+    struct Source
+    {
+        ResultFunc    result;
+        BufferWrapper buffer;
+        FrameLease    lease;
+        bool          pending = false;
+        bool          busy = false;
+        bool          removed = false;
+        ConversionSourceStatistics statistics;
+    };
+
+    void WorkerMain();
+    // This function picks the next waiting source after the last served one
+    //
+    // Returns:
+    // (Source *) - source with a frame and no running conversion, NULL if there is none
+    Source* NextPendingSource();
+
+    mutable QMutex m_Mutex;
+    QWaitCondition m_FrameAvailable;
+    QWaitCondition m_SourceIdle;
+    std::vector<std::unique_ptr<Source>> m_Sources;
+    size_t m_NextSource;
+    bool m_Stop;
+
+    std::vector<std::unique_ptr<std::thread>> m_Threads;
+};
+
+#endif // CONVERSIONPOOL_H
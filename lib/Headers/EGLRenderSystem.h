@@ -25,7 +25,8 @@ public:
     void SetFlipY(bool flip);
 
     QWidget* GetWidget() const override;
-    void PassFrame(BufferWrapper const& buffer, std::function<void()> doneCallback) override;
+    void PassFrame(BufferWrapper const& buffer, FrameLease lease) override;
+    void ReleaseFrames() override;
     bool CanRender(uint32_t pixelFormat) const override;
 
 signals:
@@ -8,6 +8,7 @@
 #include <QOpenGLTexture>
 #include <QMutex>
 #include "BufferWrapper.h"
+#include "FrameLease.h"
 #include <string>
 #include <memory>
 
@@ -16,7 +17,8 @@ struct RenderSettings {
     GLenum glPixelFormat;
     GLenum glPixelType;
     GLenum glInternalFormat;
-    void (*uploadData)(QOpenGLTexture&, RenderSettings const&, BufferWrapper const&);
+    // textures holds one texture per colour plane of the format
+    void (*uploadData)(std::unique_ptr<QOpenGLTexture> const* textures, RenderSettings const&, BufferWrapper const&);
 };
 
 class EGLRenderWidget: public QOpenGLWidget, protected QOpenGLFunctions {
@@ -26,9 +28,11 @@ class EGLRenderWidget: public QOpenGLWidget, protected QOpenGLFunctions {
     std::unique_ptr<QOpenGLShaderProgram> shader;
     std::unique_ptr<QOpenGLShader> vertexShader;
     std::unique_ptr<QOpenGLShader> fragmentShader;
-    std::unique_ptr<QOpenGLTexture> texture;
+    // luma or packed pixels first, then the chroma planes of planar formats
+    std::unique_ptr<QOpenGLTexture> textures[BUFFER_MAX_PLANES];
     int matrixUniformLocation;
     int textureUniformLocation;
+    int chromaUniformLocations[BUFFER_MAX_PLANES - 1];
     int texSizeUniformLocation;
     QMatrix4x4 windowMatrix;
     QMatrix4x4 fullMatrix;
@@ -53,7 +57,7 @@ class EGLRenderWidget: public QOpenGLWidget, protected QOpenGLFunctions {
     std::function<void()> onDraw;
 
     QMutex dataMutex;
-    std::function<void()> nextDoneCallback;
+    FrameLease nextLease;
     BufferWrapper nextBuffer;
     RenderSettings const* currentRenderSettings = nullptr;
 
@@ -68,7 +72,8 @@ public:
     void setFlip(bool flipX, bool flipY);
     EGLRenderWidget(std::function<void()> onDraw);
     ~EGLRenderWidget();
-    void nextFrame(BufferWrapper const& buffer, std::function<void()> doneCallback);
+    void nextFrame(BufferWrapper const& buffer, FrameLease lease);
+    void releaseFrame();
     void setScroll(int x, int y);
     void wheelEvent(QWheelEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
@@ -0,0 +1,97 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+#ifndef FRAMEDROPSTATISTICS_H
+#define FRAMEDROPSTATISTICS_H
+
+#include <linux/videodev2.h>
+
+#include <QMutex>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+
+// Counters of one stream, either since the start or for one second of the history
+struct FrameDropCounters
+{
+    uint64_t frames = 0;            // dequeued buffers including the error flagged ones
+    uint64_t sequenceGaps = 0;      // frames the driver skipped according to v4l2_buffer::sequence
+    uint64_t errorFrames = 0;       // buffers flagged with V4L2_BUF_FLAG_ERROR
+    uint64_t starvations = 0;       // times the driver was left without a queued buffer
+    uint64_t starvedMicroseconds = 0;
+};
+
+// Drop accounting fed from the dequeued v4l2_buffers. It tells apart frames lost
+// in the driver (sequence gaps, errors) from frames lost because we did not
+// give the buffers back in time (starvation).
+class FrameDropStatistics
+{
+public:
+    FrameDropStatistics();
+
+    // This function clears all counters and the history, the queued buffer count is kept
+    void Reset();
+
+    // This function accounts a buffer which has been dequeued from the driver
+    //
+    // Parameters:
+    // [in] (const v4l2_buffer &) buf - dequeued buffer
+    void OnBufferDequeued(const v4l2_buffer &buf);
+    // This function accounts a buffer which has been queued to the driver
+    void OnBufferQueued();
+    // This function forgets all queued buffers, e.g. after they have been freed
+    void OnBuffersReleased();
+
+    // This function returns the counters since the last reset
+    //
+    // Returns:
+    // (FrameDropCounters) - totals
+    FrameDropCounters GetTotals() const;
+    // This function returns the counters of the last completed seconds, oldest first
+    //
+    // Returns:
+    // (std::deque<FrameDropCounters>) - per second history
+    std::deque<FrameDropCounters> GetHistory() const;
+    // This function returns the number of buffers currently owned by the driver
+    //
+    // Returns:
+    // (int) - queued buffers
+    int GetQueuedBufferCount() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static const size_t HISTORY_SECONDS = 60;
+
+    void AdvanceHistory(Clock::time_point now) const;
+    template <typename F> void Account(F const &update);
+
+    mutable QMutex m_Mutex;
+    FrameDropCounters m_Totals;
+    // the history also moves on when it is read, so seconds without frames show up
+    mutable FrameDropCounters m_CurrentSecond;
+    mutable std::deque<FrameDropCounters> m_History;
+    mutable Clock::time_point m_CurrentSecondStart;
+
+    bool m_HasSequence;
+    uint32_t m_LastSequence;
+    int m_QueuedBuffers;
+    Clock::time_point m_StarvedSince;
+};
+
+#endif // FRAMEDROPSTATISTICS_H
@@ -0,0 +1,70 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#ifndef FRAMELEASE_H
+#define FRAMELEASE_H
+
+#include <cstdint>
+
+class FrameObserver;
+struct UserBuffer;
+
+// A FrameLease keeps a dequeued buffer away from the driver.
+// Copies share the buffer's reference count, the last copy which is
+// released or destroyed hands the buffer back to its FrameObserver for requeuing.
+// A single lease must not be used from several threads at once,
+// distinct copies can be released from any thread.
+class FrameLease
+{
+public:
+    FrameLease();
+    // This constructor takes a new reference on the given buffer
+    //
+    // Parameters:
+    // [in] (FrameObserver *) pOwner - observer which requeues the buffer
+    // [in] (UserBuffer *) pBuffer - buffer holding the reference count
+    // [in] (uint32_t) index - v4l2 index of the buffer
+    FrameLease(FrameObserver *pOwner, UserBuffer *pBuffer, uint32_t index);
+    FrameLease(const FrameLease &other);
+    FrameLease(FrameLease &&other) noexcept;
+    FrameLease& operator=(const FrameLease &other);
+    FrameLease& operator=(FrameLease &&other) noexcept;
+    ~FrameLease();
+
+    // This function gives up this reference, the lease is empty afterwards
+    void Release();
+
+    // Same as Release(), so a lease can be used where a done callback used to be
+    void operator()();
+
+    // This function returns whether the lease holds a buffer
+    explicit operator bool() const;
+
+    // This function returns the v4l2 index of the leased buffer
+    //
+    // Returns:
+    // (uint32_t) - buffer index
+    uint32_t GetIndex() const;
+
+private:
+    FrameObserver *m_pOwner;
+    UserBuffer    *m_pBuffer;
+    uint32_t       m_Index;
+};
+
+#endif // FRAMELEASE_H
@@ -21,9 +21,11 @@
 
 #include "LocalMutex.h"
 #include <QImage>
+#include <QMutex>
 #include <QObject>
 #include <QSharedPointer>
 #include <QThread>
+#include <QWaitCondition>
 
 #include <fcntl.h>
 #include <linux/videodev2.h>
@@ -31,22 +33,119 @@
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 
+#include <atomic>
+#include <chrono>
 #include <functional>
+#include <memory>
 #include <queue>
 #include <vector>
 #include "q_v4l2_ext_ctrl.h"
 #include "V4L2Helper.h"
 #include "FPSCalculator.h"
+#include "FrameDropStatistics.h"
 
+#include "BufferReturnQueue.h"
 #include "BufferWrapper.h"
+#include "CaptureWatchdog.h"
+#include "FrameLease.h"
+#include "RawDataProcessorQueue.h"
+#include "UserBufferTable.h"
 
 #define MAX_VIEWER_USER_BUFFER_COUNT    50
+// a power of two, every buffer fits in at once
+#define BUFFER_RETURN_QUEUE_CAPACITY    64
+
+static_assert(BUFFER_RETURN_QUEUE_CAPACITY >= MAX_VIEWER_USER_BUFFER_COUNT, "the return queue has to hold every buffer");
 
 struct UserBuffer
 {
     uint8_t              *pBuffer;
     size_t                nBufferlength;
-    std::atomic<uint64_t> processMap{0};
+    // memory planes of a multi-plane buffer, the first one is pBuffer
+    uint32_t              nPlaneCount{1};
+    uint8_t              *pPlaneBuffers[VIDEO_MAX_PLANES]{};
+    size_t                nPlaneLengths[VIDEO_MAX_PLANES]{};
+    int                   nDmabufFd{-1};
+    // dmabuf of every memory plane, the first one is nDmabufFd
+    int                   nPlaneDmabufFds[VIDEO_MAX_PLANES]{};
+    uint64_t              nDequeueTimestamp{0};
+    // number of FrameLease objects which keep the buffer away from the driver
+    std::atomic<uint32_t> leaseCount{0};
+    // taken out of circulation by the adaptive pool, it is not requeued anymore
+    std::atomic<bool>     retired{false};
+    // retired and back from the driver and all processors
+    bool                  parked{false};
+    // in the hands of the driver, only the capture thread touches it while streaming
+    bool                  queued{false};
+};
+
+// Limits of the adaptive buffer pool. The pool grows while the driver drops
+// frames or runs out of queued buffers and shrinks again after quiet periods
+// or when it exceeds the memory budget.
+struct BufferPoolPolicy
+{
+    bool     adaptive = false;
+    // the pool never shrinks below this count
+    uint32_t minimumCount = 3;
+    // nor grows above this count
+    uint32_t maximumCount = MAX_VIEWER_USER_BUFFER_COUNT;
+    // maximal memory of the buffers in circulation in bytes, 0 for no limit
+    uint64_t memoryBudget = 0;
+    // buffers added after a second with drops
+    uint32_t growStep = 2;
+    // seconds without drops before a buffer is retired
+    uint32_t quietSeconds = 10;
+};
+
+struct BufferPoolStatistics
+{
+    uint32_t activeCount = 0;       // buffers in circulation
+    uint32_t allocatedCount = 0;    // including retired buffers
+    uint32_t peakCount = 0;         // most buffers in circulation at once
+    uint32_t grownCount = 0;        // times the pool grew
+    uint32_t shrunkCount = 0;       // times the pool shrank
+    uint64_t activeBytes = 0;
+};
+
+// When the buffers given back by the processors are requeued. Without batching
+// a buffer is requeued as soon as the capture thread sees it. With batching the
+// capture thread collects them and requeues them in one pass, and the processors
+// don't wake it up for every buffer. That saves wakeups at high frame rates.
+struct BufferRequeuePolicy
+{
+    bool     batching = false;
+    // requeue as soon as this many buffers are waiting
+    uint32_t batchSize = 8;
+    // nor let a buffer wait longer than this once the capture thread has seen it
+    uint32_t maximumDelayMicroseconds = 2000;
+    // requeue at once when the driver has no more than this many buffers left
+    uint32_t minimumQueued = 2;
+};
+
+// Work of the capture thread since the stream start
+struct CaptureLoopStatistics
+{
+    uint64_t frames = 0;            // dequeued buffers
+    uint64_t wakeups = 0;           // returns of epoll_wait
+    uint64_t dequeueCalls = 0;      // VIDIOC_DQBUF, including the ones finding no buffer
+    uint64_t queueCalls = 0;        // VIDIOC_QBUF
+    uint64_t otherCalls = 0;        // epoll, poll and eventfd calls
+    uint64_t requeueBatches = 0;
+    uint32_t largestBatch = 0;
+    double   wakeupsPerSecond = 0.0;
+    double   syscallsPerFrame = 0.0;
+};
+
+// Speed of the CPU reading captured frames. A frame is read right after its
+// dequeue once a second, like the conversion does, so the numbers show what
+// the memory of the buffers allows, e.g. uncached against cached MMAP buffers.
+struct BufferReadStatistics
+{
+    uint64_t samples = 0;
+    uint64_t bytes = 0;
+    uint64_t nanoseconds = 0;
+    double   lastMegabytesPerSecond = 0.0;
+    double   bestMegabytesPerSecond = 0.0;
 };
 
 class FrameObserver : public QThread
@@ -76,10 +175,11 @@ public:
     int StartStream(bool blockingMode, int fileDescriptor, uint32_t pixelFormat,
                     uint32_t payloadSize, uint32_t width, uint32_t height, uint32_t bytesPerLine,
                     uint32_t enableLogging);
-    // This function stops streaming
+    // This function stops streaming. It returns as soon as the capture thread
+    // has ended and all leases are released, the buffers may be deleted afterwards.
     //
     // Returns:
-    // (int) - result of stream stopping
+    // (int) - result of stream stopping, -1 if the thread or a lease did not finish in time
     int StopStream();
 
     // Get the number of frames
@@ -89,6 +189,67 @@ public:
     // (unsigned int) - received frames count
     double GetReceivedFPS();
 
+    // This function returns the drop accounting of the current stream
+    //
+    // Returns:
+    // (const FrameDropStatistics &) - sequence gap, error and starvation counters
+    const FrameDropStatistics& GetDropStatistics() const;
+    // This function returns the latency histograms of the current stream
+    //
+    // Returns:
+    // (LatencyStatistics &) - histograms of all pipeline stages
+    LatencyStatistics& GetLatencyStatistics();
+
+    // This function sets how the buffer pool adapts while streaming,
+    // the count passed to CreateAllUserBuffer is the start size
+    //
+    // Parameters:
+    // [in] (const BufferPoolPolicy &) policy
+    void SetBufferPoolPolicy(const BufferPoolPolicy &policy);
+    // This function returns the size of the buffer pool of the current stream
+    //
+    // Returns:
+    // (BufferPoolStatistics) - current and peak buffer count
+    BufferPoolStatistics GetBufferPoolStatistics() const;
+
+    // This function sets when released buffers are requeued, it takes effect with the next StartStream
+    //
+    // Parameters:
+    // [in] (const BufferRequeuePolicy &) policy
+    void SetBufferRequeuePolicy(const BufferRequeuePolicy &policy);
+    // This function returns the syscalls and wakeups of the capture thread
+    //
+    // Returns:
+    // (CaptureLoopStatistics) - counters and rates of the current stream
+    CaptureLoopStatistics GetCaptureLoopStatistics() const;
+
+    // This function sets when the capture thread restarts a failing stream
+    //
+    // Parameters:
+    // [in] (const CaptureWatchdogPolicy &) policy
+    void SetCaptureWatchdogPolicy(const CaptureWatchdogPolicy &policy);
+    // This function sets the configured frame interval, the stall timeout is derived from it
+    //
+    // Parameters:
+    // [in] (uint64_t) microseconds - 0 if unknown
+    void SetFrameInterval(uint64_t microseconds);
+    // This function returns the supervision of the current stream
+    //
+    // Returns:
+    // (const CaptureWatchdog &) - incidents and recovery counters
+    const CaptureWatchdog& GetCaptureWatchdog() const;
+
+    // This function switches the sampling of the buffer read speed on or off
+    //
+    // Parameters:
+    // [in] (bool) enable
+    void SetReadBandwidthSampling(bool enable);
+    // This function returns the sampled read speed of the current stream
+    //
+    // Returns:
+    // (BufferReadStatistics) - samples and speed
+    BufferReadStatistics GetBufferReadStatistics() const;
+
     // This function sets file descriptor
     //
     // Parameters:
@@ -135,11 +296,69 @@ public:
     // [in] (bool) showFrames
     void SwitchFrameTransfer2GUI(bool showFrames);
 
-    using DataProcessorDoneCallback = std::function<void()>;
-    using DataProcessorFunc = std::function<void(BufferWrapper const&, DataProcessorDoneCallback)>;
-    int AddRawDataProcessor(DataProcessorFunc processor);
+    // This function wakes up the capture thread, e.g. to let it notice
+    // a stop or reconfiguration request without waiting for the next frame
+    void WakeCaptureThread();
+
+    // Processors get a lease on the buffer. They may keep (a copy of) it as long as
+    // they need the data, the buffer is requeued once all leases are released.
+    using DataProcessorDoneCallback = FrameLease;
+    using DataProcessorFunc = std::function<void(BufferWrapper const&, FrameLease)>;
+    // This function registers a raw data processor
+    //
+    // Parameters:
+    // [in] (DataProcessorFunc) processor - function which consumes the frames
+    // [in] (PROCESSOR_QUEUE_POLICY) policy - synchronous on the capture thread or queued to an own thread
+    // [in] (uint32_t) queueDepth - maximum number of frames waiting for the processor
+    //
+    // Returns:
+    // (int) - index of the processor
+    int AddRawDataProcessor(DataProcessorFunc processor,
+                            PROCESSOR_QUEUE_POLICY policy = PROCESSOR_QUEUE_SYNCHRONOUS,
+                            uint32_t queueDepth = 1);
+    // This function returns queue depth and drop counters of a raw data processor
+    //
+    // Parameters:
+    // [in] (int) index - index returned by AddRawDataProcessor
+    // [out] (RawDataProcessorStatistics &) statistics - current statistics
+    //
+    // Returns:
+    // (int) - -1 if there is no processor with the given index
+    int GetRawDataProcessorStatistics(int index, RawDataProcessorStatistics &statistics) const;
+    // This function returns the number of registered raw data processors
+    //
+    // Returns:
+    // (int) - number of processors
+    int GetRawDataProcessorCount() const;
 
 protected:
+    friend class FrameLease;
+
+    // This function is called when the last lease of a buffer has been released.
+    // It may run on any thread and only hands the index to the capture thread.
+    //
+    // Parameters:
+    // [in] (uint32_t) index - index of the buffer
+    void ReleaseBuffer(uint32_t index);
+    // This function takes the buffers out of the return queue and requeues them
+    // if the requeue policy says so, it runs on the capture thread
+    void ReturnReleasedBuffers();
+    // This function requeues the collected buffers in one pass
+    void RequeuePendingBuffers();
+    // This function returns how long the capture thread may wait for the next event
+    //
+    // Parameters:
+    // [in] (int) timeoutMs - longest wait without requeue batching
+    //
+    // Returns:
+    // (int) - wait in ms, short enough to requeue the collected buffers in time
+    int GetRequeueWaitTimeout(int timeoutMs) const;
+    // This function requeues a buffer or parks it if the pool retired it
+    //
+    // Parameters:
+    // [in] (uint32_t) index - index of the buffer
+    void RecycleBuffer(uint32_t index);
+
     // v4l2
     // This function reads frame
     //
@@ -159,6 +378,23 @@ protected:
     // Returns:
     // (int) - result of getting data
     virtual int GetFrameData(const v4l2_buffer &buf, uint8_t *&buffer, uint32_t &length) const = 0;
+    // This function reads the memory planes of the current format, the I/O
+    // methods call it before creating their buffers
+    //
+    // Returns:
+    // (int) - result of VIDIOC_G_FMT
+    int ReadPlaneFormats();
+    // This function points the colour planes of a frame into the memory planes
+    // of its buffer, planar formats are not copied
+    //
+    // Parameters:
+    // [in] (const v4l2_buffer &) buf - dequeued buffer
+    // [in] (const UserBuffer *) pUserBuffer - buffer the frame was captured to
+    // [in] (uint8_t *) buffer - first memory plane as returned by GetFrameData
+    // [in] (uint32_t) length - length of the first memory plane
+    // [out] (BufferWrapper &) wrapper - frame description to fill
+    void DescribePlanes(const v4l2_buffer &buf, const UserBuffer *pUserBuffer,
+                        uint8_t *buffer, uint32_t length, BufferWrapper &wrapper) const;
     // This function process frame from the buffer given in parameter
     //
     // Parameters:
@@ -168,15 +404,112 @@ protected:
     // (int) - result of frame processing
     int ProcessFrame(v4l2_buffer &buf);
     // This function dequeues and process current frame
-    void DequeueAndProcessFrame();
+    //
+    // Returns:
+    // (bool) - true if a buffer has been dequeued, false if none was ready
+    bool DequeueAndProcessFrame();
+    // This function dequeues and processes all buffers which are ready
+    void DrainReadyFrames();
+    // This function checks without blocking if the driver has a buffer ready
+    //
+    // Returns:
+    // (bool) - true if a buffer can be dequeued
+    bool IsFrameReady() const;
+    // This function waits until no processor holds a lease on a buffer anymore
+    //
+    // Parameters:
+    // [in] (int) timeoutMs - maximal time to wait
+    //
+    // Returns:
+    // (bool) - true if all buffers are released
+    bool WaitForLeasesReleased(int timeoutMs);
+    // This function enables/disables epoll notifications for the video device
+    //
+    // Parameters:
+    // [in] (int) operation - EPOLL_CTL_ADD, EPOLL_CTL_MOD or EPOLL_CTL_DEL
+    // [in] (uint32_t) events - epoll events to wait for
+    //
+    // Returns:
+    // (int) - result of epoll_ctl
+    int ControlDeviceEvents(int operation, uint32_t events);
+
+    // This function adds buffers to the running stream with VIDIOC_CREATE_BUFS.
+    // The new buffers are appended to m_UserBufferContainerList, but not queued.
+    //
+    // Parameters:
+    // [in] (uint32_t) bufferCount - number of buffers to add
+    //
+    // Returns:
+    // (int) - number of buffers added, -1 if the I/O method can't add buffers
+    virtual int AddUserBuffers(uint32_t bufferCount);
+    // This function gives the memory of a parked buffer back as far as the I/O method allows
+    //
+    // Parameters:
+    // [in] (uint32_t) index - index of the buffer
+    virtual void DiscardUserBuffer(uint32_t index);
+    // This function frees a buffer which the driver has removed
+    //
+    // Parameters:
+    // [in] (UserBuffer *) pBuffer - buffer to free
+    virtual void DeleteUserBuffer(UserBuffer *pBuffer);
+    // This function grows or shrinks the pool according to the last second
+    // of the drop statistics, it runs on the capture thread once a second
+    void AdaptBufferPool();
+    // This function brings retired buffers back or adds new ones
+    //
+    // Parameters:
+    // [in] (uint32_t) bufferCount - number of buffers to add to the circulation
+    void GrowBufferPool(uint32_t bufferCount);
+    // This function retires the buffers with the highest indices
+    //
+    // Parameters:
+    // [in] (uint32_t) bufferCount - number of buffers to take out of the circulation
+    void ShrinkBufferPool(uint32_t bufferCount);
+    // This function removes parked buffers at the end of the pool from the driver
+    void RemoveParkedBuffers();
+
+    // This function reads a dequeued frame and measures how long it takes,
+    // at most once a second
+    //
+    // Parameters:
+    // [in] (const uint8_t *) pData - first memory plane
+    // [in] (size_t) length - bytes of the plane
+    void SampleReadBandwidth(const uint8_t *pData, size_t length);
+
+    // This function asks the watchdog whether the stream stalls or only delivers
+    // errors and restarts it if so, it runs on the capture thread after every wakeup
+    void SuperviseCapture();
+    // This function restarts the stream without giving up the buffers:
+    // VIDIOC_STREAMOFF, requeue of all buffers no processor holds, VIDIOC_STREAMON
+    //
+    // Parameters:
+    // [in] (CAPTURE_INCIDENT_TYPE) type - reason of the restart
+    // [in] (uint64_t) detected - time the incident was detected
+    void RecoverStream(CAPTURE_INCIDENT_TYPE type, uint64_t detected);
+    // This function stops the device like VIDIOC_STREAMOFF, all queued buffers return to us
+    //
+    // Returns:
+    // (int) - result of stopping
+    virtual int StopDeviceStream();
+    // This function starts the device again like VIDIOC_STREAMON
+    //
+    // Returns:
+    // (int) - result of starting
+    virtual int StartDeviceStream();
 
     // This function does the work within this thread
     virtual void run();
 
 protected:
     FPSCalculator m_ReceivedFPS;
+    // derived classes report every successful VIDIOC_QBUF here
+    FrameDropStatistics m_DropStatistics;
+    LatencyStatistics m_LatencyStatistics;
+    CaptureWatchdog m_Watchdog;
 
     int m_nFileDescriptor;
+    int m_EpollFileDescriptor;
+    int m_WakeupFileDescriptor;
     v4l2_buf_type m_BufferType;
     uint32_t m_PixelFormat;
     uint32_t m_nWidth;
@@ -184,22 +517,75 @@ protected:
     uint32_t m_PayloadSize;
     uint32_t m_RealPayloadSize;
     uint32_t m_BytesPerLine;
+    // memory planes of the format, a single one for single-plane devices
+    uint32_t m_MemoryPlaneCount;
+    v4l2_plane_pix_format m_PlaneFormats[VIDEO_MAX_PLANES];
+    // filled by VIDIOC_DQBUF on the capture thread, valid until the next dequeue
+    v4l2_plane m_DequeuePlanes[VIDEO_MAX_PLANES];
     uint64_t m_FrameId;
+    // also reported to the watchdog, which counts the failures
     uint32_t m_DQBUF_last_errno;
 
     bool m_MessageSendFlag;
     bool m_BlockingMode;
-    bool m_IsStreamRunning;
-    bool m_bStreamStopped;
+    std::atomic<bool> m_IsStreamRunning;
 
     uint32_t m_EnableLogging;
 
     bool m_ShowFrames;
 
-    std::vector<UserBuffer*>              m_UserBufferContainerList;
+    // looked up without a lock, m_UsedBufferMutex serializes its changes
+    UserBufferTable<MAX_VIEWER_USER_BUFFER_COUNT> m_UserBufferContainerList;
     mutable base::LocalMutex              m_UsedBufferMutex;
 
-    std::list<DataProcessorFunc> m_rawDataProcessors;
+    // buffers released by the processors, the capture thread requeues them
+    BufferReturnQueue<BUFFER_RETURN_QUEUE_CAPACITY> m_ReturnedBuffers;
+    // a wakeup for the return queue is on its way
+    std::atomic<bool>                     m_ReturnWakeupPending;
+    // buffers the driver has, maintained by the capture thread and read by the releasing threads
+    std::atomic<int>                      m_DriverBufferCount;
+    // releasing threads wake the capture thread while the driver has no more buffers than this
+    std::atomic<int>                      m_ReturnWakeupThreshold;
+    BufferRequeuePolicy                   m_RequestedRequeuePolicy;
+    // copied from m_RequestedRequeuePolicy at stream start, read by the capture thread only
+    BufferRequeuePolicy                   m_RequeuePolicy;
+    std::vector<uint32_t>                 m_PendingRequeue;
+    uint64_t                              m_OldestPendingRequeue;
+
+    // capture loop counters, written by the capture thread except for the wakeup writes.
+    // Start and end are steady clock nanoseconds, so the statistics can read them at any time.
+    std::atomic<int64_t>                  m_CaptureLoopStart;
+    // set when the capture thread ends, the rates refer to the time in between
+    std::atomic<int64_t>                  m_CaptureLoopEnd;
+    std::atomic<uint64_t>                 m_LoopFrames;
+    std::atomic<uint64_t>                 m_LoopWakeups;
+    std::atomic<uint64_t>                 m_DequeueCalls;
+    std::atomic<uint64_t>                 m_QueueCalls;
+    mutable std::atomic<uint64_t>         m_OtherCalls;
+    std::atomic<uint64_t>                 m_RequeueBatches;
+    std::atomic<uint32_t>                 m_LargestRequeueBatch;
+
+    // signalled whenever the last lease of a buffer is released while somebody waits
+    QMutex                                m_LeaseMutex;
+    QWaitCondition                        m_LeasesReleased;
+    std::atomic<bool>                     m_WaitingForLeases;
+
+    // protects retiring, parking and growing the buffers and the pool statistics
+    mutable QMutex                        m_PoolMutex;
+    BufferPoolPolicy                      m_BufferPoolPolicy;
+    BufferPoolStatistics                  m_BufferPoolStatistics;
+    std::chrono::steady_clock::time_point m_LastPoolAdaption;
+    uint32_t                              m_QuietSeconds;
+    bool                                  m_CanRemoveBuffers;
+
+    std::vector<std::unique_ptr<RawDataProcessorQueue>> m_rawDataProcessors;
+
+    std::atomic<bool>                     m_SampleReadBandwidth;
+    std::chrono::steady_clock::time_point m_LastReadSample;
+    mutable QMutex                        m_ReadStatisticsMutex;
+    BufferReadStatistics                  m_ReadStatistics;
+    // keeps the compiler from dropping the measured reads
+    std::atomic<uint64_t>                 m_ReadChecksum;
 };
 
 #endif /* FRAMEOBSERVER_H */
@@ -0,0 +1,145 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#ifndef FRAMEOBSERVERDMABUF_H
+#define FRAMEOBSERVERDMABUF_H
+
+#include "FrameObserver.h"
+
+#include <vector>
+
+// Export: the driver allocates MMAP buffers which are exported with VIDIOC_EXPBUF
+// Import: the driver writes into dmabufs given to it with V4L2_MEMORY_DMABUF
+enum DMABUF_MODE_TYPE
+{
+    DMABUF_MODE_EXPORT,
+    DMABUF_MODE_IMPORT,
+};
+
+class FrameObserverDMABUF : public FrameObserver
+{
+  public:
+    // We pass the camera that will deliver the frames to the constructor
+    FrameObserverDMABUF(bool showFrames, DMABUF_MODE_TYPE mode);
+
+    virtual ~FrameObserverDMABUF();
+
+    // This function sets the dmabufs which are used in import mode.
+    // The file descriptors stay owned by the caller. If there are fewer
+    // descriptors than buffers, the rest is allocated with udmabuf.
+    //
+    // Parameters:
+    // [in] (const std::vector<int> &) fileDescriptors - dmabuf file descriptors
+    void SetImportFileDescriptors(const std::vector<int> &fileDescriptors);
+
+    // This function creates all user buffer
+    //
+    // Parameters:
+    // [in] (uint32_t) bufferCount
+    // [in] (uint32_t) bufferSize
+    //
+    // Returns:
+    // (int) - result of the buffer creation
+    virtual int CreateAllUserBuffer(uint32_t bufferCount, uint32_t bufferSize);
+    // This function queues all user buffer
+    //
+    // Returns:
+    // (int) - result of the buffer queuing
+    virtual int QueueAllUserBuffer();
+    // This function queues single user buffer
+    //
+    // Parameters:
+    // [in] (const int) index - index of the buffer
+    //
+    // Returns:
+    // (int) - result of the buffer queuing
+    virtual int QueueSingleUserBuffer(const int index);
+    // This function removes all user buffer
+    //
+    // Returns:
+    // (int) - result of the buffer removal
+    virtual int DeleteAllUserBuffer();
+
+protected:
+    // v4l2
+    // This function reads frame
+    //
+    // Parameters:
+    // [in] (v4l2_buffer &) buf - buffer of the frame
+    //
+    // Returns:
+    // (int) - result of frame reading
+    virtual int ReadFrame(v4l2_buffer &buf);
+    // This function returns frame data
+    //
+    // Parameters:
+    // [in] (v4l2_buffer &) buf
+    // [in] (uint8_t *&) buffer
+    // [in] (uint32_t &) length - length of the buffer
+    //
+    // Returns:
+    // (int) - result of getting data
+    virtual int GetFrameData(const v4l2_buffer &buf, uint8_t *&buffer, uint32_t &length) const;
+
+private:
+    // This function exports the MMAP buffer with the given index as dmabuf
+    //
+    // Parameters:
+    // [in] (uint32_t) index - index of the buffer
+    // [in] (UserBuffer *) pBuffer - buffer which receives mapping and file descriptor
+    //
+    // Returns:
+    // (int) - result of the export
+    int ExportBuffer(uint32_t index, UserBuffer *pBuffer);
+    // This function prepares a dmabuf for import, either a given one or a new udmabuf.
+    // Multi-plane formats get a udmabuf per memory plane, given dmabufs only carry one plane.
+    //
+    // Parameters:
+    // [in] (uint32_t) index - index of the buffer
+    // [in] (uint32_t) bufferSize - minimal size of a single-plane buffer
+    // [in] (UserBuffer *) pBuffer - buffer which receives mapping and file descriptor
+    //
+    // Returns:
+    // (int) - result of the preparation
+    int PrepareImportBuffer(uint32_t index, uint32_t bufferSize, UserBuffer *pBuffer);
+    // This function allocates a dmabuf from a sealed memfd through /dev/udmabuf
+    //
+    // Parameters:
+    // [in] (size_t) size - size of the buffer, page aligned
+    // [out] (int &) memFileDescriptor - memfd backing the dmabuf
+    //
+    // Returns:
+    // (int) - dmabuf file descriptor or -1
+    static int AllocateLocalDmabuf(size_t size, int &memFileDescriptor);
+    // This function fills the memory dependent members of the given buffer
+    //
+    // Parameters:
+    // [in] (v4l2_buffer &) buf - buffer to fill
+    // [in] (v4l2_plane *) pPlanes - VIDEO_MAX_PLANES planes for multi-plane devices
+    // [in] (uint32_t) index - index of the buffer
+    void PrepareBuffer(v4l2_buffer &buf, v4l2_plane *pPlanes, uint32_t index) const;
+
+    DMABUF_MODE_TYPE m_Mode;
+    v4l2_memory      m_Memory;
+
+    std::vector<int> m_ImportFileDescriptors;
+    // dmabufs and memfds allocated by us, closed in DeleteAllUserBuffer
+    std::vector<int> m_OwnedFileDescriptors;
+};
+
+#endif // FRAMEOBSERVERDMABUF_H
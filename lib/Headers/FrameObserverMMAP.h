@@ -21,6 +21,20 @@
 
 #include "FrameObserver.h"
 
+#include <string>
+
+enum MMAP_CACHE_MODE
+{
+    // buffers as the driver allocates them, uncached on many ARM SoCs
+    MMAP_CACHE_COHERENT,
+    // cached buffers, the kernel invalidates the caches when a buffer is
+    // dequeued and skips cleaning them on queue as the CPU doesn't write frames
+    MMAP_CACHE_NON_COHERENT,
+    // cached buffers without any cache maintenance, the CPU may see stale
+    // data, only for streams whose frames the CPU doesn't look at
+    MMAP_CACHE_NON_COHERENT_NO_SYNC,
+};
+
 class FrameObserverMMAP : public FrameObserver
 {
   public:
@@ -29,6 +43,34 @@ class FrameObserverMMAP : public FrameObserver
 
     virtual ~FrameObserverMMAP();
 
+    // This function selects the memory of the buffers, it takes effect with the next CreateAllUserBuffer
+    //
+    // Parameters:
+    // [in] (MMAP_CACHE_MODE) mode - requested mode, the driver may only support coherent buffers
+    void SetCacheMode(MMAP_CACHE_MODE mode);
+    // This function returns the mode the driver has granted
+    //
+    // Returns:
+    // (MMAP_CACHE_MODE) - mode of the current buffers
+    MMAP_CACHE_MODE GetCacheMode() const;
+    // This function returns the name of a mode as used on the command line
+    //
+    // Parameters:
+    // [in] (MMAP_CACHE_MODE) mode
+    //
+    // Returns:
+    // (const char *) - coherent, non-coherent or no-sync
+    static const char* GetCacheModeName(MMAP_CACHE_MODE mode);
+    // This function parses the name of a mode
+    //
+    // Parameters:
+    // [in] (const std::string &) name - coherent, non-coherent or no-sync
+    // [out] (MMAP_CACHE_MODE &) mode
+    //
+    // Returns:
+    // (int) - -1 if the name is unknown
+    static int ParseCacheMode(const std::string &name, MMAP_CACHE_MODE &mode);
+
     // This function creates all user buffer
     //
     // Parameters:
@@ -77,9 +119,40 @@ protected:
     // Returns:
     // (int) - result of getting data
     virtual int GetFrameData(const v4l2_buffer &buf, uint8_t *&buffer, uint32_t &length) const;
+    // This function adds buffers to the running stream
+    //
+    // Parameters:
+    // [in] (uint32_t) bufferCount - number of buffers to add
+    //
+    // Returns:
+    // (int) - number of buffers added, -1 on error
+    virtual int AddUserBuffers(uint32_t bufferCount);
+    // This function unmaps and frees a buffer which the driver has removed
+    //
+    // Parameters:
+    // [in] (UserBuffer *) pBuffer - buffer to free
+    virtual void DeleteUserBuffer(UserBuffer *pBuffer);
 
 private:
+    // This function remembers which memory the driver has allocated
+    //
+    // Parameters:
+    // [in] (uint32_t) capabilities - capabilities returned by VIDIOC_REQBUFS
+    // [in] (uint32_t) flags - memory flags returned by VIDIOC_REQBUFS
+    void AcceptCacheMode(uint32_t capabilities, uint32_t flags);
+    // This function queries and maps a buffer of the driver
+    //
+    // Parameters:
+    // [in] (uint32_t) index - index of the buffer
+    //
+    // Returns:
+    // (UserBuffer *) - mapped buffer or NULL on error
+    UserBuffer* MapUserBuffer(uint32_t index);
 
+    MMAP_CACHE_MODE m_RequestedCacheMode;
+    MMAP_CACHE_MODE m_CacheMode;
+    // V4L2_BUF_FLAG_NO_CACHE_* of the mode, set on every VIDIOC_QBUF
+    uint32_t m_QueueFlags;
 };
 
 #endif // FRAMEOBSERVERMMAP_H
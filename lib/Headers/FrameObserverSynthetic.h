@@ -0,0 +1,244 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#ifndef FRAMEOBSERVERSYNTHETIC_H
+#define FRAMEOBSERVERSYNTHETIC_H
+
+#include "FrameObserver.h"
+
+#include <QMutex>
+
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum SYNTHETIC_PATTERN_TYPE
+{
+    // colour bars moving by one bar over the frame bank, gray ramp below
+    SYNTHETIC_PATTERN_BARS,
+    // static red/green ramps, blue changes with every frame
+    SYNTHETIC_PATTERN_GRADIENT,
+    // pseudo random pixels, a different image for every frame of the bank
+    SYNTHETIC_PATTERN_NOISE,
+};
+
+// Frame source without a device, used to benchmark the pipeline reproducibly.
+// A generator thread plays the driver: at the configured rate it fills the next
+// queued buffer with a test pattern or a frame of a raw file, stamps it with
+// CLOCK_MONOTONIC and a sequence number and signals an eventfd. The eventfd is
+// handed to StartStream as device file descriptor, so the capture thread,
+// processors and leases run exactly like with a camera. If no buffer is queued
+// when a frame is due, the frame is lost and the sequence number shows the gap.
+class FrameObserverSynthetic : public FrameObserver
+{
+  public:
+    FrameObserverSynthetic(bool showFrames);
+
+    virtual ~FrameObserverSynthetic();
+
+    // This function returns the line and frame size of a pixel format
+    //
+    // Parameters:
+    // [in] (uint32_t) pixelFormat
+    // [in] (uint32_t) width - width of the frame
+    // [in] (uint32_t) height - height of the frame
+    // [out] (uint32_t &) bytesPerLine
+    // [out] (uint32_t &) payloadSize - maximal size of a frame
+    //
+    // Returns:
+    // (int) - -1 if the format can't be generated in this size
+    static int GetFrameLayout(uint32_t pixelFormat, uint32_t width, uint32_t height,
+                              uint32_t &bytesPerLine, uint32_t &payloadSize);
+
+    // This function sets the format of the generated frames
+    //
+    // Parameters:
+    // [in] (uint32_t) pixelFormat - one of the formats ImageTransform can convert
+    // [in] (uint32_t) width - width of the frame
+    // [in] (uint32_t) height - height of the frame
+    //
+    // Returns:
+    // (int) - result of setting the format
+    int SetFormat(uint32_t pixelFormat, uint32_t width, uint32_t height);
+    // This function sets the frame rate
+    //
+    // Parameters:
+    // [in] (double) framesPerSecond
+    void SetFrameRate(double framesPerSecond);
+    // This function selects the test pattern, it is used if no replay file is set
+    //
+    // Parameters:
+    // [in] (SYNTHETIC_PATTERN_TYPE) pattern
+    void SetPattern(SYNTHETIC_PATTERN_TYPE pattern);
+    // This function sets a file of raw frames in the current format which are
+    // replayed in a loop instead of the test pattern, an empty name disables replay
+    //
+    // Parameters:
+    // [in] (const std::string &) fileName
+    void SetReplayFile(const std::string &fileName);
+
+    // This function returns the file descriptor which becomes readable
+    // for every finished frame, pass it to StartStream
+    //
+    // Returns:
+    // (int) - eventfd of the generator
+    int GetFileDescriptor() const;
+
+    // This function starts the generator, the counterpart of VIDIOC_STREAMON
+    //
+    // Returns:
+    // (int) - result of starting
+    int StartGenerator();
+    // This function stops the generator, the counterpart of VIDIOC_STREAMOFF.
+    // Frames which have not been dequeued yet are discarded.
+    void StopGenerator();
+
+    // This function creates all user buffer and renders the frames to replay
+    //
+    // Parameters:
+    // [in] (uint32_t) bufferCount
+    // [in] (uint32_t) bufferSize
+    //
+    // Returns:
+    // (int) - result of the buffer creation
+    virtual int CreateAllUserBuffer(uint32_t bufferCount, uint32_t bufferSize);
+    // This function queues all user buffer
+    //
+    // Returns:
+    // (int) - result of the buffer queuing
+    virtual int QueueAllUserBuffer();
+    // This function queues single user buffer
+    //
+    // Parameters:
+    // [in] (const int) index - index of the buffer
+    //
+    // Returns:
+    // (int) - result of the buffer queuing
+    virtual int QueueSingleUserBuffer(const int index);
+    // This function removes all user buffer
+    //
+    // Returns:
+    // (int) - result of the buffer removal
+    virtual int DeleteAllUserBuffer();
+
+protected:
+    // This function reads frame
+    //
+    // Parameters:
+    // [in] (v4l2_buffer &) buf - buffer of the frame
+    //
+    // Returns:
+    // (int) - result of frame reading, -1 with errno EAGAIN if no frame is ready
+    virtual int ReadFrame(v4l2_buffer &buf);
+    // This function returns frame data
+    //
+    // Parameters:
+    // [in] (v4l2_buffer &) buf
+    // [in] (uint8_t *&) buffer
+    // [in] (uint32_t &) length - length of the buffer
+    //
+    // Returns:
+    // (int) - result of getting data
+    virtual int GetFrameData(const v4l2_buffer &buf, uint8_t *&buffer, uint32_t &length) const;
+    // This function adds buffers to the running stream, the generator
+    // takes them like VIDIOC_CREATE_BUFS buffers once they are queued
+    //
+    // Parameters:
+    // [in] (uint32_t) bufferCount - number of buffers to add
+    //
+    // Returns:
+    // (int) - number of buffers added, -1 on error
+    virtual int AddUserBuffers(uint32_t bufferCount);
+    // This function frees a removed buffer
+    //
+    // Parameters:
+    // [in] (UserBuffer *) pBuffer - buffer to free
+    virtual void DeleteUserBuffer(UserBuffer *pBuffer);
+    // This function stops the generator when the watchdog restarts the stream
+    //
+    // Returns:
+    // (int) - result of stopping
+    virtual int StopDeviceStream();
+    // This function starts the generator again when the watchdog restarts the stream
+    //
+    // Returns:
+    // (int) - result of starting
+    virtual int StartDeviceStream();
+
+private:
+    struct SourceFrame
+    {
+        std::vector<uint8_t> data;
+        uint32_t             bytesUsed;
+    };
+
+    struct FinishedFrame
+    {
+        uint32_t index;
+        uint32_t sequence;
+        uint32_t bytesUsed;
+        uint64_t timestamp;
+    };
+
+    // This function renders the test pattern or loads the replay file
+    //
+    // Parameters:
+    // [in] (uint32_t) bufferSize - size of the buffers
+    //
+    // Returns:
+    // (int) - result of preparing the source frames
+    int PrepareSourceFrames(uint32_t bufferSize);
+    // This function loads the frames of the replay file
+    //
+    // Parameters:
+    // [in] (uint32_t) maxFrameCount - maximal number of frames to keep in memory
+    //
+    // Returns:
+    // (int) - result of loading
+    int LoadReplayFile(uint32_t maxFrameCount);
+
+    // This function does the work of the generator thread
+    void GeneratorMain();
+    // This function fills the next queued buffer, if there is one
+    void ProduceFrame();
+
+    uint32_t m_GeneratedWidth;
+    uint32_t m_GeneratedHeight;
+    uint32_t m_GeneratedPixelFormat;
+    uint32_t m_GeneratedBytesPerLine;
+    uint32_t m_GeneratedPayloadSize;
+    double m_FramesPerSecond;
+    SYNTHETIC_PATTERN_TYPE m_Pattern;
+    std::string m_ReplayFileName;
+
+    std::vector<SourceFrame> m_SourceFrames;
+
+    int m_FrameReadyFileDescriptor;
+    int m_TimerFileDescriptor;
+    int m_StopFileDescriptor;
+    std::unique_ptr<std::thread> m_pGeneratorThread;
+
+    // protects the buffer queues shared with the generator
+    QMutex m_GeneratorMutex;
+    std::deque<uint32_t> m_QueuedBuffers;
+    std::deque<FinishedFrame> m_FinishedFrames;
+    uint32_t m_Sequence;
+};
+
+#endif // FRAMEOBSERVERSYNTHETIC_H
@@ -20,6 +20,7 @@
 #define FRAMEOBSERVERUSER_H
 
 #include "FrameObserver.h"
+#include "UserBufferPool.h"
 
 class FrameObserverUSER : public FrameObserver
 {
@@ -29,6 +30,13 @@ class FrameObserverUSER : public FrameObserver
 
     virtual ~FrameObserverUSER();
 
+    // This function configures the memory of the buffers created next
+    //
+    // Parameters:
+    // [in] (bool) hugePages - back the buffers with huge pages
+    // [in] (bool) lockMemory - lock the buffers in memory
+    void SetBufferPoolOptions(bool hugePages, bool lockMemory);
+
     // This function creates all user buffer
     //
     // Parameters:
@@ -77,8 +85,34 @@ protected:
     // Returns:
     // (int) - result of getting data
     virtual int GetFrameData(const v4l2_buffer &buf, uint8_t *&buffer, uint32_t &length) const;
+    // This function adds buffers to the running stream
+    //
+    // Parameters:
+    // [in] (uint32_t) bufferCount - number of buffers to add
+    //
+    // Returns:
+    // (int) - number of buffers added, -1 on error
+    virtual int AddUserBuffers(uint32_t bufferCount);
+    // This function gives the pages of a parked buffer back to the system
+    //
+    // Parameters:
+    // [in] (uint32_t) index - index of the buffer
+    virtual void DiscardUserBuffer(uint32_t index);
 
 private:
+    // This function creates the user buffer of a pool buffer
+    //
+    // Parameters:
+    // [in] (uint32_t) index - index of the buffer
+    //
+    // Returns:
+    // (UserBuffer *) - buffer with its memory planes assigned
+    UserBuffer* CreateUserBuffer(uint32_t index) const;
+
+    UserBufferPool m_BufferPool;
+    // position and size of the memory planes within a pool buffer
+    size_t m_PlaneOffsets[VIDEO_MAX_PLANES];
+    size_t m_PlaneLengths[VIDEO_MAX_PLANES];
 };
 
 #endif // FRAMEOBSERVERUSER_H
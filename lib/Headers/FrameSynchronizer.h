@@ -0,0 +1,185 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#ifndef FRAMESYNCHRONIZER_H
+#define FRAMESYNCHRONIZER_H
+
+#include "BufferWrapper.h"
+#include "FrameLease.h"
+
+#include <QMutex>
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+class FrameObserver;
+
+struct SynchronizedFrame
+{
+    // index returned by AddStream
+    int           stream;
+    BufferWrapper buffer;
+    FrameLease    lease;
+};
+
+struct FrameSynchronizerStatistics
+{
+    uint64_t received = 0;
+    // frames which became part of a set
+    uint64_t matched = 0;
+    // dropped because no other stream had a frame within the tolerance
+    uint64_t unmatched = 0;
+    // arrived after the sets of their time had been emitted already
+    uint64_t late = 0;
+    // pushed out of a full queue while waiting for a lagging stream
+    uint64_t evicted = 0;
+};
+
+// Groups the frames of several streams by their driver timestamps. A set is
+// complete when every active stream has a frame and all of them lie within
+// the tolerance of the newest one. Streams which deliver no frames anymore
+// are switched inactive, so they don't hold back the others. Frames which can no longer be matched are
+// dropped right away and every stream waits with a bounded queue, so a
+// lagging camera holds at most queueDepth buffers of each of the others.
+//
+// The timestamps of all streams must come from the same clock, frames
+// without a CLOCK_MONOTONIC driver timestamp are matched by their dequeue time.
+class FrameSynchronizer
+{
+public:
+    // Receives a matched set, one frame per active stream in the order of AddStream.
+    // It is called on the capture thread which completed the set and the
+    // sets arrive in order. Processors which need the frames longer keep
+    // copies of the leases.
+    using SetProcessorFunc = std::function<void(std::vector<SynchronizedFrame> const&)>;
+
+    // Parameters:
+    // [in] (uint64_t) toleranceMicroseconds - largest time difference within a set
+    // [in] (uint32_t) queueDepth - maximum number of frames waiting per stream
+    FrameSynchronizer(uint64_t toleranceMicroseconds, uint32_t queueDepth);
+    ~FrameSynchronizer();
+
+    FrameSynchronizer(const FrameSynchronizer &) = delete;
+    FrameSynchronizer& operator=(const FrameSynchronizer &) = delete;
+
+    // This function registers a raw data processor on the observer which
+    // feeds its frames into the synchronizer. All streams have to be added
+    // before streaming starts and the synchronizer has to outlive the streams.
+    //
+    // Parameters:
+    // [in] (FrameObserver *) pObserver - observer of the stream
+    //
+    // Returns:
+    // (int) - index of the stream, see SynchronizedFrame::stream
+    int AddStream(FrameObserver *pObserver);
+    // This function registers a stream which is fed with Push
+    //
+    // Returns:
+    // (int) - index of the stream, see SynchronizedFrame::stream
+    int AddStream();
+    // This function registers a consumer of the matched sets
+    //
+    // Parameters:
+    // [in] (SetProcessorFunc) processor
+    void AddSetProcessor(SetProcessorFunc processor);
+
+    // This function adds a frame of a stream and emits the sets it completes
+    //
+    // Parameters:
+    // [in] (int) stream - index returned by AddStream
+    // [in] (BufferWrapper const &) buffer - frame description
+    // [in] (FrameLease) lease - lease which keeps the frame alive
+    void Push(int stream, BufferWrapper const& buffer, FrameLease lease);
+    // This function drops all waiting frames and thereby releases their leases
+    void Flush();
+    // This function takes a stream out of the sets or back in. The frames
+    // waiting for an inactive stream are released and its pushed frames
+    // are dropped, the others complete their sets with their next frame.
+    //
+    // Parameters:
+    // [in] (int) stream - index returned by AddStream
+    // [in] (bool) active
+    void SetStreamActive(int stream, bool active);
+    // This function switches the matching on and off. Switched off, waiting
+    // frames are dropped and pushed frames released right away, so the
+    // streams can be stopped one after the other.
+    //
+    // Parameters:
+    // [in] (bool) active
+    void SetActive(bool active);
+
+    // This function returns the counters of a stream
+    //
+    // Parameters:
+    // [in] (int) stream - index returned by AddStream
+    //
+    // Returns:
+    // (FrameSynchronizerStatistics) - counters since the last reset
+    FrameSynchronizerStatistics GetStatistics(int stream) const;
+    // This function returns the number of emitted sets
+    //
+    // Returns:
+    // (uint64_t) - sets since the last reset
+    uint64_t GetSetCount() const;
+    // This function returns the largest time difference within an emitted set
+    //
+    // Returns:
+    // (uint64_t) - microseconds
+    uint64_t GetMaxSkew() const;
+    // This function resets all counters
+    void ResetStatistics();
+
+private:
+    struct PendingFrame
+    {
+        SynchronizedFrame frame;
+        uint64_t          timestamp;
+    };
+
+    struct Stream
+    {
+        std::deque<PendingFrame>    queue;
+        FrameSynchronizerStatistics statistics;
+        bool                        active = true;
+    };
+
+    // This function takes the complete sets out of the queues
+    //
+    // Parameters:
+    // [out] (std::vector<std::vector<SynchronizedFrame>> &) sets - matched sets, oldest first
+    // [out] (std::vector<FrameLease> &) dropped - leases of frames which cannot be matched anymore
+    void Match(std::vector<std::vector<SynchronizedFrame>> &sets, std::vector<FrameLease> &dropped);
+
+    uint64_t m_Tolerance;
+    uint32_t m_QueueDepth;
+
+    mutable QMutex m_Mutex;
+    std::vector<Stream> m_Streams;
+    bool m_Active;
+    // newest timestamp of the last emitted set, older frames are late
+    uint64_t m_LastSetTimestamp;
+    uint64_t m_SetCount;
+    uint64_t m_MaxSkew;
+
+    // keeps the order of the sets when several capture threads complete some
+    QMutex m_DispatchMutex;
+    std::vector<SetProcessorFunc> m_SetProcessors;
+};
+
+#endif // FRAMESYNCHRONIZER_H
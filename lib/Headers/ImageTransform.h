@@ -23,9 +23,16 @@
 
 #include <stdint.h>
 
+#include <memory>
+
+struct BufferWrapper;
+class FrameLease;
+class StripePool;
 
 namespace ImageTransform {
-    // This function convert frame and return results of conversion
+    // This function convert frame and return results of conversion. An image of
+    // the frame size and format which is not shared is written in place, callers
+    // which keep their image allocate nothing per frame.
     //
     // Parameters:
     // [in] (const uint8_t *) pBuffer
@@ -35,17 +42,66 @@ namespace ImageTransform {
     // [in] (uint32_t) pixelFormat
     // [in] (uint32_t &) payloadSize
     // [in] (uint32_t &) bytesPerLine
-    // [in] (QImage &) convertedImage
+    // [in,out] (QImage &) convertedImage - image reused for the result if possible
     //
     // Returns:
     // (int) - result of converting
     int ConvertFrame(const uint8_t* pBuffer, uint32_t length,
                             uint32_t width, uint32_t height, uint32_t pixelFormat,
                             uint32_t payloadSize, uint32_t bytesPerLine, QImage &convertedImage);
+    // This function converts a captured frame, planar formats are read
+    // directly from their planes, also if the driver delivers them separately.
+    // The image is reused like in the overload above.
+    //
+    // Parameters:
+    // [in] (const BufferWrapper &) buffer - frame with its planes
+    // [in,out] (QImage &) convertedImage - image reused for the result if possible
+    //
+    // Returns:
+    // (int) - result of converting
+    int ConvertFrame(const BufferWrapper &buffer, QImage &convertedImage);
+    // This function builds an image over the captured frame itself, for formats
+    // Qt shows as they are. The image keeps a copy of the lease in the given slot,
+    // the buffer goes back to the driver when the last copy of the image is destroyed.
+    //
+    // Parameters:
+    // [in] (const BufferWrapper &) buffer - captured frame
+    // [in] (const FrameLease &) lease - lease on the buffer of the frame
+    // [out] (FrameLease &) leaseSlot - empty lease which outlives the image, it is emptied again with the image
+    // [out] (QImage &) image - read-only image over the buffer
+    //
+    // Returns:
+    // (int) - -1 if the frame can't be shown without a copy, ConvertFrame has to be used then
+    int WrapFrame(const BufferWrapper &buffer, const FrameLease &lease, FrameLease &leaseSlot, QImage &image);
+    // This function returns whether WrapFrame supports a pixel format
+    //
+    // Parameters:
+    // [in] (uint32_t) pixelFormat
+    //
+    // Returns:
+    // (bool) - true if frames of the format can be shown without a copy
+    bool CanWrapFrame(uint32_t pixelFormat);
 
     bool CanConvert(uint32_t pixelFormat);
 
-    void Init(uint32_t width, uint32_t height);
+    // This function sets the number of threads which convert one frame together.
+    // The rows of YUV, Bayer and Jetson frames are split into stripes then.
+    //
+    // Parameters:
+    // [in] (uint32_t) threadCount - including the converting thread, 1 converts every frame
+    //                               on one thread, 0 for StripePool::DefaultThreadCount()
+    void SetConversionThreads(uint32_t threadCount);
+    // This function returns the number of threads which convert one frame together
+    //
+    // Returns:
+    // (uint32_t) - threads of the stripe pool including the converting thread
+    uint32_t GetConversionThreads();
+    // This function returns the pool which converts the stripes of the frames,
+    // it is created with the default thread count at the first use
+    //
+    // Returns:
+    // (std::shared_ptr<StripePool>) - pool shared by all conversion threads
+    std::shared_ptr<StripePool> GetStripePool();
 }
 
 #endif // IMAGETRANSFORM_H
@@ -0,0 +1,135 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+#ifndef LATENCYSTATISTICS_H
+#define LATENCYSTATISTICS_H
+
+#include <linux/videodev2.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Measured intervals of the frame pipeline
+enum LATENCY_STAGE
+{
+    LATENCY_DRIVER_TO_DEQUEUE,          // driver timestamp -> VIDIOC_DQBUF returned
+    LATENCY_DEQUEUE_TO_DISPATCH,        // VIDIOC_DQBUF returned -> raw data processors called
+    LATENCY_DISPATCH_TO_CONVERSION,     // processors called -> conversion or texture upload started
+    LATENCY_CONVERSION,                 // conversion start -> conversion end
+    LATENCY_TEXTURE_UPLOAD,             // texture upload start -> texture upload end
+    LATENCY_DRIVER_TO_DISPLAY,          // driver timestamp -> image or texture handed to the display
+    LATENCY_BUFFER_HOLD,                // VIDIOC_DQBUF returned -> buffer requeued
+    LATENCY_STAGE_COUNT
+};
+
+// Points in time of a frame in microseconds of CLOCK_MONOTONIC, 0 if unknown
+struct FrameTimestamps
+{
+    uint64_t driver = 0;
+    uint64_t dequeued = 0;
+    uint64_t dispatched = 0;
+
+    // This function returns the earliest known timestamp of the frame
+    uint64_t Origin() const { return driver != 0 ? driver : dequeued; }
+};
+
+struct LatencySummary
+{
+    uint64_t count;
+    double   meanMicroseconds;
+    uint64_t p50Microseconds;
+    uint64_t p90Microseconds;
+    uint64_t p99Microseconds;
+    uint64_t maxMicroseconds;
+};
+
+// Latency histograms of all pipeline stages. Recording is lock-free and
+// may happen from any thread, buckets are log-linear with 16 steps per
+// power of two (about 6% resolution).
+class LatencyStatistics
+{
+public:
+    LatencyStatistics();
+
+    // This function returns the current CLOCK_MONOTONIC time
+    //
+    // Returns:
+    // (uint64_t) - microseconds
+    static uint64_t Now();
+    // This function converts the timestamp of a dequeued buffer to CLOCK_MONOTONIC
+    //
+    // Parameters:
+    // [in] (const v4l2_buffer &) buf - dequeued buffer
+    //
+    // Returns:
+    // (uint64_t) - microseconds or 0 if the driver uses another clock
+    static uint64_t DriverTimestamp(const v4l2_buffer &buf);
+
+    // This function adds one sample
+    //
+    // Parameters:
+    // [in] (LATENCY_STAGE) stage - measured interval
+    // [in] (uint64_t) start - start of the interval in microseconds, ignored if 0
+    // [in] (uint64_t) end - end of the interval in microseconds
+    void Record(LATENCY_STAGE stage, uint64_t start, uint64_t end);
+
+    // This function clears all histograms
+    void Reset();
+
+    // This function evaluates the histogram of one stage
+    //
+    // Parameters:
+    // [in] (LATENCY_STAGE) stage - measured interval
+    //
+    // Returns:
+    // (LatencySummary) - count, mean, percentiles and maximum
+    LatencySummary GetSummary(LATENCY_STAGE stage) const;
+
+    // This function returns a printable name of a stage
+    static const char* GetStageName(LATENCY_STAGE stage);
+
+    // This function writes summaries and non-empty buckets of all stages to a text file
+    //
+    // Parameters:
+    // [in] (const std::string &) fileName - file to write
+    //
+    // Returns:
+    // (int) - 0 on success, -1 if the file could not be written
+    int DumpToFile(const std::string &fileName) const;
+
+private:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    // values up to 2^31 us, larger ones end up in the last bucket
+    static const int BUCKET_COUNT = (31 - SUB_BUCKET_BITS + 2) * SUB_BUCKET_COUNT;
+
+    static int BucketIndex(uint64_t value);
+    static uint64_t BucketValue(int index);
+
+    struct Histogram
+    {
+        std::atomic<uint64_t> buckets[BUCKET_COUNT];
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> max;
+    };
+
+    Histogram m_Histograms[LATENCY_STAGE_COUNT];
+};
+
+#endif // LATENCYSTATISTICS_H
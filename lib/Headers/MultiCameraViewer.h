@@ -0,0 +1,166 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#ifndef MULTICAMERAVIEWER_H
+#define MULTICAMERAVIEWER_H
+
+#include "Camera.h"
+#include "ConversionPool.h"
+#include "FPSCalculator.h"
+#include "FrameSynchronizer.h"
+
+#include <QImage>
+#include <QString>
+#include <QTimer>
+#include <QWidget>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct MultiCameraOptions
+{
+    std::vector<std::string> devices;
+    IO_METHOD_TYPE ioMethod = IO_METHOD_USERPTR;
+    // start size of the adaptive buffer pool of every camera
+    uint32_t bufferCount = 5;
+    // 0 for ConversionPool::DefaultThreadCount()
+    uint32_t conversionThreads = 0;
+    // show only frames matched by timestamp within this tolerance, 0 shows every frame
+    uint64_t syncToleranceMicroseconds = 0;
+    // restart streams after stalls and error storms, not for cameras in trigger mode
+    bool watchdog = false;
+};
+
+// One camera of the tiled view. It shows the newest image and an overlay
+// with the name of the device and its statistics.
+class CameraTileWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit CameraTileWidget(const QString &title, QWidget *parent = nullptr);
+
+    // This function replaces the shown image, it is called on the GUI thread
+    //
+    // Parameters:
+    // [in] (const QImage &) image - converted frame
+    void SetImage(const QImage &image);
+    // This function sets the second line of the overlay
+    //
+    // Parameters:
+    // [in] (const QString &) status - statistics or an error
+    void SetStatus(const QString &status);
+    // This function returns the size of the image area, it may be called from any thread
+    //
+    // Returns:
+    // (QSize) - images larger than this are scaled down before they are passed
+    QSize GetImageTargetSize() const;
+    // This function returns the rate of shown images
+    //
+    // Returns:
+    // (double) - images per second
+    double GetRenderedFPS();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    QString m_Title;
+    QString m_Status;
+    QImage m_Image;
+    FPSCalculator m_RenderFPS;
+    // read by the conversion threads
+    std::atomic<int> m_TargetWidth;
+    std::atomic<int> m_TargetHeight;
+};
+
+// Streams several devices at once. Every camera keeps its own FrameObserver
+// thread and buffers, the conversion is shared by one ConversionPool and
+// the images are shown in a grid of tiles. With a sync tolerance the frames
+// pass a FrameSynchronizer first and the tiles show matched sets only.
+class MultiCameraViewer : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit MultiCameraViewer(const MultiCameraOptions &options, QWidget *parent = nullptr);
+    ~MultiCameraViewer();
+
+    // This function opens all devices and starts streaming
+    //
+    // Returns:
+    // (int) - number of cameras which are streaming
+    int StartStreams();
+    // This function stops streaming and closes all devices
+    void StopStreams();
+
+private slots:
+    // This function updates the overlays of all tiles, called once a second
+    void OnUpdateStatistics();
+
+private:
+    struct CameraStream
+    {
+        std::string device;
+        std::unique_ptr<Camera> pCamera;
+        CameraTileWidget *pTile = nullptr;
+        int sourceId = -1;
+        int syncIndex = -1;
+        bool streaming = false;
+        uint32_t pixelFormat = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t bytesPerLine = 0;
+        uint32_t payloadSize = 0;
+        QString pixelFormatText;
+    };
+
+    // This function opens a device and registers its tile with the conversion pool
+    //
+    // Parameters:
+    // [in] (CameraStream &) stream
+    //
+    // Returns:
+    // (int) - result of opening, the reason of a failure is shown in the tile
+    int OpenStream(CameraStream &stream);
+    // This function starts streaming of an opened device
+    //
+    // Parameters:
+    // [in] (CameraStream &) stream
+    //
+    // Returns:
+    // (int) - result of starting, the reason of a failure is shown in the tile
+    int StartStream(CameraStream &stream);
+    // This function stops a stream and closes its device
+    //
+    // Parameters:
+    // [in] (CameraStream &) stream
+    void StopStream(CameraStream &stream);
+
+    MultiCameraOptions m_Options;
+    ConversionPool m_ConversionPool;
+    std::vector<std::unique_ptr<CameraStream>> m_Streams;
+    // created when the streams are started, every opened camera is one stream of it
+    std::unique_ptr<FrameSynchronizer> m_pSynchronizer;
+    QTimer m_StatisticsTimer;
+};
+
+#endif // MULTICAMERAVIEWER_H
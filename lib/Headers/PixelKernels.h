@@ -0,0 +1,178 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#ifndef PIXELKERNELS_H
+#define PIXELKERNELS_H
+
+#include <stdint.h>
+
+// Instruction sets of the conversion kernels
+enum KERNEL_ISA
+{
+    KERNEL_ISA_SCALAR,
+    KERNEL_ISA_SSE41,
+    KERNEL_ISA_AVX2,
+    KERNEL_ISA_NEON,
+    KERNEL_ISA_COUNT
+};
+
+// Byte order of the packed 4:2:2 formats, two pixels share one U and V
+enum YUV422_LAYOUT
+{
+    // Y0 U Y1 V
+    YUV422_LAYOUT_YUYV,
+    // U Y0 V Y1
+    YUV422_LAYOUT_UYVY,
+    // V Y0 U Y1
+    YUV422_LAYOUT_VYUY,
+};
+
+// Chroma rows of the planar 4:2:0 and 4:2:2 formats, two pixels share one U and V
+enum YUV_CHROMA_LAYOUT
+{
+    // U and V in planes of their own
+    YUV_CHROMA_LAYOUT_PLANAR,
+    // U V pairs in one plane
+    YUV_CHROMA_LAYOUT_UV,
+    // V U pairs in one plane
+    YUV_CHROMA_LAYOUT_VU,
+};
+
+// Colour filter arrays, named by the first two pixels of the first two lines
+enum BAYER_ORDER
+{
+    BAYER_ORDER_BGGR,
+    BAYER_ORDER_GBRG,
+    BAYER_ORDER_GRBG,
+    BAYER_ORDER_RGGB,
+};
+
+// Vectorized kernels of the pixel format conversions. The best instruction
+// set of the CPU is detected at the first use, every vectorized kernel gives
+// exactly the result of its scalar version. V4L2VIEWER_KERNELS=scalar, sse4.1,
+// avx2 or neon limits the kernels to that instruction set.
+namespace pixelkernels
+{
+
+// This function returns the best instruction set the CPU supports
+//
+// Returns:
+// (KERNEL_ISA) - detected instruction set
+KERNEL_ISA GetDetectedIsa();
+// This function returns the instruction set the kernels use
+//
+// Returns:
+// (KERNEL_ISA) - active instruction set
+KERNEL_ISA GetActiveIsa();
+// This function selects the instruction set of the kernels, e.g. to compare
+// the vectorized kernels with the scalar ones
+//
+// Parameters:
+// [in] (KERNEL_ISA) isa
+//
+// Returns:
+// (int) - -1 if the CPU or the build does not support the instruction set
+int SetActiveIsa(KERNEL_ISA isa);
+// This function returns the name of an instruction set as used in V4L2VIEWER_KERNELS
+//
+// Parameters:
+// [in] (KERNEL_ISA) isa
+//
+// Returns:
+// (const char *) - name
+const char* GetIsaName(KERNEL_ISA isa);
+
+// This function converts packed 4:2:2 YUV to RGB24. An odd last pixel of a row is not written.
+//
+// Parameters:
+// [in] (const uint8_t *) pSource - first row
+// [in] (uint32_t) sourceBytesPerLine
+// [out] (uint8_t *) pDestination - first row of the RGB24 image
+// [in] (uint32_t) destinationBytesPerLine
+// [in] (uint32_t) width
+// [in] (uint32_t) height
+// [in] (YUV422_LAYOUT) layout - byte order of the source
+void Yuv422ToRgb24(const uint8_t *pSource, uint32_t sourceBytesPerLine,
+                   uint8_t *pDestination, uint32_t destinationBytesPerLine,
+                   uint32_t width, uint32_t height, YUV422_LAYOUT layout);
+// This function converts one row of planar or semi-planar YUV to RGB24. Rows of
+// 4:2:0 formats share their chroma row with the neighbouring row, the caller
+// passes the chroma row of the row. An odd last pixel gets the last chroma sample alone.
+//
+// Parameters:
+// [in] (const uint8_t *) pLuma - luma row
+// [in] (const uint8_t *) pChroma - U row of planar sources, chroma row of semi-planar ones
+// [in] (const uint8_t *) pSecondChroma - V row of planar sources, ignored for semi-planar ones
+// [out] (uint8_t *) pDestination - RGB24 row
+// [in] (uint32_t) width
+// [in] (YUV_CHROMA_LAYOUT) layout - chroma rows of the source
+void YuvPlanarLineToRgb24(const uint8_t *pLuma, const uint8_t *pChroma, const uint8_t *pSecondChroma,
+                          uint8_t *pDestination, uint32_t width, YUV_CHROMA_LAYOUT layout);
+
+// This function demosaics 8 bit Bayer to RGB24 with bilinear interpolation.
+// Frames narrower than 3 or lower than 2 pixels are not written.
+//
+// Parameters:
+// [in] (const uint8_t *) pSource - first line
+// [in] (uint32_t) sourceBytesPerLine
+// [out] (uint8_t *) pDestination - first row of the RGB24 image
+// [in] (uint32_t) destinationBytesPerLine
+// [in] (uint32_t) width
+// [in] (uint32_t) height
+// [in] (BAYER_ORDER) order - colour filter array of the source
+void Bayer8ToRgb24(const uint8_t *pSource, uint32_t sourceBytesPerLine,
+                   uint8_t *pDestination, uint32_t destinationBytesPerLine,
+                   uint32_t width, uint32_t height, BAYER_ORDER order);
+// This function demosaics a part of the lines of an 8 bit Bayer frame, so
+// several threads can share a frame. The line above and the line below the
+// part are read as well. Frames narrower than 3 or lower than 2 pixels are not written.
+//
+// Parameters:
+// [in] (const uint8_t *) pSource - first line of the frame
+// [in] (uint32_t) sourceBytesPerLine
+// [out] (uint8_t *) pDestination - first row of the RGB24 image of the frame
+// [in] (uint32_t) destinationBytesPerLine
+// [in] (uint32_t) width
+// [in] (uint32_t) height - lines of the frame
+// [in] (BAYER_ORDER) order - colour filter array of the source
+// [in] (uint32_t) firstLine - first line to write
+// [in] (uint32_t) lineCount - lines to write
+void Bayer8ToRgb24Lines(const uint8_t *pSource, uint32_t sourceBytesPerLine,
+                        uint8_t *pDestination, uint32_t destinationBytesPerLine,
+                        uint32_t width, uint32_t height, BAYER_ORDER order,
+                        uint32_t firstLine, uint32_t lineCount);
+// This function demosaics one line of an 8 bit Bayer frame from the line
+// itself and its neighbours, for sources which are unpacked line by line.
+// Frames narrower than 3 or lower than 2 pixels are not written.
+//
+// Parameters:
+// [in] (const uint8_t *) pAbove - line above, NULL for the first line
+// [in] (const uint8_t *) pLine - the line
+// [in] (const uint8_t *) pBelow - line below, NULL for the last line
+// [out] (uint8_t *) pDestination - RGB24 row of the line
+// [in] (uint32_t) width
+// [in] (uint32_t) height - lines of the frame
+// [in] (uint32_t) line - index of the line in the frame
+// [in] (BAYER_ORDER) order - colour filter array of the frame
+void Bayer8LineToRgb24(const uint8_t *pAbove, const uint8_t *pLine, const uint8_t *pBelow,
+                       uint8_t *pDestination, uint32_t width, uint32_t height,
+                       uint32_t line, BAYER_ORDER order);
+
+} // namespace pixelkernels
+
+#endif // PIXELKERNELS_H
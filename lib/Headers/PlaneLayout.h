@@ -0,0 +1,81 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#ifndef PLANELAYOUT_H
+#define PLANELAYOUT_H
+
+#include "BufferWrapper.h"
+
+#include <stdint.h>
+
+// Layout of the planar YUV formats. The formats ending in M deliver every
+// colour plane in a memory plane of its own, the others put all colour
+// planes one after the other into a single buffer.
+struct PlanarFormat
+{
+    // colour planes, 2 for Y + interleaved UV, 3 for Y + U + V
+    uint32_t planeCount;
+    // memory planes of a V4L2 multi-plane buffer
+    uint32_t memoryPlaneCount;
+    // chroma rows are height >> chromaVerticalShift, chroma is always subsampled horizontally
+    uint32_t chromaVerticalShift;
+    // V before U, in the interleaved plane or as plane order
+    bool     swapChroma;
+};
+
+namespace planelayout
+{
+
+// This function returns the layout of a planar YUV format
+//
+// Parameters:
+// [in] (uint32_t) pixelFormat
+// [out] (PlanarFormat &) format
+//
+// Returns:
+// (bool) - false if the format is not planar
+bool GetPlanarFormat(uint32_t pixelFormat, PlanarFormat &format);
+// This function returns the variant of a multi-plane format which keeps all
+// planes in one memory plane, e.g. NV12 for NV12M
+//
+// Parameters:
+// [in] (uint32_t) pixelFormat
+//
+// Returns:
+// (uint32_t) - single memory plane format, other formats as they are
+uint32_t GetSinglePlaneFormat(uint32_t pixelFormat);
+// This function describes the colour planes of a frame by pointing into the
+// memory planes, a single memory plane is split at the plane boundaries
+//
+// Parameters:
+// [in] (uint32_t) pixelFormat
+// [in] (uint32_t) height - height of the frame
+// [in] (const FramePlane *) pMemoryPlanes - memory planes as delivered by the driver
+// [in] (uint32_t) memoryPlaneCount
+// [out] (FramePlane *) pPlanes - BUFFER_MAX_PLANES colour planes
+// [out] (uint32_t &) planeCount - number of colour planes
+//
+// Returns:
+// (int) - -1 if the memory is too small for the format
+int Split(uint32_t pixelFormat, uint32_t height,
+          const FramePlane *pMemoryPlanes, uint32_t memoryPlaneCount,
+          FramePlane *pPlanes, uint32_t &planeCount);
+
+} // namespace planelayout
+
+#endif // PLANELAYOUT_H
@@ -0,0 +1,121 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#ifndef RAWDATAPROCESSORQUEUE_H
+#define RAWDATAPROCESSORQUEUE_H
+
+#include "BufferWrapper.h"
+#include "FrameLease.h"
+
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+
+// How frames are handed to a raw data processor
+enum PROCESSOR_QUEUE_POLICY
+{
+    PROCESSOR_QUEUE_SYNCHRONOUS,    // called directly on the capture thread
+    PROCESSOR_QUEUE_LATEST_ONLY,    // own thread, a newer frame replaces a waiting one
+    PROCESSOR_QUEUE_DROP_OLDEST,    // own thread, the oldest frame is dropped when the queue is full
+    PROCESSOR_QUEUE_BLOCK,          // own thread, the capture thread waits while the queue is full
+};
+
+struct RawDataProcessorStatistics
+{
+    PROCESSOR_QUEUE_POLICY policy;
+    uint32_t capacity;
+    uint32_t queueDepth;
+    uint32_t maxQueueDepth;
+    uint64_t processed;
+    uint64_t dropped;
+};
+
+class RawDataProcessorQueue
+{
+public:
+    using ProcessorFunc = std::function<void(BufferWrapper const&, FrameLease)>;
+
+    // Parameters:
+    // [in] (ProcessorFunc) processor - function which consumes the frames
+    // [in] (PROCESSOR_QUEUE_POLICY) policy - dispatch policy
+    // [in] (uint32_t) capacity - maximum number of waiting frames, ignored for synchronous and latest-only
+    RawDataProcessorQueue(ProcessorFunc processor, PROCESSOR_QUEUE_POLICY policy, uint32_t capacity);
+    ~RawDataProcessorQueue();
+
+    // This function hands a frame to the processor according to the policy.
+    // It is called from the capture thread only.
+    //
+    // Parameters:
+    // [in] (BufferWrapper const &) buffer - frame description
+    // [in] (FrameLease) lease - lease which keeps the frame alive
+    void Push(BufferWrapper const& buffer, FrameLease lease);
+
+    // This function drops all waiting frames and thereby releases their leases.
+    // A frame which is being processed right now is not affected.
+    void Flush();
+
+    // This function lets Push drop every frame instead of queuing it and wakes
+    // a capture thread waiting for space, so the capture thread can be stopped.
+    // Waiting frames are kept until Flush is called.
+    void Interrupt();
+
+    // This function lets Push queue frames again after Interrupt
+    void Resume();
+
+    // This function returns the statistics of this queue
+    //
+    // Returns:
+    // (RawDataProcessorStatistics) - current statistics
+    RawDataProcessorStatistics GetStatistics() const;
+
+    // This function resets the counters of the statistics
+    void ResetStatistics();
+
+private:
+    struct QueuedFrame
+    {
+        BufferWrapper buffer;
+        FrameLease lease;
+    };
+
+    void WorkerMain();
+
+    ProcessorFunc m_Processor;
+    PROCESSOR_QUEUE_POLICY m_Policy;
+    uint32_t m_Capacity;
+
+    mutable QMutex m_QueueMutex;
+    QWaitCondition m_FrameAvailable;
+    QWaitCondition m_SpaceAvailable;
+    std::deque<QueuedFrame> m_Queue;
+    bool m_StopWorker;
+    bool m_Interrupted;
+
+    std::atomic<uint32_t> m_MaxQueueDepth;
+    std::atomic<uint64_t> m_Processed;
+    std::atomic<uint64_t> m_Dropped;
+
+    std::unique_ptr<std::thread> m_pWorkerThread;
+};
+
+#endif // RAWDATAPROCESSORQUEUE_H
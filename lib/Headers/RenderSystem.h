@@ -5,6 +5,7 @@
 #include <functional>
 #include "BufferWrapper.h"
 #include "FPSCalculator.h"
+#include "FrameLease.h"
 
 class RenderSystem: public QObject
 {
@@ -15,7 +16,9 @@ public:
     virtual void SetFlipY(bool flip) = 0;
     virtual void SetScaleFactor(double scaleFactor) = 0;
     virtual QWidget* GetWidget() const = 0;
-    virtual void PassFrame(BufferWrapper const& buffer, std::function<void()> doneCallback) = 0;
+    virtual void PassFrame(BufferWrapper const& buffer, FrameLease lease) = 0;
+    // Releases a frame which has been passed but not rendered yet, so the stream can stop without waiting for it
+    virtual void ReleaseFrames() = 0;
     virtual bool CanRender(uint32_t pixelFormat) const = 0;
     double GetRenderedFPS();
 
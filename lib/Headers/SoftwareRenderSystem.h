@@ -12,6 +12,7 @@
 #include <QScrollArea>
 #include <memory>
 #include <thread>
+#include <linux/videodev2.h>
 
 class SoftwareRenderSystem: public RenderSystem
 {
@@ -24,7 +25,8 @@ public:
     void SetFlipY(bool flip);
 
     QWidget* GetWidget() const override;
-    void PassFrame(BufferWrapper const& buffer, std::function<void()> doneCallback) override;
+    void PassFrame(BufferWrapper const& buffer, FrameLease lease) override;
+    void ReleaseFrames() override;
     bool CanRender(uint32_t pixelFormat) const override;
 
 signals:
@@ -45,6 +47,11 @@ private:
 
     void ApplyScale();
     void ConversionThreadMain();
+    // This function returns the image the next frame is converted into, called on the conversion thread
+    //
+    // Returns:
+    // (QImage &) - an image nobody else holds if there is one
+    QImage& NextConvertedImage();
 
     // TODO encapsulate for re-use in hwaccel renderer?
     std::atomic<bool> bufferAvailable;
@@ -53,7 +60,20 @@ private:
     QMutex frameAvailableMutex;
     QWaitCondition newFrameAvailable;
     BufferWrapper nextBuffer;
-    std::function<void()> nextDoneCallback;
+    FrameLease nextLease;
+    // a frame is between pick up and SetImage, guarded by frameAvailableMutex
+    bool converting = false;
+    // set by ReleaseFrames until the next frame is passed
+    bool releasingFrames = false;
+    QWaitCondition frameConverted;
+    // the widget holds the shown image and maybe a pending one, the frames are converted
+    // into the third one, so steady streaming allocates no images
+    static const int CONVERTED_IMAGE_COUNT = 3;
+    QImage convertedImages[CONVERTED_IMAGE_COUNT];
+    int nextConvertedImage = 0;
+    // the leases of wrapped frames, one per buffer index. A wrapped buffer stays away
+    // from the driver until its images are gone, so its index can't come twice meanwhile.
+    FrameLease wrappedLeases[VIDEO_MAX_FRAME];
 };
 
 #endif
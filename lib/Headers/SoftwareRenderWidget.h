@@ -1,28 +1,63 @@
 #ifndef SOFTWARERENDERWIDGET_H
 #define SOFTWARERENDERWIDGET_H
 
-#include <QPixmap>
+#include <QGraphicsItem>
+#include <QImage>
+#include <QMutex>
+
+// Scene item which paints an image as it is. Unlike QGraphicsPixmapItem it
+// needs no conversion to a pixmap, so an image over a captured buffer is
+// shown without a copy.
+class FrameImageItem: public QGraphicsItem {
+public:
+  // This function replaces the shown image
+  //
+  // Parameters:
+  // [in] (const QImage &) image
+  void SetImage(const QImage &image);
+  // This function returns the shown image
+  //
+  // Returns:
+  // (const QImage &) - image, null if none is shown
+  const QImage& GetImage() const;
+
+  QRectF boundingRect() const override;
+  void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+  QImage m_Image;
+};
 
 class SoftwareRenderWidget: public QGraphicsView {
   Q_OBJECT
 private:
   QGraphicsScene *m_Scene;
-  QGraphicsPixmapItem m_PixmapItem;
-  QPixmap *m_CurrentPixmap = nullptr;
+  FrameImageItem m_ImageItem;
+  // passed by the conversion thread, taken by the GUI thread
+  QMutex m_PendingImageMutex;
+  QImage m_PendingImage;
 
 signals:
   void RequestZoom(QPointF center, bool zoomIn);
   void Clicked(QPointF point);
-  void SetPixmapSignal(QPixmap pixmap);
+  void ImageAvailable();
 
 private slots:
-  void OnSetPixmap(QPixmap pixmap);
+  void OnImageAvailable();
 
 public:
   SoftwareRenderWidget(QWidget *parent = nullptr);
   ~SoftwareRenderWidget();
 
-  void SetPixmap(QPixmap pixmap);
+  // This function passes the next image to show, it may be called from any thread.
+  // An image which was not shown yet is replaced.
+  //
+  // Parameters:
+  // [in] (const QImage &) image - converted frame or an image over a captured buffer
+  void SetImage(const QImage &image);
+  // This function drops the pending image and replaces the shown one by a copy,
+  // so no image refers to a captured buffer anymore. It is called on the GUI thread.
+  void DetachImage();
 
   void wheelEvent(QWheelEvent *event) override;
   void mousePressEvent(QMouseEvent *event) override;
@@ -0,0 +1,122 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#ifndef STRIPEPOOL_H
+#define STRIPEPOOL_H
+
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct StripePoolStatistics
+{
+    // frames split into more than one stripe
+    uint64_t frames = 0;
+    uint64_t stripes = 0;
+    // stripes converted by the threads of the pool instead of the calling thread
+    uint64_t pooledStripes = 0;
+};
+
+// Converts one frame on several threads. Run splits the rows of the frame
+// into stripes, the calling thread and the threads of the pool take stripes
+// until all are done. Several threads may run frames at once, e.g. the
+// threads of a ConversionPool, the stripes are served in the order of the
+// frames and a caller never waits for a stripe nobody has started.
+class StripePool
+{
+public:
+    // Converts rows firstRow..firstRow+rowCount-1, called on any thread of the pool
+    using StripeFunc = std::function<void(uint32_t firstRow, uint32_t rowCount)>;
+
+    // Parameters:
+    // [in] (uint32_t) threadCount - threads which convert a frame including the calling one,
+    //                               1 converts on the calling thread only, 0 for DefaultThreadCount()
+    explicit StripePool(uint32_t threadCount);
+    ~StripePool();
+
+    StripePool(const StripePool &) = delete;
+    StripePool& operator=(const StripePool &) = delete;
+
+    // This function returns a thread count which leaves one CPU for capturing and the GUI
+    //
+    // Returns:
+    // (uint32_t) - number of threads
+    static uint32_t DefaultThreadCount();
+
+    // This function converts a frame in stripes and returns when all stripes are done
+    //
+    // Parameters:
+    // [in] (uint32_t) rowCount - rows of the frame
+    // [in] (uint32_t) rowAlignment - every stripe but the last one has a multiple of these rows
+    // [in] (const StripeFunc &) stripe - function which converts one stripe
+    void Run(uint32_t rowCount, uint32_t rowAlignment, const StripeFunc &stripe);
+
+    // This function returns the number of threads which convert a frame
+    //
+    // Returns:
+    // (uint32_t) - threads of the pool plus the calling thread
+    uint32_t GetThreadCount() const;
+    // This function returns the counters since the pool was created
+    //
+    // Returns:
+    // (StripePoolStatistics) - counters
+    StripePoolStatistics GetStatistics() const;
+
+    // stripes below this size cost more in synchronization than they save
+    static const uint32_t MINIMUM_STRIPE_ROWS = 16;
+    // more stripes than threads balance threads which are busy with something else
+    static const uint32_t STRIPES_PER_THREAD = 2;
+
+private:
+    struct Job
+    {
+        const StripeFunc *pStripe;
+        uint32_t rowCount;
+        uint32_t stripeRows;
+        uint32_t stripeCount;
+        // next stripe nobody has taken yet
+        uint32_t nextStripe;
+        uint32_t doneStripes;
+    };
+
+    void WorkerMain();
+    // This function converts one stripe of a job, it is called without the lock
+    //
+    // Parameters:
+    // [in] (const Job &) job
+    // [in] (uint32_t) stripe - index of the stripe
+    static void RunStripe(const Job &job, uint32_t stripe);
+
+    mutable QMutex m_Mutex;
+    QWaitCondition m_JobAvailable;
+    QWaitCondition m_StripeDone;
+    // jobs with stripes nobody has taken yet, oldest first. Only a few frames
+    // run at once, a vector keeps its capacity and allocates nothing per frame.
+    std::vector<Job*> m_Jobs;
+    bool m_Stop;
+    StripePoolStatistics m_Statistics;
+
+    std::vector<std::unique_ptr<std::thread>> m_Threads;
+};
+
+#endif // STRIPEPOOL_H
@@ -0,0 +1,119 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#ifndef THREADCONFIG_H
+#define THREADCONFIG_H
+
+#include <sched.h>
+#include <stdint.h>
+
+#include <string>
+
+enum THREAD_ROLE
+{
+    // FrameObserver, dequeues and dispatches the frames
+    THREAD_ROLE_CAPTURE,
+    // render conversion
+    THREAD_ROLE_CONVERSION,
+    // V4L2 control events
+    THREAD_ROLE_EVENTS,
+    // log file writers
+    THREAD_ROLE_LOGGING,
+    // periodic read of volatile controls
+    THREAD_ROLE_CONTROL_POLLING,
+    // queued raw data processors like the histogram, they keep the default scheduling
+    // unless configured, a real time conversion setting must not promote them
+    THREAD_ROLE_PROCESSOR,
+    THREAD_ROLE_COUNT
+};
+
+struct ThreadRoleSettings
+{
+    // SCHED_OTHER, SCHED_FIFO or SCHED_RR
+    int       policy = SCHED_OTHER;
+    // real time priority, or the nice value for SCHED_OTHER
+    int       priority = 0;
+    // CPUs the thread may run on, an empty set keeps the inherited affinity
+    cpu_set_t cpus{};
+    // lock all current and future memory of the process when the thread starts
+    bool      lockMemory = false;
+    // false keeps everything the thread inherits
+    bool      configured = false;
+};
+
+// The settings are read once from V4L2VIEWER_THREADS, e.g.
+//   V4L2VIEWER_THREADS="capture=fifo:80:3:mlock;conversion=other:-5:1-2;logging=other:10:0"
+// Every role is "name=policy[:priority[:cpus[:mlock]]]", cpus is a list like "0,2-3".
+namespace threadconfig
+{
+
+// This function parses a configuration and replaces the settings of the roles in it
+//
+// Parameters:
+// [in] (const std::string &) configuration - roles in the V4L2VIEWER_THREADS syntax
+//
+// Returns:
+// (int) - -1 if the configuration could not be parsed, nothing is changed then
+int Parse(const std::string &configuration);
+// This function returns the settings of a role
+//
+// Parameters:
+// [in] (THREAD_ROLE) role
+//
+// Returns:
+// (ThreadRoleSettings) - settings which are applied to threads of this role
+ThreadRoleSettings GetSettings(THREAD_ROLE role);
+// This function applies the settings of a role to the calling thread
+// and logs the settings which are in effect afterwards
+//
+// Parameters:
+// [in] (THREAD_ROLE) role
+//
+// Returns:
+// (int) - -1 if a setting could not be applied, e.g. without CAP_SYS_NICE
+int ApplyToCurrentThread(THREAD_ROLE role);
+// This function applies the settings of a role to the calling thread without logging,
+// for the logger threads themselves
+//
+// Parameters:
+// [in] (THREAD_ROLE) role
+// [out] (std::string &) report - effective settings and errors
+//
+// Returns:
+// (int) - -1 if a setting could not be applied
+int ApplyToCurrentThread(THREAD_ROLE role, std::string &report);
+// This function returns the report of the last thread which applied the role
+//
+// Parameters:
+// [in] (THREAD_ROLE) role
+//
+// Returns:
+// (std::string) - effective settings, empty if no thread of this role started yet
+std::string GetEffectiveSettings(THREAD_ROLE role);
+// This function returns the name of a role as used in the configuration
+//
+// Parameters:
+// [in] (THREAD_ROLE) role
+//
+// Returns:
+// (const char *) - name of the role
+const char* GetRoleName(THREAD_ROLE role);
+
+} // namespace threadconfig
+
+#endif // THREADCONFIG_H
@@ -0,0 +1,141 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#ifndef USERBUFFERPOOL_H
+#define USERBUFFERPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+// The user pointer buffers of a stream in one anonymous mapping, buffers
+// added while streaming get a mapping of their own. Every buffer starts on
+// a page boundary. With huge pages the mappings are backed by MAP_HUGETLB
+// pages if the system has some reserved, otherwise transparent huge pages
+// are requested. The pages are bound to the NUMA node of the device,
+// prefaulted and optionally locked, so capturing never takes a page fault.
+class UserBufferPool
+{
+public:
+    UserBufferPool();
+    ~UserBufferPool();
+
+    UserBufferPool(const UserBufferPool &) = delete;
+    UserBufferPool& operator=(const UserBufferPool &) = delete;
+
+    // This function selects huge pages for the next allocation
+    //
+    // Parameters:
+    // [in] (bool) hugePages
+    void SetHugePages(bool hugePages);
+    // This function selects locking the memory of the next allocation
+    //
+    // Parameters:
+    // [in] (bool) lockMemory
+    void SetLockMemory(bool lockMemory);
+    // This function sets the NUMA node of the next allocation
+    //
+    // Parameters:
+    // [in] (int) numaNode - node to bind the memory to, -1 for the default policy
+    void SetNumaNode(int numaNode);
+
+    // This function maps the memory for all buffers, a previous allocation is freed
+    //
+    // Parameters:
+    // [in] (uint32_t) bufferCount
+    // [in] (size_t) bufferSize - size of a single buffer
+    //
+    // Returns:
+    // (int) - -1 if the memory could not be mapped
+    int Allocate(uint32_t bufferCount, size_t bufferSize);
+    // This function maps more buffers of the size given to Allocate
+    //
+    // Parameters:
+    // [in] (uint32_t) bufferCount - total number of buffers needed
+    //
+    // Returns:
+    // (int) - -1 if the memory could not be mapped
+    int Reserve(uint32_t bufferCount);
+    // This function gives the pages of a buffer back to the system, they are
+    // faulted in again when the buffer is used. Locked memory is kept.
+    //
+    // Parameters:
+    // [in] (uint32_t) index - index of the buffer
+    void Discard(uint32_t index);
+    // This function unmaps the memory of all buffers
+    void Free();
+
+    // This function returns the start of a buffer
+    //
+    // Parameters:
+    // [in] (uint32_t) index - index of the buffer
+    //
+    // Returns:
+    // (uint8_t *) - start of the buffer or NULL if the index is out of range
+    uint8_t* GetBuffer(uint32_t index) const;
+    // This function returns whether the memory is backed by MAP_HUGETLB pages
+    //
+    // Returns:
+    // (bool) - true if any mapping uses huge pages
+    bool IsHugePageBacked() const;
+    // This function returns whether the memory is locked
+    //
+    // Returns:
+    // (bool) - true if locked
+    bool IsLocked() const;
+
+    // This function returns the NUMA node of a device as reported by sysfs
+    //
+    // Parameters:
+    // [in] (int) fileDescriptor - opened video device
+    //
+    // Returns:
+    // (int) - node of the device, -1 if unknown or not a NUMA system
+    static int GetDeviceNumaNode(int fileDescriptor);
+
+private:
+    struct Mapping
+    {
+        uint8_t *pMemory;
+        size_t   size;
+        bool     hugePages;
+        bool     locked;
+    };
+
+    // This function maps, binds, prefaults and locks the memory of new buffers
+    //
+    // Parameters:
+    // [in] (uint32_t) bufferCount - number of buffers to add
+    //
+    // Returns:
+    // (int) - -1 if the memory could not be mapped
+    int MapBuffers(uint32_t bufferCount);
+
+    bool     m_HugePages;
+    bool     m_LockMemory;
+    int      m_NumaNode;
+
+    size_t   m_BufferStride;
+    std::vector<Mapping>  m_Mappings;
+    // start of every buffer and the mapping it belongs to
+    std::vector<uint8_t*> m_Buffers;
+    std::vector<size_t>   m_BufferMappings;
+};
+
+#endif // USERBUFFERPOOL_H
@@ -0,0 +1,136 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#ifndef USERBUFFERTABLE_H
+#define USERBUFFERTABLE_H
+
+#include <atomic>
+#include <cstddef>
+
+struct UserBuffer;
+
+// The buffers of a stream, indexed like the driver. The slots never move, so
+// the capture thread and the processors look buffers up without a lock while
+// the adaptive pool grows or shrinks the table. Changes of the table are
+// serialized by its owner: a slot is filled before the size makes it visible,
+// and a buffer is only removed when no thread can reach it anymore, i.e. it
+// is neither queued nor leased nor waiting to be requeued.
+template <size_t Capacity>
+class UserBufferTable
+{
+public:
+    UserBufferTable()
+        : m_Size(0)
+    {
+        for (auto &slot : m_Slots)
+        {
+            slot.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    UserBufferTable(const UserBufferTable&) = delete;
+    UserBufferTable& operator=(const UserBufferTable&) = delete;
+
+    size_t size() const
+    {
+        return m_Size.load(std::memory_order_acquire);
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    static constexpr size_t capacity()
+    {
+        return Capacity;
+    }
+
+    // This function returns the buffer of a slot below size()
+    //
+    // Parameters:
+    // [in] (size_t) index - index of the buffer
+    //
+    // Returns:
+    // (UserBuffer *) - buffer, NULL while the slot is not filled yet
+    UserBuffer* operator[](size_t index) const
+    {
+        return m_Slots[index].load(std::memory_order_acquire);
+    }
+
+    // This function fills a slot below size()
+    //
+    // Parameters:
+    // [in] (size_t) index - index of the buffer
+    // [in] (UserBuffer *) pBuffer - buffer
+    void set(size_t index, UserBuffer *pBuffer)
+    {
+        m_Slots[index].store(pBuffer, std::memory_order_release);
+    }
+
+    // This function appends a buffer
+    //
+    // Parameters:
+    // [in] (UserBuffer *) pBuffer - buffer
+    //
+    // Returns:
+    // (bool) - false if the table is full
+    bool push_back(UserBuffer *pBuffer)
+    {
+        size_t const count = m_Size.load(std::memory_order_relaxed);
+        if (count >= Capacity)
+        {
+            return false;
+        }
+
+        m_Slots[count].store(pBuffer, std::memory_order_release);
+        m_Size.store(count + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // This function changes the size, new slots are empty. The buffers
+    // of dropped slots are not deleted.
+    //
+    // Parameters:
+    // [in] (size_t) count - new size
+    //
+    // Returns:
+    // (bool) - false if count exceeds the capacity, the size is unchanged then
+    bool resize(size_t count)
+    {
+        if (count > Capacity)
+        {
+            return false;
+        }
+
+        for (size_t i = m_Size.load(std::memory_order_relaxed); i < count; ++i)
+        {
+            m_Slots[i].store(nullptr, std::memory_order_relaxed);
+        }
+        m_Size.store(count, std::memory_order_release);
+
+        return true;
+    }
+
+private:
+    std::atomic<UserBuffer*> m_Slots[Capacity];
+    std::atomic<size_t>      m_Size;
+};
+
+#endif // USERBUFFERTABLE_H
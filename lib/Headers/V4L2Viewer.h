@@ -117,7 +117,9 @@ protected:
     // Stores last displayed frame in case we need it for saving a frame or picking a pixel's color
     QMutex lastFrameMutex;
     BufferWrapper lastFrame;
-    std::function<void()> lastDoneCallback = nullptr;
+    FrameLease lastFrameLease;
+    // Serializes passing frames to the render system with stopping the stream
+    QMutex renderFrameMutex;
 
     QGraphicsScene m_LogoScene;
     QGraphicsPixmapItem *m_LogoPixmapItem;
@@ -17,6 +17,7 @@
 
 
 #include "AutoReaderWorker.h"
+#include "ThreadConfig.h"
 
 AutoReaderWorker::AutoReaderWorker(QObject *parent) : QObject(parent), m_pTimer(nullptr)
 {
@@ -37,6 +38,8 @@ void AutoReaderWorker::Process()
 {
     if (m_pTimer == nullptr)
     {
+        threadconfig::ApplyToCurrentThread(THREAD_ROLE_CONTROL_POLLING);
+
         m_pTimer = new QTimer();
         connect(m_pTimer, SIGNAL(timeout()), this, SLOT(ReadData()));
         m_pTimer->setInterval(1000);
@@ -18,6 +18,7 @@
 
 #include "LocalMutexLockGuard.h"
 #include "Logger.h"
+#include "ThreadConfig.h"
 
 #include <iomanip>
 #include <sstream>
@@ -193,6 +194,7 @@ void BaseLogger::LogBuffer(const std::string &filename, uint8_t *buffer, uint32_
 void BaseLogger::ThreadProc()
 {
     PrintStartMessage();
+    ApplyThreadConfig();
 
     while(m_bThreadRunning)
     {
@@ -219,6 +221,8 @@ void BaseLogger::ThreadProc()
 
 void BaseLogger::DmpThreadProc()
 {
+    ApplyThreadConfig();
+
     while(m_bDumpThreadRunning)
     {
         if(m_DumpQueue.size() > 0)
@@ -246,6 +250,8 @@ void BaseLogger::DmpThreadProc()
 
 void BaseLogger::BufThreadProc()
 {
+    ApplyThreadConfig();
+
     while(m_bBufferThreadRunning)
     {
         if(m_BufferQueue.size() > 0)
@@ -290,6 +296,14 @@ void BaseLogger::PrintStartMessage()
     }
 }
 
+void BaseLogger::ApplyThreadConfig()
+{
+    // LOG_EX is not usable here, the logger may still be under construction
+    std::string report;
+    threadconfig::ApplyToCurrentThread(THREAD_ROLE_LOGGING, report);
+    Log("threadconfig::ApplyToCurrentThread " + report);
+}
+
 void BaseLogger::PrintExitMessage()
 {
     std::stringstream text;
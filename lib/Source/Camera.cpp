@@ -17,6 +17,7 @@
 
 
 #include "Camera.h"
+#include "FrameObserverDMABUF.h"
 #include "FrameObserverMMAP.h"
 #include "FrameObserverUSER.h"
 #include "IOHelper.h"
@@ -215,6 +216,10 @@ Camera::Camera()
     , m_ControlIdToFileDescriptorMap()
     , m_BlockingMode(false)
     , m_ShowFrames(true)
+    , m_UserBufferHugePages(false)
+    , m_UserBufferLockMemory(false)
+    , m_MmapCacheMode(MMAP_CACHE_COHERENT)
+    , m_SampleReadBandwidth(false)
     , m_UseV4L2TryFmt(true)
     , m_Recording(false)
     , m_IsAvtCamera(true)
@@ -293,6 +298,20 @@ double Camera::GetReceivedFPS()
     return m_pFrameObserver->GetReceivedFPS();
 }
 
+LatencyStatistics& Camera::GetLatencyStatistics()
+{
+    return m_pFrameObserver->GetLatencyStatistics();
+}
+
+void Camera::GetFrameDropCounters(FrameDropCounters &totals, FrameDropCounters &lastSecond)
+{
+    const FrameDropStatistics &statistics = m_pFrameObserver->GetDropStatistics();
+    totals = statistics.GetTotals();
+
+    std::deque<FrameDropCounters> const history = statistics.GetHistory();
+    lastSecond = history.empty() ? FrameDropCounters() : history.back();
+}
+
 
 int Camera::OpenDevice(std::string &deviceName, QVector<QString>& subDevices, bool blockingMode, IO_METHOD_TYPE ioMethodType,
                bool v4l2TryFmt)
@@ -302,7 +321,8 @@ int Camera::OpenDevice(std::string &deviceName, QVector<QString>& subDevices, bo
     m_BlockingMode = blockingMode;
     m_UseV4L2TryFmt = v4l2TryFmt;
 
-    std::vector<IO_METHOD_TYPE> ioMethodList = {IO_METHOD_USERPTR, IO_METHOD_MMAP};
+    // the requested method is preferred, the others are fallbacks
+    std::vector<IO_METHOD_TYPE> ioMethodList = {ioMethodType, IO_METHOD_USERPTR, IO_METHOD_MMAP};
 
     auto ioMethodToMemory = [](IO_METHOD_TYPE method) -> int {
         switch (method)
@@ -310,7 +330,10 @@ int Camera::OpenDevice(std::string &deviceName, QVector<QString>& subDevices, bo
             case IO_METHOD_USERPTR:
                 return V4L2_MEMORY_USERPTR;
             case IO_METHOD_MMAP:
+            case IO_METHOD_DMABUF:
                 return V4L2_MEMORY_MMAP;
+            case IO_METHOD_DMABUF_IMPORT:
+                return V4L2_MEMORY_DMABUF;
         }
 
         return 0;
@@ -444,13 +467,35 @@ int Camera::OpenDevice(std::string &deviceName, QVector<QString>& subDevices, bo
     switch (ioMethodType)
     {
         case IO_METHOD_MMAP:
-            m_pFrameObserver = QSharedPointer<FrameObserverMMAP>(new FrameObserverMMAP(m_ShowFrames));
+        {
+            QSharedPointer<FrameObserverMMAP> pFrameObserver(new FrameObserverMMAP(m_ShowFrames));
+            pFrameObserver->SetCacheMode(m_MmapCacheMode);
+            m_pFrameObserver = pFrameObserver;
             break;
+        }
         case IO_METHOD_USERPTR:
-            m_pFrameObserver = QSharedPointer<FrameObserverUSER>(new FrameObserverUSER(m_ShowFrames));
+        {
+            QSharedPointer<FrameObserverUSER> pFrameObserver(new FrameObserverUSER(m_ShowFrames));
+            pFrameObserver->SetBufferPoolOptions(m_UserBufferHugePages, m_UserBufferLockMemory);
+            m_pFrameObserver = pFrameObserver;
+            break;
+        }
+        case IO_METHOD_DMABUF:
+            m_pFrameObserver = QSharedPointer<FrameObserverDMABUF>(new FrameObserverDMABUF(m_ShowFrames, DMABUF_MODE_EXPORT));
+            break;
+        case IO_METHOD_DMABUF_IMPORT:
+            m_pFrameObserver = QSharedPointer<FrameObserverDMABUF>(new FrameObserverDMABUF(m_ShowFrames, DMABUF_MODE_IMPORT));
             break;
     }
 
+    if (m_pFrameObserver)
+    {
+        m_pFrameObserver->SetBufferPoolPolicy(m_BufferPoolPolicy);
+        m_pFrameObserver->SetCaptureWatchdogPolicy(m_CaptureWatchdogPolicy);
+        m_pFrameObserver->SetBufferRequeuePolicy(m_BufferRequeuePolicy);
+        m_pFrameObserver->SetReadBandwidthSampling(m_SampleReadBandwidth);
+    }
+
     auto fileDescriptors = m_SubDeviceFileDescriptors;
     fileDescriptors.push_back(m_DeviceFileDescriptor);
 
@@ -745,6 +790,16 @@ int Camera::StartStreamChannel(uint32_t pixelFormat, uint32_t payloadSize, uint3
 
     LOG_EX("Camera::StartStreamChannel %s pixelFormat=%d, payloadSize=%d, width=%d, height=%d.", m_FileDescriptorToNameMap[m_DeviceFileDescriptor].c_str(), pixelFormat, payloadSize, width, height);
 
+    // the watchdog derives its stall timeout from the configured frame interval
+    uint32_t numerator = 0;
+    uint32_t denominator = 0;
+    uint64_t frameInterval = 0;
+    if (ReadFrameRate(numerator, denominator, width, height, pixelFormat) == 0 && denominator != 0)
+    {
+        frameInterval = uint64_t(numerator) * 1000000 / denominator;
+    }
+    m_pFrameObserver->SetFrameInterval(frameInterval);
+
     m_pFrameObserver->StartStream(m_BlockingMode, m_DeviceFileDescriptor, pixelFormat,
                                   payloadSize, width, height, bytesPerLine,
                                   enableLogging);
@@ -2254,6 +2309,7 @@ int Camera::ReadFrameRate(uint32_t &numerator, uint32_t &denominator, uint32_t w
             {
                 numerator = parm.parm.capture.timeperframe.numerator;
                 denominator = parm.parm.capture.timeperframe.denominator;
+                result = 0;
                 LOG_EX("Camera::ReadFrameRate VIDIOC_G_PARM %s %d/%dOK",
                        m_FileDescriptorToNameMap[m_FrameRateDeviceFileDescriptor].c_str(), numerator, denominator);
             }
@@ -2527,6 +2583,20 @@ int Camera::DeleteUserBuffer()
     return result;
 }
 
+int Camera::SetDmabufImportFileDescriptors(const std::vector<int> &fileDescriptors)
+{
+    FrameObserverDMABUF *pObserver = dynamic_cast<FrameObserverDMABUF*>(m_pFrameObserver.data());
+    if (0 == pObserver)
+    {
+        LOG_EX("Camera::SetDmabufImportFileDescriptors current I/O method does not use dmabufs");
+        return -1;
+    }
+
+    pObserver->SetImportFileDescriptors(fileDescriptors);
+
+    return 0;
+}
+
 /*********************************************************************************************************/
 // Info
 /*********************************************************************************************************/
@@ -2957,6 +3027,73 @@ void Camera::SwitchFrameTransfer2GUI(bool showFrames)
     m_ShowFrames = showFrames;
 }
 
+void Camera::SetUserBufferPoolOptions(bool hugePages, bool lockMemory)
+{
+    m_UserBufferHugePages = hugePages;
+    m_UserBufferLockMemory = lockMemory;
+}
+
+void Camera::SetMmapCacheMode(MMAP_CACHE_MODE mode)
+{
+    m_MmapCacheMode = mode;
+}
+
+MMAP_CACHE_MODE Camera::GetMmapCacheMode()
+{
+    FrameObserverMMAP const *pFrameObserver = dynamic_cast<FrameObserverMMAP const*>(m_pFrameObserver.data());
+    return pFrameObserver ? pFrameObserver->GetCacheMode() : MMAP_CACHE_COHERENT;
+}
+
+bool Camera::UsesMmap()
+{
+    return dynamic_cast<FrameObserverMMAP const*>(m_pFrameObserver.data()) != nullptr;
+}
+
+void Camera::SetReadBandwidthSampling(bool enable)
+{
+    m_SampleReadBandwidth = enable;
+}
+
+BufferReadStatistics Camera::GetBufferReadStatistics()
+{
+    return m_pFrameObserver->GetBufferReadStatistics();
+}
+
+void Camera::SetBufferPoolPolicy(const BufferPoolPolicy &policy)
+{
+    m_BufferPoolPolicy = policy;
+}
+
+BufferPoolStatistics Camera::GetBufferPoolStatistics()
+{
+    return m_pFrameObserver->GetBufferPoolStatistics();
+}
+
+void Camera::SetCaptureWatchdogPolicy(const CaptureWatchdogPolicy &policy)
+{
+    m_CaptureWatchdogPolicy = policy;
+}
+
+CaptureWatchdogStatistics Camera::GetCaptureWatchdogStatistics()
+{
+    return m_pFrameObserver->GetCaptureWatchdog().GetStatistics();
+}
+
+std::vector<CaptureIncident> Camera::GetCaptureIncidents()
+{
+    return m_pFrameObserver->GetCaptureWatchdog().GetIncidents();
+}
+
+void Camera::SetBufferRequeuePolicy(const BufferRequeuePolicy &policy)
+{
+    m_BufferRequeuePolicy = policy;
+}
+
+CaptureLoopStatistics Camera::GetCaptureLoopStatistics()
+{
+    return m_pFrameObserver->GetCaptureLoopStatistics();
+}
+
 /*********************************************************************************************************/
 // Tools
 /*********************************************************************************************************/
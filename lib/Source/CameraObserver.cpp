@@ -19,6 +19,8 @@
 #include "CameraObserver.h"
 #include "Logger.h"
 
+#include <QMutexLocker>
+
 #include <errno.h>
 #include <fcntl.h>
 #include <IOHelper.h>
@@ -43,17 +45,23 @@ CameraObserver::~CameraObserver(void)
 
 void CameraObserver::Start()
 {
+    {
+        QMutexLocker locker(&m_AbortMutex);
+        m_bAbort = false;
+    }
     start();
 }
 
 void CameraObserver::Stop()
 {
     // stop the internal processing thread and wait until the thread is really stopped
-    m_bAbort = true;
+    {
+        QMutexLocker locker(&m_AbortMutex);
+        m_bAbort = true;
+        m_AbortCondition.wakeAll();
+    }
 
-    // wait until the thread is stopped
-    while (isRunning())
-        QThread::msleep(10);
+    wait();
 }
 
 void CameraObserver::SetTerminateFlag()
@@ -64,12 +72,20 @@ void CameraObserver::SetTerminateFlag()
 // Do the work within this thread
 void CameraObserver::run()
 {
+    const unsigned long CHECK_INTERVAL_MS = 1000;
+
+    QMutexLocker locker(&m_AbortMutex);
     while (!m_bAbort)
     {
+        locker.unlock();
         CheckDevices();
         CheckSubDevices();
+        locker.relock();
 
-        QThread::msleep(1000);
+        if (!m_bAbort)
+        {
+            m_AbortCondition.wait(&m_AbortMutex, CHECK_INTERVAL_MS);
+        }
     }
 }
 
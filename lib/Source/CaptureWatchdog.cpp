@@ -0,0 +1,253 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#include "CaptureWatchdog.h"
+#include "Logger.h"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+
+CaptureWatchdog::CaptureWatchdog()
+    : m_FrameInterval(0)
+    , m_MeasuredInterval(0)
+    , m_StreamStart(0)
+    , m_LastFrame(0)
+    , m_LastActivity(0)
+    , m_ErrorsInRow(0)
+    , m_ErrnoInRow(0)
+    , m_Attempts(0)
+    , m_AwaitingFrame(false)
+{
+}
+
+void CaptureWatchdog::SetPolicy(const CaptureWatchdogPolicy &policy)
+{
+    QMutexLocker locker(&m_Mutex);
+    m_Policy = policy;
+    m_Policy.errorStormCount = std::max<uint32_t>(m_Policy.errorStormCount, 1);
+}
+
+CaptureWatchdogPolicy CaptureWatchdog::GetPolicy() const
+{
+    QMutexLocker locker(&m_Mutex);
+    return m_Policy;
+}
+
+void CaptureWatchdog::SetFrameInterval(uint64_t microseconds)
+{
+    QMutexLocker locker(&m_Mutex);
+    m_FrameInterval = microseconds;
+}
+
+void CaptureWatchdog::Start(uint64_t now)
+{
+    QMutexLocker locker(&m_Mutex);
+    m_MeasuredInterval = 0;
+    m_StreamStart = now;
+    m_LastFrame = 0;
+    m_LastActivity = now;
+    m_ErrorsInRow = 0;
+    m_ErrnoInRow = 0;
+    m_Attempts = 0;
+    m_AwaitingFrame = false;
+    m_Incidents.clear();
+    m_Statistics = CaptureWatchdogStatistics();
+}
+
+void CaptureWatchdog::OnFrame(uint64_t now)
+{
+    QMutexLocker locker(&m_Mutex);
+
+    // the gap over an incident is no frame interval
+    if (m_LastFrame != 0 && !m_AwaitingFrame && now > m_LastFrame)
+    {
+        uint64_t const interval = now - m_LastFrame;
+        m_MeasuredInterval = (m_MeasuredInterval == 0) ? interval : (m_MeasuredInterval * 7 + interval) / 8;
+    }
+
+    if (m_AwaitingFrame)
+    {
+        m_AwaitingFrame = false;
+        CaptureIncident &incident = m_Incidents.back();
+        incident.firstFrameTimestamp = now;
+        uint64_t const lostSince = std::max(incident.lastFrameTimestamp, m_StreamStart);
+        m_Statistics.lostMicroseconds += now - std::min(lostSince, now);
+        ++m_Statistics.recoveries;
+    }
+
+    m_LastFrame = now;
+    m_LastActivity = now;
+    m_ErrorsInRow = 0;
+    m_ErrnoInRow = 0;
+    m_Attempts = 0;
+    m_Statistics.gaveUp = false;
+}
+
+void CaptureWatchdog::OnErrorFrame()
+{
+    QMutexLocker locker(&m_Mutex);
+    ++m_ErrorsInRow;
+}
+
+void CaptureWatchdog::OnDequeueError(int errorNumber)
+{
+    QMutexLocker locker(&m_Mutex);
+    ++m_ErrorsInRow;
+    m_ErrnoInRow = errorNumber;
+    ++m_Statistics.dequeueErrors;
+    m_Statistics.lastErrno = errorNumber;
+}
+
+void CaptureWatchdog::OnStarved(uint64_t now)
+{
+    QMutexLocker locker(&m_Mutex);
+    m_LastActivity = std::max(m_LastActivity, now);
+}
+
+uint64_t CaptureWatchdog::StallTimeout() const
+{
+    if (!m_Policy.enabled)
+    {
+        return 0;
+    }
+
+    uint64_t const interval = std::max(m_FrameInterval, m_MeasuredInterval);
+    if (interval == 0)
+    {
+        return uint64_t(m_Policy.defaultStallMilliseconds) * 1000;
+    }
+
+    return std::max(interval * m_Policy.stallFrameIntervals, uint64_t(m_Policy.minimumStallMilliseconds) * 1000);
+}
+
+bool CaptureWatchdog::Check(uint64_t now, CAPTURE_INCIDENT_TYPE &type)
+{
+    QMutexLocker locker(&m_Mutex);
+    if (!m_Policy.enabled || m_Statistics.gaveUp)
+    {
+        return false;
+    }
+
+    uint64_t const timeout = StallTimeout();
+    if (m_ErrorsInRow >= m_Policy.errorStormCount)
+    {
+        type = CAPTURE_INCIDENT_ERROR_STORM;
+    }
+    // every further attempt waits a little longer, a dead sensor is not hammered
+    else if (timeout != 0 && now > m_LastActivity && now - m_LastActivity >= timeout * (m_Attempts + 1))
+    {
+        type = CAPTURE_INCIDENT_STALL;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (m_Attempts >= m_Policy.maximumRecoveries)
+    {
+        m_Statistics.gaveUp = true;
+        LOG_EX("CaptureWatchdog::Check giving up after %u recoveries without a frame", m_Attempts);
+        return false;
+    }
+
+    ++m_Attempts;
+
+    return true;
+}
+
+CaptureIncident CaptureWatchdog::OnRecovery(CAPTURE_INCIDENT_TYPE type, uint64_t detected, uint64_t restarted)
+{
+    QMutexLocker locker(&m_Mutex);
+
+    CaptureIncident incident;
+    incident.type = type;
+    incident.attempt = m_Attempts;
+    incident.errorCount = m_ErrorsInRow;
+    incident.lastErrno = m_ErrnoInRow;
+    incident.lastFrameTimestamp = m_LastFrame;
+    incident.detectedTimestamp = detected;
+    incident.restartedTimestamp = restarted;
+    incident.firstFrameTimestamp = 0;
+
+    if (type == CAPTURE_INCIDENT_STALL)
+    {
+        ++m_Statistics.stalls;
+    }
+    else
+    {
+        ++m_Statistics.errorStorms;
+    }
+
+    // the previous restart did not bring frames back
+    if (m_AwaitingFrame)
+    {
+        ++m_Statistics.failedRecoveries;
+    }
+    if (restarted == 0)
+    {
+        ++m_Statistics.failedRecoveries;
+    }
+    m_AwaitingFrame = (restarted != 0);
+
+    m_ErrorsInRow = 0;
+    m_ErrnoInRow = 0;
+    m_LastActivity = (restarted != 0) ? restarted : detected;
+
+    m_Incidents.push_back(incident);
+    if (m_Incidents.size() > MAX_INCIDENTS)
+    {
+        m_Incidents.pop_front();
+    }
+
+    return incident;
+}
+
+std::vector<CaptureIncident> CaptureWatchdog::GetIncidents() const
+{
+    QMutexLocker locker(&m_Mutex);
+    return std::vector<CaptureIncident>(m_Incidents.begin(), m_Incidents.end());
+}
+
+CaptureWatchdogStatistics CaptureWatchdog::GetStatistics() const
+{
+    QMutexLocker locker(&m_Mutex);
+    CaptureWatchdogStatistics statistics = m_Statistics;
+    statistics.stallTimeoutMicroseconds = StallTimeout();
+
+    return statistics;
+}
+
+uint64_t CaptureWatchdog::GetStallTimeout() const
+{
+    QMutexLocker locker(&m_Mutex);
+    return StallTimeout();
+}
+
+const char* CaptureWatchdog::GetIncidentName(CAPTURE_INCIDENT_TYPE type)
+{
+    switch (type)
+    {
+        case CAPTURE_INCIDENT_STALL:
+            return "stall";
+        case CAPTURE_INCIDENT_ERROR_STORM:
+            return "error storm";
+    }
+
+    return "unknown";
+}
@@ -0,0 +1,233 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#include "ConversionPool.h"
+#include "ImageTransform.h"
+#include "LatencyStatistics.h"
+#include "ThreadConfig.h"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+
+ConversionPool::ConversionPool(uint32_t threadCount)
+    : m_NextSource(0)
+    , m_Stop(false)
+{
+    if (threadCount == 0)
+    {
+        threadCount = DefaultThreadCount();
+    }
+
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        m_Threads.push_back(std::make_unique<std::thread>([this] {
+            WorkerMain();
+        }));
+    }
+}
+
+ConversionPool::~ConversionPool()
+{
+    {
+        QMutexLocker locker(&m_Mutex);
+        m_Stop = true;
+        m_FrameAvailable.wakeAll();
+    }
+    for (auto &pThread : m_Threads)
+    {
+        pThread->join();
+    }
+
+    // waiting frames give their buffers back here
+    m_Sources.clear();
+}
+
+uint32_t ConversionPool::DefaultThreadCount()
+{
+    unsigned int const cpuCount = std::thread::hardware_concurrency();
+    return std::max(cpuCount, 2u) - 1;
+}
+
+int ConversionPool::AddSource(ResultFunc result)
+{
+    QMutexLocker locker(&m_Mutex);
+    auto pSource = std::make_unique<Source>();
+    pSource->result = std::move(result);
+    m_Sources.push_back(std::move(pSource));
+
+    return static_cast<int>(m_Sources.size() - 1);
+}
+
+void ConversionPool::RemoveSource(int id)
+{
+    FrameLease droppedLease;
+    QMutexLocker locker(&m_Mutex);
+    if (id < 0 || id >= static_cast<int>(m_Sources.size()))
+    {
+        return;
+    }
+
+    Source &source = *m_Sources[id];
+    source.removed = true;
+    source.pending = false;
+    droppedLease = std::move(source.lease);
+    while (source.busy)
+    {
+        m_SourceIdle.wait(&m_Mutex);
+    }
+    // the slot stays, ids of the other sources must not change
+    source.result = nullptr;
+}
+
+void ConversionPool::Submit(int id, BufferWrapper const& buffer, FrameLease lease)
+{
+    // released outside of the lock, requeuing a buffer may take a while
+    FrameLease replacedLease;
+    {
+        QMutexLocker locker(&m_Mutex);
+        if (id < 0 || id >= static_cast<int>(m_Sources.size()) || m_Sources[id]->removed || m_Stop)
+        {
+            return;
+        }
+
+        Source &source = *m_Sources[id];
+        if (source.pending)
+        {
+            ++source.statistics.replaced;
+        }
+        replacedLease = std::move(source.lease);
+        source.buffer = buffer;
+        source.lease = std::move(lease);
+        source.pending = true;
+
+        m_FrameAvailable.wakeOne();
+    }
+}
+
+void ConversionPool::Flush(int id)
+{
+    FrameLease droppedLease;
+    QMutexLocker locker(&m_Mutex);
+    if (id < 0 || id >= static_cast<int>(m_Sources.size()))
+    {
+        return;
+    }
+
+    m_Sources[id]->pending = false;
+    droppedLease = std::move(m_Sources[id]->lease);
+}
+
+ConversionSourceStatistics ConversionPool::GetStatistics(int id) const
+{
+    QMutexLocker locker(&m_Mutex);
+    if (id < 0 || id >= static_cast<int>(m_Sources.size()))
+    {
+        return ConversionSourceStatistics();
+    }
+
+    return m_Sources[id]->statistics;
+}
+
+uint32_t ConversionPool::GetThreadCount() const
+{
+    return static_cast<uint32_t>(m_Threads.size());
+}
+
+ConversionPool::Source* ConversionPool::NextPendingSource()
+{
+    size_t const count = m_Sources.size();
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t const index = (m_NextSource + i) % count;
+        Source *pSource = m_Sources[index].get();
+        if (pSource->pending && !pSource->busy)
+        {
+            m_NextSource = index + 1;
+            return pSource;
+        }
+    }
+
+    return NULL;
+}
+
+void ConversionPool::WorkerMain()
+{
+    threadconfig::ApplyToCurrentThread(THREAD_ROLE_CONVERSION);
+
+    // reused by the next frames unless a result function keeps a copy of it
+    QImage convertedImage;
+
+    m_Mutex.lock();
+    while (!m_Stop)
+    {
+        Source *pSource = NextPendingSource();
+        if (pSource == NULL)
+        {
+            m_FrameAvailable.wait(&m_Mutex);
+            continue;
+        }
+
+        BufferWrapper const buffer = pSource->buffer;
+        FrameLease lease = std::move(pSource->lease);
+        ResultFunc const &result = pSource->result;
+        pSource->pending = false;
+        pSource->busy = true;
+        m_Mutex.unlock();
+
+        uint64_t const conversionStart = LatencyStatistics::Now();
+
+        int const conversionResult = ImageTransform::ConvertFrame(buffer, convertedImage);
+
+        uint64_t const conversionEnd = LatencyStatistics::Now();
+        if (buffer.latencyStatistics)
+        {
+            buffer.latencyStatistics->Record(LATENCY_DISPATCH_TO_CONVERSION, buffer.timestamps.dispatched, conversionStart);
+            buffer.latencyStatistics->Record(LATENCY_CONVERSION, conversionStart, conversionEnd);
+        }
+
+        // the result function may still look at the raw frame
+        if (conversionResult == 0 && !convertedImage.isNull())
+        {
+            result(convertedImage, buffer);
+            if (buffer.latencyStatistics)
+            {
+                buffer.latencyStatistics->Record(LATENCY_DRIVER_TO_DISPLAY, buffer.timestamps.Origin(), LatencyStatistics::Now());
+            }
+        }
+        lease.Release();
+
+        m_Mutex.lock();
+        if (conversionResult == 0)
+        {
+            ++pSource->statistics.converted;
+        }
+        else
+        {
+            ++pSource->statistics.failed;
+        }
+        pSource->busy = false;
+        m_SourceIdle.wakeAll();
+        // a frame of this source may have arrived while it was busy
+        if (pSource->pending)
+        {
+            m_FrameAvailable.wakeOne();
+        }
+    }
+    m_Mutex.unlock();
+}
@@ -107,7 +107,7 @@ void EGLRenderSystem::UpdateScrollbars() {
     ScrollChanged();
 }
 
-void EGLRenderSystem::PassFrame(BufferWrapper const& buffer, std::function<void()> doneCallback) {
+void EGLRenderSystem::PassFrame(BufferWrapper const& buffer, FrameLease lease) {
     if(buffer.width != curWidth || buffer.height != curHeight || buffer.pixelFormat != curPixelformat) {
         glWidget->setFormat(buffer.width, buffer.height, buffer.pixelFormat);
         curWidth = buffer.width;
@@ -116,10 +116,14 @@ void EGLRenderSystem::PassFrame(BufferWrapper const& buffer, std::function<void(
         emit EffectiveSizeChanged();
     }
 
-    glWidget->nextFrame(buffer, doneCallback);
+    glWidget->nextFrame(buffer, std::move(lease));
     newFrame = true;
 }
 
+void EGLRenderSystem::ReleaseFrames() {
+    glWidget->releaseFrame();
+}
+
 void EGLRenderSystem::ScrollChanged() {
     glWidget->setScroll(horizontalScrollbar->value(), verticalScrollbar->value());
 }
@@ -1,10 +1,12 @@
 #include "EGLRenderWidget.h"
+#include "PlaneLayout.h"
 #include <QOpenGLContext>
 #include <QWheelEvent>
 #include <iostream>
 #include <QMutexLocker>
 #include <QOpenGLPixelTransferOptions>
 #include <QOffscreenSurface>
+#include <algorithm>
 #include <unordered_map>
 
 struct VertexData {
@@ -14,7 +16,8 @@ struct VertexData {
 
 namespace {
     template<unsigned bytesPerPixel>
-    void uploadRaw(QOpenGLTexture& texture, RenderSettings const& settings, BufferWrapper const& buffer) {
+    void uploadRaw(std::unique_ptr<QOpenGLTexture> const* textures, RenderSettings const& settings, BufferWrapper const& buffer) {
+       QOpenGLTexture& texture = *textures[0];
        /*
        QOpenGLPixelTransferOptions options;
        options.setRowLength(buffer.bytesPerLine);
@@ -34,6 +37,30 @@ namespace {
        gl.glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, buffer.width, buffer.height, settings.glPixelFormat, settings.glPixelType, buffer.data);
     }
 
+    // Every colour plane goes to its own texture straight from the capture buffer,
+    // the chroma textures have half the width and for 4:2:0 half the height.
+    void uploadPlanes(std::unique_ptr<QOpenGLTexture> const* textures, RenderSettings const&, BufferWrapper const& buffer) {
+       PlanarFormat format;
+       if(!planelayout::GetPlanarFormat(buffer.pixelFormat, format) || buffer.planeCount < format.planeCount) {
+           return;
+       }
+
+       auto & gl = *QOpenGLContext::currentContext()->functions();
+       gl.glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+       for(uint32_t i = 0; i < format.planeCount; ++i) {
+           bool const luma = (i == 0);
+           GLenum const glFormat = (!luma && format.planeCount == 2) ? GL_RG : GL_RED;
+           unsigned const bytesPerPixel = (glFormat == GL_RG) ? 2 : 1;
+           uint32_t const width = luma ? buffer.width : (buffer.width + 1) / 2;
+           uint32_t const height = luma ? buffer.height : (buffer.height + (1u << format.chromaVerticalShift) - 1) >> format.chromaVerticalShift;
+
+           textures[i]->bind();
+           gl.glPixelStorei(GL_UNPACK_ROW_LENGTH, buffer.planes[i].bytesPerLine / bytesPerPixel);
+           gl.glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, glFormat, GL_UNSIGNED_BYTE, buffer.planes[i].data);
+       }
+       gl.glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
     // Always explicitly return A=1.0 to avoid issues with AR24 and XR24 formats
     static std::string const shaderRGB = "return vec4(texture(image, v_uv).rgb, 1.0);";
     static std::string const shaderBGR = "return vec4(texture(image, v_uv).bgr, 1.0);";
@@ -155,6 +182,41 @@ namespace {
         #define channelUV r
     )eof" + shaderBaseYUV;
 
+    // Nearest sampling at the same uv picks the chroma sample of the pixel,
+    // the chroma textures only have a fraction of the luma texture's size
+    static std::string const shaderBasePlanarYUV = R"eof(
+        float y = texture(image, v_uv).r;
+        float u = sampleU - 0.5;
+        float v = sampleV - 0.5;
+
+        return vec4(
+            y + (1.403 * v),
+            y - (0.344 * u) - (0.714 * v),
+            y + (1.770 * u),
+            1.0
+        );
+    )eof";
+
+    static std::string const shaderNV12 = R"eof(
+        #define sampleU texture(chroma1, v_uv).r
+        #define sampleV texture(chroma1, v_uv).g
+    )eof" + shaderBasePlanarYUV;
+
+    static std::string const shaderNV21 = R"eof(
+        #define sampleU texture(chroma1, v_uv).g
+        #define sampleV texture(chroma1, v_uv).r
+    )eof" + shaderBasePlanarYUV;
+
+    static std::string const shaderYUV420 = R"eof(
+        #define sampleU texture(chroma1, v_uv).r
+        #define sampleV texture(chroma2, v_uv).r
+    )eof" + shaderBasePlanarYUV;
+
+    static std::string const shaderYVU420 = R"eof(
+        #define sampleU texture(chroma2, v_uv).r
+        #define sampleV texture(chroma1, v_uv).r
+    )eof" + shaderBasePlanarYUV;
+
     static std::unordered_map<uint32_t, RenderSettings> const renderSettings {
         { V4L2_PIX_FMT_RGB24,   { shaderRGB, GL_RGB, GL_UNSIGNED_BYTE, GL_RGB8, uploadRaw<3> } },
         { V4L2_PIX_FMT_BGR24,   { shaderBGR, GL_RGB, GL_UNSIGNED_BYTE, GL_RGB8, uploadRaw<3> } },
@@ -171,6 +233,20 @@ namespace {
         { V4L2_PIX_FMT_UYVY,    { shaderUYVY, GL_RG, GL_UNSIGNED_BYTE, GL_RG8, uploadRaw<2> } },
         { V4L2_PIX_FMT_YUYV,    { shaderYUYV, GL_RG, GL_UNSIGNED_BYTE, GL_RG8, uploadRaw<2> } },
 
+        // The settings describe the luma plane, the chroma textures follow from the PlanarFormat
+        { V4L2_PIX_FMT_NV12,    { shaderNV12, GL_RED, GL_UNSIGNED_BYTE, GL_R8, uploadPlanes } },
+        { V4L2_PIX_FMT_NV12M,   { shaderNV12, GL_RED, GL_UNSIGNED_BYTE, GL_R8, uploadPlanes } },
+        { V4L2_PIX_FMT_NV21,    { shaderNV21, GL_RED, GL_UNSIGNED_BYTE, GL_R8, uploadPlanes } },
+        { V4L2_PIX_FMT_NV21M,   { shaderNV21, GL_RED, GL_UNSIGNED_BYTE, GL_R8, uploadPlanes } },
+        { V4L2_PIX_FMT_NV16,    { shaderNV12, GL_RED, GL_UNSIGNED_BYTE, GL_R8, uploadPlanes } },
+        { V4L2_PIX_FMT_NV16M,   { shaderNV12, GL_RED, GL_UNSIGNED_BYTE, GL_R8, uploadPlanes } },
+        { V4L2_PIX_FMT_NV61,    { shaderNV21, GL_RED, GL_UNSIGNED_BYTE, GL_R8, uploadPlanes } },
+        { V4L2_PIX_FMT_NV61M,   { shaderNV21, GL_RED, GL_UNSIGNED_BYTE, GL_R8, uploadPlanes } },
+        { V4L2_PIX_FMT_YUV420,  { shaderYUV420, GL_RED, GL_UNSIGNED_BYTE, GL_R8, uploadPlanes } },
+        { V4L2_PIX_FMT_YUV420M, { shaderYUV420, GL_RED, GL_UNSIGNED_BYTE, GL_R8, uploadPlanes } },
+        { V4L2_PIX_FMT_YVU420,  { shaderYVU420, GL_RED, GL_UNSIGNED_BYTE, GL_R8, uploadPlanes } },
+        { V4L2_PIX_FMT_YVU420M, { shaderYVU420, GL_RED, GL_UNSIGNED_BYTE, GL_R8, uploadPlanes } },
+
         // Note: The i.MX8 Vivante GPU really doesn't like integer textures. Uploading 16 bit integer values
         //       and using GL_RED_INTEGER / GL_UNSIGNED_SHORT / GL_R16UI led to glTexSubImage taking more than 100x
         //       as long as just uploading to a GL_RG8 target.
@@ -195,6 +271,8 @@ namespace {
         precision highp float;
         precision highp int;
         uniform sampler2D image;
+        uniform sampler2D chroma1;
+        uniform sampler2D chroma2;
         uniform vec2 texSize;
         varying vec2 v_uv;
         vec4 convert() {
@@ -221,8 +299,10 @@ bool EGLRenderWidget::canRender(uint32_t pixelFormat) {
         return ((err == GL_NO_ERROR) && v >= 3) || rgExt;
     }();
     auto const renderSettingsIt = renderSettings.find(pixelFormat);
+    PlanarFormat format;
+    bool const semiPlanar = planelayout::GetPlanarFormat(pixelFormat, format) && format.planeCount == 2;
     return (renderSettingsIt != renderSettings.end())
-           && ((renderSettingsIt->second.glPixelFormat != GL_RG) || rgTextureSupported);
+           && ((renderSettingsIt->second.glPixelFormat != GL_RG && !semiPlanar) || rgTextureSupported);
 }
 
 void EGLRenderWidget::initializeGL() {
@@ -261,7 +341,9 @@ EGLRenderWidget::~EGLRenderWidget() {
     vertices.destroy();
     makeCurrent();
     shader.reset();
-    texture.reset();
+    for(auto & texture : textures) {
+        texture.reset();
+    }
     fragmentShader.reset();
     vertexShader.reset();
     doneCurrent();
@@ -319,12 +401,29 @@ void EGLRenderWidget::paintGL() {
 
         currentRenderSettings = &renderSettingsIt->second;
 
-        texture = std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target2D);
-        texture->setSize(textureWidth, textureHeight);
-        texture->setMinMagFilters(QOpenGLTexture::Nearest, QOpenGLTexture::Nearest);
+        auto const createTexture = [](int width, int height, GLenum internalFormat, GLenum pixelFormat, GLenum pixelType) {
+            auto texture = std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target2D);
+            texture->setSize(width, height);
+            texture->setMinMagFilters(QOpenGLTexture::Nearest, QOpenGLTexture::Nearest);
+
+            texture->setFormat(QOpenGLTexture::TextureFormat(internalFormat));
+            texture->allocateStorage(QOpenGLTexture::PixelFormat(pixelFormat), QOpenGLTexture::PixelType(pixelType));
+            return texture;
+        };
 
-        texture->setFormat(QOpenGLTexture::TextureFormat(currentRenderSettings->glInternalFormat));
-        texture->allocateStorage(QOpenGLTexture::PixelFormat(currentRenderSettings->glPixelFormat), QOpenGLTexture::PixelType(currentRenderSettings->glPixelType));
+        textures[0] = createTexture(textureWidth, textureHeight, currentRenderSettings->glInternalFormat,
+                                    currentRenderSettings->glPixelFormat, currentRenderSettings->glPixelType);
+
+        PlanarFormat format;
+        bool const planar = planelayout::GetPlanarFormat(pixelFormat, format);
+        for(uint32_t i = 1; i < BUFFER_MAX_PLANES; ++i) {
+            textures[i].reset();
+            if(planar && i < format.planeCount) {
+                bool const semiPlanar = (format.planeCount == 2);
+                textures[i] = createTexture(std::max(textureWidth / 2, 1), std::max(textureHeight >> format.chromaVerticalShift, 1),
+                                            semiPlanar ? GL_RG8 : GL_R8, semiPlanar ? GL_RG : GL_RED, GL_UNSIGNED_BYTE);
+            }
+        }
 
         fragmentShader = std::make_unique<QOpenGLShader>(QOpenGLShader::Fragment);
         bool const compiled = fragmentShader->compileSourceCode(QString(pixelShaderFramework).arg(currentRenderSettings->fragmentShaderSource.c_str()));
@@ -352,15 +451,23 @@ void EGLRenderWidget::paintGL() {
 
         matrixUniformLocation = shader->uniformLocation("matrix");
         textureUniformLocation = shader->uniformLocation("image");
+        chromaUniformLocations[0] = shader->uniformLocation("chroma1");
+        chromaUniformLocations[1] = shader->uniformLocation("chroma2");
         texSizeUniformLocation = shader->uniformLocation("texSize");
     }
 
     {
         QMutexLocker locker(&dataMutex);
-        if(nextDoneCallback) {
-            currentRenderSettings->uploadData(*texture, *currentRenderSettings, nextBuffer);
-            nextDoneCallback();
-            nextDoneCallback = std::function<void()>();
+        if(nextLease) {
+            uint64_t const uploadStart = LatencyStatistics::Now();
+            currentRenderSettings->uploadData(textures, *currentRenderSettings, nextBuffer);
+            uint64_t const uploadEnd = LatencyStatistics::Now();
+            if(nextBuffer.latencyStatistics) {
+                nextBuffer.latencyStatistics->Record(LATENCY_DISPATCH_TO_CONVERSION, nextBuffer.timestamps.dispatched, uploadStart);
+                nextBuffer.latencyStatistics->Record(LATENCY_TEXTURE_UPLOAD, uploadStart, uploadEnd);
+                nextBuffer.latencyStatistics->Record(LATENCY_DRIVER_TO_DISPLAY, nextBuffer.timestamps.Origin(), uploadEnd);
+            }
+            nextLease.Release();
         }
     }
     
@@ -371,7 +478,13 @@ void EGLRenderWidget::paintGL() {
     shader->setUniformValue(matrixUniformLocation, fullMatrix);
     shader->setUniformValue(textureUniformLocation, 0);
     shader->setUniformValue(texSizeUniformLocation, QVector2D(textureWidth, textureHeight));
-    texture->bind(0);
+    textures[0]->bind(0);
+    for(int i = 1; i < BUFFER_MAX_PLANES; ++i) {
+        if(textures[i]) {
+            shader->setUniformValue(chromaUniformLocations[i - 1], i);
+            textures[i]->bind(i);
+        }
+    }
 
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
     onDraw();
@@ -420,17 +533,21 @@ void EGLRenderWidget::setFlip(bool flipX, bool flipY) {
     updateViewMatrix();
 }
 
-void EGLRenderWidget::nextFrame(BufferWrapper const& buffer, std::function<void()> doneCallback) {
+void EGLRenderWidget::nextFrame(BufferWrapper const& buffer, FrameLease lease) {
     QMutexLocker locker(&dataMutex);
-    if(nextDoneCallback) {
-      nextDoneCallback();
-    }
-    nextDoneCallback = doneCallback;
+    // a frame which has not been uploaded yet is dropped and released here
+    nextLease = std::move(lease);
     nextBuffer = buffer;
     locker.unlock();
     update();
 }
 
+void EGLRenderWidget::releaseFrame() {
+    // paintGL runs on the GUI thread, which may be busy stopping the stream
+    QMutexLocker locker(&dataMutex);
+    nextLease.Release();
+}
+
 void EGLRenderWidget::resizeEvent(QResizeEvent* event) {
     emit resized();
     QOpenGLWidget::resizeEvent(event);
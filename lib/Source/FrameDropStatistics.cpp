@@ -0,0 +1,149 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+#include "FrameDropStatistics.h"
+#include <QMutexLocker>
+
+FrameDropStatistics::FrameDropStatistics()
+    : m_CurrentSecondStart(Clock::now())
+    , m_HasSequence(false)
+    , m_LastSequence(0)
+    , m_QueuedBuffers(0)
+{
+}
+
+void FrameDropStatistics::Reset()
+{
+    QMutexLocker lock(&m_Mutex);
+    m_Totals = FrameDropCounters();
+    m_CurrentSecond = FrameDropCounters();
+    m_History.clear();
+    m_CurrentSecondStart = Clock::now();
+    m_HasSequence = false;
+}
+
+void FrameDropStatistics::AdvanceHistory(Clock::time_point now) const
+{
+    while (now - m_CurrentSecondStart >= std::chrono::seconds(1))
+    {
+        m_History.push_back(m_CurrentSecond);
+        if (m_History.size() > HISTORY_SECONDS)
+        {
+            m_History.pop_front();
+        }
+        m_CurrentSecond = FrameDropCounters();
+        m_CurrentSecondStart += std::chrono::seconds(1);
+
+        // don't fill the history with a long idle period second by second
+        if (now - m_CurrentSecondStart > std::chrono::seconds(HISTORY_SECONDS))
+        {
+            m_CurrentSecondStart = now;
+        }
+    }
+}
+
+template <typename F>
+void FrameDropStatistics::Account(F const &update)
+{
+    update(m_Totals);
+    update(m_CurrentSecond);
+}
+
+void FrameDropStatistics::OnBufferDequeued(const v4l2_buffer &buf)
+{
+    QMutexLocker lock(&m_Mutex);
+    Clock::time_point const now = Clock::now();
+    AdvanceHistory(now);
+
+    uint64_t gap = 0;
+    if (m_HasSequence)
+    {
+        // unsigned arithmetic also handles the wrap around of the 32 bit counter
+        uint32_t const expected = m_LastSequence + 1;
+        uint32_t const skipped = buf.sequence - expected;
+        // a sequence going backwards means the driver restarted counting
+        if (skipped < 0x80000000u)
+        {
+            gap = skipped;
+        }
+    }
+    m_HasSequence = true;
+    m_LastSequence = buf.sequence;
+
+    bool const error = (buf.flags & V4L2_BUF_FLAG_ERROR) != 0;
+
+    bool starved = false;
+    if (m_QueuedBuffers > 0)
+    {
+        --m_QueuedBuffers;
+        if (m_QueuedBuffers == 0)
+        {
+            starved = true;
+            m_StarvedSince = now;
+        }
+    }
+
+    Account([&](FrameDropCounters &counters) {
+        counters.frames++;
+        counters.sequenceGaps += gap;
+        counters.errorFrames += error ? 1 : 0;
+        counters.starvations += starved ? 1 : 0;
+    });
+}
+
+void FrameDropStatistics::OnBufferQueued()
+{
+    QMutexLocker lock(&m_Mutex);
+
+    if (m_QueuedBuffers == 0 && m_HasSequence)
+    {
+        Clock::time_point const now = Clock::now();
+        AdvanceHistory(now);
+        uint64_t const starvedMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(now - m_StarvedSince).count();
+        Account([&](FrameDropCounters &counters) {
+            counters.starvedMicroseconds += starvedMicroseconds;
+        });
+    }
+
+    ++m_QueuedBuffers;
+}
+
+void FrameDropStatistics::OnBuffersReleased()
+{
+    QMutexLocker lock(&m_Mutex);
+    m_QueuedBuffers = 0;
+    m_HasSequence = false;
+}
+
+FrameDropCounters FrameDropStatistics::GetTotals() const
+{
+    QMutexLocker lock(&m_Mutex);
+    return m_Totals;
+}
+
+std::deque<FrameDropCounters> FrameDropStatistics::GetHistory() const
+{
+    QMutexLocker lock(&m_Mutex);
+    AdvanceHistory(Clock::now());
+    return m_History;
+}
+
+int FrameDropStatistics::GetQueuedBufferCount() const
+{
+    QMutexLocker lock(&m_Mutex);
+    return m_QueuedBuffers;
+}
@@ -0,0 +1,115 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#include "FrameLease.h"
+#include "FrameObserver.h"
+
+#include <utility>
+
+FrameLease::FrameLease()
+    : m_pOwner(nullptr)
+    , m_pBuffer(nullptr)
+    , m_Index(0)
+{
+}
+
+FrameLease::FrameLease(FrameObserver *pOwner, UserBuffer *pBuffer, uint32_t index)
+    : m_pOwner(pOwner)
+    , m_pBuffer(pBuffer)
+    , m_Index(index)
+{
+    if (m_pBuffer)
+    {
+        m_pBuffer->leaseCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+FrameLease::FrameLease(const FrameLease &other)
+    : m_pOwner(other.m_pOwner)
+    , m_pBuffer(other.m_pBuffer)
+    , m_Index(other.m_Index)
+{
+    if (m_pBuffer)
+    {
+        m_pBuffer->leaseCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+FrameLease::FrameLease(FrameLease &&other) noexcept
+    : m_pOwner(other.m_pOwner)
+    , m_pBuffer(other.m_pBuffer)
+    , m_Index(other.m_Index)
+{
+    other.m_pOwner = nullptr;
+    other.m_pBuffer = nullptr;
+}
+
+FrameLease& FrameLease::operator=(const FrameLease &other)
+{
+    FrameLease copy(other);
+    *this = std::move(copy);
+    return *this;
+}
+
+FrameLease& FrameLease::operator=(FrameLease &&other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+        m_pOwner = other.m_pOwner;
+        m_pBuffer = other.m_pBuffer;
+        m_Index = other.m_Index;
+        other.m_pOwner = nullptr;
+        other.m_pBuffer = nullptr;
+    }
+    return *this;
+}
+
+FrameLease::~FrameLease()
+{
+    Release();
+}
+
+void FrameLease::Release()
+{
+    if (m_pBuffer)
+    {
+        // acq_rel: all reads of the frame data have to happen before the buffer is requeued
+        if (m_pBuffer->leaseCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            m_pOwner->ReleaseBuffer(m_Index);
+        }
+        m_pOwner = nullptr;
+        m_pBuffer = nullptr;
+    }
+}
+
+void FrameLease::operator()()
+{
+    Release();
+}
+
+FrameLease::operator bool() const
+{
+    return m_pBuffer != nullptr;
+}
+
+uint32_t FrameLease::GetIndex() const
+{
+    return m_Index;
+}
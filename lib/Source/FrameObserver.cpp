@@ -17,23 +17,41 @@
 
 
 #include "FrameObserver.h"
+#include "IOHelper.h"
+#include "LocalMutexLockGuard.h"
 #include "Logger.h"
+#include "MemoryHelper.h"
+#include "PlaneLayout.h"
+#include "ThreadConfig.h"
 
-#include <QApplication>
+#include <QDeadlineTimer>
+#include <QMutexLocker>
 #include <QPixmap>
 #include <errno.h>
 #include <fcntl.h>
 #include <linux/videodev2.h>
 #include <sstream>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <unistd.h>
 #include <iostream>
-#include <cassert>
+#include <algorithm>
+#include <climits>
 
 
+// This function returns the steady clock in nanoseconds, for timestamps shared between threads
+static int64_t SteadyClockNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 FrameObserver::FrameObserver(bool showFrames)
     : m_nFileDescriptor(0)
+    , m_EpollFileDescriptor(-1)
+    , m_WakeupFileDescriptor(-1)
     , m_BufferType(V4L2_BUF_TYPE_VIDEO_CAPTURE)
     , m_PixelFormat(0)
     , m_nWidth(0)
@@ -41,21 +59,75 @@ FrameObserver::FrameObserver(bool showFrames)
     , m_PayloadSize(0)
     , m_RealPayloadSize(0)
     , m_BytesPerLine(0)
+    , m_MemoryPlaneCount(1)
     , m_FrameId(0)
     , m_DQBUF_last_errno(0)
     , m_MessageSendFlag(false)
     , m_BlockingMode(false)
     , m_IsStreamRunning(false)
-    , m_bStreamStopped(true)
     , m_EnableLogging(0)
     , m_ShowFrames(showFrames)
+    , m_ReturnWakeupPending(false)
+    , m_DriverBufferCount(0)
+    , m_ReturnWakeupThreshold(INT_MAX)
+    , m_OldestPendingRequeue(0)
+    , m_CaptureLoopStart(0)
+    , m_CaptureLoopEnd(0)
+    , m_LoopFrames(0)
+    , m_LoopWakeups(0)
+    , m_DequeueCalls(0)
+    , m_QueueCalls(0)
+    , m_OtherCalls(0)
+    , m_RequeueBatches(0)
+    , m_LargestRequeueBatch(0)
+    , m_WaitingForLeases(false)
+    , m_QuietSeconds(0)
+    , m_CanRemoveBuffers(true)
+    , m_SampleReadBandwidth(false)
+    , m_ReadChecksum(0)
 {
+    CLEAR(m_PlaneFormats);
+    CLEAR(m_DequeuePlanes);
+    m_PendingRequeue.reserve(MAX_VIEWER_USER_BUFFER_COUNT);
+
+    m_EpollFileDescriptor = epoll_create1(EPOLL_CLOEXEC);
+    if (m_EpollFileDescriptor < 0)
+    {
+        LOG_EX("FrameObserver::FrameObserver epoll_create1 failed errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+    }
+
+    m_WakeupFileDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_WakeupFileDescriptor < 0)
+    {
+        LOG_EX("FrameObserver::FrameObserver eventfd failed errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+    }
+
+    if (m_EpollFileDescriptor >= 0 && m_WakeupFileDescriptor >= 0)
+    {
+        epoll_event event;
+        CLEAR(event);
+        event.events = EPOLLIN;
+        event.data.fd = m_WakeupFileDescriptor;
+        if (epoll_ctl(m_EpollFileDescriptor, EPOLL_CTL_ADD, m_WakeupFileDescriptor, &event) < 0)
+        {
+            LOG_EX("FrameObserver::FrameObserver epoll_ctl for wakeup failed errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        }
+    }
 }
 
 FrameObserver::~FrameObserver()
 {
     StopStream();
     wait();
+
+    if (m_WakeupFileDescriptor >= 0)
+    {
+        close(m_WakeupFileDescriptor);
+    }
+    if (m_EpollFileDescriptor >= 0)
+    {
+        close(m_EpollFileDescriptor);
+    }
 }
 
 int FrameObserver::StartStream(bool blockingMode, int fileDescriptor, uint32_t pixelFormat,
@@ -70,12 +142,66 @@ int FrameObserver::StartStream(bool blockingMode, int fileDescriptor, uint32_t p
     m_nHeight = height;
     m_FrameId = 0;
     m_ReceivedFPS.clear();
+    m_DropStatistics.Reset();
+    m_LatencyStatistics.Reset();
+    m_Watchdog.Start(LatencyStatistics::Now());
+    {
+        QMutexLocker locker(&m_ReadStatisticsMutex);
+        m_ReadStatistics = BufferReadStatistics();
+    }
+    m_LastReadSample = std::chrono::steady_clock::time_point();
+    for (size_t i = 0; i < m_rawDataProcessors.size(); ++i) {
+        m_rawDataProcessors[i]->ResetStatistics();
+    }
     m_PayloadSize = payloadSize;
     m_PixelFormat = pixelFormat;
     m_BytesPerLine = bytesPerLine;
     m_MessageSendFlag = false;
 
-    m_bStreamStopped = false;
+    // indices left over from the previous stream would be queued twice,
+    // QueueAllUserBuffer has queued every buffer again
+    m_ReturnedBuffers.Reset();
+    m_ReturnWakeupPending = false;
+    m_PendingRequeue.clear();
+    m_RequeuePolicy = m_RequestedRequeuePolicy;
+    m_RequeuePolicy.batchSize = std::max<uint32_t>(m_RequeuePolicy.batchSize, 1);
+    // without batching every released buffer wakes the capture thread
+    m_ReturnWakeupThreshold = m_RequeuePolicy.batching ? static_cast<int>(m_RequeuePolicy.minimumQueued) : INT_MAX;
+
+    m_CaptureLoopStart = SteadyClockNanoseconds();
+    m_CaptureLoopEnd = 0;
+    m_LoopFrames = 0;
+    m_LoopWakeups = 0;
+    m_DequeueCalls = 0;
+    m_QueueCalls = 0;
+    m_OtherCalls = 0;
+    m_RequeueBatches = 0;
+    m_LargestRequeueBatch = 0;
+
+    {
+        QMutexLocker locker(&m_PoolMutex);
+        for (size_t i = 0; i < m_UserBufferContainerList.size(); ++i)
+        {
+            UserBuffer *pBuffer = m_UserBufferContainerList[i];
+            pBuffer->retired = false;
+            pBuffer->parked = false;
+            pBuffer->queued = true;
+        }
+        m_DriverBufferCount = static_cast<int>(m_UserBufferContainerList.size());
+        m_BufferPoolStatistics = BufferPoolStatistics();
+        m_BufferPoolStatistics.activeCount = static_cast<uint32_t>(m_UserBufferContainerList.size());
+        m_BufferPoolStatistics.allocatedCount = m_BufferPoolStatistics.activeCount;
+        m_BufferPoolStatistics.peakCount = m_BufferPoolStatistics.activeCount;
+        m_BufferPoolStatistics.activeBytes = uint64_t(m_BufferPoolStatistics.activeCount) * m_RealPayloadSize;
+        m_LastPoolAdaption = std::chrono::steady_clock::now();
+        m_QuietSeconds = 0;
+        m_CanRemoveBuffers = true;
+    }
+
+    for (size_t i = 0; i < m_rawDataProcessors.size(); ++i) {
+        m_rawDataProcessors[i]->Resume();
+    }
+
     m_IsStreamRunning = true;
 
     m_EnableLogging = enableLogging;
@@ -87,62 +213,300 @@ int FrameObserver::StartStream(bool blockingMode, int fileDescriptor, uint32_t p
 
 int FrameObserver::StopStream()
 {
+    // Both limits only matter if something is broken, normally
+    // the capture thread ends within one wakeup
+    const unsigned long THREAD_STOP_TIMEOUT_MS = 3000;
+    const int LEASE_RELEASE_TIMEOUT_MS = 3000;
+
     int nResult = 0;
-    int count = 300;
+    uint64_t const stopStart = LatencyStatistics::Now();
 
     m_IsStreamRunning = false;
-
-    while (!m_bStreamStopped && count-- > 0) {
-        QThread::msleep(10);
+    // a blocking processor queue must not keep the capture thread from noticing the stop
+    for (size_t i = 0; i < m_rawDataProcessors.size(); ++i) {
+        m_rawDataProcessors[i]->Interrupt();
     }
+    WakeCaptureThread();
 
-    if (count <= 0) {
+    if (!wait(THREAD_STOP_TIMEOUT_MS))
+    {
+        LOG_EX("FrameObserver::StopStream capture thread did not stop within %lu ms", THREAD_STOP_TIMEOUT_MS);
         nResult = -1;
     }
 
-    for (auto const & buf : m_UserBufferContainerList) {
-        int timeout = 1000;
-        while (buf->processMap != 0 && timeout-- > 0)
+    // frames still waiting for a processor won't be needed anymore
+    for (size_t i = 0; i < m_rawDataProcessors.size(); ++i) {
+        m_rawDataProcessors[i]->Flush();
+
+        RawDataProcessorStatistics const statistics = m_rawDataProcessors[i]->GetStatistics();
+        if (m_EnableLogging)
         {
-            QApplication::processEvents();
-            QThread::msleep(10);
+            LOG_EX("FrameObserver::StopStream processor %zu policy=%d processed=%llu dropped=%llu max queue depth=%u/%u",
+                   i, statistics.policy, (unsigned long long)statistics.processed, (unsigned long long)statistics.dropped,
+                   statistics.maxQueueDepth, statistics.capacity);
         }
+    }
 
-        assert(timeout > 0);
+    if (!WaitForLeasesReleased(LEASE_RELEASE_TIMEOUT_MS))
+    {
+        LOG_EX("FrameObserver::StopStream buffers still leased after %d ms", LEASE_RELEASE_TIMEOUT_MS);
+        nResult = -1;
+    }
+
+    if (m_EnableLogging)
+    {
+        BufferPoolStatistics const pool = GetBufferPoolStatistics();
+        LOG_EX("FrameObserver::StopStream buffers active=%u allocated=%u peak=%u grown=%u shrunk=%u",
+               pool.activeCount, pool.allocatedCount, pool.peakCount, pool.grownCount, pool.shrunkCount);
+        LOG_EX("FrameObserver::StopStream took %llu us", (unsigned long long)(LatencyStatistics::Now() - stopStart));
     }
 
     return nResult;
 }
 
-int FrameObserver::AddRawDataProcessor(DataProcessorFunc processor)
+bool FrameObserver::WaitForLeasesReleased(int timeoutMs)
+{
+    QDeadlineTimer const deadline(timeoutMs);
+    QMutexLocker locker(&m_LeaseMutex);
+
+    // the releasing threads only signal while somebody waits, see ReleaseBuffer
+    m_WaitingForLeases = true;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    auto const isAnyLeased = [this] () {
+        for (size_t i = 0; i < m_UserBufferContainerList.size(); ++i)
+        {
+            UserBuffer const *pBuffer = m_UserBufferContainerList[i];
+            if (pBuffer != NULL && pBuffer->leaseCount.load(std::memory_order_acquire) != 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    bool released = true;
+    while (isAnyLeased())
+    {
+        if (!m_LeasesReleased.wait(&m_LeaseMutex, deadline))
+        {
+            released = !isAnyLeased();
+            break;
+        }
+    }
+
+    m_WaitingForLeases = false;
+
+    return released;
+}
+
+int FrameObserver::AddRawDataProcessor(DataProcessorFunc processor, PROCESSOR_QUEUE_POLICY policy, uint32_t queueDepth)
 {
     int index = m_rawDataProcessors.size();
-    m_rawDataProcessors.push_back(processor);
+    m_rawDataProcessors.push_back(std::make_unique<RawDataProcessorQueue>(std::move(processor), policy, queueDepth));
 
     return index;
 }
 
+int FrameObserver::GetRawDataProcessorStatistics(int index, RawDataProcessorStatistics &statistics) const
+{
+    if (index < 0 || index >= static_cast<int>(m_rawDataProcessors.size()))
+    {
+        return -1;
+    }
+
+    statistics = m_rawDataProcessors[index]->GetStatistics();
+
+    return 0;
+}
+
+int FrameObserver::GetRawDataProcessorCount() const
+{
+    return static_cast<int>(m_rawDataProcessors.size());
+}
+
+void FrameObserver::WakeCaptureThread()
+{
+    if (m_WakeupFileDescriptor >= 0)
+    {
+        uint64_t value = 1;
+        m_OtherCalls.fetch_add(1, std::memory_order_relaxed);
+        // EAGAIN only happens if the counter is saturated, which still means a pending wakeup
+        if (write(m_WakeupFileDescriptor, &value, sizeof(value)) < 0 && errno != EAGAIN)
+        {
+            LOG_EX("FrameObserver::WakeCaptureThread write to eventfd failed errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        }
+    }
+}
+
+void FrameObserver::ReleaseBuffer(uint32_t index)
+{
+    // The buffer itself is not touched here anymore, a stopped stream
+    // may delete it as soon as its lease count has dropped to 0
+    if (!m_ReturnedBuffers.Push(index))
+    {
+        LOG_EX("FrameObserver::ReleaseBuffer return queue full, buffer %u is not requeued", index);
+    }
+
+    // One wakeup covers all buffers returned until the capture thread drains the queue.
+    // The capture thread drains it after every frame anyway. With batching the next
+    // frame picks the buffer up, unless the driver is about to run out of buffers.
+    if (QThread::currentThread() != this
+        && m_DriverBufferCount.load(std::memory_order_relaxed) <= m_ReturnWakeupThreshold.load(std::memory_order_relaxed)
+        && !m_ReturnWakeupPending.exchange(true, std::memory_order_acq_rel))
+    {
+        WakeCaptureThread();
+    }
+
+    // a stopping stream may be waiting for this buffer
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_WaitingForLeases.load(std::memory_order_relaxed))
+    {
+        QMutexLocker locker(&m_LeaseMutex);
+        m_LeasesReleased.wakeAll();
+    }
+}
+
+void FrameObserver::ReturnReleasedBuffers()
+{
+    // acquire pairs with the release of the last wakeup, its index is visible below
+    m_ReturnWakeupPending.exchange(false, std::memory_order_acq_rel);
+
+    uint32_t index = 0;
+    uint64_t now = 0;
+    while (m_ReturnedBuffers.Pop(index))
+    {
+        if (m_PendingRequeue.empty())
+        {
+            now = (now == 0) ? LatencyStatistics::Now() : now;
+            m_OldestPendingRequeue = now;
+        }
+        m_PendingRequeue.push_back(index);
+    }
+
+    if (m_PendingRequeue.empty())
+    {
+        return;
+    }
+
+    if (m_RequeuePolicy.batching
+        && m_PendingRequeue.size() < m_RequeuePolicy.batchSize
+        && m_DriverBufferCount.load(std::memory_order_relaxed) > static_cast<int>(m_RequeuePolicy.minimumQueued))
+    {
+        now = (now == 0) ? LatencyStatistics::Now() : now;
+        if (now - m_OldestPendingRequeue < m_RequeuePolicy.maximumDelayMicroseconds)
+        {
+            return;
+        }
+    }
+
+    RequeuePendingBuffers();
+}
+
+void FrameObserver::RequeuePendingBuffers()
+{
+    uint64_t const now = LatencyStatistics::Now();
+    for (auto index : m_PendingRequeue)
+    {
+        if (index < m_UserBufferContainerList.size())
+        {
+            m_LatencyStatistics.Record(LATENCY_BUFFER_HOLD, m_UserBufferContainerList[index]->nDequeueTimestamp, now);
+        }
 
-uint64_t constexpr allOnes(int count) {
-    assert(count < sizeof(uint64_t) * 8);
-    return (1ULL << uint64_t(count)) - 1ULL;
+        RecycleBuffer(index);
+    }
+
+    uint32_t const batch = static_cast<uint32_t>(m_PendingRequeue.size());
+    m_RequeueBatches.fetch_add(1, std::memory_order_relaxed);
+    if (batch > m_LargestRequeueBatch.load(std::memory_order_relaxed))
+    {
+        m_LargestRequeueBatch.store(batch, std::memory_order_relaxed);
+    }
+    m_PendingRequeue.clear();
 }
 
+int FrameObserver::GetRequeueWaitTimeout(int timeoutMs) const
+{
+    if (m_PendingRequeue.empty())
+    {
+        return timeoutMs;
+    }
+
+    uint64_t const now = LatencyStatistics::Now();
+    uint64_t const due = m_OldestPendingRequeue + m_RequeuePolicy.maximumDelayMicroseconds;
+    // rounded up, a wait of 0 ms would spin until the buffers are due
+    int const remainingMs = (due > now) ? static_cast<int>((due - now + 999) / 1000) : 0;
+
+    return std::min(timeoutMs, remainingMs);
+}
 
-void FrameObserver::DequeueAndProcessFrame()
+void FrameObserver::RecycleBuffer(uint32_t index)
+{
+    if (index >= m_UserBufferContainerList.size())
+    {
+        return;
+    }
+
+    UserBuffer *pBuffer = m_UserBufferContainerList[index];
+    if (pBuffer->retired)
+    {
+        QMutexLocker locker(&m_PoolMutex);
+        // the pool may have grown again in the meantime
+        if (pBuffer->retired)
+        {
+            if (pBuffer->queued)
+            {
+                pBuffer->queued = false;
+                m_DriverBufferCount.fetch_sub(1, std::memory_order_relaxed);
+            }
+            pBuffer->parked = true;
+            DiscardUserBuffer(index);
+            return;
+        }
+    }
+
+    // a buffer of a restarted stream is queued again without ever leaving us
+    if (!pBuffer->queued)
+    {
+        pBuffer->queued = true;
+        m_DriverBufferCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_QueueCalls.fetch_add(1, std::memory_order_relaxed);
+    QueueSingleUserBuffer(index);
+}
+
+bool FrameObserver::DequeueAndProcessFrame()
 {
     v4l2_buffer buf;
     int result = 0;
 
+    m_DequeueCalls.fetch_add(1, std::memory_order_relaxed);
     result = ReadFrame(buf);
     if (0 == result)
     {
+        FrameTimestamps timestamps;
+        timestamps.dequeued = LatencyStatistics::Now();
+        timestamps.driver = LatencyStatistics::DriverTimestamp(buf);
+        m_LatencyStatistics.Record(LATENCY_DRIVER_TO_DEQUEUE, timestamps.driver, timestamps.dequeued);
+
+        m_DropStatistics.OnBufferDequeued(buf);
+
+        m_LoopFrames.fetch_add(1, std::memory_order_relaxed);
+        if (buf.index < m_UserBufferContainerList.size() && m_UserBufferContainerList[buf.index]->queued)
+        {
+            m_UserBufferContainerList[buf.index]->queued = false;
+            m_DriverBufferCount.fetch_sub(1, std::memory_order_relaxed);
+        }
+
         if (buf.flags & V4L2_BUF_FLAG_ERROR) 
         {
-            QueueSingleUserBuffer(buf.index);
-            return;
+            m_Watchdog.OnErrorFrame();
+            RecycleBuffer(buf.index);
+            return true;
         }
 
+        m_Watchdog.OnFrame(timestamps.dequeued);
+
         m_FrameId++;
         m_ReceivedFPS.trigger();
 
@@ -151,91 +515,253 @@ void FrameObserver::DequeueAndProcessFrame()
 
           if (0 == GetFrameData(buf, buffer, length))
           {
-              auto const procCount = m_rawDataProcessors.size();
-              if(procCount > 0) {
-                  m_UserBufferContainerList[buf.index]->processMap = allOnes(procCount);
-                  int i = 0;
-                  for (auto const & cb : m_rawDataProcessors) {
-                      cb(BufferWrapper { buf, buffer, length, m_nWidth, m_nHeight,
-                                         m_PixelFormat, m_PayloadSize, m_BytesPerLine, m_FrameId },
-                          [i, idx = buf.index, this] {
-                              auto& map = m_UserBufferContainerList[idx]->processMap;
-                              map &= ~(1ULL << i);
-                              if(map == 0) {
-                                QueueSingleUserBuffer(idx);
-                              }
-                          });
-                      ++i;
-                  }
-              } else {
-                  QueueSingleUserBuffer(buf.index);
+              UserBuffer *pUserBuffer = m_UserBufferContainerList[buf.index];
+              pUserBuffer->nDequeueTimestamp = timestamps.dequeued;
+
+              if (m_SampleReadBandwidth)
+              {
+                  SampleReadBandwidth(buffer, length);
+              }
+
+              timestamps.dispatched = LatencyStatistics::Now();
+              m_LatencyStatistics.Record(LATENCY_DEQUEUE_TO_DISPATCH, timestamps.dequeued, timestamps.dispatched);
+
+              BufferWrapper wrapper { buf, buffer, length, m_nWidth, m_nHeight,
+                                      m_PixelFormat, m_PayloadSize, m_BytesPerLine, m_FrameId,
+                                      pUserBuffer->nDmabufFd, timestamps, &m_LatencyStatistics };
+              DescribePlanes(buf, pUserBuffer, buffer, length, wrapper);
+
+              // Our own lease keeps the buffer while fanning out,
+              // it is requeued here if no processor holds on to it
+              FrameLease lease(this, pUserBuffer, buf.index);
+              for (auto const & processor : m_rawDataProcessors) {
+                  processor->Push(wrapper, lease);
               }
             }
             else
             {
-                QueueSingleUserBuffer(buf.index);
+                RecycleBuffer(buf.index);
             }
+        return true;
+    }
+    else if (errno != EAGAIN)
+    {
+        // e.g. EIO after the driver flagged the queue as broken, only a restart helps then
+        m_DQBUF_last_errno = errno;
+        m_Watchdog.OnDequeueError(errno);
+    }
+
+    return false;
+}
+
+int FrameObserver::ReadPlaneFormats()
+{
+    v4l2_format fmt;
+    CLEAR(fmt);
+    fmt.type = m_BufferType;
+
+    CLEAR(m_PlaneFormats);
+    m_MemoryPlaneCount = 1;
+
+    if (-1 == iohelper::xioctl(m_nFileDescriptor, VIDIOC_G_FMT, &fmt))
+    {
+        LOG_EX("FrameObserver::ReadPlaneFormats VIDIOC_G_FMT errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        return -1;
+    }
+
+    if (m_BufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
+    {
+        m_MemoryPlaneCount = std::min<uint32_t>(std::max<uint32_t>(fmt.fmt.pix_mp.num_planes, 1), VIDEO_MAX_PLANES);
+        for (uint32_t i = 0; i < m_MemoryPlaneCount; ++i)
+        {
+            m_PlaneFormats[i] = fmt.fmt.pix_mp.plane_fmt[i];
+            LOG_EX("FrameObserver::ReadPlaneFormats plane %u bytesperline=%u sizeimage=%u",
+                   i, m_PlaneFormats[i].bytesperline, m_PlaneFormats[i].sizeimage);
+        }
     }
     else
     {
-        if (!m_BlockingMode && errno != EAGAIN)
+        m_PlaneFormats[0].bytesperline = fmt.fmt.pix.bytesperline;
+        m_PlaneFormats[0].sizeimage = fmt.fmt.pix.sizeimage;
+    }
+
+    return 0;
+}
+
+void FrameObserver::DescribePlanes(const v4l2_buffer &buf, const UserBuffer *pUserBuffer,
+                                   uint8_t *buffer, uint32_t length, BufferWrapper &wrapper) const
+{
+    FramePlane memoryPlanes[VIDEO_MAX_PLANES];
+    uint32_t memoryPlaneCount = 1;
+
+    memoryPlanes[0] = { buffer, length, m_BytesPerLine };
+    if (buf.type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
+    {
+        memoryPlaneCount = std::min(std::min(buf.length, m_MemoryPlaneCount), pUserBuffer->nPlaneCount);
+        for (uint32_t i = 0; i < memoryPlaneCount; ++i)
         {
-            static int i = 0;
-            i++;
-            if (i % 10000 == 0 || static_cast<int32_t>(m_DQBUF_last_errno) != errno)
+            v4l2_plane const &plane = buf.m.planes[i];
+            uint8_t const *pPlane = (i == 0) ? buffer : pUserBuffer->pPlaneBuffers[i];
+            size_t planeLength = (i == 0) ? length : pUserBuffer->nPlaneLengths[i];
+            // the payload of a plane may start behind a header
+            if (plane.data_offset < planeLength)
             {
-                m_DQBUF_last_errno = errno;
+                pPlane += plane.data_offset;
+                planeLength -= plane.data_offset;
             }
+            memoryPlanes[i] = { pPlane, planeLength, m_PlaneFormats[i].bytesperline ? m_PlaneFormats[i].bytesperline : m_BytesPerLine };
+        }
+    }
+
+    if (planelayout::Split(m_PixelFormat, m_nHeight, memoryPlanes, memoryPlaneCount, wrapper.planes, wrapper.planeCount) != 0)
+    {
+        // the converters reject the frame, it is still passed on for recording
+        wrapper.planes[0] = memoryPlanes[0];
+        wrapper.planeCount = 1;
+    }
+}
+
+bool FrameObserver::IsFrameReady() const
+{
+    pollfd pfd;
+    pfd.fd = m_nFileDescriptor;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    m_OtherCalls.fetch_add(1, std::memory_order_relaxed);
+    return poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN);
+}
+
+void FrameObserver::DrainReadyFrames()
+{
+    // In non-blocking mode VIDIOC_DQBUF tells us with EAGAIN when the queue is empty.
+    // In blocking mode it would sleep instead, so ask the driver before every further dequeue.
+    while (m_IsStreamRunning && DequeueAndProcessFrame())
+    {
+        // synchronous processors are done, their buffers can go back right away
+        ReturnReleasedBuffers();
+
+        if (m_BlockingMode && !IsFrameReady())
+        {
+            break;
         }
     }
 }
 
+int FrameObserver::ControlDeviceEvents(int operation, uint32_t events)
+{
+    epoll_event event;
+    CLEAR(event);
+    event.events = events;
+    event.data.fd = m_nFileDescriptor;
+
+    m_OtherCalls.fetch_add(1, std::memory_order_relaxed);
+    int result = epoll_ctl(m_EpollFileDescriptor, operation, m_nFileDescriptor, &event);
+    if (result < 0)
+    {
+        LOG_EX("FrameObserver::ControlDeviceEvents epoll_ctl(%d) failed errno=%d=%s", operation, errno, v4l2helper::ConvertErrno2String(errno).c_str());
+    }
+
+    return result;
+}
+
 // Do the work within this thread
 void FrameObserver::run()
 {
-    m_IsStreamRunning = true;
+    // How long to wait before looking at the device again after it reported EPOLLERR,
+    // which V4L2 does e.g. while all buffers are held by the processors
+    const int ERROR_BACKOFF_TIMEOUT_MS = 10;
+    // Upper bound for a single wait, so a stalled device does not block us forever
+    const int WAIT_TIMEOUT_MS = 1000;
+
+    threadconfig::ApplyToCurrentThread(THREAD_ROLE_CAPTURE);
+
+    // m_IsStreamRunning is set by StartStream only, a StopStream before
+    // this thread got here must not be overwritten
+
+    if (m_EpollFileDescriptor < 0 || m_WakeupFileDescriptor < 0 || ControlDeviceEvents(EPOLL_CTL_ADD, EPOLLIN) < 0)
+    {
+        LOG_EX("FrameObserver::run cannot wait for frames of device %d", m_nFileDescriptor);
+        return;
+    }
+
+    bool deviceArmed = true;
 
     while (m_IsStreamRunning)
     {
-        fd_set fds;
-        struct timeval tv;
-        int result = -1;
+        epoll_event events[2];
+        int timeout = deviceArmed ? WAIT_TIMEOUT_MS : ERROR_BACKOFF_TIMEOUT_MS;
 
-        FD_ZERO(&fds);
-        FD_SET(m_nFileDescriptor, &fds);
+        // wake up often enough to notice a stall in time
+        uint64_t const stallTimeout = m_Watchdog.GetStallTimeout();
+        if (deviceArmed && stallTimeout != 0)
+        {
+            timeout = static_cast<int>(std::min<uint64_t>(WAIT_TIMEOUT_MS, std::max<uint64_t>(stallTimeout / 4000, ERROR_BACKOFF_TIMEOUT_MS)));
+        }
+
+        // collected buffers must not wait longer than the requeue policy allows
+        timeout = GetRequeueWaitTimeout(timeout);
 
-        if (m_BlockingMode)
+        int result = epoll_wait(m_EpollFileDescriptor, events, 2, timeout);
+        m_LoopWakeups.fetch_add(1, std::memory_order_relaxed);
+        m_OtherCalls.fetch_add(1, std::memory_order_relaxed);
+
+        if (result == -1)
         {
-            /* Timeout. */
-            tv.tv_sec = 1;
-            tv.tv_usec = 0;
+            if (errno != EINTR)
+            {
+                LOG_EX("FrameObserver::run epoll_wait failed errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+            }
+            continue;
+        }
 
-            result = select(m_nFileDescriptor + 1, &fds, NULL, NULL, &tv);
+        if (!deviceArmed)
+        {
+            if (0 == ControlDeviceEvents(EPOLL_CTL_MOD, EPOLLIN))
+            {
+                deviceArmed = true;
+            }
+        }
 
-            if (result == -1)
+        for (int i = 0; i < result; ++i)
+        {
+            if (events[i].data.fd == m_WakeupFileDescriptor)
             {
-                // Error
-                continue;
+                uint64_t value;
+                // Reset the counter, the request itself is carried by the member flags
+                do
+                {
+                    m_OtherCalls.fetch_add(1, std::memory_order_relaxed);
+                }
+                while (read(m_WakeupFileDescriptor, &value, sizeof(value)) > 0);
             }
-            else if (result == 0)
+            else if (events[i].events & EPOLLIN)
             {
-                // Timeout
-                QThread::msleep(0);
-                continue;
+                DrainReadyFrames();
             }
-            else
+            else if (events[i].events & EPOLLERR)
             {
-                DequeueAndProcessFrame();
+                // Level triggered EPOLLERR would wake us up continuously,
+                // so stop watching the device for a short while.
+                // A blocking dequeue would sleep while no buffer is queued at all.
+                if (!m_BlockingMode || IsFrameReady())
+                {
+                    DequeueAndProcessFrame();
+                }
+                if (0 == ControlDeviceEvents(EPOLL_CTL_MOD, 0))
+                {
+                    deviceArmed = false;
+                }
             }
         }
-        // non-blocking mode
-        else
-        {
-            DequeueAndProcessFrame();
-        }
+
+        ReturnReleasedBuffers();
+        AdaptBufferPool();
+        SuperviseCapture();
     }
 
-    m_bStreamStopped = true;
+    ControlDeviceEvents(EPOLL_CTL_DEL, 0);
+    m_CaptureLoopEnd = SteadyClockNanoseconds();
 }
 
 // Get the number of frames
@@ -245,12 +771,436 @@ double FrameObserver::GetReceivedFPS()
     return m_ReceivedFPS.getFPS();
 }
 
+void FrameObserver::SetBufferPoolPolicy(const BufferPoolPolicy &policy)
+{
+    QMutexLocker locker(&m_PoolMutex);
+    m_BufferPoolPolicy = policy;
+    m_BufferPoolPolicy.maximumCount = std::min<uint32_t>(m_BufferPoolPolicy.maximumCount, MAX_VIEWER_USER_BUFFER_COUNT);
+    m_BufferPoolPolicy.minimumCount = std::max<uint32_t>(std::min(m_BufferPoolPolicy.minimumCount, m_BufferPoolPolicy.maximumCount), 1);
+}
+
+BufferPoolStatistics FrameObserver::GetBufferPoolStatistics() const
+{
+    QMutexLocker locker(&m_PoolMutex);
+    return m_BufferPoolStatistics;
+}
+
+const FrameDropStatistics& FrameObserver::GetDropStatistics() const
+{
+    return m_DropStatistics;
+}
+
+LatencyStatistics& FrameObserver::GetLatencyStatistics()
+{
+    return m_LatencyStatistics;
+}
+
+void FrameObserver::SetBufferRequeuePolicy(const BufferRequeuePolicy &policy)
+{
+    m_RequestedRequeuePolicy = policy;
+}
+
+CaptureLoopStatistics FrameObserver::GetCaptureLoopStatistics() const
+{
+    CaptureLoopStatistics statistics;
+    statistics.frames = m_LoopFrames.load(std::memory_order_relaxed);
+    statistics.wakeups = m_LoopWakeups.load(std::memory_order_relaxed);
+    statistics.dequeueCalls = m_DequeueCalls.load(std::memory_order_relaxed);
+    statistics.queueCalls = m_QueueCalls.load(std::memory_order_relaxed);
+    statistics.otherCalls = m_OtherCalls.load(std::memory_order_relaxed);
+    statistics.requeueBatches = m_RequeueBatches.load(std::memory_order_relaxed);
+    statistics.largestBatch = m_LargestRequeueBatch.load(std::memory_order_relaxed);
+
+    int64_t const start = m_CaptureLoopStart.load();
+    int64_t const loopEnd = m_CaptureLoopEnd.load();
+    int64_t const end = (loopEnd > start) ? loopEnd : SteadyClockNanoseconds();
+    double const seconds = (end - start) / 1e9;
+    if (start != 0 && seconds > 0.0)
+    {
+        statistics.wakeupsPerSecond = statistics.wakeups / seconds;
+    }
+    if (statistics.frames != 0)
+    {
+        statistics.syscallsPerFrame = double(statistics.dequeueCalls + statistics.queueCalls + statistics.otherCalls) / statistics.frames;
+    }
+
+    return statistics;
+}
+
+void FrameObserver::SetCaptureWatchdogPolicy(const CaptureWatchdogPolicy &policy)
+{
+    m_Watchdog.SetPolicy(policy);
+}
+
+void FrameObserver::SetFrameInterval(uint64_t microseconds)
+{
+    m_Watchdog.SetFrameInterval(microseconds);
+}
+
+const CaptureWatchdog& FrameObserver::GetCaptureWatchdog() const
+{
+    return m_Watchdog;
+}
+
+void FrameObserver::SetReadBandwidthSampling(bool enable)
+{
+    m_SampleReadBandwidth = enable;
+}
+
+BufferReadStatistics FrameObserver::GetBufferReadStatistics() const
+{
+    QMutexLocker locker(&m_ReadStatisticsMutex);
+    return m_ReadStatistics;
+}
+
+void FrameObserver::SampleReadBandwidth(const uint8_t *pData, size_t length)
+{
+    // bounds the time the capture thread spends here, even with uncached memory
+    const size_t MAX_SAMPLE_BYTES = 4 * 1024 * 1024;
+
+    std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+    if (start - m_LastReadSample < std::chrono::seconds(1))
+    {
+        return;
+    }
+    m_LastReadSample = start;
+
+    // buffers are page aligned, whole groups of four words are read
+    size_t const wordCount = (std::min(length, MAX_SAMPLE_BYTES) / sizeof(uint64_t)) & ~size_t(3);
+    if (wordCount == 0)
+    {
+        return;
+    }
+
+    uint64_t const *pWords = reinterpret_cast<uint64_t const*>(pData);
+    uint64_t sum0 = 0;
+    uint64_t sum1 = 0;
+    uint64_t sum2 = 0;
+    uint64_t sum3 = 0;
+    for (size_t i = 0; i < wordCount; i += 4)
+    {
+        sum0 += pWords[i];
+        sum1 += pWords[i + 1];
+        sum2 += pWords[i + 2];
+        sum3 += pWords[i + 3];
+    }
+    m_ReadChecksum.store(sum0 + sum1 + sum2 + sum3, std::memory_order_relaxed);
+
+    uint64_t const nanoseconds = std::max<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(), 1);
+    uint64_t const bytes = wordCount * sizeof(uint64_t);
+    // bytes per nanosecond times 1000 are megabytes per second
+    double const megabytesPerSecond = 1000.0 * bytes / nanoseconds;
+
+    QMutexLocker locker(&m_ReadStatisticsMutex);
+    m_ReadStatistics.samples++;
+    m_ReadStatistics.bytes += bytes;
+    m_ReadStatistics.nanoseconds += nanoseconds;
+    m_ReadStatistics.lastMegabytesPerSecond = megabytesPerSecond;
+    m_ReadStatistics.bestMegabytesPerSecond = std::max(m_ReadStatistics.bestMegabytesPerSecond, megabytesPerSecond);
+}
+
 
 /*********************************************************************************************************/
 // Frame buffer handling
 /*********************************************************************************************************/
 
 
+int FrameObserver::AddUserBuffers(uint32_t bufferCount)
+{
+    return -1;
+}
+
+void FrameObserver::DiscardUserBuffer(uint32_t index)
+{
+}
+
+void FrameObserver::DeleteUserBuffer(UserBuffer *pBuffer)
+{
+    delete pBuffer;
+}
+
+void FrameObserver::AdaptBufferPool()
+{
+    std::chrono::steady_clock::time_point const now = std::chrono::steady_clock::now();
+    if (!m_BufferPoolPolicy.adaptive || now - m_LastPoolAdaption < std::chrono::seconds(1) || m_RealPayloadSize == 0)
+    {
+        return;
+    }
+    m_LastPoolAdaption = now;
+
+    std::deque<FrameDropCounters> const history = m_DropStatistics.GetHistory();
+    if (history.empty())
+    {
+        return;
+    }
+    FrameDropCounters const &lastSecond = history.back();
+
+    BufferPoolPolicy policy;
+    uint32_t activeCount = 0;
+    {
+        QMutexLocker locker(&m_PoolMutex);
+        policy = m_BufferPoolPolicy;
+        activeCount = m_BufferPoolStatistics.activeCount;
+    }
+
+    uint32_t limit = policy.maximumCount;
+    if (policy.memoryBudget != 0)
+    {
+        limit = static_cast<uint32_t>(std::min<uint64_t>(limit, policy.memoryBudget / m_RealPayloadSize));
+    }
+    // running out of buffers completely is worse than exceeding the budget
+    limit = std::max(limit, policy.minimumCount);
+
+    if (activeCount > limit)
+    {
+        m_QuietSeconds = 0;
+        ShrinkBufferPool(activeCount - limit);
+    }
+    else if (lastSecond.starvations != 0 || lastSecond.sequenceGaps != 0)
+    {
+        m_QuietSeconds = 0;
+        if (activeCount < limit)
+        {
+            GrowBufferPool(std::min(policy.growStep, limit - activeCount));
+        }
+    }
+    else if (++m_QuietSeconds >= policy.quietSeconds && activeCount > policy.minimumCount)
+    {
+        m_QuietSeconds = 0;
+        ShrinkBufferPool(1);
+    }
+
+    RemoveParkedBuffers();
+}
+
+void FrameObserver::GrowBufferPool(uint32_t bufferCount)
+{
+    std::vector<uint32_t> buffersToQueue;
+    uint32_t added = 0;
+    {
+        QMutexLocker locker(&m_PoolMutex);
+
+        // retired buffers come back first, they still exist
+        for (uint32_t i = 0; i < m_UserBufferContainerList.size() && added < bufferCount; ++i)
+        {
+            UserBuffer *pBuffer = m_UserBufferContainerList[i];
+            if (pBuffer->retired)
+            {
+                pBuffer->retired = false;
+                if (pBuffer->parked)
+                {
+                    pBuffer->parked = false;
+                    buffersToQueue.push_back(i);
+                }
+                ++added;
+            }
+        }
+
+        if (added < bufferCount)
+        {
+            uint32_t const firstIndex = static_cast<uint32_t>(m_UserBufferContainerList.size());
+            int const created = AddUserBuffers(bufferCount - added);
+            for (int i = 0; i < created; ++i)
+            {
+                buffersToQueue.push_back(firstIndex + i);
+            }
+            if (created > 0)
+            {
+                added += created;
+                m_BufferPoolStatistics.allocatedCount += created;
+            }
+        }
+
+        if (added != 0)
+        {
+            m_BufferPoolStatistics.activeCount += added;
+            m_BufferPoolStatistics.peakCount = std::max(m_BufferPoolStatistics.peakCount, m_BufferPoolStatistics.activeCount);
+            m_BufferPoolStatistics.activeBytes = uint64_t(m_BufferPoolStatistics.activeCount) * m_RealPayloadSize;
+            m_BufferPoolStatistics.grownCount++;
+        }
+    }
+
+    for (auto index : buffersToQueue)
+    {
+        RecycleBuffer(index);
+    }
+
+    if (added != 0)
+    {
+        LOG_EX("FrameObserver::GrowBufferPool added %u buffers, %u in circulation", added, GetBufferPoolStatistics().activeCount);
+    }
+}
+
+void FrameObserver::ShrinkBufferPool(uint32_t bufferCount)
+{
+    uint32_t retired = 0;
+    {
+        QMutexLocker locker(&m_PoolMutex);
+
+        // they are parked one by one as they come back from the driver
+        for (size_t i = m_UserBufferContainerList.size(); i-- > 0 && retired < bufferCount;)
+        {
+            UserBuffer *pBuffer = m_UserBufferContainerList[i];
+            if (!pBuffer->retired)
+            {
+                pBuffer->retired = true;
+                ++retired;
+            }
+        }
+
+        if (retired != 0)
+        {
+            m_BufferPoolStatistics.activeCount -= retired;
+            m_BufferPoolStatistics.activeBytes = uint64_t(m_BufferPoolStatistics.activeCount) * m_RealPayloadSize;
+            m_BufferPoolStatistics.shrunkCount++;
+        }
+    }
+
+    if (retired != 0)
+    {
+        LOG_EX("FrameObserver::ShrinkBufferPool retired %u buffers, %u in circulation", retired, GetBufferPoolStatistics().activeCount);
+    }
+}
+
+void FrameObserver::RemoveParkedBuffers()
+{
+#ifdef VIDIOC_REMOVE_BUFS
+    if (!m_CanRemoveBuffers)
+    {
+        return;
+    }
+
+    QMutexLocker locker(&m_PoolMutex);
+
+    size_t firstParked = m_UserBufferContainerList.size();
+    while (firstParked > 0 && m_UserBufferContainerList[firstParked - 1]->parked)
+    {
+        --firstParked;
+    }
+    if (firstParked == m_UserBufferContainerList.size())
+    {
+        return;
+    }
+
+    v4l2_remove_buffers remove;
+    CLEAR(remove);
+    remove.index = static_cast<uint32_t>(firstParked);
+    remove.count = static_cast<uint32_t>(m_UserBufferContainerList.size() - firstParked);
+    remove.type = m_BufferType;
+    if (-1 == iohelper::xioctl(m_nFileDescriptor, VIDIOC_REMOVE_BUFS, &remove))
+    {
+        LOG_EX("FrameObserver::RemoveParkedBuffers VIDIOC_REMOVE_BUFS failed, errno=%d=%s, retired buffers stay allocated",
+               errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        m_CanRemoveBuffers = false;
+        return;
+    }
+
+    std::vector<UserBuffer*> removed;
+    {
+        base::LocalMutexLockGuard guard(m_UsedBufferMutex);
+        for (size_t i = firstParked; i < m_UserBufferContainerList.size(); ++i)
+        {
+            removed.push_back(m_UserBufferContainerList[i]);
+        }
+        m_UserBufferContainerList.resize(firstParked);
+    }
+    for (auto pBuffer : removed)
+    {
+        DeleteUserBuffer(pBuffer);
+    }
+
+    m_BufferPoolStatistics.allocatedCount = static_cast<uint32_t>(firstParked);
+#else
+    // without VIDIOC_REMOVE_BUFS the driver keeps retired buffers until the stream ends
+    m_CanRemoveBuffers = false;
+#endif
+}
+
+void FrameObserver::SuperviseCapture()
+{
+    uint64_t const now = LatencyStatistics::Now();
+
+    // while the processors hold all buffers the driver can't deliver anything
+    if (m_DropStatistics.GetQueuedBufferCount() == 0)
+    {
+        m_Watchdog.OnStarved(now);
+        return;
+    }
+
+    CAPTURE_INCIDENT_TYPE type;
+    if (m_Watchdog.Check(now, type))
+    {
+        RecoverStream(type, now);
+    }
+}
+
+void FrameObserver::RecoverStream(CAPTURE_INCIDENT_TYPE type, uint64_t detected)
+{
+    LOG_EX("FrameObserver::RecoverStream %s on device %d, restarting the stream", CaptureWatchdog::GetIncidentName(type), m_nFileDescriptor);
+
+    uint64_t restarted = 0;
+    if (0 == StopDeviceStream())
+    {
+        // the driver has given back all queued buffers
+        m_DropStatistics.OnBuffersReleased();
+
+        // Only the buffers the driver had are requeued here, the ones of the processors
+        // come back through the return queue as usual. Both are requeued by this thread only.
+        std::vector<uint32_t> driverBuffers;
+        for (uint32_t i = 0; i < m_UserBufferContainerList.size(); ++i)
+        {
+            if (m_UserBufferContainerList[i]->queued)
+            {
+                driverBuffers.push_back(i);
+            }
+        }
+
+        for (auto index : driverBuffers)
+        {
+            RecycleBuffer(index);
+        }
+
+        if (0 == StartDeviceStream())
+        {
+            restarted = LatencyStatistics::Now();
+        }
+    }
+
+    CaptureIncident const incident = m_Watchdog.OnRecovery(type, detected, restarted);
+    uint64_t const lastFrame = incident.lastFrameTimestamp != 0 ? incident.lastFrameTimestamp : detected;
+    LOG_EX("FrameObserver::RecoverStream attempt %u %s: %llu us without frame, %u bad buffers, last errno=%d, %d buffers queued, restart %s in %llu us",
+           incident.attempt, CaptureWatchdog::GetIncidentName(type), (unsigned long long)(detected - std::min(lastFrame, detected)),
+           incident.errorCount, incident.lastErrno, m_DropStatistics.GetQueuedBufferCount(),
+           restarted != 0 ? "done" : "failed", (unsigned long long)(LatencyStatistics::Now() - detected));
+}
+
+int FrameObserver::StopDeviceStream()
+{
+    v4l2_buf_type type = m_BufferType;
+
+    if (-1 == iohelper::xioctl(m_nFileDescriptor, VIDIOC_STREAMOFF, &type))
+    {
+        LOG_EX("FrameObserver::StopDeviceStream VIDIOC_STREAMOFF failed errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        return -1;
+    }
+
+    return 0;
+}
+
+int FrameObserver::StartDeviceStream()
+{
+    v4l2_buf_type type = m_BufferType;
+
+    if (-1 == iohelper::xioctl(m_nFileDescriptor, VIDIOC_STREAMON, &type))
+    {
+        LOG_EX("FrameObserver::StartDeviceStream VIDIOC_STREAMON failed errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        return -1;
+    }
+
+    return 0;
+}
+
 void FrameObserver::SwitchFrameTransfer2GUI(bool showFrames)
 {
     m_ShowFrames = showFrames;
@@ -0,0 +1,474 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#include "FrameObserverDMABUF.h"
+#include "LocalMutexLockGuard.h"
+#include "Logger.h"
+#include "MemoryHelper.h"
+#include "V4L2Helper.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <IOHelper.h>
+#include <linux/udmabuf.h>
+#include <linux/videodev2.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstring>
+
+FrameObserverDMABUF::FrameObserverDMABUF(bool showFrames, DMABUF_MODE_TYPE mode)
+    : FrameObserver(showFrames)
+    , m_Mode(mode)
+    , m_Memory(mode == DMABUF_MODE_EXPORT ? V4L2_MEMORY_MMAP : V4L2_MEMORY_DMABUF)
+{
+}
+
+FrameObserverDMABUF::~FrameObserverDMABUF()
+{
+}
+
+void FrameObserverDMABUF::SetImportFileDescriptors(const std::vector<int> &fileDescriptors)
+{
+    base::LocalMutexLockGuard guard(m_UsedBufferMutex);
+
+    m_ImportFileDescriptors = fileDescriptors;
+}
+
+void FrameObserverDMABUF::PrepareBuffer(v4l2_buffer &buf, v4l2_plane *pPlanes, uint32_t index) const
+{
+    CLEAR(buf);
+    buf.type = m_BufferType;
+    buf.index = index;
+    buf.memory = m_Memory;
+
+    if (m_BufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
+    {
+        memset(pPlanes, 0, VIDEO_MAX_PLANES * sizeof(v4l2_plane));
+        buf.m.planes = pPlanes;
+        buf.length = m_MemoryPlaneCount;
+    }
+
+    if (m_Memory == V4L2_MEMORY_DMABUF && index < m_UserBufferContainerList.size())
+    {
+        UserBuffer *pBuffer = m_UserBufferContainerList[index];
+        if (m_BufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
+        {
+            buf.length = pBuffer->nPlaneCount;
+            for (uint32_t i = 0; i < pBuffer->nPlaneCount; ++i)
+            {
+                pPlanes[i].m.fd = pBuffer->nPlaneDmabufFds[i];
+                pPlanes[i].length = pBuffer->nPlaneLengths[i];
+            }
+        }
+        else
+        {
+            buf.m.fd = pBuffer->nDmabufFd;
+            buf.length = pBuffer->nBufferlength;
+        }
+    }
+}
+
+int FrameObserverDMABUF::ReadFrame(v4l2_buffer &buf)
+{
+    int result = -1;
+
+    CLEAR(buf);
+    buf.type = m_BufferType;
+    buf.memory = m_Memory;
+
+    // only the capture thread dequeues, the planes are read before the next dequeue
+    if(m_BufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
+    {
+        CLEAR(m_DequeuePlanes);
+        buf.m.planes = m_DequeuePlanes;
+        buf.length = m_MemoryPlaneCount;
+    }
+
+    if (m_IsStreamRunning)
+        result = iohelper::xioctl(m_nFileDescriptor, VIDIOC_DQBUF, &buf);
+
+    return result;
+}
+
+int FrameObserverDMABUF::GetFrameData(const v4l2_buffer &buf, uint8_t *&buffer, uint32_t &length) const
+{
+    int result = -1;
+
+    if (m_IsStreamRunning)
+    {
+        if (buf.index < m_UserBufferContainerList.size())
+        {
+            length = m_UserBufferContainerList[buf.index]->nBufferlength;
+            buffer = m_UserBufferContainerList[buf.index]->pBuffer;
+        }
+        else
+        {
+            length = 0;
+            buffer = 0;
+        }
+
+        if (0 != buffer && 0 != length)
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+/*********************************************************************************************************/
+// Frame buffer handling
+/*********************************************************************************************************/
+
+int FrameObserverDMABUF::ExportBuffer(uint32_t index, UserBuffer *pBuffer)
+{
+    v4l2_buffer buf;
+    v4l2_plane planes[VIDEO_MAX_PLANES];
+    PrepareBuffer(buf, planes, index);
+
+    if (-1 == iohelper::xioctl(m_nFileDescriptor, VIDIOC_QUERYBUF, &buf))
+    {
+        LOG_EX("FrameObserverDMABUF::ExportBuffer VIDIOC_QUERYBUF errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        return -1;
+    }
+
+    const bool isMultiPlane = (m_BufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE);
+    uint32_t const planeCount = isMultiPlane ? std::min<uint32_t>(buf.length, m_MemoryPlaneCount) : 1;
+
+    // every memory plane is mapped and exported on its own
+    for (uint32_t i = 0; i < planeCount; ++i)
+    {
+        size_t const length = isMultiPlane ? buf.m.planes[i].length : buf.length;
+        void *pPlane = mmap(NULL,
+                            length,
+                            PROT_READ | PROT_WRITE,
+                            MAP_SHARED,
+                            m_nFileDescriptor,
+                            isMultiPlane ? buf.m.planes[i].m.mem_offset : buf.m.offset);
+        if (MAP_FAILED == pPlane)
+        {
+            LOG_EX("FrameObserverDMABUF::ExportBuffer mmap #%d plane %u failed errno=%d=%s", index, i, errno, v4l2helper::ConvertErrno2String(errno).c_str());
+            return -1;
+        }
+        pBuffer->pPlaneBuffers[i] = static_cast<uint8_t*>(pPlane);
+        pBuffer->nPlaneLengths[i] = length;
+        pBuffer->nPlaneCount = i + 1;
+
+        v4l2_exportbuffer expbuf;
+        CLEAR(expbuf);
+        expbuf.type = m_BufferType;
+        expbuf.index = index;
+        expbuf.plane = i;
+        expbuf.flags = O_RDWR | O_CLOEXEC;
+
+        if (-1 == iohelper::xioctl(m_nFileDescriptor, VIDIOC_EXPBUF, &expbuf))
+        {
+            LOG_EX("FrameObserverDMABUF::ExportBuffer VIDIOC_EXPBUF #%d plane %u errno=%d=%s", index, i, errno, v4l2helper::ConvertErrno2String(errno).c_str());
+            return -1;
+        }
+
+        pBuffer->nPlaneDmabufFds[i] = expbuf.fd;
+        m_OwnedFileDescriptors.push_back(expbuf.fd);
+
+        LOG_EX("FrameObserverDMABUF::ExportBuffer VIDIOC_EXPBUF #%d plane %u OK fd=%d length=%zu", index, i, expbuf.fd, length);
+    }
+
+    pBuffer->pBuffer = pBuffer->pPlaneBuffers[0];
+    pBuffer->nBufferlength = pBuffer->nPlaneLengths[0];
+    pBuffer->nDmabufFd = pBuffer->nPlaneDmabufFds[0];
+
+    return 0;
+}
+
+int FrameObserverDMABUF::AllocateLocalDmabuf(size_t size, int &memFileDescriptor)
+{
+    memFileDescriptor = memfd_create("v4l2viewer-dmabuf", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memFileDescriptor < 0)
+    {
+        LOG_EX("FrameObserverDMABUF::AllocateLocalDmabuf memfd_create errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        return -1;
+    }
+
+    // udmabuf only accepts memfds which cannot shrink below the exported size
+    if (ftruncate(memFileDescriptor, size) < 0 || fcntl(memFileDescriptor, F_ADD_SEALS, F_SEAL_SHRINK) < 0)
+    {
+        LOG_EX("FrameObserverDMABUF::AllocateLocalDmabuf preparing memfd errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        close(memFileDescriptor);
+        memFileDescriptor = -1;
+        return -1;
+    }
+
+    int udmabufFileDescriptor = open("/dev/udmabuf", O_RDWR | O_CLOEXEC);
+    if (udmabufFileDescriptor < 0)
+    {
+        LOG_EX("FrameObserverDMABUF::AllocateLocalDmabuf open /dev/udmabuf errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        close(memFileDescriptor);
+        memFileDescriptor = -1;
+        return -1;
+    }
+
+    udmabuf_create create;
+    CLEAR(create);
+    create.memfd = memFileDescriptor;
+    create.flags = UDMABUF_FLAGS_CLOEXEC;
+    create.offset = 0;
+    create.size = size;
+
+    int dmabufFileDescriptor = iohelper::xioctl(udmabufFileDescriptor, UDMABUF_CREATE, &create);
+    if (dmabufFileDescriptor < 0)
+    {
+        LOG_EX("FrameObserverDMABUF::AllocateLocalDmabuf UDMABUF_CREATE errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        close(memFileDescriptor);
+        memFileDescriptor = -1;
+    }
+
+    close(udmabufFileDescriptor);
+
+    return dmabufFileDescriptor;
+}
+
+int FrameObserverDMABUF::PrepareImportBuffer(uint32_t index, uint32_t bufferSize, UserBuffer *pBuffer)
+{
+    const size_t pageSize = sysconf(_SC_PAGESIZE);
+    uint32_t const planeCount = (m_BufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE) ? m_MemoryPlaneCount : 1;
+
+    if (index < m_ImportFileDescriptors.size() && planeCount > 1)
+    {
+        LOG_EX("FrameObserverDMABUF::PrepareImportBuffer dmabuf #%d can't carry %u planes", index, planeCount);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < planeCount; ++i)
+    {
+        int dmabufFileDescriptor = -1;
+        int mapFileDescriptor = -1;
+        size_t length = 0;
+
+        if (index < m_ImportFileDescriptors.size())
+        {
+            dmabufFileDescriptor = m_ImportFileDescriptors[index];
+            mapFileDescriptor = dmabufFileDescriptor;
+
+            off_t size = lseek(dmabufFileDescriptor, 0, SEEK_END);
+            if (size < 0 || static_cast<size_t>(size) < bufferSize)
+            {
+                LOG_EX("FrameObserverDMABUF::PrepareImportBuffer dmabuf #%d fd=%d is too small (%lld < %u)", index, dmabufFileDescriptor, (long long)size, bufferSize);
+                return -1;
+            }
+            length = size;
+        }
+        else
+        {
+            int memFileDescriptor = -1;
+            size_t const planeSize = (planeCount > 1) ? m_PlaneFormats[i].sizeimage : bufferSize;
+            length = (planeSize + pageSize - 1) / pageSize * pageSize;
+            dmabufFileDescriptor = AllocateLocalDmabuf(length, memFileDescriptor);
+            if (dmabufFileDescriptor < 0)
+            {
+                return -1;
+            }
+            m_OwnedFileDescriptors.push_back(dmabufFileDescriptor);
+            m_OwnedFileDescriptors.push_back(memFileDescriptor);
+            // The memfd is always mappable, udmabufs only since kernel 5.x
+            mapFileDescriptor = memFileDescriptor;
+        }
+
+        void *pPlane = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, mapFileDescriptor, 0);
+        if (MAP_FAILED == pPlane)
+        {
+            LOG_EX("FrameObserverDMABUF::PrepareImportBuffer mmap #%d plane %u failed errno=%d=%s", index, i, errno, v4l2helper::ConvertErrno2String(errno).c_str());
+            return -1;
+        }
+
+        pBuffer->pPlaneBuffers[i] = static_cast<uint8_t*>(pPlane);
+        pBuffer->nPlaneLengths[i] = length;
+        pBuffer->nPlaneDmabufFds[i] = dmabufFileDescriptor;
+        pBuffer->nPlaneCount = i + 1;
+
+        LOG_EX("FrameObserverDMABUF::PrepareImportBuffer #%d plane %u OK fd=%d length=%zu", index, i, dmabufFileDescriptor, length);
+    }
+
+    pBuffer->pBuffer = pBuffer->pPlaneBuffers[0];
+    pBuffer->nBufferlength = pBuffer->nPlaneLengths[0];
+    pBuffer->nDmabufFd = pBuffer->nPlaneDmabufFds[0];
+
+    return 0;
+}
+
+int FrameObserverDMABUF::CreateAllUserBuffer(uint32_t bufferCount, uint32_t bufferSize)
+{
+    int result = -1;
+
+    if (bufferCount <= MAX_VIEWER_USER_BUFFER_COUNT && 0 == ReadPlaneFormats())
+    {
+        v4l2_requestbuffers req;
+
+        // creates user defined buffer
+        CLEAR(req);
+
+        req.count  = bufferCount;
+        req.type   = m_BufferType;
+        req.memory = m_Memory;
+
+        if (-1 == iohelper::xioctl(m_nFileDescriptor, VIDIOC_REQBUFS, &req))
+        {
+            if (EINVAL == errno)
+            {
+                LOG_EX("FrameObserverDMABUF::CreateAllUserBuffer VIDIOC_REQBUFS does not support memory type %d", m_Memory);
+            }
+            else
+            {
+                LOG_EX("FrameObserverDMABUF::CreateAllUserBuffer VIDIOC_REQBUFS errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+            }
+        }
+        else
+        {
+            base::LocalMutexLockGuard guard(m_UsedBufferMutex);
+
+            LOG_EX("FrameObserverDMABUF::CreateAllUserBuffer VIDIOC_REQBUFS OK");
+
+            // the driver may adjust the count in export mode
+            bufferCount = std::min<uint32_t>(req.count, MAX_VIEWER_USER_BUFFER_COUNT);
+            m_UserBufferContainerList.resize(bufferCount);
+
+            for (unsigned int x = 0; x < bufferCount; ++x)
+            {
+                UserBuffer* pTmpBuffer = new UserBuffer;
+                pTmpBuffer->pBuffer = 0;
+                pTmpBuffer->nBufferlength = 0;
+                pTmpBuffer->nPlaneCount = 0;
+                m_UserBufferContainerList.set(x, pTmpBuffer);
+
+                int prepareResult = (m_Mode == DMABUF_MODE_EXPORT) ? ExportBuffer(x, pTmpBuffer)
+                                                                   : PrepareImportBuffer(x, bufferSize, pTmpBuffer);
+                if (0 != prepareResult)
+                {
+                    // the buffers created so far are released by DeleteAllUserBuffer
+                    return -1;
+                }
+
+                m_RealPayloadSize = 0;
+                for (uint32_t i = 0; i < pTmpBuffer->nPlaneCount; ++i)
+                {
+                    m_RealPayloadSize += pTmpBuffer->nPlaneLengths[i];
+                }
+            }
+
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int FrameObserverDMABUF::QueueAllUserBuffer()
+{
+    int result = -1;
+    base::LocalMutexLockGuard guard(m_UsedBufferMutex);
+
+    // queue the buffer
+    for (uint32_t i=0; i<m_UserBufferContainerList.size(); i++)
+    {
+        v4l2_buffer buf;
+        v4l2_plane planes[VIDEO_MAX_PLANES];
+        PrepareBuffer(buf, planes, i);
+
+        if (-1 == iohelper::xioctl(m_nFileDescriptor, VIDIOC_QBUF, &buf))
+        {
+            LOG_EX("FrameObserverDMABUF::QueueUserBuffer VIDIOC_QBUF queue #%d fd=%d failed, errno=%d=%s", i, m_UserBufferContainerList[i]->nDmabufFd, errno, v4l2helper::ConvertErrno2String(errno).c_str());
+            return result;
+        }
+        else
+        {
+            LOG_EX("FrameObserverDMABUF::QueueUserBuffer VIDIOC_QBUF queue #%d fd=%d OK", i, m_UserBufferContainerList[i]->nDmabufFd);
+            m_DropStatistics.OnBufferQueued();
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int FrameObserverDMABUF::QueueSingleUserBuffer(const int index)
+{
+    int result = 0;
+
+    if (index < static_cast<int>(m_UserBufferContainerList.size()))
+    {
+        v4l2_buffer buf;
+        v4l2_plane planes[VIDEO_MAX_PLANES];
+        PrepareBuffer(buf, planes, index);
+
+        if (m_IsStreamRunning)
+        {
+            if (-1 == iohelper::xioctl(m_nFileDescriptor, VIDIOC_QBUF, &buf))
+            {
+                LOG_EX("FrameObserverDMABUF::QueueSingleUserBuffer VIDIOC_QBUF queue #%d fd=%d failed, errno=%d=%s", index, m_UserBufferContainerList[index]->nDmabufFd, errno, v4l2helper::ConvertErrno2String(errno).c_str());
+            }
+            else
+            {
+                m_DropStatistics.OnBufferQueued();
+            }
+        }
+    }
+
+    return result;
+}
+
+int FrameObserverDMABUF::DeleteAllUserBuffer()
+{
+    int result = 0;
+
+    base::LocalMutexLockGuard guard(m_UsedBufferMutex);
+
+    // delete all user buffer
+    for (unsigned int x = 0; x < m_UserBufferContainerList.size(); x++)
+    {
+        if (0 != m_UserBufferContainerList[x])
+        {
+            for (uint32_t i = 0; i < m_UserBufferContainerList[x]->nPlaneCount; ++i)
+            {
+                munmap(m_UserBufferContainerList[x]->pPlaneBuffers[i], m_UserBufferContainerList[x]->nPlaneLengths[i]);
+            }
+            delete m_UserBufferContainerList[x];
+        }
+    }
+
+    m_UserBufferContainerList.resize(0);
+    m_DropStatistics.OnBuffersReleased();
+
+    for (int fd : m_OwnedFileDescriptors)
+    {
+        close(fd);
+    }
+    m_OwnedFileDescriptors.clear();
+
+    // free all internal buffers
+    v4l2_requestbuffers req;
+    CLEAR(req);
+    req.count  = 0;
+    req.type   = m_BufferType;
+    req.memory = m_Memory;
+
+    result = iohelper::xioctl(m_nFileDescriptor, VIDIOC_REQBUFS, &req);
+
+    return result;
+}
@@ -33,10 +33,14 @@
 #include <sys/mman.h>
 #include <QDebug>
 
+#include <algorithm>
 #include <sstream>
 
 FrameObserverMMAP::FrameObserverMMAP(bool showFrames)
     : FrameObserver(showFrames)
+    , m_RequestedCacheMode(MMAP_CACHE_COHERENT)
+    , m_CacheMode(MMAP_CACHE_COHERENT)
+    , m_QueueFlags(0)
 {
 }
 
@@ -44,6 +48,78 @@ FrameObserverMMAP::~FrameObserverMMAP()
 {
 }
 
+void FrameObserverMMAP::SetCacheMode(MMAP_CACHE_MODE mode)
+{
+    m_RequestedCacheMode = mode;
+}
+
+MMAP_CACHE_MODE FrameObserverMMAP::GetCacheMode() const
+{
+    return m_CacheMode;
+}
+
+const char* FrameObserverMMAP::GetCacheModeName(MMAP_CACHE_MODE mode)
+{
+    switch (mode)
+    {
+        case MMAP_CACHE_COHERENT:
+            return "coherent";
+        case MMAP_CACHE_NON_COHERENT:
+            return "non-coherent";
+        case MMAP_CACHE_NON_COHERENT_NO_SYNC:
+            return "no-sync";
+    }
+
+    return "unknown";
+}
+
+int FrameObserverMMAP::ParseCacheMode(const std::string &name, MMAP_CACHE_MODE &mode)
+{
+    for (auto candidate : { MMAP_CACHE_COHERENT, MMAP_CACHE_NON_COHERENT, MMAP_CACHE_NON_COHERENT_NO_SYNC })
+    {
+        if (name == GetCacheModeName(candidate))
+        {
+            mode = candidate;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+void FrameObserverMMAP::AcceptCacheMode(uint32_t capabilities, uint32_t flags)
+{
+    m_CacheMode = MMAP_CACHE_COHERENT;
+    m_QueueFlags = 0;
+
+#ifdef V4L2_MEMORY_FLAG_NON_COHERENT
+    // drivers without cache hints silently hand out coherent buffers
+    if (m_RequestedCacheMode != MMAP_CACHE_COHERENT)
+    {
+        if ((capabilities & V4L2_BUF_CAP_SUPPORTS_MMAP_CACHE_HINTS) && (flags & V4L2_MEMORY_FLAG_NON_COHERENT))
+        {
+            m_CacheMode = m_RequestedCacheMode;
+            m_QueueFlags = V4L2_BUF_FLAG_NO_CACHE_CLEAN;
+            if (m_CacheMode == MMAP_CACHE_NON_COHERENT_NO_SYNC)
+            {
+                m_QueueFlags |= V4L2_BUF_FLAG_NO_CACHE_INVALIDATE;
+            }
+        }
+        else
+        {
+            LOG_EX("FrameObserverMMAP::AcceptCacheMode driver does not support cache hints, buffers are coherent");
+        }
+    }
+#else
+    if (m_RequestedCacheMode != MMAP_CACHE_COHERENT)
+    {
+        LOG_EX("FrameObserverMMAP::AcceptCacheMode built without V4L2_MEMORY_FLAG_NON_COHERENT, buffers are coherent");
+    }
+#endif
+
+    LOG_EX("FrameObserverMMAP::AcceptCacheMode %s buffers", GetCacheModeName(m_CacheMode));
+}
+
 int FrameObserverMMAP::ReadFrame(v4l2_buffer &buf)
 {
     int result = -1;
@@ -51,11 +127,12 @@ int FrameObserverMMAP::ReadFrame(v4l2_buffer &buf)
     buf.type = m_BufferType;
     buf.memory = V4L2_MEMORY_MMAP;
 
-    v4l2_plane plane;
+    // only the capture thread dequeues, the planes are read before the next dequeue
     if(m_BufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
     {
-        buf.m.planes = &plane;
-        buf.length = 1;
+        CLEAR(m_DequeuePlanes);
+        buf.m.planes = m_DequeuePlanes;
+        buf.length = m_MemoryPlaneCount;
     }
 
     if (m_IsStreamRunning)
@@ -70,8 +147,6 @@ int FrameObserverMMAP::GetFrameData(const v4l2_buffer &buf, uint8_t *&buffer, ui
 
     if (m_IsStreamRunning)
     {
-        base::LocalMutexLockGuard guard(m_UsedBufferMutex);
-
         if (buf.index < m_UserBufferContainerList.size())
         {
             length = m_UserBufferContainerList[buf.index]->nBufferlength;
@@ -100,7 +175,7 @@ int FrameObserverMMAP::CreateAllUserBuffer(uint32_t bufferCount, uint32_t buffer
 {
     int result = -1;
 
-    if (bufferCount <= MAX_VIEWER_USER_BUFFER_COUNT)
+    if (bufferCount <= MAX_VIEWER_USER_BUFFER_COUNT && 0 == ReadPlaneFormats())
     {
         v4l2_requestbuffers req;
 
@@ -110,6 +185,12 @@ int FrameObserverMMAP::CreateAllUserBuffer(uint32_t bufferCount, uint32_t buffer
         req.count  = bufferCount;
         req.type   = m_BufferType;
         req.memory = V4L2_MEMORY_MMAP;
+#ifdef V4L2_MEMORY_FLAG_NON_COHERENT
+        if (m_RequestedCacheMode != MMAP_CACHE_COHERENT)
+        {
+            req.flags = V4L2_MEMORY_FLAG_NON_COHERENT;
+        }
+#endif
 
         // requests 4 video capture buffer. Driver is going to configure all parameter and doesn't allocate them.
         if (-1 == iohelper::xioctl(m_nFileDescriptor, VIDIOC_REQBUFS, &req))
@@ -128,6 +209,11 @@ int FrameObserverMMAP::CreateAllUserBuffer(uint32_t bufferCount, uint32_t buffer
             base::LocalMutexLockGuard guard(m_UsedBufferMutex);
 
             LOG_EX("FrameObserverMMAP::CreateAllUserBuffer VIDIOC_REQBUFS OK");
+#ifdef V4L2_MEMORY_FLAG_NON_COHERENT
+            AcceptCacheMode(req.capabilities, req.flags);
+#else
+            AcceptCacheMode(req.capabilities, 0);
+#endif
 
             // create local buffer container
             m_UserBufferContainerList.resize(bufferCount);
@@ -141,46 +227,22 @@ int FrameObserverMMAP::CreateAllUserBuffer(uint32_t bufferCount, uint32_t buffer
 
             for (unsigned int x = 0; x < bufferCount; ++x)
             {
-                v4l2_buffer buf;
-                CLEAR(buf);
-                buf.type = m_BufferType;
-                buf.memory = V4L2_MEMORY_MMAP;
-                buf.index = x;
-
-                v4l2_plane plane;
-                if(m_BufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
-                {
-                    buf.m.planes = &plane;
-                    buf.length = 1;
-                    LOG_EX("FrameObserverMMAP::CreateAllUserBuffer plane count=%d", buf.length);
-                }
+                UserBuffer* pTmpBuffer = MapUserBuffer(x);
 
-                if (-1 == iohelper::xioctl(m_nFileDescriptor, VIDIOC_QUERYBUF, &buf))
+                if (NULL == pTmpBuffer)
                 {
-                    LOG_EX("FrameObserverMMAP::CreateAllUserBuffer VIDIOC_QUERYBUF errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
-                    return -1;
-                }
-
-                LOG_EX("FrameObserverMMAP::CreateAllUserBuffer VIDIOC_QUERYBUF MMAP OK length=%d", buf.length);
-
-                UserBuffer* pTmpBuffer = new UserBuffer;
-                pTmpBuffer->nBufferlength = (m_BufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE ? buf.m.planes[0].length : buf.length);
-                m_RealPayloadSize = pTmpBuffer->nBufferlength;
-                pTmpBuffer->pBuffer = (uint8_t*)mmap(NULL,
-                        pTmpBuffer->nBufferlength,
-                                    PROT_READ | PROT_WRITE,
-                                    MAP_SHARED,
-                                    m_nFileDescriptor,
-                                    m_BufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE ? buf.m.planes[0].m.mem_offset : buf.m.offset);
-
-                if (MAP_FAILED == pTmpBuffer->pBuffer)
-                {
-                    delete pTmpBuffer;
                     m_UserBufferContainerList.resize(0);
                     return -1;
                 }
                 else
-                    m_UserBufferContainerList[x] = pTmpBuffer;
+                {
+                    m_RealPayloadSize = 0;
+                    for (uint32_t i = 0; i < pTmpBuffer->nPlaneCount; ++i)
+                    {
+                        m_RealPayloadSize += pTmpBuffer->nPlaneLengths[i];
+                    }
+                    m_UserBufferContainerList.set(x, pTmpBuffer);
+                }
             }
 
             result = 0;
@@ -190,6 +252,129 @@ int FrameObserverMMAP::CreateAllUserBuffer(uint32_t bufferCount, uint32_t buffer
     return result;
 }
 
+UserBuffer* FrameObserverMMAP::MapUserBuffer(uint32_t index)
+{
+    v4l2_buffer buf;
+    CLEAR(buf);
+    buf.type = m_BufferType;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = index;
+
+    v4l2_plane planes[VIDEO_MAX_PLANES];
+    const bool isMultiPlane = (m_BufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE);
+    if(isMultiPlane)
+    {
+        CLEAR(planes);
+        buf.m.planes = planes;
+        buf.length = m_MemoryPlaneCount;
+        LOG_EX("FrameObserverMMAP::MapUserBuffer plane count=%d", buf.length);
+    }
+
+    if (-1 == iohelper::xioctl(m_nFileDescriptor, VIDIOC_QUERYBUF, &buf))
+    {
+        LOG_EX("FrameObserverMMAP::MapUserBuffer VIDIOC_QUERYBUF errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        return NULL;
+    }
+
+    LOG_EX("FrameObserverMMAP::MapUserBuffer VIDIOC_QUERYBUF MMAP OK length=%d", buf.length);
+
+    UserBuffer* pTmpBuffer = new UserBuffer;
+    pTmpBuffer->nPlaneCount = isMultiPlane ? std::min<uint32_t>(buf.length, m_MemoryPlaneCount) : 1;
+
+    // every memory plane has its own offset into the device
+    for (uint32_t i = 0; i < pTmpBuffer->nPlaneCount; ++i)
+    {
+        size_t const length = isMultiPlane ? buf.m.planes[i].length : buf.length;
+        void *pPlane = mmap(NULL,
+                            length,
+                            PROT_READ | PROT_WRITE,
+                            MAP_SHARED,
+                            m_nFileDescriptor,
+                            isMultiPlane ? buf.m.planes[i].m.mem_offset : buf.m.offset);
+
+        if (MAP_FAILED == pPlane)
+        {
+            LOG_EX("FrameObserverMMAP::MapUserBuffer mmap #%u plane %u failed errno=%d=%s", index, i, errno, v4l2helper::ConvertErrno2String(errno).c_str());
+            pTmpBuffer->nPlaneCount = i;
+            DeleteUserBuffer(pTmpBuffer);
+            return NULL;
+        }
+
+        pTmpBuffer->pPlaneBuffers[i] = static_cast<uint8_t*>(pPlane);
+        pTmpBuffer->nPlaneLengths[i] = length;
+    }
+
+    pTmpBuffer->pBuffer = pTmpBuffer->pPlaneBuffers[0];
+    pTmpBuffer->nBufferlength = pTmpBuffer->nPlaneLengths[0];
+
+    return pTmpBuffer;
+}
+
+int FrameObserverMMAP::AddUserBuffers(uint32_t bufferCount)
+{
+    v4l2_create_buffers create;
+    CLEAR(create);
+    create.count = bufferCount;
+    create.memory = V4L2_MEMORY_MMAP;
+    create.format.type = m_BufferType;
+#ifdef V4L2_MEMORY_FLAG_NON_COHERENT
+    // the added buffers have to behave like the existing ones
+    if (m_CacheMode != MMAP_CACHE_COHERENT)
+    {
+        create.flags = V4L2_MEMORY_FLAG_NON_COHERENT;
+    }
+#endif
+
+    if (-1 == iohelper::xioctl(m_nFileDescriptor, VIDIOC_G_FMT, &create.format))
+    {
+        LOG_EX("FrameObserverMMAP::AddUserBuffers VIDIOC_G_FMT errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        return -1;
+    }
+
+    if (-1 == iohelper::xioctl(m_nFileDescriptor, VIDIOC_CREATE_BUFS, &create))
+    {
+        LOG_EX("FrameObserverMMAP::AddUserBuffers VIDIOC_CREATE_BUFS errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        return -1;
+    }
+
+    // the container is indexed like the driver, so the new buffers have to follow the existing ones
+    if (create.index != m_UserBufferContainerList.size())
+    {
+        LOG_EX("FrameObserverMMAP::AddUserBuffers VIDIOC_CREATE_BUFS returned index %u, expected %zu", create.index, m_UserBufferContainerList.size());
+        return -1;
+    }
+
+    uint32_t added = 0;
+    for (; added < create.count; ++added)
+    {
+        UserBuffer* pTmpBuffer = MapUserBuffer(create.index + added);
+        if (NULL == pTmpBuffer)
+        {
+            break;
+        }
+
+        base::LocalMutexLockGuard guard(m_UsedBufferMutex);
+        if (!m_UserBufferContainerList.push_back(pTmpBuffer))
+        {
+            // the driver keeps the buffer unused until the stream ends
+            LOG_EX("FrameObserverMMAP::AddUserBuffers buffer table is full");
+            DeleteUserBuffer(pTmpBuffer);
+            break;
+        }
+    }
+
+    return added > 0 ? static_cast<int>(added) : -1;
+}
+
+void FrameObserverMMAP::DeleteUserBuffer(UserBuffer *pBuffer)
+{
+    for (uint32_t i = 0; i < pBuffer->nPlaneCount; ++i)
+    {
+        munmap(pBuffer->pPlaneBuffers[i], pBuffer->nPlaneLengths[i]);
+    }
+    delete pBuffer;
+}
+
 int FrameObserverMMAP::QueueAllUserBuffer()
 {
     int result = -1;
@@ -204,12 +389,14 @@ int FrameObserverMMAP::QueueAllUserBuffer()
         buf.type = m_BufferType;
         buf.index = i;
         buf.memory = V4L2_MEMORY_MMAP;
+        buf.flags = m_QueueFlags;
 
-        v4l2_plane plane;
+        v4l2_plane planes[VIDEO_MAX_PLANES];
         if(m_BufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
         {
-            buf.m.planes = &plane;
-            buf.length = 1;
+            CLEAR(planes);
+            buf.m.planes = planes;
+            buf.length = m_MemoryPlaneCount;
         }
 
         if (-1 == iohelper::xioctl(m_nFileDescriptor, VIDIOC_QBUF, &buf))
@@ -220,6 +407,7 @@ int FrameObserverMMAP::QueueAllUserBuffer()
         else
         {
             LOG_EX("FrameObserverMMAP::QueueUserBuffer VIDIOC_QBUF queue #%d buffer=%p OK", i, m_UserBufferContainerList[i]->pBuffer);
+            m_DropStatistics.OnBufferQueued();
             result = 0;
         }
     }
@@ -231,7 +419,6 @@ int FrameObserverMMAP::QueueSingleUserBuffer(const int index)
 {
     int result = 0;
     v4l2_buffer buf;
-    base::LocalMutexLockGuard guard(m_UsedBufferMutex);
 
     if (index < static_cast<int>(m_UserBufferContainerList.size()))
     {
@@ -239,12 +426,14 @@ int FrameObserverMMAP::QueueSingleUserBuffer(const int index)
         buf.type = m_BufferType;
         buf.index = index;
         buf.memory = V4L2_MEMORY_MMAP;
+        buf.flags = m_QueueFlags;
 
-        v4l2_plane plane;
+        v4l2_plane planes[VIDEO_MAX_PLANES];
         if(m_BufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
         {
-            buf.m.planes = &plane;
-            buf.length = 1;
+            CLEAR(planes);
+            buf.m.planes = planes;
+            buf.length = m_MemoryPlaneCount;
         }
 
         if (m_IsStreamRunning)
@@ -253,6 +442,10 @@ int FrameObserverMMAP::QueueSingleUserBuffer(const int index)
             {
                 LOG_EX("FrameObserverMMAP::QueueSingleUserBuffer VIDIOC_QBUF queue #%d buffer=%p failed, errno=%d=%s", index, m_UserBufferContainerList[index]->pBuffer, errno, v4l2helper::ConvertErrno2String(errno).c_str());
             }
+            else
+            {
+                m_DropStatistics.OnBufferQueued();
+            }
         }
     }
 
@@ -268,15 +461,14 @@ int FrameObserverMMAP::DeleteAllUserBuffer()
     // delete all user buffer
     for (unsigned int x = 0; x < m_UserBufferContainerList.size(); x++)
     {
-        munmap(m_UserBufferContainerList[x]->pBuffer, m_UserBufferContainerList[x]->nBufferlength);
-
         if (0 != m_UserBufferContainerList[x])
         {
-            delete m_UserBufferContainerList[x];
+            DeleteUserBuffer(m_UserBufferContainerList[x]);
         }
     }
 
     m_UserBufferContainerList.resize(0);
+    m_DropStatistics.OnBuffersReleased();
 
     // free all internal buffers
     v4l2_requestbuffers req;
@@ -0,0 +1,1166 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#include "FrameObserverSynthetic.h"
+#include "LatencyStatistics.h"
+#include "LocalMutexLockGuard.h"
+#include "Logger.h"
+#include "MemoryHelper.h"
+#include "V4L2Helper.h"
+#include "videodev2_av.h"
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QImage>
+#include <QMutexLocker>
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+
+// how many different frames are rendered for the test patterns
+const uint32_t PATTERN_FRAME_COUNT = 8;
+// upper limit for the rendered or replayed frames kept in memory
+const uint64_t SOURCE_FRAME_MEMORY_BUDGET = 256ULL * 1024 * 1024;
+
+enum SAMPLE_LAYOUT
+{
+    LAYOUT_BGRX32,
+    LAYOUT_XRGB32,
+    LAYOUT_RGB24,
+    LAYOUT_BGR24,
+    LAYOUT_RGB565,
+    LAYOUT_YUYV,
+    LAYOUT_UYVY,
+    LAYOUT_VYUY,
+    LAYOUT_YUV420,
+    LAYOUT_NV12,
+    LAYOUT_NV16,
+    LAYOUT_JPEG,
+    LAYOUT_RAW8,
+    LAYOUT_RAW10P,
+    LAYOUT_RAW12P,
+    LAYOUT_RAW16,
+};
+
+struct SyntheticFormat
+{
+    SAMPLE_LAYOUT layout;
+    // colour filter of the first two lines, nullptr for monochrome raw formats
+    const char   *cfa;
+    // significant bits of the 16 bit raw formats
+    uint32_t      storedBits;
+    // left shift of the significant bits within the 16 bits
+    uint32_t      alignShift = 0;
+};
+
+bool DescribeFormat(uint32_t pixelFormat, SyntheticFormat &format)
+{
+    format = { LAYOUT_RAW8, nullptr, 8 };
+
+    switch (pixelFormat)
+    {
+        case V4L2_PIX_FMT_XBGR32:
+        case V4L2_PIX_FMT_ABGR32:
+        case V4L2_PIX_FMT_BGR32:
+            format.layout = LAYOUT_BGRX32;
+            break;
+        case V4L2_PIX_FMT_XRGB32:
+        case V4L2_PIX_FMT_RGB32:
+            format.layout = LAYOUT_XRGB32;
+            break;
+        case V4L2_PIX_FMT_RGB24:
+            format.layout = LAYOUT_RGB24;
+            break;
+        case V4L2_PIX_FMT_BGR24:
+            format.layout = LAYOUT_BGR24;
+            break;
+        case V4L2_PIX_FMT_RGB565:
+            format.layout = LAYOUT_RGB565;
+            break;
+        case V4L2_PIX_FMT_YUYV:
+            format.layout = LAYOUT_YUYV;
+            break;
+        case V4L2_PIX_FMT_UYVY:
+            format.layout = LAYOUT_UYVY;
+            break;
+        case V4L2_PIX_FMT_VYUY:
+            format.layout = LAYOUT_VYUY;
+            break;
+        case V4L2_PIX_FMT_YUV420:
+            format.layout = LAYOUT_YUV420;
+            break;
+        case V4L2_PIX_FMT_NV12:
+            format.layout = LAYOUT_NV12;
+            break;
+        case V4L2_PIX_FMT_NV16:
+            format.layout = LAYOUT_NV16;
+            break;
+        case V4L2_PIX_FMT_JPEG:
+        case V4L2_PIX_FMT_MJPEG:
+            format.layout = LAYOUT_JPEG;
+            break;
+
+        case V4L2_PIX_FMT_GREY:
+            break;
+        case V4L2_PIX_FMT_SBGGR8:
+            format.cfa = "BGGR";
+            break;
+        case V4L2_PIX_FMT_SGBRG8:
+            format.cfa = "GBRG";
+            break;
+        case V4L2_PIX_FMT_SGRBG8:
+            format.cfa = "GRBG";
+            break;
+        case V4L2_PIX_FMT_SRGGB8:
+            format.cfa = "RGGB";
+            break;
+
+        case V4L2_PIX_FMT_Y10P:
+            format = { LAYOUT_RAW10P, nullptr, 10 };
+            break;
+        case V4L2_PIX_FMT_SBGGR10P:
+            format = { LAYOUT_RAW10P, "BGGR", 10 };
+            break;
+        case V4L2_PIX_FMT_SGBRG10P:
+            format = { LAYOUT_RAW10P, "GBRG", 10 };
+            break;
+        case V4L2_PIX_FMT_SGRBG10P:
+            format = { LAYOUT_RAW10P, "GRBG", 10 };
+            break;
+        case V4L2_PIX_FMT_SRGGB10P:
+            format = { LAYOUT_RAW10P, "RGGB", 10 };
+            break;
+
+        case V4L2_PIX_FMT_GREY12P:
+        case V4L2_PIX_FMT_Y12P:
+            format = { LAYOUT_RAW12P, nullptr, 12 };
+            break;
+        case V4L2_PIX_FMT_SBGGR12P:
+            format = { LAYOUT_RAW12P, "BGGR", 12 };
+            break;
+        case V4L2_PIX_FMT_SGBRG12P:
+            format = { LAYOUT_RAW12P, "GBRG", 12 };
+            break;
+        case V4L2_PIX_FMT_SGRBG12P:
+            format = { LAYOUT_RAW12P, "GRBG", 12 };
+            break;
+        case V4L2_PIX_FMT_SRGGB12P:
+            format = { LAYOUT_RAW12P, "RGGB", 12 };
+            break;
+
+        // Jetson VI writes the samples MSB aligned to bit 14 (Xavier) or bit 13 (TX2)
+        case V4L2_PIX_FMT_XAVIER_Y10:
+        case V4L2_PIX_FMT_XAVIER_Y12:
+            format = { LAYOUT_RAW16, nullptr, 15 };
+            break;
+        case V4L2_PIX_FMT_XAVIER_SGRBG10:
+        case V4L2_PIX_FMT_XAVIER_SGRBG12:
+            format = { LAYOUT_RAW16, "GRBG", 15 };
+            break;
+        case V4L2_PIX_FMT_XAVIER_SRGGB10:
+        case V4L2_PIX_FMT_XAVIER_SRGGB12:
+            format = { LAYOUT_RAW16, "RGGB", 15 };
+            break;
+        case V4L2_PIX_FMT_XAVIER_SGBRG10:
+        case V4L2_PIX_FMT_XAVIER_SGBRG12:
+            format = { LAYOUT_RAW16, "GBRG", 15 };
+            break;
+        case V4L2_PIX_FMT_XAVIER_SBGGR10:
+        case V4L2_PIX_FMT_XAVIER_SBGGR12:
+            format = { LAYOUT_RAW16, "BGGR", 15 };
+            break;
+        case V4L2_PIX_FMT_TX2_Y10:
+        case V4L2_PIX_FMT_TX2_Y12:
+            format = { LAYOUT_RAW16, nullptr, 14 };
+            break;
+        case V4L2_PIX_FMT_TX2_SGRBG10:
+        case V4L2_PIX_FMT_TX2_SGRBG12:
+            format = { LAYOUT_RAW16, "GRBG", 14 };
+            break;
+        case V4L2_PIX_FMT_TX2_SRGGB10:
+        case V4L2_PIX_FMT_TX2_SRGGB12:
+            format = { LAYOUT_RAW16, "RGGB", 14 };
+            break;
+        case V4L2_PIX_FMT_TX2_SGBRG10:
+        case V4L2_PIX_FMT_TX2_SGBRG12:
+            format = { LAYOUT_RAW16, "GBRG", 14 };
+            break;
+        case V4L2_PIX_FMT_TX2_SBGGR10:
+        case V4L2_PIX_FMT_TX2_SBGGR12:
+            format = { LAYOUT_RAW16, "BGGR", 14 };
+            break;
+
+        // the generic formats are MSB aligned, the viewer shows their upper byte
+        case V4L2_PIX_FMT_Y10:
+            format = { LAYOUT_RAW16, nullptr, 10, 6 };
+            break;
+        case V4L2_PIX_FMT_SBGGR10:
+            format = { LAYOUT_RAW16, "BGGR", 10, 6 };
+            break;
+        case V4L2_PIX_FMT_SGBRG10:
+            format = { LAYOUT_RAW16, "GBRG", 10, 6 };
+            break;
+        case V4L2_PIX_FMT_SGRBG10:
+            format = { LAYOUT_RAW16, "GRBG", 10, 6 };
+            break;
+        case V4L2_PIX_FMT_SRGGB10:
+            format = { LAYOUT_RAW16, "RGGB", 10, 6 };
+            break;
+        case V4L2_PIX_FMT_Y12:
+            format = { LAYOUT_RAW16, nullptr, 12, 4 };
+            break;
+        case V4L2_PIX_FMT_SBGGR12:
+            format = { LAYOUT_RAW16, "BGGR", 12, 4 };
+            break;
+        case V4L2_PIX_FMT_SGBRG12:
+            format = { LAYOUT_RAW16, "GBRG", 12, 4 };
+            break;
+        case V4L2_PIX_FMT_SGRBG12:
+            format = { LAYOUT_RAW16, "GRBG", 12, 4 };
+            break;
+        case V4L2_PIX_FMT_SRGGB12:
+            format = { LAYOUT_RAW16, "RGGB", 12, 4 };
+            break;
+
+        default:
+            return false;
+    }
+
+    return true;
+}
+
+uint8_t Clamp(int value)
+{
+    return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+}
+
+// BT.601 full range, the inverse of what ImageTransform expects
+uint8_t Luma(const uint8_t *rgb)
+{
+    return Clamp((77 * rgb[0] + 150 * rgb[1] + 29 * rgb[2] + 128) >> 8);
+}
+
+uint8_t ChromaBlue(const uint8_t *rgb)
+{
+    return Clamp(((-43 * rgb[0] - 85 * rgb[1] + 128 * rgb[2] + 128) >> 8) + 128);
+}
+
+uint8_t ChromaRed(const uint8_t *rgb)
+{
+    return Clamp(((128 * rgb[0] - 107 * rgb[1] - 21 * rgb[2] + 128) >> 8) + 128);
+}
+
+// the raw sample at the given position, the colour is picked by the filter pattern
+uint8_t RawSample(const SyntheticFormat &format, const uint8_t *rgb, uint32_t x, uint32_t y)
+{
+    if (format.cfa == nullptr)
+    {
+        return Luma(rgb);
+    }
+
+    switch (format.cfa[(y & 1) * 2 + (x & 1)])
+    {
+        case 'R':
+            return rgb[0];
+        case 'G':
+            return rgb[1];
+        default:
+            return rgb[2];
+    }
+}
+
+// widens an 8 bit sample by repeating its upper bits
+uint16_t WidenSample(uint8_t sample, uint32_t bits)
+{
+    return static_cast<uint16_t>((sample << (bits - 8)) | (sample >> (16 - bits)));
+}
+
+void RenderPatternPixel(SYNTHETIC_PATTERN_TYPE pattern, uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                        uint32_t frame, uint32_t frameCount, uint8_t *rgb)
+{
+    static const uint8_t BAR_COLORS[8][3] = {
+        { 255, 255, 255 }, { 255, 255, 0 }, { 0, 255, 255 }, { 0, 255, 0 },
+        { 255, 0, 255 }, { 255, 0, 0 }, { 0, 0, 255 }, { 0, 0, 0 }
+    };
+
+    switch (pattern)
+    {
+        case SYNTHETIC_PATTERN_BARS:
+        {
+            if (y >= height - height / 8)
+            {
+                rgb[0] = rgb[1] = rgb[2] = static_cast<uint8_t>(x * 255 / std::max<uint32_t>(width - 1, 1));
+                break;
+            }
+            // after frameCount frames the bars moved by exactly one bar, so the bank loops seamlessly
+            uint32_t const barWidth = std::max<uint32_t>(width / 8, 1);
+            uint32_t const shift = frame * barWidth / frameCount;
+            uint8_t const *color = BAR_COLORS[((x + shift) / barWidth) % 8];
+            std::memcpy(rgb, color, 3);
+            break;
+        }
+        case SYNTHETIC_PATTERN_GRADIENT:
+            rgb[0] = static_cast<uint8_t>(x * 255 / std::max<uint32_t>(width - 1, 1));
+            rgb[1] = static_cast<uint8_t>(y * 255 / std::max<uint32_t>(height - 1, 1));
+            rgb[2] = static_cast<uint8_t>(frame * 255 / frameCount);
+            break;
+        case SYNTHETIC_PATTERN_NOISE:
+        {
+            uint32_t hash = (x * 0x9E3779B1u) ^ (y * 0x85EBCA77u) ^ ((frame + 1) * 0xC2B2AE3Du);
+            hash ^= hash >> 15;
+            hash *= 0x2C1B3C6Du;
+            hash ^= hash >> 12;
+            rgb[0] = static_cast<uint8_t>(hash);
+            rgb[1] = static_cast<uint8_t>(hash >> 8);
+            rgb[2] = static_cast<uint8_t>(hash >> 16);
+            break;
+        }
+    }
+}
+
+// Converts an RGB888 image into the given format, returns the number of bytes used
+uint32_t EncodeFrame(const SyntheticFormat &format, const uint8_t *rgb, uint32_t width, uint32_t height,
+                     uint32_t bytesPerLine, uint8_t *destination, uint32_t destinationSize)
+{
+    switch (format.layout)
+    {
+        case LAYOUT_JPEG:
+        {
+            QByteArray encoded;
+            QBuffer device(&encoded);
+            device.open(QIODevice::WriteOnly);
+            QImage(rgb, width, height, width * 3, QImage::Format_RGB888).save(&device, "JPG", 90);
+
+            uint32_t const size = static_cast<uint32_t>(encoded.size());
+            if (size > destinationSize)
+            {
+                return 0;
+            }
+            std::memcpy(destination, encoded.constData(), size);
+            return size;
+        }
+        case LAYOUT_YUV420:
+        {
+            uint8_t *yPlane = destination;
+            uint8_t *uPlane = yPlane + width * height;
+            uint8_t *vPlane = uPlane + (width / 2) * (height / 2);
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                for (uint32_t x = 0; x < width; ++x)
+                {
+                    yPlane[y * width + x] = Luma(&rgb[(y * width + x) * 3]);
+                }
+            }
+            for (uint32_t y = 0; y < height / 2; ++y)
+            {
+                for (uint32_t x = 0; x < width / 2; ++x)
+                {
+                    const uint8_t *pixel = &rgb[(2 * y * width + 2 * x) * 3];
+                    uPlane[y * (width / 2) + x] = ChromaBlue(pixel);
+                    vPlane[y * (width / 2) + x] = ChromaRed(pixel);
+                }
+            }
+            return width * height * 3 / 2;
+        }
+        case LAYOUT_NV12:
+        case LAYOUT_NV16:
+        {
+            // one chroma line for two luma lines with NV12, one for each with NV16
+            const uint32_t chromaShift = (format.layout == LAYOUT_NV12) ? 1 : 0;
+            uint8_t *yPlane = destination;
+            uint8_t *uvPlane = yPlane + width * height;
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                for (uint32_t x = 0; x < width; ++x)
+                {
+                    yPlane[y * width + x] = Luma(&rgb[(y * width + x) * 3]);
+                }
+            }
+            for (uint32_t y = 0; y < (height >> chromaShift); ++y)
+            {
+                for (uint32_t x = 0; x < width / 2; ++x)
+                {
+                    const uint8_t *pixel = &rgb[((y << chromaShift) * width + 2 * x) * 3];
+                    uvPlane[y * width + 2 * x] = ChromaBlue(pixel);
+                    uvPlane[y * width + 2 * x + 1] = ChromaRed(pixel);
+                }
+            }
+            return width * height + width * (height >> chromaShift);
+        }
+        default:
+            break;
+    }
+
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        const uint8_t *source = &rgb[y * width * 3];
+        uint8_t *line = destination + y * bytesPerLine;
+
+        switch (format.layout)
+        {
+            case LAYOUT_BGRX32:
+            case LAYOUT_XRGB32:
+                for (uint32_t x = 0; x < width; ++x, source += 3, line += 4)
+                {
+                    if (format.layout == LAYOUT_BGRX32)
+                    {
+                        line[0] = source[2]; line[1] = source[1]; line[2] = source[0]; line[3] = 0xFF;
+                    }
+                    else
+                    {
+                        line[0] = 0xFF; line[1] = source[0]; line[2] = source[1]; line[3] = source[2];
+                    }
+                }
+                break;
+            case LAYOUT_RGB24:
+                std::memcpy(line, source, width * 3);
+                break;
+            case LAYOUT_BGR24:
+                for (uint32_t x = 0; x < width; ++x, source += 3, line += 3)
+                {
+                    line[0] = source[2]; line[1] = source[1]; line[2] = source[0];
+                }
+                break;
+            case LAYOUT_RGB565:
+                for (uint32_t x = 0; x < width; ++x, source += 3, line += 2)
+                {
+                    uint16_t const value = ((source[0] >> 3) << 11) | ((source[1] >> 2) << 5) | (source[2] >> 3);
+                    line[0] = static_cast<uint8_t>(value);
+                    line[1] = static_cast<uint8_t>(value >> 8);
+                }
+                break;
+            case LAYOUT_YUYV:
+            case LAYOUT_UYVY:
+            case LAYOUT_VYUY:
+                for (uint32_t x = 0; x + 1 < width; x += 2, source += 6, line += 4)
+                {
+                    uint8_t const y0 = Luma(source);
+                    uint8_t const y1 = Luma(source + 3);
+                    uint8_t const u = ChromaBlue(source);
+                    uint8_t const v = ChromaRed(source);
+                    if (format.layout == LAYOUT_YUYV)
+                    {
+                        line[0] = y0; line[1] = u; line[2] = y1; line[3] = v;
+                    }
+                    else if (format.layout == LAYOUT_UYVY)
+                    {
+                        line[0] = u; line[1] = y0; line[2] = v; line[3] = y1;
+                    }
+                    else
+                    {
+                        line[0] = v; line[1] = y0; line[2] = u; line[3] = y1;
+                    }
+                }
+                break;
+            case LAYOUT_RAW8:
+                for (uint32_t x = 0; x < width; ++x, source += 3)
+                {
+                    line[x] = RawSample(format, source, x, y);
+                }
+                break;
+            case LAYOUT_RAW10P:
+                // MIPI CSI-2 RAW10: four upper bytes followed by the low bits of all four
+                for (uint32_t x = 0; x + 3 < width; x += 4, line += 5)
+                {
+                    uint8_t lowBits = 0;
+                    for (uint32_t i = 0; i < 4; ++i, source += 3)
+                    {
+                        uint16_t const sample = WidenSample(RawSample(format, source, x + i, y), 10);
+                        line[i] = static_cast<uint8_t>(sample >> 2);
+                        lowBits |= (sample & 0x3) << (2 * i);
+                    }
+                    line[4] = lowBits;
+                }
+                break;
+            case LAYOUT_RAW12P:
+                // MIPI CSI-2 RAW12: two upper bytes followed by the low nibbles of both
+                for (uint32_t x = 0; x + 1 < width; x += 2, source += 6, line += 3)
+                {
+                    uint16_t const sample0 = WidenSample(RawSample(format, source, x, y), 12);
+                    uint16_t const sample1 = WidenSample(RawSample(format, source + 3, x + 1, y), 12);
+                    line[0] = static_cast<uint8_t>(sample0 >> 4);
+                    line[1] = static_cast<uint8_t>(sample1 >> 4);
+                    line[2] = static_cast<uint8_t>((sample0 & 0xF) | ((sample1 & 0xF) << 4));
+                }
+                break;
+            case LAYOUT_RAW16:
+                for (uint32_t x = 0; x < width; ++x, source += 3, line += 2)
+                {
+                    uint16_t const sample = static_cast<uint16_t>(WidenSample(RawSample(format, source, x, y), format.storedBits)
+                                                                  << format.alignShift);
+                    line[0] = static_cast<uint8_t>(sample);
+                    line[1] = static_cast<uint8_t>(sample >> 8);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    return bytesPerLine * height;
+}
+
+} // namespace
+
+FrameObserverSynthetic::FrameObserverSynthetic(bool showFrames)
+    : FrameObserver(showFrames)
+    , m_GeneratedWidth(0)
+    , m_GeneratedHeight(0)
+    , m_GeneratedPixelFormat(0)
+    , m_GeneratedBytesPerLine(0)
+    , m_GeneratedPayloadSize(0)
+    , m_FramesPerSecond(30.0)
+    , m_Pattern(SYNTHETIC_PATTERN_BARS)
+    , m_FrameReadyFileDescriptor(-1)
+    , m_TimerFileDescriptor(-1)
+    , m_StopFileDescriptor(-1)
+    , m_Sequence(0)
+{
+    // semaphore mode: the descriptor stays readable as long as finished frames are waiting,
+    // just like a video device with buffers in its done queue
+    m_FrameReadyFileDescriptor = eventfd(0, EFD_SEMAPHORE | EFD_NONBLOCK | EFD_CLOEXEC);
+    m_StopFileDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_FrameReadyFileDescriptor < 0 || m_StopFileDescriptor < 0)
+    {
+        LOG_EX("FrameObserverSynthetic::FrameObserverSynthetic eventfd failed errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+    }
+}
+
+FrameObserverSynthetic::~FrameObserverSynthetic()
+{
+    // the base class can't requeue through us anymore once we are gone
+    StopGenerator();
+    StopStream();
+    wait();
+    DeleteAllUserBuffer();
+
+    if (m_FrameReadyFileDescriptor >= 0)
+    {
+        close(m_FrameReadyFileDescriptor);
+    }
+    if (m_StopFileDescriptor >= 0)
+    {
+        close(m_StopFileDescriptor);
+    }
+}
+
+int FrameObserverSynthetic::GetFrameLayout(uint32_t pixelFormat, uint32_t width, uint32_t height,
+                                           uint32_t &bytesPerLine, uint32_t &payloadSize)
+{
+    SyntheticFormat format;
+    if (!DescribeFormat(pixelFormat, format) || width < 2 || height < 2)
+    {
+        return -1;
+    }
+
+    switch (format.layout)
+    {
+        case LAYOUT_BGRX32:
+        case LAYOUT_XRGB32:
+            bytesPerLine = width * 4;
+            break;
+        case LAYOUT_RGB24:
+        case LAYOUT_BGR24:
+            bytesPerLine = width * 3;
+            break;
+        case LAYOUT_RGB565:
+        case LAYOUT_RAW16:
+            bytesPerLine = width * 2;
+            break;
+        case LAYOUT_YUYV:
+        case LAYOUT_UYVY:
+        case LAYOUT_VYUY:
+            if (width % 2)
+            {
+                return -1;
+            }
+            bytesPerLine = width * 2;
+            break;
+        case LAYOUT_YUV420:
+            if (width % 2 || height % 2)
+            {
+                return -1;
+            }
+            bytesPerLine = width;
+            payloadSize = width * height * 3 / 2;
+            return 0;
+        case LAYOUT_NV12:
+        case LAYOUT_NV16:
+            if (width % 2 || (format.layout == LAYOUT_NV12 && height % 2))
+            {
+                return -1;
+            }
+            bytesPerLine = width;
+            payloadSize = (format.layout == LAYOUT_NV12) ? width * height * 3 / 2 : width * height * 2;
+            return 0;
+        case LAYOUT_JPEG:
+            // compressed frames are never larger than the raw image
+            bytesPerLine = 0;
+            payloadSize = width * height * 3;
+            return 0;
+        case LAYOUT_RAW8:
+            bytesPerLine = width;
+            break;
+        case LAYOUT_RAW10P:
+            if (width % 4)
+            {
+                return -1;
+            }
+            bytesPerLine = width * 5 / 4;
+            break;
+        case LAYOUT_RAW12P:
+            if (width % 2)
+            {
+                return -1;
+            }
+            bytesPerLine = width * 3 / 2;
+            break;
+    }
+
+    payloadSize = bytesPerLine * height;
+
+    return 0;
+}
+
+int FrameObserverSynthetic::SetFormat(uint32_t pixelFormat, uint32_t width, uint32_t height)
+{
+    uint32_t bytesPerLine = 0;
+    uint32_t payloadSize = 0;
+
+    if (GetFrameLayout(pixelFormat, width, height, bytesPerLine, payloadSize) < 0)
+    {
+        LOG_EX("FrameObserverSynthetic::SetFormat format %s with %ux%u is not supported", v4l2helper::ConvertPixelFormat2String(pixelFormat).c_str(), width, height);
+        return -1;
+    }
+
+    m_GeneratedPixelFormat = pixelFormat;
+    m_GeneratedWidth = width;
+    m_GeneratedHeight = height;
+    m_GeneratedBytesPerLine = bytesPerLine;
+    m_GeneratedPayloadSize = payloadSize;
+
+    return 0;
+}
+
+void FrameObserverSynthetic::SetFrameRate(double framesPerSecond)
+{
+    m_FramesPerSecond = framesPerSecond;
+    SetFrameInterval(framesPerSecond > 0.0 ? static_cast<uint64_t>(1e6 / framesPerSecond) : 0);
+}
+
+void FrameObserverSynthetic::SetPattern(SYNTHETIC_PATTERN_TYPE pattern)
+{
+    m_Pattern = pattern;
+}
+
+void FrameObserverSynthetic::SetReplayFile(const std::string &fileName)
+{
+    m_ReplayFileName = fileName;
+}
+
+int FrameObserverSynthetic::GetFileDescriptor() const
+{
+    return m_FrameReadyFileDescriptor;
+}
+
+int FrameObserverSynthetic::StartGenerator()
+{
+    if (m_pGeneratorThread)
+    {
+        return 0;
+    }
+
+    if (m_SourceFrames.empty() || m_FramesPerSecond <= 0.0)
+    {
+        LOG_EX("FrameObserverSynthetic::StartGenerator no frames to generate");
+        return -1;
+    }
+
+    m_TimerFileDescriptor = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (m_TimerFileDescriptor < 0)
+    {
+        LOG_EX("FrameObserverSynthetic::StartGenerator timerfd_create failed errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        return -1;
+    }
+
+    uint64_t const periodNanoseconds = static_cast<uint64_t>(1e9 / m_FramesPerSecond);
+    itimerspec timerSpec;
+    CLEAR(timerSpec);
+    timerSpec.it_interval.tv_sec = periodNanoseconds / 1000000000ULL;
+    timerSpec.it_interval.tv_nsec = periodNanoseconds % 1000000000ULL;
+    timerSpec.it_value = timerSpec.it_interval;
+
+    if (timerfd_settime(m_TimerFileDescriptor, 0, &timerSpec, NULL) < 0)
+    {
+        LOG_EX("FrameObserverSynthetic::StartGenerator timerfd_settime failed errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        close(m_TimerFileDescriptor);
+        m_TimerFileDescriptor = -1;
+        return -1;
+    }
+
+    {
+        QMutexLocker locker(&m_GeneratorMutex);
+        m_Sequence = 0;
+    }
+
+    m_pGeneratorThread = std::make_unique<std::thread>([this] {
+        GeneratorMain();
+    });
+
+    LOG_EX("FrameObserverSynthetic::StartGenerator %s %ux%u at %.2f fps from %zu source frames",
+           v4l2helper::ConvertPixelFormat2String(m_GeneratedPixelFormat).c_str(), m_GeneratedWidth, m_GeneratedHeight,
+           m_FramesPerSecond, m_SourceFrames.size());
+
+    return 0;
+}
+
+void FrameObserverSynthetic::StopGenerator()
+{
+    uint64_t value = 1;
+
+    if (m_pGeneratorThread)
+    {
+        if (write(m_StopFileDescriptor, &value, sizeof(value)) < 0)
+        {
+            LOG_EX("FrameObserverSynthetic::StopGenerator write to eventfd failed errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        }
+        m_pGeneratorThread->join();
+        m_pGeneratorThread.reset();
+
+        while (read(m_StopFileDescriptor, &value, sizeof(value)) > 0)
+        {
+        }
+    }
+
+    if (m_TimerFileDescriptor >= 0)
+    {
+        close(m_TimerFileDescriptor);
+        m_TimerFileDescriptor = -1;
+    }
+
+    // like VIDIOC_STREAMOFF, finished but not dequeued frames are gone
+    QMutexLocker locker(&m_GeneratorMutex);
+    m_FinishedFrames.clear();
+    m_QueuedBuffers.clear();
+    while (read(m_FrameReadyFileDescriptor, &value, sizeof(value)) > 0)
+    {
+    }
+}
+
+int FrameObserverSynthetic::StopDeviceStream()
+{
+    StopGenerator();
+
+    return 0;
+}
+
+int FrameObserverSynthetic::StartDeviceStream()
+{
+    return StartGenerator();
+}
+
+void FrameObserverSynthetic::GeneratorMain()
+{
+    pollfd fds[2];
+    fds[0].fd = m_TimerFileDescriptor;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_StopFileDescriptor;
+    fds[1].events = POLLIN;
+
+    while (true)
+    {
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno != EINTR)
+            {
+                LOG_EX("FrameObserverSynthetic::GeneratorMain poll failed errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+                break;
+            }
+            continue;
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+            break;
+        }
+
+        uint64_t expirations = 0;
+        if ((fds[0].revents & POLLIN) && read(m_TimerFileDescriptor, &expirations, sizeof(expirations)) == sizeof(expirations))
+        {
+            if (expirations > 1)
+            {
+                // we have been late ourselves, the frames of the missed periods are lost
+                QMutexLocker locker(&m_GeneratorMutex);
+                m_Sequence += static_cast<uint32_t>(expirations - 1);
+            }
+
+            ProduceFrame();
+        }
+    }
+}
+
+void FrameObserverSynthetic::ProduceFrame()
+{
+    FinishedFrame frame;
+
+    {
+        QMutexLocker locker(&m_GeneratorMutex);
+        frame.sequence = m_Sequence++;
+
+        if (m_QueuedBuffers.empty())
+        {
+            // no buffer to write into, the frame is lost like with a real sensor
+            return;
+        }
+
+        frame.index = m_QueuedBuffers.front();
+        m_QueuedBuffers.pop_front();
+    }
+
+    // the slots of the buffer table never move, the capture thread may be adding buffers meanwhile
+    uint8_t *pBuffer = m_UserBufferContainerList[frame.index]->pBuffer;
+
+    // this copy stands for the DMA transfer of the driver
+    SourceFrame const &source = m_SourceFrames[frame.sequence % m_SourceFrames.size()];
+    std::memcpy(pBuffer, source.data.data(), source.bytesUsed);
+
+    frame.bytesUsed = source.bytesUsed;
+    frame.timestamp = LatencyStatistics::Now();
+
+    {
+        QMutexLocker locker(&m_GeneratorMutex);
+        m_FinishedFrames.push_back(frame);
+    }
+
+    uint64_t value = 1;
+    if (write(m_FrameReadyFileDescriptor, &value, sizeof(value)) < 0)
+    {
+        LOG_EX("FrameObserverSynthetic::ProduceFrame write to eventfd failed errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+    }
+}
+
+int FrameObserverSynthetic::ReadFrame(v4l2_buffer &buf)
+{
+    uint64_t value;
+
+    // sets errno to EAGAIN if nothing is ready, which is what the caller expects from VIDIOC_DQBUF
+    if (read(m_FrameReadyFileDescriptor, &value, sizeof(value)) != sizeof(value))
+    {
+        return -1;
+    }
+
+    FinishedFrame frame;
+    {
+        QMutexLocker locker(&m_GeneratorMutex);
+        if (m_FinishedFrames.empty())
+        {
+            errno = EAGAIN;
+            return -1;
+        }
+
+        frame = m_FinishedFrames.front();
+        m_FinishedFrames.pop_front();
+    }
+
+    CLEAR(buf);
+    buf.index = frame.index;
+    buf.type = m_BufferType;
+    buf.memory = V4L2_MEMORY_USERPTR;
+    buf.bytesused = frame.bytesUsed;
+    buf.field = V4L2_FIELD_NONE;
+    buf.flags = V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC | V4L2_BUF_FLAG_TSTAMP_SRC_EOF;
+    buf.sequence = frame.sequence;
+    buf.timestamp.tv_sec = frame.timestamp / 1000000ULL;
+    buf.timestamp.tv_usec = frame.timestamp % 1000000ULL;
+    buf.m.userptr = reinterpret_cast<unsigned long>(m_UserBufferContainerList[frame.index]->pBuffer);
+    buf.length = m_UserBufferContainerList[frame.index]->nBufferlength;
+
+    return 0;
+}
+
+int FrameObserverSynthetic::GetFrameData(const v4l2_buffer &buf, uint8_t *&buffer, uint32_t &length) const
+{
+    int result = -1;
+
+    if (m_IsStreamRunning)
+    {
+        if (buf.index < m_UserBufferContainerList.size())
+        {
+            length = m_UserBufferContainerList[buf.index]->nBufferlength;
+            buffer = m_UserBufferContainerList[buf.index]->pBuffer;
+        }
+        else
+        {
+            length = 0;
+            buffer = 0;
+        }
+
+        if (0 != buffer && 0 != length)
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+/*********************************************************************************************************/
+// Frame buffer handling
+/*********************************************************************************************************/
+
+int FrameObserverSynthetic::CreateAllUserBuffer(uint32_t bufferCount, uint32_t bufferSize)
+{
+    if (bufferCount == 0 || bufferCount > MAX_VIEWER_USER_BUFFER_COUNT)
+    {
+        return -1;
+    }
+
+    if (m_GeneratedPixelFormat == 0)
+    {
+        LOG_EX("FrameObserverSynthetic::CreateAllUserBuffer no format set");
+        return -1;
+    }
+
+    bufferSize = std::max(bufferSize, m_GeneratedPayloadSize);
+
+    if (PrepareSourceFrames(bufferSize) < 0)
+    {
+        return -1;
+    }
+
+    base::LocalMutexLockGuard guard(m_UsedBufferMutex);
+
+    m_UserBufferContainerList.resize(bufferCount);
+
+    for (unsigned int x = 0; x < m_UserBufferContainerList.size(); ++x)
+    {
+        UserBuffer* pTmpBuffer = new UserBuffer;
+        pTmpBuffer->nBufferlength = bufferSize;
+        m_RealPayloadSize = pTmpBuffer->nBufferlength;
+
+        // same alignment as the user pointer buffers
+        uint32_t const allocationSize = ((bufferSize + 127) / 128) * 128;
+        pTmpBuffer->pBuffer = static_cast<uint8_t*>(aligned_alloc(128, allocationSize));
+
+        if (!pTmpBuffer->pBuffer)
+        {
+            delete pTmpBuffer;
+            LOG_EX("FrameObserverSynthetic::CreateAllUserBuffer buffer creation error");
+            for (unsigned int i = 0; i < x; ++i)
+            {
+                free(m_UserBufferContainerList[i]->pBuffer);
+                delete m_UserBufferContainerList[i];
+            }
+            m_UserBufferContainerList.resize(0);
+            return -1;
+        }
+
+        m_UserBufferContainerList.set(x, pTmpBuffer);
+    }
+
+    return 0;
+}
+
+int FrameObserverSynthetic::PrepareSourceFrames(uint32_t bufferSize)
+{
+    uint32_t const maxFrameCount = static_cast<uint32_t>(std::max<uint64_t>(SOURCE_FRAME_MEMORY_BUDGET / bufferSize, 1));
+
+    m_SourceFrames.clear();
+
+    if (!m_ReplayFileName.empty())
+    {
+        return LoadReplayFile(maxFrameCount);
+    }
+
+    SyntheticFormat format;
+    DescribeFormat(m_GeneratedPixelFormat, format);
+
+    uint32_t const frameCount = std::min(PATTERN_FRAME_COUNT, maxFrameCount);
+    std::vector<uint8_t> rgb(size_t(m_GeneratedWidth) * m_GeneratedHeight * 3);
+
+    m_SourceFrames.resize(frameCount);
+    for (uint32_t frame = 0; frame < frameCount; ++frame)
+    {
+        uint8_t *pixel = rgb.data();
+        for (uint32_t y = 0; y < m_GeneratedHeight; ++y)
+        {
+            for (uint32_t x = 0; x < m_GeneratedWidth; ++x, pixel += 3)
+            {
+                RenderPatternPixel(m_Pattern, x, y, m_GeneratedWidth, m_GeneratedHeight, frame, frameCount, pixel);
+            }
+        }
+
+        SourceFrame &source = m_SourceFrames[frame];
+        source.data.assign(bufferSize, 0);
+        source.bytesUsed = EncodeFrame(format, rgb.data(), m_GeneratedWidth, m_GeneratedHeight,
+                                       m_GeneratedBytesPerLine, source.data.data(), bufferSize);
+        if (source.bytesUsed == 0)
+        {
+            LOG_EX("FrameObserverSynthetic::PrepareSourceFrames encoding frame %u failed", frame);
+            m_SourceFrames.clear();
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int FrameObserverSynthetic::LoadReplayFile(uint32_t maxFrameCount)
+{
+    SyntheticFormat format;
+    DescribeFormat(m_GeneratedPixelFormat, format);
+    if (format.layout == LAYOUT_JPEG)
+    {
+        // there are no frame boundaries in a raw recording of compressed frames
+        LOG_EX("FrameObserverSynthetic::LoadReplayFile compressed formats can't be replayed");
+        return -1;
+    }
+
+    FILE *pFile = fopen(m_ReplayFileName.c_str(), "rb");
+    if (pFile == NULL)
+    {
+        LOG_EX("FrameObserverSynthetic::LoadReplayFile opening %s failed errno=%d=%s", m_ReplayFileName.c_str(), errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        return -1;
+    }
+
+    while (m_SourceFrames.size() < maxFrameCount)
+    {
+        SourceFrame source;
+        source.data.assign(m_GeneratedPayloadSize, 0);
+        source.bytesUsed = m_GeneratedPayloadSize;
+
+        if (fread(source.data.data(), 1, m_GeneratedPayloadSize, pFile) != m_GeneratedPayloadSize)
+        {
+            break;
+        }
+
+        m_SourceFrames.push_back(std::move(source));
+    }
+
+    fclose(pFile);
+
+    if (m_SourceFrames.empty())
+    {
+        LOG_EX("FrameObserverSynthetic::LoadReplayFile %s has no complete frame of %u bytes", m_ReplayFileName.c_str(), m_GeneratedPayloadSize);
+        return -1;
+    }
+
+    LOG_EX("FrameObserverSynthetic::LoadReplayFile %zu frames loaded from %s", m_SourceFrames.size(), m_ReplayFileName.c_str());
+
+    return 0;
+}
+
+int FrameObserverSynthetic::QueueAllUserBuffer()
+{
+    base::LocalMutexLockGuard guard(m_UsedBufferMutex);
+    QMutexLocker locker(&m_GeneratorMutex);
+
+    m_QueuedBuffers.clear();
+    for (uint32_t i = 0; i < m_UserBufferContainerList.size(); i++)
+    {
+        m_QueuedBuffers.push_back(i);
+        m_DropStatistics.OnBufferQueued();
+    }
+
+    return m_UserBufferContainerList.empty() ? -1 : 0;
+}
+
+int FrameObserverSynthetic::QueueSingleUserBuffer(const int index)
+{
+    if (index < static_cast<int>(m_UserBufferContainerList.size()) && m_IsStreamRunning)
+    {
+        QMutexLocker locker(&m_GeneratorMutex);
+        m_QueuedBuffers.push_back(index);
+        m_DropStatistics.OnBufferQueued();
+    }
+
+    return 0;
+}
+
+int FrameObserverSynthetic::AddUserBuffers(uint32_t bufferCount)
+{
+    // same alignment as the user pointer buffers
+    uint32_t const allocationSize = ((m_RealPayloadSize + 127) / 128) * 128;
+
+    base::LocalMutexLockGuard guard(m_UsedBufferMutex);
+
+    uint32_t added = 0;
+    for (; added < bufferCount; ++added)
+    {
+        UserBuffer* pTmpBuffer = new UserBuffer;
+        pTmpBuffer->nBufferlength = m_RealPayloadSize;
+        pTmpBuffer->pBuffer = static_cast<uint8_t*>(aligned_alloc(128, allocationSize));
+
+        if (!pTmpBuffer->pBuffer)
+        {
+            delete pTmpBuffer;
+            LOG_EX("FrameObserverSynthetic::AddUserBuffers buffer creation error");
+            break;
+        }
+
+        if (!m_UserBufferContainerList.push_back(pTmpBuffer))
+        {
+            DeleteUserBuffer(pTmpBuffer);
+            LOG_EX("FrameObserverSynthetic::AddUserBuffers buffer table is full");
+            break;
+        }
+    }
+
+    return added > 0 ? static_cast<int>(added) : -1;
+}
+
+void FrameObserverSynthetic::DeleteUserBuffer(UserBuffer *pBuffer)
+{
+    free(pBuffer->pBuffer);
+    delete pBuffer;
+}
+
+int FrameObserverSynthetic::DeleteAllUserBuffer()
+{
+    StopGenerator();
+
+    base::LocalMutexLockGuard guard(m_UsedBufferMutex);
+
+    for (unsigned int x = 0; x < m_UserBufferContainerList.size(); x++)
+    {
+        if (0 != m_UserBufferContainerList[x])
+        {
+            free(m_UserBufferContainerList[x]->pBuffer);
+            delete m_UserBufferContainerList[x];
+        }
+    }
+
+    m_UserBufferContainerList.resize(0);
+    m_DropStatistics.OnBuffersReleased();
+    m_SourceFrames.clear();
+
+    return 0;
+}
@@ -32,11 +32,12 @@
 #include <sys/mman.h>
 #include <unistd.h>
 
-#include <cstdlib>
 #include <sstream>
 
 FrameObserverUSER::FrameObserverUSER(bool showFrames)
     : FrameObserver(showFrames)
+    , m_PlaneOffsets()
+    , m_PlaneLengths()
 {
 }
 
@@ -44,6 +45,12 @@ FrameObserverUSER::~FrameObserverUSER()
 {
 }
 
+void FrameObserverUSER::SetBufferPoolOptions(bool hugePages, bool lockMemory)
+{
+    m_BufferPool.SetHugePages(hugePages);
+    m_BufferPool.SetLockMemory(lockMemory);
+}
+
 int FrameObserverUSER::ReadFrame(v4l2_buffer &buf)
 {
     int result = -1;
@@ -53,11 +60,12 @@ int FrameObserverUSER::ReadFrame(v4l2_buffer &buf)
     buf.type = m_BufferType;
     buf.memory = V4L2_MEMORY_USERPTR;
 
-    v4l2_plane *plane = new v4l2_plane;
+    // only the capture thread dequeues, the planes are read before the next dequeue
     if(m_BufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
     {
-        buf.m.planes = plane;
-        buf.length = 1;
+        CLEAR(m_DequeuePlanes);
+        buf.m.planes = m_DequeuePlanes;
+        buf.length = m_MemoryPlaneCount;
     }
 
     if (m_IsStreamRunning)
@@ -76,7 +84,6 @@ int FrameObserverUSER::GetFrameData(const v4l2_buffer &buf, uint8_t *&buffer, ui
         {
             length = buf.m.planes[0].length;
             buffer = (uint8_t *) buf.m.planes[0].m.userptr;
-            delete buf.m.planes;
         }
         else
         {
@@ -101,7 +108,7 @@ int FrameObserverUSER::CreateAllUserBuffer(uint32_t bufferCount, uint32_t buffer
 {
     int result = -1;
 
-    if (bufferCount <= MAX_VIEWER_USER_BUFFER_COUNT)
+    if (bufferCount <= MAX_VIEWER_USER_BUFFER_COUNT && 0 == ReadPlaneFormats())
     {
         v4l2_requestbuffers req;
 
@@ -139,28 +146,33 @@ int FrameObserverUSER::CreateAllUserBuffer(uint32_t bufferCount, uint32_t buffer
                 return -1;
             }
 
-            // get the length and start address of each of the 4 buffer structs and assign the user buffer addresses
+            // the memory planes of a buffer follow each other in its pool buffer, each page aligned
+            uint32_t const planeCount = (m_BufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE) ? m_MemoryPlaneCount : 1;
+            size_t const pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            size_t totalSize = 0;
+            for (uint32_t i = 0; i < planeCount; ++i)
+            {
+                size_t const planeSize = (planeCount > 1) ? m_PlaneFormats[i].sizeimage : bufferSize;
+                m_PlaneOffsets[i] = totalSize;
+                m_PlaneLengths[i] = planeSize;
+                totalSize += (planeSize + pageSize - 1) / pageSize * pageSize;
+            }
+
+            // one mapping for all buffers, local to the device and faulted in before streaming
+            m_BufferPool.SetNumaNode(UserBufferPool::GetDeviceNumaNode(m_nFileDescriptor));
+            if (m_BufferPool.Allocate(bufferCount, totalSize) != 0)
+            {
+                LOG_EX("FrameObserverUSER::CreateAllUserBuffer buffer creation error");
+                m_UserBufferContainerList.resize(0);
+                return -1;
+            }
+
+            // assign the user buffer addresses
             for (unsigned int x = 0; x < m_UserBufferContainerList.size(); ++x)
             {
-                UserBuffer* pTmpBuffer = new UserBuffer;
-                pTmpBuffer->nBufferlength = bufferSize;
-                m_RealPayloadSize = pTmpBuffer->nBufferlength;
-
-                // buffer needs to be aligned to 128 bytes
-                if (bufferSize % 128)
-                    bufferSize = ((bufferSize / 128) + 1) * 128;
-                pTmpBuffer->pBuffer = static_cast<uint8_t*>(aligned_alloc(128, bufferSize));
-
-                if (!pTmpBuffer->pBuffer)
-                {
-                    delete pTmpBuffer;
-                    LOG_EX("FrameObserverUSER::CreateAllUserBuffer buffer creation error");
-                    m_UserBufferContainerList.resize(0);
-                    return -1;
-                }
-                else
-                    m_UserBufferContainerList[x] = pTmpBuffer;
+                m_UserBufferContainerList.set(x, CreateUserBuffer(x));
             }
+            m_RealPayloadSize = totalSize;
 
             result = 0;
         }
@@ -178,20 +190,24 @@ int FrameObserverUSER::QueueAllUserBuffer()
     for (uint32_t i=0; i<m_UserBufferContainerList.size(); i++)
     {
         v4l2_buffer buf;
-        v4l2_plane plane;
+        v4l2_plane planes[VIDEO_MAX_PLANES];
         CLEAR(buf);
-        CLEAR(plane);
+        CLEAR(planes);
         buf.type = m_BufferType;
         buf.index = i;
         buf.memory = V4L2_MEMORY_USERPTR;
 
         if (buf.type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
         {
-            buf.m.planes = &plane;
-            buf.length = 1;
+            UserBuffer const *pBuffer = m_UserBufferContainerList[i];
+            buf.m.planes = planes;
+            buf.length = pBuffer->nPlaneCount;
 
-            plane.m.userptr = (unsigned long)m_UserBufferContainerList[i]->pBuffer;
-            plane.length = m_UserBufferContainerList[i]->nBufferlength;
+            for (uint32_t plane = 0; plane < pBuffer->nPlaneCount; ++plane)
+            {
+                planes[plane].m.userptr = (unsigned long)pBuffer->pPlaneBuffers[plane];
+                planes[plane].length = pBuffer->nPlaneLengths[plane];
+            }
         }
         else
         {
@@ -208,6 +224,7 @@ int FrameObserverUSER::QueueAllUserBuffer()
         else
         {
             LOG_EX("FrameObserverUSER::QueueAllUserBuffer VIDIOC_QBUF queue #%d buffer=%p OK", i, m_UserBufferContainerList[i]->pBuffer);
+            m_DropStatistics.OnBufferQueued();
             result = 0;
         }
     }
@@ -219,23 +236,27 @@ int FrameObserverUSER::QueueSingleUserBuffer(const int index)
 {
     int result = 0;
     v4l2_buffer buf;
-    base::LocalMutexLockGuard guard(m_UsedBufferMutex);
 
     if (index < static_cast<int>(m_UserBufferContainerList.size()))
     {
-        v4l2_plane plane;
+        v4l2_plane planes[VIDEO_MAX_PLANES];
         CLEAR(buf);
+        CLEAR(planes);
         buf.type = m_BufferType;
         buf.index = index;
         buf.memory = V4L2_MEMORY_USERPTR;
 
         if (buf.type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
         {
-            buf.m.planes = &plane;
-            buf.length = 1;
+            UserBuffer const *pBuffer = m_UserBufferContainerList[index];
+            buf.m.planes = planes;
+            buf.length = pBuffer->nPlaneCount;
 
-            plane.m.userptr = (unsigned long)m_UserBufferContainerList[index]->pBuffer;
-            plane.length = m_UserBufferContainerList[index]->nBufferlength;
+            for (uint32_t plane = 0; plane < pBuffer->nPlaneCount; ++plane)
+            {
+                planes[plane].m.userptr = (unsigned long)pBuffer->pPlaneBuffers[plane];
+                planes[plane].length = pBuffer->nPlaneLengths[plane];
+            }
         }
         else
         {
@@ -250,12 +271,89 @@ int FrameObserverUSER::QueueSingleUserBuffer(const int index)
             {
                 LOG_EX("FrameObserverUSER::QueueSingleUserBuffer VIDIOC_QBUF queue #%d buffer=%p failed", index, m_UserBufferContainerList[index]->pBuffer);
             }
+            else
+            {
+                m_DropStatistics.OnBufferQueued();
+            }
         }
     }
 
     return result;
 }
 
+int FrameObserverUSER::AddUserBuffers(uint32_t bufferCount)
+{
+    v4l2_create_buffers create;
+    CLEAR(create);
+    create.count = bufferCount;
+    create.memory = V4L2_MEMORY_USERPTR;
+    create.format.type = m_BufferType;
+
+    if (-1 == iohelper::xioctl(m_nFileDescriptor, VIDIOC_G_FMT, &create.format))
+    {
+        LOG_EX("FrameObserverUSER::AddUserBuffers VIDIOC_G_FMT errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        return -1;
+    }
+
+    if (-1 == iohelper::xioctl(m_nFileDescriptor, VIDIOC_CREATE_BUFS, &create))
+    {
+        LOG_EX("FrameObserverUSER::AddUserBuffers VIDIOC_CREATE_BUFS errno=%d=%s", errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        return -1;
+    }
+
+    // the container is indexed like the driver, so the new buffers have to follow the existing ones
+    if (create.index != m_UserBufferContainerList.size())
+    {
+        LOG_EX("FrameObserverUSER::AddUserBuffers VIDIOC_CREATE_BUFS returned index %u, expected %zu", create.index, m_UserBufferContainerList.size());
+        return -1;
+    }
+
+    if (m_BufferPool.Reserve(create.index + create.count) != 0)
+    {
+        LOG_EX("FrameObserverUSER::AddUserBuffers buffer creation error");
+        return -1;
+    }
+
+    base::LocalMutexLockGuard guard(m_UsedBufferMutex);
+
+    uint32_t added = 0;
+    for (; added < create.count; ++added)
+    {
+        UserBuffer* pTmpBuffer = CreateUserBuffer(create.index + added);
+        if (!m_UserBufferContainerList.push_back(pTmpBuffer))
+        {
+            // the driver keeps the buffer unused until the stream ends
+            LOG_EX("FrameObserverUSER::AddUserBuffers buffer table is full");
+            delete pTmpBuffer;
+            break;
+        }
+    }
+
+    return added > 0 ? static_cast<int>(added) : -1;
+}
+
+UserBuffer* FrameObserverUSER::CreateUserBuffer(uint32_t index) const
+{
+    UserBuffer* pTmpBuffer = new UserBuffer;
+    uint8_t *pMemory = m_BufferPool.GetBuffer(index);
+
+    pTmpBuffer->nPlaneCount = (m_BufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE) ? m_MemoryPlaneCount : 1;
+    for (uint32_t i = 0; i < pTmpBuffer->nPlaneCount; ++i)
+    {
+        pTmpBuffer->pPlaneBuffers[i] = pMemory + m_PlaneOffsets[i];
+        pTmpBuffer->nPlaneLengths[i] = m_PlaneLengths[i];
+    }
+    pTmpBuffer->pBuffer = pTmpBuffer->pPlaneBuffers[0];
+    pTmpBuffer->nBufferlength = pTmpBuffer->nPlaneLengths[0];
+
+    return pTmpBuffer;
+}
+
+void FrameObserverUSER::DiscardUserBuffer(uint32_t index)
+{
+    m_BufferPool.Discard(index);
+}
+
 int FrameObserverUSER::DeleteAllUserBuffer()
 {
     int result = 0;
@@ -274,16 +372,15 @@ int FrameObserverUSER::DeleteAllUserBuffer()
     {
         base::LocalMutexLockGuard guard(m_UsedBufferMutex);
 
-        // delete all user buffer
+        // delete all user buffer, the memory belongs to the pool
         for (unsigned int x = 0; x < m_UserBufferContainerList.size(); x++)
         {
-            if (0 != m_UserBufferContainerList[x]->pBuffer)
-            free(m_UserBufferContainerList[x]->pBuffer);
-            if (0 != m_UserBufferContainerList[x])
             delete m_UserBufferContainerList[x];
         }
 
         m_UserBufferContainerList.resize(0);
+        m_BufferPool.Free();
+        m_DropStatistics.OnBuffersReleased();
     }
 
     return result;
@@ -0,0 +1,268 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#include "FrameSynchronizer.h"
+#include "FrameObserver.h"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+
+FrameSynchronizer::FrameSynchronizer(uint64_t toleranceMicroseconds, uint32_t queueDepth)
+    : m_Tolerance(toleranceMicroseconds)
+    , m_QueueDepth(std::max<uint32_t>(queueDepth, 1))
+    , m_Active(true)
+    , m_LastSetTimestamp(0)
+    , m_SetCount(0)
+    , m_MaxSkew(0)
+{
+}
+
+FrameSynchronizer::~FrameSynchronizer()
+{
+    Flush();
+}
+
+int FrameSynchronizer::AddStream(FrameObserver *pObserver)
+{
+    int const stream = AddStream();
+    pObserver->AddRawDataProcessor([this, stream] (BufferWrapper const& buffer, FrameLease lease) {
+        Push(stream, buffer, std::move(lease));
+    });
+
+    return stream;
+}
+
+int FrameSynchronizer::AddStream()
+{
+    QMutexLocker locker(&m_Mutex);
+    m_Streams.emplace_back();
+
+    return static_cast<int>(m_Streams.size() - 1);
+}
+
+void FrameSynchronizer::AddSetProcessor(SetProcessorFunc processor)
+{
+    QMutexLocker locker(&m_DispatchMutex);
+    m_SetProcessors.push_back(std::move(processor));
+}
+
+void FrameSynchronizer::Push(int stream, BufferWrapper const& buffer, FrameLease lease)
+{
+    // released outside of the locks, requeuing a buffer may take a while
+    std::vector<FrameLease> dropped;
+    std::vector<std::vector<SynchronizedFrame>> sets;
+
+    m_Mutex.lock();
+    if (!m_Active || stream < 0 || stream >= static_cast<int>(m_Streams.size()))
+    {
+        m_Mutex.unlock();
+        return;
+    }
+
+    Stream &current = m_Streams[stream];
+    if (!current.active)
+    {
+        m_Mutex.unlock();
+        return;
+    }
+
+    uint64_t const timestamp = buffer.timestamps.Origin();
+    ++current.statistics.received;
+
+    // the other streams have moved on, sets are emitted in time order
+    if (m_LastSetTimestamp != 0 && timestamp + m_Tolerance < m_LastSetTimestamp)
+    {
+        ++current.statistics.late;
+        m_Mutex.unlock();
+        return;
+    }
+
+    if (current.queue.size() >= m_QueueDepth)
+    {
+        dropped.push_back(std::move(current.queue.front().frame.lease));
+        current.queue.pop_front();
+        ++current.statistics.evicted;
+    }
+    current.queue.push_back(PendingFrame { SynchronizedFrame { stream, buffer, std::move(lease) }, timestamp });
+
+    Match(sets, dropped);
+
+    if (sets.empty())
+    {
+        m_Mutex.unlock();
+        return;
+    }
+
+    // taken before the state is unlocked, so sets of other threads wait behind these
+    m_DispatchMutex.lock();
+    m_Mutex.unlock();
+    for (auto const &set : sets)
+    {
+        for (auto const &processor : m_SetProcessors)
+        {
+            processor(set);
+        }
+    }
+    m_DispatchMutex.unlock();
+}
+
+void FrameSynchronizer::Match(std::vector<std::vector<SynchronizedFrame>> &sets, std::vector<FrameLease> &dropped)
+{
+    for (;;)
+    {
+        uint64_t newest = 0;
+        size_t activeStreams = 0;
+        for (auto const &stream : m_Streams)
+        {
+            if (!stream.active)
+            {
+                continue;
+            }
+            if (stream.queue.empty())
+            {
+                return;
+            }
+            newest = std::max(newest, stream.queue.front().timestamp);
+            ++activeStreams;
+        }
+        if (activeStreams == 0)
+        {
+            return;
+        }
+
+        // the later frames of every stream are even newer, so a head which
+        // is too old for the newest head will never find a partner
+        bool droppedHead = false;
+        for (auto &stream : m_Streams)
+        {
+            while (!stream.queue.empty() && stream.queue.front().timestamp + m_Tolerance < newest)
+            {
+                dropped.push_back(std::move(stream.queue.front().frame.lease));
+                stream.queue.pop_front();
+                ++stream.statistics.unmatched;
+                droppedHead = true;
+            }
+        }
+        if (droppedHead)
+        {
+            continue;
+        }
+
+        uint64_t oldest = newest;
+        std::vector<SynchronizedFrame> set;
+        set.reserve(activeStreams);
+        for (auto &stream : m_Streams)
+        {
+            if (!stream.active)
+            {
+                continue;
+            }
+            oldest = std::min(oldest, stream.queue.front().timestamp);
+            set.push_back(std::move(stream.queue.front().frame));
+            stream.queue.pop_front();
+            ++stream.statistics.matched;
+        }
+
+        m_MaxSkew = std::max(m_MaxSkew, newest - oldest);
+        m_LastSetTimestamp = newest;
+        ++m_SetCount;
+        sets.push_back(std::move(set));
+    }
+}
+
+void FrameSynchronizer::Flush()
+{
+    std::vector<FrameLease> dropped;
+    QMutexLocker locker(&m_Mutex);
+    for (auto &stream : m_Streams)
+    {
+        for (auto &pending : stream.queue)
+        {
+            dropped.push_back(std::move(pending.frame.lease));
+        }
+        stream.queue.clear();
+    }
+}
+
+void FrameSynchronizer::SetStreamActive(int stream, bool active)
+{
+    std::vector<FrameLease> dropped;
+    QMutexLocker locker(&m_Mutex);
+    if (stream < 0 || stream >= static_cast<int>(m_Streams.size()))
+    {
+        return;
+    }
+
+    Stream &current = m_Streams[stream];
+    current.active = active;
+    if (!active)
+    {
+        for (auto &pending : current.queue)
+        {
+            dropped.push_back(std::move(pending.frame.lease));
+        }
+        current.queue.clear();
+    }
+}
+
+void FrameSynchronizer::SetActive(bool active)
+{
+    {
+        QMutexLocker locker(&m_Mutex);
+        m_Active = active;
+    }
+    if (!active)
+    {
+        Flush();
+    }
+}
+
+FrameSynchronizerStatistics FrameSynchronizer::GetStatistics(int stream) const
+{
+    QMutexLocker locker(&m_Mutex);
+    if (stream < 0 || stream >= static_cast<int>(m_Streams.size()))
+    {
+        return FrameSynchronizerStatistics();
+    }
+
+    return m_Streams[stream].statistics;
+}
+
+uint64_t FrameSynchronizer::GetSetCount() const
+{
+    QMutexLocker locker(&m_Mutex);
+    return m_SetCount;
+}
+
+uint64_t FrameSynchronizer::GetMaxSkew() const
+{
+    QMutexLocker locker(&m_Mutex);
+    return m_MaxSkew;
+}
+
+void FrameSynchronizer::ResetStatistics()
+{
+    QMutexLocker locker(&m_Mutex);
+    for (auto &stream : m_Streams)
+    {
+        stream.statistics = FrameSynchronizerStatistics();
+    }
+    m_SetCount = 0;
+    m_MaxSkew = 0;
+}
@@ -17,75 +17,87 @@
 
 
 #include "ImageTransform.h"
+#include "BufferWrapper.h"
+#include "FrameLease.h"
 #include "Logger.h"
+#include "PixelKernels.h"
+#include "PlaneLayout.h"
+#include "StripePool.h"
 #include "videodev2_av.h"
 
 #include <regex>
 
 #include <QFile>
-#include <QPixmap>
+#include <QMutex>
+#include <QMutexLocker>
 
+#include <algorithm>
 #include <cstring>
 #include <linux/videodev2.h>
 
-#define CLIP(color) (unsigned char)(((color) > 0xFF) ? 0xff : (((color) < 0) ? 0 : (color)))
 
-static std::unique_ptr<uint8_t[]> s_ConversionBuffer;
+// Scratch memory of the conversions, e.g. the rolling lines of the packed Bayer
+// formats or lines without padding. Every conversion thread has its own so several
+// streams and stripes can convert at once. It only grows, once it fits the format
+// and resolution of a stream the conversions allocate nothing.
+static thread_local std::unique_ptr<uint8_t[]> s_ConversionBuffer;
+static thread_local size_t s_ConversionBufferSize = 0;
 
-int g_shift10Bit = -1;
-int g_shift12Bit = -1;
+static uint8_t* GetConversionBuffer(uint32_t width, uint32_t height)
+{
+    size_t const size = size_t(width) * height;
+    if (size > s_ConversionBufferSize)
+    {
+        s_ConversionBuffer = std::make_unique<uint8_t[]>(size);
+        s_ConversionBufferSize = size;
+    }
+    return s_ConversionBuffer.get();
+}
 
+// threads which convert one frame together, shared by all conversion threads
+static QMutex s_StripePoolMutex;
+static std::shared_ptr<StripePool> s_pStripePool;
 
-static void ConvertMono12gToRGB24(const void *sourceBuffer, uint32_t width,
-                           uint32_t height, const void *destBuffer)
+// This function converts the rows of a frame in stripes on the shared pool
+template <typename Func>
+static void ConvertStripes(uint32_t rowCount, uint32_t rowAlignment, const Func &stripe)
 {
-    unsigned char *destdata = (unsigned char *)destBuffer;
-    unsigned char *srcdata = (unsigned char *)sourceBuffer;
-    uint32_t count = 0;
-    uint32_t bytesPerLine = width * 1.5;
+    // a reference keeps std::function from allocating a copy of the lambda
+    ImageTransform::GetStripePool()->Run(rowCount, rowAlignment, std::cref(stripe));
+}
 
-    for (unsigned int i = 0; i < height; i++)
+// This function makes the image an image of the frame size and format. An image which
+// already is one and is not shared is kept, converting into the same image allocates nothing.
+static void PrepareImage(QImage &image, uint32_t width, uint32_t height, QImage::Format format)
+{
+    if (image.isDetached() && image.width() == static_cast<int>(width)
+        && image.height() == static_cast<int>(height) && image.format() == format)
     {
-        for (unsigned int ii = 0; ii < bytesPerLine; ii++)
-        {
-            if (((count + 1) % 3) != 0)
-            {
-                *destdata++ = *srcdata;
-                *destdata++ = *srcdata;
-                *destdata++ = *srcdata;
-            }
-            count++;
-            srcdata++;
-        }
+        return;
     }
+
+    image = QImage(width, height, format);
 }
 
-static void ConvertMono10gToRGB24(const void *sourceBuffer, uint32_t width,
-                           uint32_t height, const void *destBuffer)
+// This function copies the lines of a frame Qt can show as they are
+static void CopyLines(const uint8_t *pSource, uint32_t bytesPerLine, uint32_t width, uint32_t height,
+                      QImage::Format format, uint32_t bytesPerPixel, QImage &dst)
 {
-    unsigned char *destdata = (unsigned char *)destBuffer;
-    unsigned char *srcdata = (unsigned char *)sourceBuffer;
-    uint32_t count = 0;
-    uint32_t bytesPerLine = width * 1.25;
-
-    for (unsigned int i = 0; i < height; i++)
+    PrepareImage(dst, width, height, format);
+    uint8_t *const pDestination = dst.bits();
+    size_t const destinationBytesPerLine = dst.bytesPerLine();
+    for (uint32_t y = 0; y < height; ++y)
     {
-        for (unsigned int ii = 0; ii < bytesPerLine; ii++)
-        {
-            if (((count + 1) % 5) != 0)
-            {
-                *destdata++ = *srcdata;
-                *destdata++ = *srcdata;
-                *destdata++ = *srcdata;
-            }
-            count++;
-            srcdata++;
-        }
+        memcpy(pDestination + y * destinationBytesPerLine, pSource + size_t(y) * bytesPerLine, size_t(width) * bytesPerPixel);
     }
 }
 
-static void ConvertRAW12gToRAW8(const void *sourceBuffer, uint32_t width,
-                         uint32_t height, const void *destBuffer)
+int g_shift10Bit = -1;
+int g_shift12Bit = -1;
+
+
+static void ConvertMono12gToRGB24(const void *sourceBuffer, uint32_t width,
+                           uint32_t height, const void *destBuffer)
 {
     unsigned char *destdata = (unsigned char *)destBuffer;
     unsigned char *srcdata = (unsigned char *)sourceBuffer;
@@ -99,6 +111,8 @@ static void ConvertRAW12gToRAW8(const void *sourceBuffer, uint32_t width,
             if (((count + 1) % 3) != 0)
             {
                 *destdata++ = *srcdata;
+                *destdata++ = *srcdata;
+                *destdata++ = *srcdata;
             }
             count++;
             srcdata++;
@@ -106,8 +120,8 @@ static void ConvertRAW12gToRAW8(const void *sourceBuffer, uint32_t width,
     }
 }
 
-static void ConvertRAW10gToRAW8(const void *sourceBuffer, uint32_t width,
-                         uint32_t height, const void *destBuffer)
+static void ConvertMono10gToRGB24(const void *sourceBuffer, uint32_t width,
+                           uint32_t height, const void *destBuffer)
 {
     unsigned char *destdata = (unsigned char *)destBuffer;
     unsigned char *srcdata = (unsigned char *)sourceBuffer;
@@ -121,6 +135,8 @@ static void ConvertRAW10gToRAW8(const void *sourceBuffer, uint32_t width,
             if (((count + 1) % 5) != 0)
             {
                 *destdata++ = *srcdata;
+                *destdata++ = *srcdata;
+                *destdata++ = *srcdata;
             }
             count++;
             srcdata++;
@@ -150,393 +166,177 @@ static void ConvertRAW10ToRAW8(const void *sourceBuffer, uint32_t width,
     }
 }
 
-static void v4lconvert_bayer8_to_rgb24(const unsigned char *bayer, unsigned char *bgr,
-                                int width, int height,
-                                const unsigned int stride, unsigned int pixfmt);
-
-static void  ConvertJetsonMono16ToRGB24(const void *sourceBuffer, uint32_t width, uint32_t height, QImage& dst, int shift, size_t bpl)
+// This function returns the colour filter array of an 8 bit Bayer format
+static BAYER_ORDER GetBayerOrder(uint32_t pixelFormat)
 {
-    dst = QImage(width, height, QImage::Format_RGB888);
-    uint8_t *destdata = dst.bits();
-    auto const *srcdata = reinterpret_cast<uint8_t const*>(sourceBuffer);
-
-    for (unsigned int y = 0; y < height; y++) 
+    switch (pixelFormat)
     {
-        for (unsigned int x = 0; x < width; x++) {
-            auto const offs = y*bpl + 2*x;
-            auto const val16 = reinterpret_cast<uint16_t const*>(&srcdata[offs]);
-            uint8_t const val = (*val16 >> shift) & 0xFF;
-            *destdata++ = val;
-            *destdata++ = val;
-            *destdata++ = val;
-        }
+        case V4L2_PIX_FMT_SGBRG8:
+            return BAYER_ORDER_GBRG;
+        case V4L2_PIX_FMT_SGRBG8:
+            return BAYER_ORDER_GRBG;
+        case V4L2_PIX_FMT_SRGGB8:
+            return BAYER_ORDER_RGGB;
+        default:
+            return BAYER_ORDER_BGGR;
     }
 }
 
+// This function demosaics 8 bit Bayer into an RGB888 image of the frame size.
+// Every stripe reads one line above and below itself, the source must not
+// change until all stripes are done.
+static void DemosaicBayer8(const uint8_t *pBayer, uint32_t bytesPerLine, uint32_t pixelFormat, QImage &dst)
+{
+    BAYER_ORDER const order = GetBayerOrder(pixelFormat);
+    uint8_t *const pDestination = dst.bits();
+    uint32_t const destinationBytesPerLine = dst.bytesPerLine();
+    uint32_t const width = dst.width();
+    uint32_t const height = dst.height();
+    ConvertStripes(height, 1, [=](uint32_t firstRow, uint32_t rowCount) {
+        pixelkernels::Bayer8ToRgb24Lines(pBayer, bytesPerLine, pDestination, destinationBytesPerLine,
+                                         width, height, order, firstRow, rowCount);
+    });
+}
 
-
-static void ConvertJetsonBayer16ToRGB24(const void *sourceBuffer, uint32_t width, uint32_t height, QImage& dst, int shift, unsigned int pixfmt, size_t bpl)
+static void  ConvertJetsonMono16ToRGB24(const void *sourceBuffer, uint32_t width, uint32_t height, QImage& dst, int shift, size_t bpl)
 {
-    uint8_t *destdata = s_ConversionBuffer.get();
+    PrepareImage(dst, width, height, QImage::Format_RGB888);
+    uint8_t *const pDestination = dst.bits();
+    size_t const destinationBytesPerLine = dst.bytesPerLine();
     auto const *srcdata = reinterpret_cast<uint8_t const*>(sourceBuffer);
 
-    for (unsigned int y = 0; y < height; y++) 
-    {
-        for (unsigned int x = 0; x < width; x++) 
+    ConvertStripes(height, 1, [=](uint32_t firstRow, uint32_t rowCount) {
+        for (unsigned int y = firstRow; y < firstRow + rowCount; y++)
         {
-            auto const offs = y*bpl + 2*x;
-            auto const val16 = reinterpret_cast<uint16_t const*>(&srcdata[offs]);
-            uint8_t const val = (*val16 >> shift) & 0xFF;
-            *destdata++ = val;
+            uint8_t *destdata = pDestination + y * destinationBytesPerLine;
+            for (unsigned int x = 0; x < width; x++) {
+                auto const offs = y*bpl + 2*x;
+                auto const val16 = reinterpret_cast<uint16_t const*>(&srcdata[offs]);
+                uint8_t const val = (*val16 >> shift) & 0xFF;
+                *destdata++ = val;
+                *destdata++ = val;
+                *destdata++ = val;
+            }
         }
-    }
-
-    dst = QImage(width, height, QImage::Format_RGB888);
-    v4lconvert_bayer8_to_rgb24(s_ConversionBuffer.get(), dst.bits(), width, height, width, pixfmt);
+    });
 }
 
-/* inspired by OpenCV's Bayer decoding */
-static void v4lconvert_border_bayer8_line_to_bgr24(const unsigned char *bayer, const unsigned char *adjacent_bayer,
-                                                   unsigned char *bgr, int width, const int start_with_green,
-                                                   const int blue_line)
-{
-    int t0, t1;
 
-    if (start_with_green)
+
+// Unpacks one line of a Bayer frame with more than 8 bits to the upper 8 bits
+typedef void (*BayerLineUnpackFunc)(const uint8_t *pSource, uint8_t *pDestination, uint32_t width, int shift);
+
+// 10 bit packed, 4 pixels in 5 bytes, the fifth one holds the low bits
+static void UnpackRAW10gLine(const uint8_t *pSource, uint8_t *pDestination, uint32_t width, int)
+{
+    uint32_t x = 0;
+    for (; x + 4 <= width; x += 4)
     {
-        /* First pixel */
-        if (blue_line)
-        {
-            *bgr++ = bayer[1];
-            *bgr++ = bayer[0];
-            *bgr++ = adjacent_bayer[0];
-        }
-        else
-        {
-            *bgr++ = adjacent_bayer[0];
-            *bgr++ = bayer[0];
-            *bgr++ = bayer[1];
-        }
-        /* Second pixel */
-        t0 = (bayer[0] + bayer[2] + adjacent_bayer[1] + 1) / 3;
-        t1 = (adjacent_bayer[0] + adjacent_bayer[2] + 1) >> 1;
-        if (blue_line)
-        {
-            *bgr++ = bayer[1];
-            *bgr++ = t0;
-            *bgr++ = t1;
-        }
-        else
-        {
-            *bgr++ = t1;
-            *bgr++ = t0;
-            *bgr++ = bayer[1];
-        }
-        bayer++;
-        adjacent_bayer++;
-        width -= 2;
+        pDestination[x] = pSource[0];
+        pDestination[x + 1] = pSource[1];
+        pDestination[x + 2] = pSource[2];
+        pDestination[x + 3] = pSource[3];
+        pSource += 5;
     }
-    else
+    for (uint32_t i = 0; x < width; ++x, ++i)
     {
-        /* First pixel */
-        t0 = (bayer[1] + adjacent_bayer[0] + 1) >> 1;
-        if (blue_line)
-        {
-            *bgr++ = bayer[0];
-            *bgr++ = t0;
-            *bgr++ = adjacent_bayer[1];
-        }
-        else
-        {
-            *bgr++ = adjacent_bayer[1];
-            *bgr++ = t0;
-            *bgr++ = bayer[0];
-        }
-        width--;
+        pDestination[x] = pSource[i];
     }
+}
 
-    if (blue_line)
+// 12 bit packed, 2 pixels in 3 bytes, the third one holds the low bits
+static void UnpackRAW12gLine(const uint8_t *pSource, uint8_t *pDestination, uint32_t width, int)
+{
+    uint32_t x = 0;
+    for (; x + 2 <= width; x += 2)
     {
-        for (; width > 2; width -= 2)
-        {
-            t0 = (bayer[0] + bayer[2] + 1) >> 1;
-            *bgr++ = t0;
-            *bgr++ = bayer[1];
-            *bgr++ = adjacent_bayer[1];
-            bayer++;
-            adjacent_bayer++;
-
-            t0 = (bayer[0] + bayer[2] + adjacent_bayer[1] + 1) / 3;
-            t1 = (adjacent_bayer[0] + adjacent_bayer[2] + 1) >> 1;
-            *bgr++ = bayer[1];
-            *bgr++ = t0;
-            *bgr++ = t1;
-            bayer++;
-            adjacent_bayer++;
-        }
+        pDestination[x] = pSource[0];
+        pDestination[x + 1] = pSource[1];
+        pSource += 3;
     }
-    else
+    if (x < width)
     {
-        for (; width > 2; width -= 2)
-        {
-            t0 = (bayer[0] + bayer[2] + 1) >> 1;
-            *bgr++ = adjacent_bayer[1];
-            *bgr++ = bayer[1];
-            *bgr++ = t0;
-            bayer++;
-            adjacent_bayer++;
-
-            t0 = (bayer[0] + bayer[2] + adjacent_bayer[1] + 1) / 3;
-            t1 = (adjacent_bayer[0] + adjacent_bayer[2] + 1) >> 1;
-            *bgr++ = t1;
-            *bgr++ = t0;
-            *bgr++ = bayer[1];
-            bayer++;
-            adjacent_bayer++;
-        }
+        pDestination[x] = pSource[0];
     }
+}
 
-    if (width == 2)
+// Jetson, 16 bit little endian words with the pixel at a platform specific shift
+static void UnpackJetson16Line(const uint8_t *pSource, uint8_t *pDestination, uint32_t width, int shift)
+{
+    auto const *srcdata = reinterpret_cast<uint16_t const*>(pSource);
+    for (uint32_t x = 0; x < width; ++x)
     {
-        /* Second to last pixel */
-        t0 = (bayer[0] + bayer[2] + 1) >> 1;
-        if (blue_line)
-        {
-            *bgr++ = t0;
-            *bgr++ = bayer[1];
-            *bgr++ = adjacent_bayer[1];
-        }
-        else
-        {
-            *bgr++ = adjacent_bayer[1];
-            *bgr++ = bayer[1];
-            *bgr++ = t0;
-        }
-        /* Last pixel */
-        t0 = (bayer[1] + adjacent_bayer[2] + 1) >> 1;
-        if (blue_line)
-        {
-            *bgr++ = bayer[2];
-            *bgr++ = t0;
-            *bgr++ = adjacent_bayer[1];
-        }
-        else
-        {
-            *bgr++ = adjacent_bayer[1];
-            *bgr++ = t0;
-            *bgr++ = bayer[2];
-        }
-    }
-    else
-    {
-        /* Last pixel */
-        if (blue_line)
-        {
-            *bgr++ = bayer[0];
-            *bgr++ = bayer[1];
-            *bgr++ = adjacent_bayer[1];
-        }
-        else
-        {
-            *bgr++ = adjacent_bayer[1];
-            *bgr++ = bayer[1];
-            *bgr++ = bayer[0];
-        }
+        pDestination[x] = (srcdata[x] >> shift) & 0xFF;
     }
 }
 
-/* From libdc1394, which on turn was based on OpenCV's Bayer decoding */
-static void bayer8_to_rgbbgr24(const unsigned char *bayer, unsigned char *bgr,
-                               int width, int height, const unsigned int stride,
-                               unsigned int pixfmt, int start_with_green,
-                               int blue_line)
+// This function unpacks and demosaics lines of a Bayer frame in one pass. Only
+// the last three unpacked lines are kept, each stripe unpacks the line above
+// and below itself as well.
+static void DemosaicUnpackedBayerLines(BayerLineUnpackFunc unpack, const uint8_t *pSource, size_t bytesPerLine, int shift,
+                                       uint32_t width, uint32_t height, BAYER_ORDER order,
+                                       uint8_t *pDestination, size_t destinationBytesPerLine,
+                                       uint32_t firstLine, uint32_t lineCount)
 {
-    /* render the first line */
-    v4lconvert_border_bayer8_line_to_bgr24(bayer, bayer + stride, bgr, width,
-                                           start_with_green, blue_line);
-    bgr += width * 3;
+    uint8_t *const pLines = GetConversionBuffer(width, 3);
+    auto const unpacked = [=](uint32_t line) {
+        return pLines + (line % 3) * size_t(width);
+    };
 
-    /* reduce height by 2 because of the special case top/bottom line */
-    for (height -= 2; height; height--)
+    uint32_t nextLine = (firstLine > 0) ? firstLine - 1 : 0;
+    for (uint32_t y = firstLine; y < firstLine + lineCount; ++y)
     {
-        int t0, t1;
-        /* (width - 2) because of the border */
-        const unsigned char *bayer_end = bayer + (width - 2);
-
-        if (start_with_green)
+        for (uint32_t const lastLine = std::min(y + 1, height - 1); nextLine <= lastLine; ++nextLine)
         {
-
-            t0 = (bayer[1] + bayer[stride * 2 + 1] + 1) >> 1;
-            /* Write first pixel */
-            t1 = (bayer[0] + bayer[stride * 2] + bayer[stride + 1] + 1) / 3;
-            if (blue_line)
-            {
-                *bgr++ = t0;
-                *bgr++ = t1;
-                *bgr++ = bayer[stride];
-            }
-            else
-            {
-                *bgr++ = bayer[stride];
-                *bgr++ = t1;
-                *bgr++ = t0;
-            }
-
-            /* Write second pixel */
-            t1 = (bayer[stride] + bayer[stride + 2] + 1) >> 1;
-            if (blue_line)
-            {
-                *bgr++ = t0;
-                *bgr++ = bayer[stride + 1];
-                *bgr++ = t1;
-            }
-            else
-            {
-                *bgr++ = t1;
-                *bgr++ = bayer[stride + 1];
-                *bgr++ = t0;
-            }
-            bayer++;
+            unpack(pSource + nextLine * bytesPerLine, unpacked(nextLine), width, shift);
         }
-        else
-        {
-            /* Write first pixel */
-            t0 = (bayer[0] + bayer[stride * 2] + 1) >> 1;
-            if (blue_line)
-            {
-                *bgr++ = t0;
-                *bgr++ = bayer[stride];
-                *bgr++ = bayer[stride + 1];
-            }
-            else
-            {
-                *bgr++ = bayer[stride + 1];
-                *bgr++ = bayer[stride];
-                *bgr++ = t0;
-            }
-        }
-
-        if (blue_line)
-        {
-            for (; bayer <= bayer_end - 2; bayer += 2)
-            {
-                t0 = (bayer[0] + bayer[2] + bayer[stride * 2] +
-                      bayer[stride * 2 + 2] + 2) >>
-                     2;
-                t1 = (bayer[1] + bayer[stride] + bayer[stride + 2] +
-                      bayer[stride * 2 + 1] + 2) >>
-                     2;
-                *bgr++ = t0;
-                *bgr++ = t1;
-                *bgr++ = bayer[stride + 1];
-
-                t0 = (bayer[2] + bayer[stride * 2 + 2] + 1) >> 1;
-                t1 = (bayer[stride + 1] + bayer[stride + 3] + 1) >> 1;
-                *bgr++ = t0;
-                *bgr++ = bayer[stride + 2];
-                *bgr++ = t1;
-            }
-        }
-        else
-        {
-            for (; bayer <= bayer_end - 2; bayer += 2)
-            {
-                t0 = (bayer[0] + bayer[2] + bayer[stride * 2] +
-                      bayer[stride * 2 + 2] + 2) >>
-                     2;
-                t1 = (bayer[1] + bayer[stride] + bayer[stride + 2] +
-                      bayer[stride * 2 + 1] + 2) >>
-                     2;
-                *bgr++ = bayer[stride + 1];
-                *bgr++ = t1;
-                *bgr++ = t0;
-
-                t0 = (bayer[2] + bayer[stride * 2 + 2] + 1) >> 1;
-                t1 = (bayer[stride + 1] + bayer[stride + 3] + 1) >> 1;
-                *bgr++ = t1;
-                *bgr++ = bayer[stride + 2];
-                *bgr++ = t0;
-            }
-        }
-
-        if (bayer < bayer_end)
-        {
-            /* write second to last pixel */
-            t0 = (bayer[0] + bayer[2] + bayer[stride * 2] +
-                  bayer[stride * 2 + 2] + 2) >>
-                 2;
-            t1 = (bayer[1] + bayer[stride] + bayer[stride + 2] +
-                  bayer[stride * 2 + 1] + 2) >>
-                 2;
-            if (blue_line)
-            {
-                *bgr++ = t0;
-                *bgr++ = t1;
-                *bgr++ = bayer[stride + 1];
-            }
-            else
-            {
-                *bgr++ = bayer[stride + 1];
-                *bgr++ = t1;
-                *bgr++ = t0;
-            }
-            /* write last pixel */
-            t0 = (bayer[2] + bayer[stride * 2 + 2] + 1) >> 1;
-            if (blue_line)
-            {
-                *bgr++ = t0;
-                *bgr++ = bayer[stride + 2];
-                *bgr++ = bayer[stride + 1];
-            }
-            else
-            {
-                *bgr++ = bayer[stride + 1];
-                *bgr++ = bayer[stride + 2];
-                *bgr++ = t0;
-            }
 
-            bayer++;
-        }
-        else
-        {
-            /* write last pixel */
-            t0 = (bayer[0] + bayer[stride * 2] + 1) >> 1;
-            t1 = (bayer[1] + bayer[stride * 2 + 1] + bayer[stride] + 1) / 3;
-            if (blue_line)
-            {
-                *bgr++ = t0;
-                *bgr++ = t1;
-                *bgr++ = bayer[stride + 1];
-            }
-            else
-            {
-                *bgr++ = bayer[stride + 1];
-                *bgr++ = t1;
-                *bgr++ = t0;
-            }
-        }
+        pixelkernels::Bayer8LineToRgb24((y > 0) ? unpacked(y - 1) : nullptr, unpacked(y),
+                                        (y + 1 < height) ? unpacked(y + 1) : nullptr,
+                                        pDestination + y * destinationBytesPerLine, width, height, y, order);
+    }
+}
 
-        /* skip 2 border pixels and padding */
-        bayer += (stride - width) + 2;
+// This function converts a Bayer frame with more than 8 bits into an RGB888 image
+static void ConvertUnpackedBayer(BayerLineUnpackFunc unpack, const uint8_t *pSource, size_t bytesPerLine, int shift,
+                                 uint32_t width, uint32_t height, uint32_t pixelFormat, QImage &dst)
+{
+    BAYER_ORDER const order = GetBayerOrder(pixelFormat);
+    PrepareImage(dst, width, height, QImage::Format_RGB888);
+    uint8_t *const pDestination = dst.bits();
+    size_t const destinationBytesPerLine = dst.bytesPerLine();
+
+    ConvertStripes(height, 1, [=](uint32_t firstRow, uint32_t rowCount) {
+        DemosaicUnpackedBayerLines(unpack, pSource, bytesPerLine, shift, width, height, order,
+                                   pDestination, destinationBytesPerLine, firstRow, rowCount);
+    });
+}
 
-        blue_line = !blue_line;
-        start_with_green = !start_with_green;
+// This function converts 10 or 12 bit packed Bayer. Lines are as long as their
+// packed pixels unless the driver reports padding.
+//
+// Returns:
+// (int) - -1 if the buffer is too short for the frame
+static int ConvertPackedBayer(const uint8_t *pBuffer, uint32_t length, uint32_t width, uint32_t height,
+                              uint32_t bytesPerLine, int bitsPerPixel, uint32_t pixelFormat, QImage &dst)
+{
+    size_t const packedBytesPerLine = (size_t(width) * bitsPerPixel + 7) / 8;
+    size_t const lineStride = std::max<size_t>(bytesPerLine, packedBytesPerLine);
+    if (height == 0 || length < (height - 1) * lineStride + packedBytesPerLine)
+    {
+        return -1;
     }
 
-    /* render the last line */
-    v4lconvert_border_bayer8_line_to_bgr24(bayer + stride, bayer, bgr, width,
-                                           !start_with_green, !blue_line);
+    ConvertUnpackedBayer((bitsPerPixel == 10) ? UnpackRAW10gLine : UnpackRAW12gLine, pBuffer, lineStride, 0,
+                         width, height, pixelFormat, dst);
+
+    return 0;
 }
 
-static void v4lconvert_bayer8_to_rgb24(const unsigned char *bayer, unsigned char *bgr,
-                                int width, int height,
-                                const unsigned int stride, unsigned int pixfmt)
+static void ConvertJetsonBayer16ToRGB24(const void *sourceBuffer, uint32_t width, uint32_t height, QImage& dst, int shift, unsigned int pixfmt, size_t bpl)
 {
-    bayer8_to_rgbbgr24(bayer, bgr, width, height, stride, pixfmt,
-                       pixfmt == V4L2_PIX_FMT_SGBRG8 /* start with green */
-                           || pixfmt == V4L2_PIX_FMT_SGRBG8,
-                       pixfmt != V4L2_PIX_FMT_SBGGR8 /* blue line */
-                           && pixfmt != V4L2_PIX_FMT_SGBRG8);
+    ConvertUnpackedBayer(UnpackJetson16Line, reinterpret_cast<uint8_t const*>(sourceBuffer), bpl, shift,
+                         width, height, pixfmt, dst);
 }
 
 static void v4lconvert_grey_to_rgb24(const unsigned char *src, unsigned char *dest,
@@ -577,139 +377,70 @@ static void v4lconvert_swap_rgb(const unsigned char *src, unsigned char *dst,
     }
 }
 
-static void v4lconvert_uyvy_to_rgb24(const unsigned char *src, unsigned char *dest,
-                              int width, int height, int stride,
-                              unsigned int pixfmt)
+// Converts NV12, NV21, NV16, NV61, YUV420 and YVU420 and their multi-plane
+// variants straight from the planes with the vectorized kernels.
+// Every row reads its chroma row itself, so any range of rows can be converted.
+static void ConvertPlanarYUVToRGB24(const FramePlane *pPlanes, const PlanarFormat &format,
+                                    uint32_t width, uint32_t firstRow, uint32_t rowCount,
+                                    uint8_t *pDestination, size_t destinationBytesPerLine)
 {
-    int j;
-
-    while (--height >= 0)
+    const bool semiPlanar = (format.planeCount == 2);
+    const YUV_CHROMA_LAYOUT layout = !semiPlanar ? YUV_CHROMA_LAYOUT_PLANAR
+                                                 : (format.swapChroma ? YUV_CHROMA_LAYOUT_VU : YUV_CHROMA_LAYOUT_UV);
+    // the semi-planar kernels only read the first chroma plane
+    const FramePlane &uPlane = semiPlanar ? pPlanes[1] : pPlanes[format.swapChroma ? 2 : 1];
+    const FramePlane &vPlane = semiPlanar ? pPlanes[1] : pPlanes[format.swapChroma ? 1 : 2];
+
+    for (uint32_t y = firstRow; y < firstRow + rowCount; ++y)
     {
-        for (j = 0; j + 1 < width; j += 2)
-        {
-
-            int u, v;
-
-            if (pixfmt == V4L2_PIX_FMT_UYVY)
-            {
-                u = src[0];
-                v = src[2];
-            }
-            else if (pixfmt == V4L2_PIX_FMT_VYUY)
-            {
-                u = src[2];
-                v = src[0];
-            }
-
-            int u1 = (((u - 128) << 7) + (u - 128)) >> 6;
-            int rg = (((u - 128) << 1) + (u - 128) + ((v - 128) << 2) +
-                      ((v - 128) << 1)) >>
-                     3;
-            int v1 = (((v - 128) << 1) + (v - 128)) >> 1;
-
-            *dest++ = CLIP(src[1] + v1);
-            *dest++ = CLIP(src[1] - rg);
-            *dest++ = CLIP(src[1] + u1);
-
-            *dest++ = CLIP(src[3] + v1);
-            *dest++ = CLIP(src[3] - rg);
-            *dest++ = CLIP(src[3] + u1);
-
-            src += 4;
-        }
-        src += stride - width * 2;
+        const uint32_t chromaRow = y >> format.chromaVerticalShift;
+        pixelkernels::YuvPlanarLineToRgb24(pPlanes[0].data + size_t(y) * pPlanes[0].bytesPerLine,
+                                           uPlane.data + size_t(chromaRow) * uPlane.bytesPerLine,
+                                           vPlane.data + size_t(chromaRow) * vPlane.bytesPerLine,
+                                           pDestination + y * destinationBytesPerLine, width, layout);
     }
 }
 
-static void v4lconvert_yuyv_to_rgb24(const unsigned char *src, unsigned char *dest,
-                              int width, int height, int stride)
+// This function checks that every plane holds all rows the converter reads
+static bool PlanesCoverFrame(const FramePlane *pPlanes, const PlanarFormat &format,
+                             uint32_t width, uint32_t height)
 {
-    int j;
+    const uint32_t chromaHeight = (height + (1u << format.chromaVerticalShift) - 1) >> format.chromaVerticalShift;
+    const uint32_t chromaWidth = (width + 1) / 2;
 
-    while (--height >= 0)
+    for (uint32_t i = 0; i < format.planeCount; ++i)
     {
-        for (j = 0; j + 1 < width; j += 2)
+        const uint32_t rows = (i == 0) ? height : chromaHeight;
+        const size_t rowBytes = (i == 0) ? width : ((format.planeCount == 2) ? chromaWidth * 2 : chromaWidth);
+        if (NULL == pPlanes[i].data || pPlanes[i].bytesPerLine < rowBytes
+            || size_t(rows - 1) * pPlanes[i].bytesPerLine + rowBytes > pPlanes[i].length)
         {
-            int u = src[1];
-            int v = src[3];
-            int u1 = (((u - 128) << 7) + (u - 128)) >> 6;
-            int rg = (((u - 128) << 1) + (u - 128) + ((v - 128) << 2) +
-                      ((v - 128) << 1)) >>
-                     3;
-            int v1 = (((v - 128) << 1) + (v - 128)) >> 1;
-
-            *dest++ = CLIP(src[0] + v1);
-            *dest++ = CLIP(src[0] - rg);
-            *dest++ = CLIP(src[0] + u1);
-
-            *dest++ = CLIP(src[2] + v1);
-            *dest++ = CLIP(src[2] - rg);
-            *dest++ = CLIP(src[2] + u1);
-            src += 4;
+            return false;
         }
-        src += stride - (width * 2);
     }
+
+    return true;
 }
 
-static void v4lconvert_yuv420_to_rgb24(const unsigned char *src, unsigned char *dest,
-                                int width, int height, int yvu)
+static int ConvertPlanarFrame(const FramePlane *pPlanes, uint32_t planeCount, uint32_t width, uint32_t height,
+                              uint32_t pixelFormat, QImage &convertedImage)
 {
-    int i, j;
-
-    const unsigned char *ysrc = src;
-    const unsigned char *usrc, *vsrc;
-
-    if (yvu)
-    {
-        vsrc = src + width * height;
-        usrc = vsrc + (width * height) / 4;
-    }
-    else
+    PlanarFormat format;
+    if (width == 0 || height == 0 || !planelayout::GetPlanarFormat(pixelFormat, format)
+        || planeCount < format.planeCount || !PlanesCoverFrame(pPlanes, format, width, height))
     {
-        usrc = src + width * height;
-        vsrc = usrc + (width * height) / 4;
+        return -1;
     }
 
-    for (i = 0; i < height; i++)
-    {
-        for (j = 0; j < width; j += 2)
-        {
-#if 1 /* fast slightly less accurate multiplication free code */
-            int u1 = (((*usrc - 128) << 7) + (*usrc - 128)) >> 6;
-            int rg = (((*usrc - 128) << 1) + (*usrc - 128) +
-                      ((*vsrc - 128) << 2) + ((*vsrc - 128) << 1)) >>
-                     3;
-            int v1 = (((*vsrc - 128) << 1) + (*vsrc - 128)) >> 1;
-
-            *dest++ = CLIP(*ysrc + v1);
-            *dest++ = CLIP(*ysrc - rg);
-            *dest++ = CLIP(*ysrc + u1);
-            ysrc++;
-
-            *dest++ = CLIP(*ysrc + v1);
-            *dest++ = CLIP(*ysrc - rg);
-            *dest++ = CLIP(*ysrc + u1);
-#else
-            *dest++ = YUV2R(*ysrc, *usrc, *vsrc);
-            *dest++ = YUV2G(*ysrc, *usrc, *vsrc);
-            *dest++ = YUV2B(*ysrc, *usrc, *vsrc);
-            ysrc++;
-
-            *dest++ = YUV2R(*ysrc, *usrc, *vsrc);
-            *dest++ = YUV2G(*ysrc, *usrc, *vsrc);
-            *dest++ = YUV2B(*ysrc, *usrc, *vsrc);
-#endif
-            ysrc++;
-            usrc++;
-            vsrc++;
-        }
-        /* Rewind u and v for next line */
-        if (!(i & 1))
-        {
-            usrc -= width / 2;
-            vsrc -= width / 2;
-        }
-    }
+    PrepareImage(convertedImage, width, height, QImage::Format_RGB888);
+    uint8_t *const pDestination = convertedImage.bits();
+    size_t const destinationBytesPerLine = convertedImage.bytesPerLine();
+    // stripes of whole chroma rows, two threads never read the same one
+    ConvertStripes(height, 1u << format.chromaVerticalShift, [&](uint32_t firstRow, uint32_t rowCount) {
+        ConvertPlanarYUVToRGB24(pPlanes, format, width, firstRow, rowCount, pDestination, destinationBytesPerLine);
+    });
+
+    return 0;
 }
 
 static void v4lconvert_rgb565_to_rgb24(const unsigned char *src, unsigned char *dest,
@@ -763,7 +494,6 @@ static void v4lconvert_xbgr32_to_argb32(const unsigned char *src, unsigned char
 }
 
 static void v4lconvert_remove_padding(const uint8_t **src,
-                               std::vector<uint8_t> *conversionBuffer,
                                int width, int height, int bytesPerPixel,
                                int bytesPerLine)
 {
@@ -774,8 +504,8 @@ static void v4lconvert_remove_padding(const uint8_t **src,
     }
 
     const uint8_t *data = *src;
-    conversionBuffer->resize(width * height * bytesPerPixel);
-    uint8_t *dst = conversionBuffer->data();
+    uint8_t *const conversionBuffer = GetConversionBuffer(width * bytesPerPixel, height);
+    uint8_t *dst = conversionBuffer;
     size_t payloadPerLine = width * bytesPerPixel;
 
     // iterate every line
@@ -787,7 +517,7 @@ static void v4lconvert_remove_padding(const uint8_t **src,
         data += bytesPerLine;
     }
 
-    *src = conversionBuffer->data();
+    *src = conversionBuffer;
 }
 
 namespace ImageTransform {
@@ -806,6 +536,17 @@ namespace ImageTransform {
             case V4L2_PIX_FMT_UYVY:
             case V4L2_PIX_FMT_YUYV:
             case V4L2_PIX_FMT_YUV420:
+            case V4L2_PIX_FMT_YVU420:
+            case V4L2_PIX_FMT_NV12:
+            case V4L2_PIX_FMT_NV21:
+            case V4L2_PIX_FMT_NV16:
+            case V4L2_PIX_FMT_NV61:
+            case V4L2_PIX_FMT_YUV420M:
+            case V4L2_PIX_FMT_YVU420M:
+            case V4L2_PIX_FMT_NV12M:
+            case V4L2_PIX_FMT_NV21M:
+            case V4L2_PIX_FMT_NV16M:
+            case V4L2_PIX_FMT_NV61M:
             case V4L2_PIX_FMT_RGB24:
             case V4L2_PIX_FMT_RGB32:
             case V4L2_PIX_FMT_BGR32:
@@ -863,11 +604,6 @@ namespace ImageTransform {
         return false;
     }
 
-    void Init(uint32_t width, uint32_t height)
-    {
-        s_ConversionBuffer = std::make_unique<uint8_t[]>(width*height*4);
-    }
-
     int ConvertFrame(const uint8_t *pBuffer, uint32_t length,
                                      uint32_t width, uint32_t height,
                                      uint32_t pixelFormat, uint32_t payloadSize,
@@ -918,26 +654,24 @@ namespace ImageTransform {
             }
         }
 
-        std::vector<uint8_t> conversionBuffer;
-
         switch (pixelFormat)
         {
 
         case V4L2_PIX_FMT_ABGR32:
             {
-                convertedImage = QImage(pBuffer, width, height, bytesPerLine, QImage::Format_ARGB32).copy();
+                CopyLines(pBuffer, bytesPerLine, width, height, QImage::Format_ARGB32, 4, convertedImage);
             }
             break;
         case V4L2_PIX_FMT_XBGR32:
             {
-                convertedImage = QImage(pBuffer, width, height, bytesPerLine, QImage::Format_RGB32).copy();
+                CopyLines(pBuffer, bytesPerLine, width, height, QImage::Format_RGB32, 4, convertedImage);
             }
             break;
         case V4L2_PIX_FMT_XRGB32:
             {
-                v4lconvert_remove_padding(&pBuffer, &conversionBuffer, width, height, 4,
+                v4lconvert_remove_padding(&pBuffer, width, height, 4,
                                           bytesPerLine);
-                convertedImage = QImage(width, height, QImage::Format_ARGB32);
+                PrepareImage(convertedImage, width, height, QImage::Format_ARGB32);
                 v4lconvert_xrgb32_to_argb32(pBuffer, convertedImage.bits(), width,
                                            height);
             }
@@ -946,14 +680,16 @@ namespace ImageTransform {
         case V4L2_PIX_FMT_JPEG:
         case V4L2_PIX_FMT_MJPEG:
             {
-                QPixmap pix;
-                pix.loadFromData(pBuffer, payloadSize, "JPG");
-                convertedImage = pix.toImage();
+                // decoded into a new image, QPixmap must not be used outside of the GUI thread
+                if (!convertedImage.loadFromData(pBuffer, payloadSize, "JPG"))
+                {
+                    convertedImage = QImage();
+                }
             }
             break;
         case V4L2_PIX_FMT_RGB565:
             {
-                convertedImage = QImage(width, height, QImage::Format_RGB888);
+                PrepareImage(convertedImage, width, height, QImage::Format_RGB888);
                 v4lconvert_rgb565_to_rgb24(pBuffer, convertedImage.bits(), width,
                                            height);
             }
@@ -961,9 +697,9 @@ namespace ImageTransform {
         case V4L2_PIX_FMT_BGR24:
             {
 #if QT_VERSION >= QT_VERSION_CHECK(5,14,0)
-                convertedImage = QImage(pBuffer, width, height, bytesPerLine, QImage::Format_BGR888).copy();
+                CopyLines(pBuffer, bytesPerLine, width, height, QImage::Format_BGR888, 3, convertedImage);
 #else
-                convertedImage = QImage(width, height, QImage::Format_RGB888);
+                PrepareImage(convertedImage, width, height, QImage::Format_RGB888);
                 auto const offset = bytesPerLine - (width * 3);
                 v4lconvert_swap_rgb(pBuffer, convertedImage.bits(), width, height, offset);
 #endif
@@ -971,43 +707,64 @@ namespace ImageTransform {
             break;
         case V4L2_PIX_FMT_VYUY:
         case V4L2_PIX_FMT_UYVY:
-            {
-                convertedImage = QImage(width, height, QImage::Format_RGB888);
-                v4lconvert_uyvy_to_rgb24(pBuffer, convertedImage.bits(), width, height,
-                                         bytesPerLine, pixelFormat);
-            }
-            break;
         case V4L2_PIX_FMT_YUYV:
             {
-                convertedImage = QImage(width, height, QImage::Format_RGB888);
-                v4lconvert_yuyv_to_rgb24(pBuffer, convertedImage.bits(), width, height,
-                                         bytesPerLine);
+                YUV422_LAYOUT const layout = (pixelFormat == V4L2_PIX_FMT_UYVY) ? YUV422_LAYOUT_UYVY
+                                           : (pixelFormat == V4L2_PIX_FMT_VYUY) ? YUV422_LAYOUT_VYUY
+                                                                                : YUV422_LAYOUT_YUYV;
+                PrepareImage(convertedImage, width, height, QImage::Format_RGB888);
+                uint8_t *const pDestination = convertedImage.bits();
+                size_t const destinationBytesPerLine = convertedImage.bytesPerLine();
+                ConvertStripes(height, 1, [=](uint32_t firstRow, uint32_t rowCount) {
+                    pixelkernels::Yuv422ToRgb24(pBuffer + size_t(firstRow) * bytesPerLine, bytesPerLine,
+                                                pDestination + firstRow * destinationBytesPerLine, destinationBytesPerLine,
+                                                width, rowCount, layout);
+                });
             }
             break;
         case V4L2_PIX_FMT_YUV420:
+        case V4L2_PIX_FMT_YVU420:
+        case V4L2_PIX_FMT_NV12:
+        case V4L2_PIX_FMT_NV21:
+        case V4L2_PIX_FMT_NV16:
+        case V4L2_PIX_FMT_NV61:
+        case V4L2_PIX_FMT_YUV420M:
+        case V4L2_PIX_FMT_YVU420M:
+        case V4L2_PIX_FMT_NV12M:
+        case V4L2_PIX_FMT_NV21M:
+        case V4L2_PIX_FMT_NV16M:
+        case V4L2_PIX_FMT_NV61M:
             {
-                convertedImage = QImage(width, height, QImage::Format_RGB888);
-                v4lconvert_yuv420_to_rgb24(pBuffer, convertedImage.bits(), width,
-                                           height, 1);
+                // all planes one after another in one buffer, also for the multi-plane variants,
+                // e.g. a saved frame. Separate memory planes need the BufferWrapper overload.
+                uint32_t const singlePlaneFormat = planelayout::GetSinglePlaneFormat(pixelFormat);
+                FramePlane const memoryPlane { pBuffer, length, bytesPerLine };
+                FramePlane planes[BUFFER_MAX_PLANES];
+                uint32_t planeCount = 0;
+                result = planelayout::Split(singlePlaneFormat, height, &memoryPlane, 1, planes, planeCount);
+                if (0 == result)
+                {
+                    result = ConvertPlanarFrame(planes, planeCount, width, height, singlePlaneFormat, convertedImage);
+                }
             }
             break;
         case V4L2_PIX_FMT_RGB24:
             {
-                convertedImage = QImage(pBuffer, width, height, bytesPerLine, QImage::Format_RGB888).copy();
+                CopyLines(pBuffer, bytesPerLine, width, height, QImage::Format_RGB888, 3, convertedImage);
             }
             break;
         case V4L2_PIX_FMT_RGB32:
         case V4L2_PIX_FMT_BGR32:
             {
-                convertedImage = QImage(width, height, QImage::Format_RGB32);
+                PrepareImage(convertedImage, width, height, QImage::Format_RGB32);
                 memcpy(convertedImage.bits(), pBuffer, width * height * 4);
             }
             break;
         case V4L2_PIX_FMT_GREY:
             {
-                v4lconvert_remove_padding(&pBuffer, &conversionBuffer, width, height, 1,
+                v4lconvert_remove_padding(&pBuffer, width, height, 1,
                                           bytesPerLine);
-                convertedImage = QImage(width, height, QImage::Format_RGB888);
+                PrepareImage(convertedImage, width, height, QImage::Format_RGB888);
                 v4lconvert_grey_to_rgb24(pBuffer, convertedImage.bits(), width, height);
             }
             break;
@@ -1016,11 +773,8 @@ namespace ImageTransform {
         case V4L2_PIX_FMT_SGRBG8:
         case V4L2_PIX_FMT_SRGGB8:
             {
-                v4lconvert_remove_padding(&pBuffer, &conversionBuffer, width, height, 1,
-                                          bytesPerLine);
-                convertedImage = QImage(width, height, QImage::Format_RGB888);
-                v4lconvert_bayer8_to_rgb24(pBuffer, convertedImage.bits(), width,
-                                           height, width, pixelFormat);
+                PrepareImage(convertedImage, width, height, QImage::Format_RGB888);
+                DemosaicBayer8(pBuffer, bytesPerLine, pixelFormat, convertedImage);
             }
             break;
 
@@ -1028,91 +782,43 @@ namespace ImageTransform {
         /* 10bit raw bayer packed, 5 bytes for every 4 pixels */
         case V4L2_PIX_FMT_Y10P:
             {
-                convertedImage = QImage(width, height, QImage::Format_RGB888);
+                PrepareImage(convertedImage, width, height, QImage::Format_RGB888);
                 ConvertMono10gToRGB24(pBuffer, width, height, convertedImage.bits());
                 break;
             }
         case V4L2_PIX_FMT_SBGGR10P:
-            {
-                ConvertRAW10gToRAW8(pBuffer, width, height, s_ConversionBuffer.get());
-                convertedImage = QImage(width, height, QImage::Format_RGB888);
-                v4lconvert_bayer8_to_rgb24(s_ConversionBuffer.get(), convertedImage.bits(),
-                                           width, height, width,
-                                           V4L2_PIX_FMT_SBGGR8);
-                break;
-            }
+            result = ConvertPackedBayer(pBuffer, length, width, height, bytesPerLine, 10, V4L2_PIX_FMT_SBGGR8, convertedImage);
+            break;
         case V4L2_PIX_FMT_SGBRG10P:
-            {
-                ConvertRAW10gToRAW8(pBuffer, width, height, s_ConversionBuffer.get());
-                convertedImage = QImage(width, height, QImage::Format_RGB888);
-                v4lconvert_bayer8_to_rgb24(s_ConversionBuffer.get(), convertedImage.bits(),
-                                           width, height, width,
-                                           V4L2_PIX_FMT_SGBRG8);
-                break;
-            }
+            result = ConvertPackedBayer(pBuffer, length, width, height, bytesPerLine, 10, V4L2_PIX_FMT_SGBRG8, convertedImage);
+            break;
         case V4L2_PIX_FMT_SGRBG10P:
-            {
-                ConvertRAW10gToRAW8(pBuffer, width, height, s_ConversionBuffer.get());
-                convertedImage = QImage(width, height, QImage::Format_RGB888);
-                v4lconvert_bayer8_to_rgb24(s_ConversionBuffer.get(), convertedImage.bits(),
-                                           width, height, width,
-                                           V4L2_PIX_FMT_SGRBG8);
-                break;
-            }
+            result = ConvertPackedBayer(pBuffer, length, width, height, bytesPerLine, 10, V4L2_PIX_FMT_SGRBG8, convertedImage);
+            break;
         case V4L2_PIX_FMT_SRGGB10P:
-            {
-                ConvertRAW10gToRAW8(pBuffer, width, height, s_ConversionBuffer.get());
-                convertedImage = QImage(width, height, QImage::Format_RGB888);
-                v4lconvert_bayer8_to_rgb24(s_ConversionBuffer.get(), convertedImage.bits(),
-                                           width, height, width,
-                                           V4L2_PIX_FMT_SRGGB8);
-                break;
-            }
+            result = ConvertPackedBayer(pBuffer, length, width, height, bytesPerLine, 10, V4L2_PIX_FMT_SRGGB8, convertedImage);
+            break;
 
         /* 12bit raw bayer packed, 6 bytes for every 4 pixels */
         case V4L2_PIX_FMT_GREY12P:
         case V4L2_PIX_FMT_Y12P:
             {
-                convertedImage = QImage(width, height, QImage::Format_RGB888);
+                PrepareImage(convertedImage, width, height, QImage::Format_RGB888);
                 ConvertMono12gToRGB24(pBuffer, width, height, convertedImage.bits());
                 break;
             }
         case V4L2_PIX_FMT_SBGGR12P:
-            {
-                ConvertRAW12gToRAW8(pBuffer, width, height, s_ConversionBuffer.get());
-                convertedImage = QImage(width, height, QImage::Format_RGB888);
-                v4lconvert_bayer8_to_rgb24(s_ConversionBuffer.get(), convertedImage.bits(),
-                                           width, height, width,
-                                           V4L2_PIX_FMT_SBGGR8);
-                break;
-            }
+            result = ConvertPackedBayer(pBuffer, length, width, height, bytesPerLine, 12, V4L2_PIX_FMT_SBGGR8, convertedImage);
+            break;
         case V4L2_PIX_FMT_SGBRG12P:
-            {
-                ConvertRAW12gToRAW8(pBuffer, width, height, s_ConversionBuffer.get());
-                convertedImage = QImage(width, height, QImage::Format_RGB888);
-                v4lconvert_bayer8_to_rgb24(s_ConversionBuffer.get(), convertedImage.bits(),
-                                           width, height, width,
-                                           V4L2_PIX_FMT_SGBRG8);
-                break;
-            }
+            result = ConvertPackedBayer(pBuffer, length, width, height, bytesPerLine, 12, V4L2_PIX_FMT_SGBRG8, convertedImage);
+            break;
         case V4L2_PIX_FMT_SGRBG12P:
-            {
-                ConvertRAW12gToRAW8(pBuffer, width, height, s_ConversionBuffer.get());
-                convertedImage = QImage(width, height, QImage::Format_RGB888);
-                v4lconvert_bayer8_to_rgb24(s_ConversionBuffer.get(), convertedImage.bits(),
-                                           width, height, width,
-                                           V4L2_PIX_FMT_SGRBG8);
-                break;
-            }
+            result = ConvertPackedBayer(pBuffer, length, width, height, bytesPerLine, 12, V4L2_PIX_FMT_SGRBG8, convertedImage);
+            break;
         case V4L2_PIX_FMT_SRGGB12P:
-            {
-                ConvertRAW12gToRAW8(pBuffer, width, height, s_ConversionBuffer.get());
-                convertedImage = QImage(width, height, QImage::Format_RGB888);
-                v4lconvert_bayer8_to_rgb24(s_ConversionBuffer.get(), convertedImage.bits(),
-                                           width, height, width,
-                                           V4L2_PIX_FMT_SRGGB8);
-                break;
-            }
+            result = ConvertPackedBayer(pBuffer, length, width, height, bytesPerLine, 12, V4L2_PIX_FMT_SRGGB8, convertedImage);
+            break;
 
         /* Special 10 and 12 bit pixel formats for NVidia Jetson */
 
@@ -1217,4 +923,117 @@ namespace ImageTransform {
 
         return result;
     }
+
+    int ConvertFrame(const BufferWrapper &buffer, QImage &convertedImage)
+    {
+        PlanarFormat format;
+        if (planelayout::GetPlanarFormat(buffer.pixelFormat, format))
+        {
+            return ConvertPlanarFrame(buffer.planes, buffer.planeCount, buffer.width, buffer.height,
+                                      buffer.pixelFormat, convertedImage);
+        }
+
+        return ConvertFrame(buffer.data, buffer.length, buffer.width, buffer.height, buffer.pixelFormat,
+                            buffer.payloadSize, buffer.bytesPerLine, convertedImage);
+    }
+
+    // QImage format which holds the pixels exactly as the driver delivers them
+    static bool GetWrapFormat(uint32_t pixelFormat, QImage::Format &format, uint32_t &bytesPerPixel)
+    {
+        switch (pixelFormat)
+        {
+        case V4L2_PIX_FMT_ABGR32:
+            format = QImage::Format_ARGB32;
+            bytesPerPixel = 4;
+            return true;
+        case V4L2_PIX_FMT_XBGR32:
+            format = QImage::Format_RGB32;
+            bytesPerPixel = 4;
+            return true;
+        case V4L2_PIX_FMT_RGB24:
+            format = QImage::Format_RGB888;
+            bytesPerPixel = 3;
+            return true;
+#if QT_VERSION >= QT_VERSION_CHECK(5,14,0)
+        case V4L2_PIX_FMT_BGR24:
+            format = QImage::Format_BGR888;
+            bytesPerPixel = 3;
+            return true;
+#endif
+        default:
+            return false;
+        }
+    }
+
+    // called by QImage when the last copy of a wrapped frame is gone
+    static void ReleaseWrappedFrame(void *pLeaseSlot)
+    {
+        // the slot is emptied before the buffer is requeued, it may be filled again right after
+        FrameLease lease = std::move(*static_cast<FrameLease*>(pLeaseSlot));
+        lease.Release();
+    }
+
+    bool CanWrapFrame(uint32_t pixelFormat)
+    {
+        QImage::Format format;
+        uint32_t bytesPerPixel;
+
+        return GetWrapFormat(pixelFormat, format, bytesPerPixel);
+    }
+
+    void SetConversionThreads(uint32_t threadCount)
+    {
+        auto pPool = std::make_shared<StripePool>(threadCount);
+        LOG_EX("ImageTransform::SetConversionThreads %u threads convert a frame", pPool->GetThreadCount());
+
+        // running conversions keep the previous pool until they are done
+        QMutexLocker locker(&s_StripePoolMutex);
+        s_pStripePool.swap(pPool);
+    }
+
+    uint32_t GetConversionThreads()
+    {
+        return GetStripePool()->GetThreadCount();
+    }
+
+    std::shared_ptr<StripePool> GetStripePool()
+    {
+        QMutexLocker locker(&s_StripePoolMutex);
+        if (!s_pStripePool)
+        {
+            s_pStripePool = std::make_shared<StripePool>(0);
+        }
+
+        return s_pStripePool;
+    }
+
+    int WrapFrame(const BufferWrapper &buffer, const FrameLease &lease, FrameLease &leaseSlot, QImage &image)
+    {
+        QImage::Format format;
+        uint32_t bytesPerPixel;
+        if (!GetWrapFormat(buffer.pixelFormat, format, bytesPerPixel) || buffer.planeCount != 1)
+        {
+            return -1;
+        }
+
+        // Qt reads 32 bit pixels directly from the buffer
+        if (reinterpret_cast<uintptr_t>(buffer.data) % 4 != 0 || buffer.width == 0 || buffer.height == 0)
+        {
+            return -1;
+        }
+
+        size_t const lineSize = size_t(buffer.width) * bytesPerPixel;
+        if (buffer.bytesPerLine < lineSize
+            || buffer.length < size_t(buffer.bytesPerLine) * (buffer.height - 1) + lineSize)
+        {
+            return -1;
+        }
+
+        // the const constructor keeps Qt from writing into the buffer, a write detaches
+        leaseSlot = lease;
+        image = QImage(buffer.data, buffer.width, buffer.height, buffer.bytesPerLine, format,
+                       ReleaseWrappedFrame, &leaseSlot);
+
+        return 0;
+    }
 }
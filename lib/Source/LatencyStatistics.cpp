@@ -0,0 +1,214 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+#include "LatencyStatistics.h"
+
+#include <cstdio>
+#include <time.h>
+
+LatencyStatistics::LatencyStatistics()
+{
+    Reset();
+}
+
+uint64_t LatencyStatistics::Now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000ULL + uint64_t(ts.tv_nsec) / 1000ULL;
+}
+
+uint64_t LatencyStatistics::DriverTimestamp(const v4l2_buffer &buf)
+{
+    if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) != V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC)
+    {
+        return 0;
+    }
+
+    return uint64_t(buf.timestamp.tv_sec) * 1000000ULL + uint64_t(buf.timestamp.tv_usec);
+}
+
+int LatencyStatistics::BucketIndex(uint64_t value)
+{
+    if (value < SUB_BUCKET_COUNT)
+    {
+        return static_cast<int>(value);
+    }
+
+    int const exponent = 63 - __builtin_clzll(value);
+    int const index = (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT
+                    + static_cast<int>((value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1));
+
+    return index < BUCKET_COUNT ? index : BUCKET_COUNT - 1;
+}
+
+uint64_t LatencyStatistics::BucketValue(int index)
+{
+    if (index < SUB_BUCKET_COUNT)
+    {
+        return index;
+    }
+
+    int const exponent = index / SUB_BUCKET_COUNT + SUB_BUCKET_BITS - 1;
+    uint64_t const subBucket = index % SUB_BUCKET_COUNT;
+    uint64_t const lower = (SUB_BUCKET_COUNT + subBucket) << (exponent - SUB_BUCKET_BITS);
+    uint64_t const width = 1ULL << (exponent - SUB_BUCKET_BITS);
+
+    // middle of the bucket
+    return lower + width / 2;
+}
+
+void LatencyStatistics::Record(LATENCY_STAGE stage, uint64_t start, uint64_t end)
+{
+    if (start == 0 || stage >= LATENCY_STAGE_COUNT)
+    {
+        return;
+    }
+
+    // clocks of different sources may be slightly off, don't let that wrap around
+    uint64_t const value = end > start ? end - start : 0;
+
+    Histogram &histogram = m_Histograms[stage];
+    histogram.buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    histogram.count.fetch_add(1, std::memory_order_relaxed);
+    histogram.sum.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t max = histogram.max.load(std::memory_order_relaxed);
+    while (value > max && !histogram.max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+void LatencyStatistics::Reset()
+{
+    for (Histogram &histogram : m_Histograms)
+    {
+        for (std::atomic<uint64_t> &bucket : histogram.buckets)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        histogram.count.store(0, std::memory_order_relaxed);
+        histogram.sum.store(0, std::memory_order_relaxed);
+        histogram.max.store(0, std::memory_order_relaxed);
+    }
+}
+
+LatencySummary LatencyStatistics::GetSummary(LATENCY_STAGE stage) const
+{
+    LatencySummary summary = {};
+    if (stage >= LATENCY_STAGE_COUNT)
+    {
+        return summary;
+    }
+
+    Histogram const &histogram = m_Histograms[stage];
+
+    // Take a snapshot, so the percentiles are consistent with the count
+    // even while other threads keep recording
+    uint64_t counts[BUCKET_COUNT];
+    uint64_t total = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+    {
+        counts[i] = histogram.buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    summary.count = total;
+    summary.maxMicroseconds = histogram.max.load(std::memory_order_relaxed);
+    if (total == 0)
+    {
+        return summary;
+    }
+
+    uint64_t const sampleCount = histogram.count.load(std::memory_order_relaxed);
+    summary.meanMicroseconds = sampleCount ? double(histogram.sum.load(std::memory_order_relaxed)) / double(sampleCount) : 0.0;
+
+    struct { double fraction; uint64_t *pValue; } percentiles[] = {
+        { 0.50, &summary.p50Microseconds },
+        { 0.90, &summary.p90Microseconds },
+        { 0.99, &summary.p99Microseconds },
+    };
+
+    uint64_t cumulated = 0;
+    size_t next = 0;
+    for (int i = 0; i < BUCKET_COUNT && next < sizeof(percentiles) / sizeof(percentiles[0]); ++i)
+    {
+        cumulated += counts[i];
+        while (next < sizeof(percentiles) / sizeof(percentiles[0]) &&
+               double(cumulated) >= percentiles[next].fraction * double(total))
+        {
+            uint64_t const value = BucketValue(i);
+            *percentiles[next].pValue = value < summary.maxMicroseconds ? value : summary.maxMicroseconds;
+            ++next;
+        }
+    }
+
+    return summary;
+}
+
+const char* LatencyStatistics::GetStageName(LATENCY_STAGE stage)
+{
+    switch (stage)
+    {
+        case LATENCY_DRIVER_TO_DEQUEUE:      return "driver_to_dequeue";
+        case LATENCY_DEQUEUE_TO_DISPATCH:    return "dequeue_to_dispatch";
+        case LATENCY_DISPATCH_TO_CONVERSION: return "dispatch_to_conversion";
+        case LATENCY_CONVERSION:             return "conversion";
+        case LATENCY_TEXTURE_UPLOAD:         return "texture_upload";
+        case LATENCY_DRIVER_TO_DISPLAY:      return "driver_to_display";
+        case LATENCY_BUFFER_HOLD:            return "buffer_hold";
+        default:                             return "unknown";
+    }
+}
+
+int LatencyStatistics::DumpToFile(const std::string &fileName) const
+{
+    FILE *pFile = fopen(fileName.c_str(), "w");
+    if (pFile == nullptr)
+    {
+        return -1;
+    }
+
+    fprintf(pFile, "# stage count mean_us p50_us p90_us p99_us max_us\n");
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; ++stage)
+    {
+        LatencySummary const summary = GetSummary(static_cast<LATENCY_STAGE>(stage));
+        fprintf(pFile, "%s %llu %.1f %llu %llu %llu %llu\n", GetStageName(static_cast<LATENCY_STAGE>(stage)),
+                (unsigned long long)summary.count, summary.meanMicroseconds,
+                (unsigned long long)summary.p50Microseconds, (unsigned long long)summary.p90Microseconds,
+                (unsigned long long)summary.p99Microseconds, (unsigned long long)summary.maxMicroseconds);
+    }
+
+    fprintf(pFile, "\n# stage bucket_us count\n");
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; ++stage)
+    {
+        for (int i = 0; i < BUCKET_COUNT; ++i)
+        {
+            uint64_t const count = m_Histograms[stage].buckets[i].load(std::memory_order_relaxed);
+            if (count != 0)
+            {
+                fprintf(pFile, "%s %llu %llu\n", GetStageName(static_cast<LATENCY_STAGE>(stage)),
+                        (unsigned long long)BucketValue(i), (unsigned long long)count);
+            }
+        }
+    }
+
+    int const result = ferror(pFile) ? -1 : 0;
+    fclose(pFile);
+
+    return result;
+}
@@ -0,0 +1,364 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#include "MultiCameraViewer.h"
+#include "ImageTransform.h"
+#include "LatencyStatistics.h"
+#include "Logger.h"
+#include "V4L2Helper.h"
+
+#include <QGridLayout>
+#include <QPainter>
+#include <QResizeEvent>
+
+#include <algorithm>
+#include <cmath>
+
+#define TILE_TEXT_HEIGHT    60
+
+CameraTileWidget::CameraTileWidget(const QString &title, QWidget *parent)
+    : QWidget(parent)
+    , m_Title(title)
+    , m_TargetWidth(0)
+    , m_TargetHeight(0)
+{
+    setMinimumSize(160, 120);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void CameraTileWidget::SetImage(const QImage &image)
+{
+    m_Image = image;
+    m_RenderFPS.trigger();
+    update();
+}
+
+void CameraTileWidget::SetStatus(const QString &status)
+{
+    m_Status = status;
+    update();
+}
+
+QSize CameraTileWidget::GetImageTargetSize() const
+{
+    return QSize(m_TargetWidth.load(std::memory_order_relaxed), m_TargetHeight.load(std::memory_order_relaxed));
+}
+
+double CameraTileWidget::GetRenderedFPS()
+{
+    return m_RenderFPS.getFPS();
+}
+
+void CameraTileWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(19, 20, 21));
+
+    if (!m_Image.isNull())
+    {
+        QSize const imageSize = m_Image.size().scaled(size(), Qt::KeepAspectRatio);
+        QRect imageRect(QPoint(0, 0), imageSize);
+        imageRect.moveCenter(rect().center());
+        painter.drawImage(imageRect, m_Image);
+    }
+
+    QRect const textRect(0, 0, width(), TILE_TEXT_HEIGHT);
+    painter.fillRect(textRect, QColor(0, 0, 0, 160));
+    painter.setPen(Qt::white);
+    painter.drawText(textRect.adjusted(6, 2, -6, -2), Qt::AlignLeft | Qt::AlignVCenter, m_Title + "\n" + m_Status);
+}
+
+void CameraTileWidget::resizeEvent(QResizeEvent *event)
+{
+    m_TargetWidth.store(event->size().width(), std::memory_order_relaxed);
+    m_TargetHeight.store(event->size().height(), std::memory_order_relaxed);
+    QWidget::resizeEvent(event);
+}
+
+MultiCameraViewer::MultiCameraViewer(const MultiCameraOptions &options, QWidget *parent)
+    : QWidget(parent)
+    , m_Options(options)
+    , m_ConversionPool(options.conversionThreads)
+{
+    Logger::InitializeLogger("V4L2ViewerLog.log");
+
+    setStyleSheet("background-color: rgb(19,20,21);");
+    setWindowTitle(QString("V4L2 Viewer - %1 cameras, %2 conversion threads")
+                   .arg(m_Options.devices.size()).arg(m_ConversionPool.GetThreadCount()));
+
+    QGridLayout *pLayout = new QGridLayout(this);
+    pLayout->setContentsMargins(0, 0, 0, 0);
+    pLayout->setSpacing(2);
+
+    int const columns = std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<double>(m_Options.devices.size())))));
+    for (size_t i = 0; i < m_Options.devices.size(); ++i)
+    {
+        auto pStream = std::make_unique<CameraStream>();
+        pStream->device = m_Options.devices[i];
+        pStream->pTile = new CameraTileWidget(QString::fromStdString(pStream->device), this);
+        pLayout->addWidget(pStream->pTile, static_cast<int>(i) / columns, static_cast<int>(i) % columns);
+        m_Streams.push_back(std::move(pStream));
+    }
+
+    resize(640 * columns, 480 * ((static_cast<int>(m_Options.devices.size()) + columns - 1) / columns));
+
+    connect(&m_StatisticsTimer, SIGNAL(timeout()), this, SLOT(OnUpdateStatistics()));
+}
+
+MultiCameraViewer::~MultiCameraViewer()
+{
+    StopStreams();
+}
+
+int MultiCameraViewer::StartStreams()
+{
+    std::vector<CameraStream*> openedStreams;
+    for (auto &pStream : m_Streams)
+    {
+        if (OpenStream(*pStream) == 0)
+        {
+            openedStreams.push_back(pStream.get());
+        }
+    }
+
+    // all streams have to be known to the synchronizer before the first frame arrives,
+    // it matches only once every camera has been started. A camera which fails to
+    // start is taken out of the sets by StopStream, so it doesn't hold back the others.
+    if (m_Options.syncToleranceMicroseconds != 0 && !openedStreams.empty())
+    {
+        m_pSynchronizer = std::make_unique<FrameSynchronizer>(m_Options.syncToleranceMicroseconds,
+                                                              std::max<uint32_t>(m_Options.bufferCount / 2, 1));
+        m_pSynchronizer->SetActive(false);
+        std::vector<int> sourceIds;
+        for (CameraStream *pStream : openedStreams)
+        {
+            pStream->syncIndex = m_pSynchronizer->AddStream(pStream->pCamera->GetFrameObserver());
+            sourceIds.push_back(pStream->sourceId);
+        }
+        m_pSynchronizer->AddSetProcessor([this, sourceIds] (std::vector<SynchronizedFrame> const& set) {
+            for (auto const &frame : set)
+            {
+                m_ConversionPool.Submit(sourceIds[frame.stream], frame.buffer, frame.lease);
+            }
+        });
+    }
+    else
+    {
+        for (CameraStream *pStream : openedStreams)
+        {
+            int const sourceId = pStream->sourceId;
+            pStream->pCamera->GetFrameObserver()->AddRawDataProcessor([this, sourceId] (BufferWrapper const& buffer, FrameLease lease) {
+                m_ConversionPool.Submit(sourceId, buffer, std::move(lease));
+            });
+        }
+    }
+
+    int started = 0;
+    for (CameraStream *pStream : openedStreams)
+    {
+        if (StartStream(*pStream) == 0)
+        {
+            ++started;
+        }
+    }
+    if (m_pSynchronizer)
+    {
+        m_pSynchronizer->SetActive(true);
+    }
+
+    LOG_EX("MultiCameraViewer::StartStreams %d of %zu cameras streaming, %u conversion threads, sync tolerance %llu us",
+           started, m_Streams.size(), m_ConversionPool.GetThreadCount(), (unsigned long long)m_Options.syncToleranceMicroseconds);
+
+    m_StatisticsTimer.start(1000);
+    return started;
+}
+
+void MultiCameraViewer::StopStreams()
+{
+    m_StatisticsTimer.stop();
+    // waiting sets would hold buffers of the streams which are stopped later
+    if (m_pSynchronizer)
+    {
+        m_pSynchronizer->SetActive(false);
+    }
+    for (auto &pStream : m_Streams)
+    {
+        StopStream(*pStream);
+    }
+    m_pSynchronizer.reset();
+}
+
+int MultiCameraViewer::OpenStream(CameraStream &stream)
+{
+    if (stream.pCamera)
+    {
+        return -1;
+    }
+
+    stream.pCamera = std::make_unique<Camera>();
+    Camera &camera = *stream.pCamera;
+
+    // The configured buffer count is the floor, bursts may add more buffers
+    BufferPoolPolicy bufferPoolPolicy;
+    bufferPoolPolicy.adaptive = true;
+    bufferPoolPolicy.minimumCount = m_Options.bufferCount;
+    camera.SetBufferPoolPolicy(bufferPoolPolicy);
+
+    CaptureWatchdogPolicy watchdogPolicy;
+    watchdogPolicy.enabled = m_Options.watchdog;
+    camera.SetCaptureWatchdogPolicy(watchdogPolicy);
+
+    std::string deviceName = stream.device;
+    QVector<QString> subDevices;
+    if (camera.OpenDevice(deviceName, subDevices, true, m_Options.ioMethod, true) != 0)
+    {
+        stream.pTile->SetStatus(tr("The camera cannot be opened"));
+        stream.pCamera.reset();
+        return -1;
+    }
+
+    camera.ReadPayloadSize(stream.payloadSize);
+    camera.ReadFrameSize(stream.width, stream.height);
+    if (camera.ReadPixelFormat(stream.pixelFormat, stream.bytesPerLine, stream.pixelFormatText) != 0 ||
+        !ImageTransform::CanConvert(stream.pixelFormat))
+    {
+        stream.pTile->SetStatus(tr("Pixel format %1 cannot be shown")
+                                .arg(QString::fromStdString(v4l2helper::ConvertPixelFormat2String(stream.pixelFormat))));
+        camera.CloseDevice();
+        stream.pCamera.reset();
+        return -1;
+    }
+
+    CameraTileWidget *pTile = stream.pTile;
+    stream.sourceId = m_ConversionPool.AddSource([pTile] (QImage &image, BufferWrapper const&) {
+        // scaled down on the conversion thread, the GUI thread only draws
+        QSize const targetSize = pTile->GetImageTargetSize();
+        if (targetSize.isValid() && (image.width() > targetSize.width() || image.height() > targetSize.height()))
+        {
+            image = image.scaled(targetSize, Qt::KeepAspectRatio, Qt::FastTransformation);
+        }
+        QMetaObject::invokeMethod(pTile, [pTile, image] {
+            pTile->SetImage(image);
+        }, Qt::QueuedConnection);
+    });
+
+    return 0;
+}
+
+int MultiCameraViewer::StartStream(CameraStream &stream)
+{
+    Camera &camera = *stream.pCamera;
+
+    LOG_EX("MultiCameraViewer::StartStream %s pixelFormat=%d,payloadSize=%d,width=%d,height=%d,bytesPerLine=%d",
+           stream.device.c_str(), stream.pixelFormat, stream.payloadSize, stream.width, stream.height, stream.bytesPerLine);
+
+    if (camera.CreateUserBuffer(m_Options.bufferCount, stream.payloadSize) != 0 ||
+        camera.QueueAllUserBuffer() != 0 ||
+        camera.StartStreaming() != 0 ||
+        camera.StartStreamChannel(stream.pixelFormat, stream.payloadSize, stream.width, stream.height, stream.bytesPerLine, NULL, false) != 0)
+    {
+        stream.pTile->SetStatus(tr("Streaming could not be started"));
+        StopStream(stream);
+        return -1;
+    }
+
+    stream.streaming = true;
+    stream.pTile->SetStatus(QString("%1 %2x%3").arg(stream.pixelFormatText).arg(stream.width).arg(stream.height));
+
+    return 0;
+}
+
+void MultiCameraViewer::StopStream(CameraStream &stream)
+{
+    if (!stream.pCamera)
+    {
+        return;
+    }
+
+    // the pool gives back its waiting frame and takes no new ones,
+    // so no lease keeps the stream from stopping
+    m_ConversionPool.RemoveSource(stream.sourceId);
+    stream.sourceId = -1;
+    if (m_pSynchronizer && stream.syncIndex >= 0)
+    {
+        m_pSynchronizer->SetStreamActive(stream.syncIndex, false);
+    }
+    stream.syncIndex = -1;
+
+    if (stream.streaming)
+    {
+        stream.pCamera->StopStreamChannel();
+        stream.pCamera->StopStreaming();
+        stream.streaming = false;
+    }
+    stream.pCamera->DeleteUserBuffer();
+    stream.pCamera->CloseDevice();
+    stream.pCamera.reset();
+}
+
+void MultiCameraViewer::OnUpdateStatistics()
+{
+    for (auto &pStream : m_Streams)
+    {
+        if (!pStream->streaming)
+        {
+            continue;
+        }
+
+        Camera &camera = *pStream->pCamera;
+        FrameDropCounters totals;
+        FrameDropCounters lastSecond;
+        camera.GetFrameDropCounters(totals, lastSecond);
+        LatencySummary const latency = camera.GetLatencyStatistics().GetSummary(LATENCY_DRIVER_TO_DISPLAY);
+        ConversionSourceStatistics const conversion = m_ConversionPool.GetStatistics(pStream->sourceId);
+
+        // dropped are lost before or in the driver, skipped frames were captured but not shown
+        QString status = QString::asprintf("%ux%u | %.1f received/ %.1f shown fps | dropped %llu (+%llu) starved %llu | skipped %llu | latency p50 %.1f p99 %.1f ms",
+                                           pStream->width, pStream->height,
+                                           camera.GetReceivedFPS(), pStream->pTile->GetRenderedFPS(),
+                                           (unsigned long long)(totals.sequenceGaps + totals.errorFrames),
+                                           (unsigned long long)(lastSecond.sequenceGaps + lastSecond.errorFrames),
+                                           (unsigned long long)totals.starvations,
+                                           (unsigned long long)conversion.replaced,
+                                           latency.p50Microseconds / 1000.0, latency.p99Microseconds / 1000.0);
+        // the watchdog restarts a stalled camera, the others keep streaming
+        CaptureWatchdogStatistics const watchdog = camera.GetCaptureWatchdogStatistics();
+        if (watchdog.gaveUp)
+        {
+            status = "NO FRAMES | " + status;
+        }
+        // a camera without frames would stop all sets, it takes part again with its next frame
+        if (m_pSynchronizer && pStream->syncIndex >= 0)
+        {
+            m_pSynchronizer->SetStreamActive(pStream->syncIndex, !watchdog.gaveUp);
+        }
+        if (watchdog.stalls + watchdog.errorStorms != 0)
+        {
+            status += QString::asprintf(" | restarts %u", watchdog.stalls + watchdog.errorStorms);
+        }
+        if (m_pSynchronizer && pStream->syncIndex >= 0)
+        {
+            FrameSynchronizerStatistics const sync = m_pSynchronizer->GetStatistics(pStream->syncIndex);
+            status += QString::asprintf("\nsync: %llu sets, max skew %.2f ms | matched %llu unmatched %llu late %llu evicted %llu",
+                                        (unsigned long long)m_pSynchronizer->GetSetCount(), m_pSynchronizer->GetMaxSkew() / 1000.0,
+                                        (unsigned long long)sync.matched, (unsigned long long)sync.unmatched,
+                                        (unsigned long long)sync.late, (unsigned long long)sync.evicted);
+        }
+        pStream->pTile->SetStatus(status);
+    }
+}
@@ -0,0 +1,1347 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#include "PixelKernels.h"
+#include "Logger.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PIXELKERNELS_X86 1
+#include <immintrin.h>
+// compiled for the instruction set regardless of the build flags, called only after detection
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(__ARM_NEON)
+#define PIXELKERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace pixelkernels
+{
+
+namespace
+{
+
+const char* const ISA_NAMES[KERNEL_ISA_COUNT] = {
+    "scalar", "sse4.1", "avx2", "neon"
+};
+
+std::atomic<int> s_ActiveIsa{-1};
+
+KERNEL_ISA DetectIsa()
+{
+#if defined(PIXELKERNELS_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return KERNEL_ISA_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1"))
+    {
+        return KERNEL_ISA_SSE41;
+    }
+#elif defined(PIXELKERNELS_NEON)
+    // part of every AArch64 CPU, 32 bit builds only define __ARM_NEON if they may use it
+    return KERNEL_ISA_NEON;
+#endif
+    return KERNEL_ISA_SCALAR;
+}
+
+// An instruction set can be used if the detected one includes it
+bool IsSupported(KERNEL_ISA isa)
+{
+    KERNEL_ISA const detected = GetDetectedIsa();
+    switch (isa)
+    {
+        case KERNEL_ISA_SCALAR:
+            return true;
+        case KERNEL_ISA_SSE41:
+            return detected == KERNEL_ISA_SSE41 || detected == KERNEL_ISA_AVX2;
+        case KERNEL_ISA_AVX2:
+        case KERNEL_ISA_NEON:
+            return detected == isa;
+        default:
+            return false;
+    }
+}
+
+KERNEL_ISA SelectIsa()
+{
+    KERNEL_ISA isa = GetDetectedIsa();
+    if (const char *pName = getenv("V4L2VIEWER_KERNELS"))
+    {
+        int requested = -1;
+        for (int i = 0; i < KERNEL_ISA_COUNT; ++i)
+        {
+            if (strcmp(pName, ISA_NAMES[i]) == 0)
+            {
+                requested = i;
+            }
+        }
+
+        if (requested < 0 || !IsSupported(static_cast<KERNEL_ISA>(requested)))
+        {
+            LOG_EX("pixelkernels: V4L2VIEWER_KERNELS=%s is not supported, using %s", pName, ISA_NAMES[isa]);
+        }
+        else
+        {
+            isa = static_cast<KERNEL_ISA>(requested);
+        }
+    }
+
+    LOG_EX("pixelkernels: detected %s, using %s", ISA_NAMES[GetDetectedIsa()], ISA_NAMES[isa]);
+
+    return isa;
+}
+
+// Chroma terms of a pixel pair, the integer approximation of BT.601 used by libv4lconvert
+//   R = Y + (3 * V') / 2, G = Y - (3 * U' + 6 * V') / 8, B = Y + (129 * U') / 64
+// with U' = U - 128 and V' = V - 128. All vectorized kernels compute exactly this
+// in 16 bit, the terms stay within -1152..1143.
+
+template <YUV422_LAYOUT Layout>
+struct Yuv422Order
+{
+    static constexpr bool LUMA_FIRST = (Layout == YUV422_LAYOUT_YUYV);
+    static constexpr bool SWAP_CHROMA = (Layout == YUV422_LAYOUT_VYUY);
+    static constexpr int Y0 = LUMA_FIRST ? 0 : 1;
+    static constexpr int Y1 = LUMA_FIRST ? 2 : 3;
+    static constexpr int U = LUMA_FIRST ? 1 : (SWAP_CHROMA ? 2 : 0);
+    static constexpr int V = LUMA_FIRST ? 3 : (SWAP_CHROMA ? 0 : 2);
+};
+
+inline uint8_t Clip(int value)
+{
+    return static_cast<uint8_t>((value > 0xFF) ? 0xFF : ((value < 0) ? 0 : value));
+}
+
+template <YUV422_LAYOUT Layout>
+void Yuv422RowScalar(const uint8_t *pSource, uint8_t *pDestination, uint32_t pairs)
+{
+    typedef Yuv422Order<Layout> Order;
+
+    for (uint32_t i = 0; i < pairs; ++i)
+    {
+        int const u = pSource[Order::U] - 128;
+        int const v = pSource[Order::V] - 128;
+        int const u1 = (u * 129) >> 6;
+        int const rg = (u * 3 + v * 6) >> 3;
+        int const v1 = (v * 3) >> 1;
+
+        *pDestination++ = Clip(pSource[Order::Y0] + v1);
+        *pDestination++ = Clip(pSource[Order::Y0] - rg);
+        *pDestination++ = Clip(pSource[Order::Y0] + u1);
+
+        *pDestination++ = Clip(pSource[Order::Y1] + v1);
+        *pDestination++ = Clip(pSource[Order::Y1] - rg);
+        *pDestination++ = Clip(pSource[Order::Y1] + u1);
+
+        pSource += 4;
+    }
+}
+
+// Planar and semi-planar rows use the same arithmetic, the chroma of a pixel
+// pair comes from separate U and V rows or from one row of interleaved pairs
+template <YUV_CHROMA_LAYOUT Layout>
+struct YuvChromaOrder
+{
+    static constexpr uint32_t STEP = (Layout == YUV_CHROMA_LAYOUT_PLANAR) ? 1 : 2;
+    static constexpr int U = (Layout == YUV_CHROMA_LAYOUT_VU) ? 1 : 0;
+    static constexpr int V = (Layout == YUV_CHROMA_LAYOUT_UV) ? 1 : 0;
+};
+
+template <YUV_CHROMA_LAYOUT Layout>
+void YuvPlanarRowScalar(const uint8_t *pLuma, const uint8_t *pChroma, const uint8_t *pSecondChroma,
+                        uint8_t *pDestination, uint32_t width)
+{
+    typedef YuvChromaOrder<Layout> Order;
+    const uint8_t *pU = pChroma + Order::U;
+    const uint8_t *pV = (Layout == YUV_CHROMA_LAYOUT_PLANAR) ? pSecondChroma : pChroma + Order::V;
+
+    for (uint32_t x = 0; x < width; x += 2)
+    {
+        int const u = *pU - 128;
+        int const v = *pV - 128;
+        int const u1 = (u * 129) >> 6;
+        int const rg = (u * 3 + v * 6) >> 3;
+        int const v1 = (v * 3) >> 1;
+
+        *pDestination++ = Clip(pLuma[0] + v1);
+        *pDestination++ = Clip(pLuma[0] - rg);
+        *pDestination++ = Clip(pLuma[0] + u1);
+
+        // an odd width leaves a single pixel for the last chroma sample
+        if (x + 1 < width)
+        {
+            *pDestination++ = Clip(pLuma[1] + v1);
+            *pDestination++ = Clip(pLuma[1] - rg);
+            *pDestination++ = Clip(pLuma[1] + u1);
+        }
+
+        pLuma += 2;
+        pU += Order::STEP;
+        pV += Order::STEP;
+    }
+}
+
+// This function converts the rest of a planar row from pixel x on
+template <YUV_CHROMA_LAYOUT Layout>
+inline void YuvPlanarRowTail(const uint8_t *pLuma, const uint8_t *pChroma, const uint8_t *pSecondChroma,
+                             uint8_t *pDestination, uint32_t width, uint32_t x)
+{
+    typedef YuvChromaOrder<Layout> Order;
+    YuvPlanarRowScalar<Layout>(pLuma + x, pChroma + (x / 2) * Order::STEP,
+                               (Layout == YUV_CHROMA_LAYOUT_PLANAR) ? pSecondChroma + x / 2 : NULL,
+                               pDestination + size_t(x) * 3, width - x);
+}
+
+#if defined(PIXELKERNELS_X86)
+
+// This function interleaves 16 pixels of R, G and B to 48 bytes RGB24
+TARGET_SSE41 inline void StoreRgb24(uint8_t *pDestination, __m128i r, __m128i g, __m128i b)
+{
+    const __m128i r0 = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5);
+    const __m128i g0 = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1);
+    const __m128i b0 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+    const __m128i r1 = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1);
+    const __m128i g1 = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10);
+    const __m128i b1 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1);
+    const __m128i r2 = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+    const __m128i g2 = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+    const __m128i b2 = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+
+    __m128i const out0 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r0), _mm_shuffle_epi8(g, g0)),
+                                      _mm_shuffle_epi8(b, b0));
+    __m128i const out1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r1), _mm_shuffle_epi8(g, g1)),
+                                      _mm_shuffle_epi8(b, b1));
+    __m128i const out2 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r2), _mm_shuffle_epi8(g, g2)),
+                                      _mm_shuffle_epi8(b, b2));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pDestination), out0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pDestination + 16), out1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pDestination + 32), out2);
+}
+
+// This function converts 16 pixels from their luma in 16 bit and the
+// chroma of their 8 pairs in 16 bit
+TARGET_SSE41 inline void YuvPairsToRgb24Sse41(__m128i yA, __m128i yB, __m128i u, __m128i v, uint8_t *pDestination)
+{
+    const __m128i offset = _mm_set1_epi16(128);
+    u = _mm_sub_epi16(u, offset);
+    v = _mm_sub_epi16(v, offset);
+
+    __m128i const u1 = _mm_srai_epi16(_mm_add_epi16(_mm_slli_epi16(u, 7), u), 6);
+    __m128i const u3 = _mm_add_epi16(_mm_slli_epi16(u, 1), u);
+    __m128i const v3 = _mm_add_epi16(_mm_slli_epi16(v, 1), v);
+    __m128i const rg = _mm_srai_epi16(_mm_add_epi16(u3, _mm_slli_epi16(v3, 1)), 3);
+    __m128i const v1 = _mm_srai_epi16(v3, 1);
+
+    // every term for both pixels of its pair
+    __m128i const r = _mm_packus_epi16(_mm_add_epi16(yA, _mm_unpacklo_epi16(v1, v1)),
+                                       _mm_add_epi16(yB, _mm_unpackhi_epi16(v1, v1)));
+    __m128i const g = _mm_packus_epi16(_mm_sub_epi16(yA, _mm_unpacklo_epi16(rg, rg)),
+                                       _mm_sub_epi16(yB, _mm_unpackhi_epi16(rg, rg)));
+    __m128i const b = _mm_packus_epi16(_mm_add_epi16(yA, _mm_unpacklo_epi16(u1, u1)),
+                                       _mm_add_epi16(yB, _mm_unpackhi_epi16(u1, u1)));
+    StoreRgb24(pDestination, r, g, b);
+}
+
+// 16 pixels per iteration
+template <YUV422_LAYOUT Layout>
+TARGET_SSE41 void Yuv422RowSse41(const uint8_t *pSource, uint8_t *pDestination, uint32_t pairs)
+{
+    typedef Yuv422Order<Layout> Order;
+    const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+    const __m128i lowWords = _mm_set1_epi32(0x0000FFFF);
+
+    for (; pairs >= 8; pairs -= 8, pSource += 32, pDestination += 48)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource + 16));
+        // luma to the even bytes
+        if (!Order::LUMA_FIRST)
+        {
+            a = _mm_or_si128(_mm_slli_epi16(a, 8), _mm_srli_epi16(a, 8));
+            b = _mm_or_si128(_mm_slli_epi16(b, 8), _mm_srli_epi16(b, 8));
+        }
+
+        __m128i const yA = _mm_and_si128(a, lowBytes);
+        __m128i const yB = _mm_and_si128(b, lowBytes);
+        __m128i const cA = _mm_srli_epi16(a, 8);
+        __m128i const cB = _mm_srli_epi16(b, 8);
+        __m128i const c0 = _mm_packus_epi32(_mm_and_si128(cA, lowWords), _mm_and_si128(cB, lowWords));
+        __m128i const c1 = _mm_packus_epi32(_mm_srli_epi32(cA, 16), _mm_srli_epi32(cB, 16));
+        YuvPairsToRgb24Sse41(yA, yB, Order::SWAP_CHROMA ? c1 : c0, Order::SWAP_CHROMA ? c0 : c1, pDestination);
+    }
+
+    Yuv422RowScalar<Layout>(pSource, pDestination, pairs);
+}
+
+// 16 pixels per iteration
+template <YUV_CHROMA_LAYOUT Layout>
+TARGET_SSE41 void YuvPlanarRowSse41(const uint8_t *pLuma, const uint8_t *pChroma, const uint8_t *pSecondChroma,
+                                    uint8_t *pDestination, uint32_t width)
+{
+    const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+    const __m128i zero = _mm_setzero_si128();
+
+    uint32_t x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i const luma = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pLuma + x));
+        __m128i u, v;
+        if (Layout == YUV_CHROMA_LAYOUT_PLANAR)
+        {
+            u = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pChroma + x / 2)));
+            v = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSecondChroma + x / 2)));
+        }
+        else
+        {
+            __m128i const chroma = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pChroma + x));
+            __m128i const c0 = _mm_and_si128(chroma, lowBytes);
+            __m128i const c1 = _mm_srli_epi16(chroma, 8);
+            u = (Layout == YUV_CHROMA_LAYOUT_VU) ? c1 : c0;
+            v = (Layout == YUV_CHROMA_LAYOUT_VU) ? c0 : c1;
+        }
+
+        YuvPairsToRgb24Sse41(_mm_cvtepu8_epi16(luma), _mm_unpackhi_epi8(luma, zero), u, v,
+                             pDestination + size_t(x) * 3);
+    }
+
+    YuvPlanarRowTail<Layout>(pLuma, pChroma, pSecondChroma, pDestination, width, x);
+}
+
+// This function converts 32 pixels from their luma in 16 bit, pixels 0-15 and
+// 16-31, and the chroma of their 16 pairs in 16 bit, pairs 0-3, 8-11, 4-7 and
+// 12-15. Packing works within the 128 bit lanes, the quarters of the results
+// are put back in order before the store.
+TARGET_AVX2 inline void YuvPairsToRgb24Avx2(__m256i yA, __m256i yB, __m256i u, __m256i v, uint8_t *pDestination)
+{
+    const __m256i offset = _mm256_set1_epi16(128);
+    u = _mm256_sub_epi16(u, offset);
+    v = _mm256_sub_epi16(v, offset);
+
+    __m256i const u1 = _mm256_srai_epi16(_mm256_add_epi16(_mm256_slli_epi16(u, 7), u), 6);
+    __m256i const u3 = _mm256_add_epi16(_mm256_slli_epi16(u, 1), u);
+    __m256i const v3 = _mm256_add_epi16(_mm256_slli_epi16(v, 1), v);
+    __m256i const rg = _mm256_srai_epi16(_mm256_add_epi16(u3, _mm256_slli_epi16(v3, 1)), 3);
+    __m256i const v1 = _mm256_srai_epi16(v3, 1);
+
+    __m256i r = _mm256_packus_epi16(_mm256_add_epi16(yA, _mm256_unpacklo_epi16(v1, v1)),
+                                    _mm256_add_epi16(yB, _mm256_unpackhi_epi16(v1, v1)));
+    __m256i g = _mm256_packus_epi16(_mm256_sub_epi16(yA, _mm256_unpacklo_epi16(rg, rg)),
+                                    _mm256_sub_epi16(yB, _mm256_unpackhi_epi16(rg, rg)));
+    __m256i b = _mm256_packus_epi16(_mm256_add_epi16(yA, _mm256_unpacklo_epi16(u1, u1)),
+                                    _mm256_add_epi16(yB, _mm256_unpackhi_epi16(u1, u1)));
+    // pixels 0-7, 16-23, 8-15, 24-31 to 0-31
+    r = _mm256_permute4x64_epi64(r, 0xD8);
+    g = _mm256_permute4x64_epi64(g, 0xD8);
+    b = _mm256_permute4x64_epi64(b, 0xD8);
+
+    StoreRgb24(pDestination, _mm256_castsi256_si128(r), _mm256_castsi256_si128(g),
+               _mm256_castsi256_si128(b));
+    StoreRgb24(pDestination + 48, _mm256_extracti128_si256(r, 1), _mm256_extracti128_si256(g, 1),
+               _mm256_extracti128_si256(b, 1));
+}
+
+// 32 pixels per iteration
+template <YUV422_LAYOUT Layout>
+TARGET_AVX2 void Yuv422RowAvx2(const uint8_t *pSource, uint8_t *pDestination, uint32_t pairs)
+{
+    typedef Yuv422Order<Layout> Order;
+    const __m256i lowBytes = _mm256_set1_epi16(0x00FF);
+    const __m256i lowWords = _mm256_set1_epi32(0x0000FFFF);
+
+    for (; pairs >= 16; pairs -= 16, pSource += 64, pDestination += 96)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSource));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSource + 32));
+        if (!Order::LUMA_FIRST)
+        {
+            a = _mm256_or_si256(_mm256_slli_epi16(a, 8), _mm256_srli_epi16(a, 8));
+            b = _mm256_or_si256(_mm256_slli_epi16(b, 8), _mm256_srli_epi16(b, 8));
+        }
+
+        __m256i const yA = _mm256_and_si256(a, lowBytes);
+        __m256i const yB = _mm256_and_si256(b, lowBytes);
+        __m256i const cA = _mm256_srli_epi16(a, 8);
+        __m256i const cB = _mm256_srli_epi16(b, 8);
+        __m256i const c0 = _mm256_packus_epi32(_mm256_and_si256(cA, lowWords), _mm256_and_si256(cB, lowWords));
+        __m256i const c1 = _mm256_packus_epi32(_mm256_srli_epi32(cA, 16), _mm256_srli_epi32(cB, 16));
+        YuvPairsToRgb24Avx2(yA, yB, Order::SWAP_CHROMA ? c1 : c0, Order::SWAP_CHROMA ? c0 : c1, pDestination);
+    }
+
+    Yuv422RowScalar<Layout>(pSource, pDestination, pairs);
+}
+
+// 32 pixels per iteration, the chroma is spread to the lanes as YuvPairsToRgb24Avx2 expects it
+template <YUV_CHROMA_LAYOUT Layout>
+TARGET_AVX2 void YuvPlanarRowAvx2(const uint8_t *pLuma, const uint8_t *pChroma, const uint8_t *pSecondChroma,
+                                  uint8_t *pDestination, uint32_t width)
+{
+    const __m256i lowBytes = _mm256_set1_epi16(0x00FF);
+
+    uint32_t x = 0;
+    for (; x + 32 <= width; x += 32)
+    {
+        __m256i const yA = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pLuma + x)));
+        __m256i const yB = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pLuma + x + 16)));
+        __m256i u, v;
+        if (Layout == YUV_CHROMA_LAYOUT_PLANAR)
+        {
+            u = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pChroma + x / 2)));
+            v = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pSecondChroma + x / 2)));
+        }
+        else
+        {
+            __m256i const chroma = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pChroma + x));
+            __m256i const c0 = _mm256_and_si256(chroma, lowBytes);
+            __m256i const c1 = _mm256_srli_epi16(chroma, 8);
+            u = (Layout == YUV_CHROMA_LAYOUT_VU) ? c1 : c0;
+            v = (Layout == YUV_CHROMA_LAYOUT_VU) ? c0 : c1;
+        }
+        // pairs 0-15 to 0-3, 8-11, 4-7, 12-15
+        u = _mm256_permute4x64_epi64(u, 0xD8);
+        v = _mm256_permute4x64_epi64(v, 0xD8);
+
+        YuvPairsToRgb24Avx2(yA, yB, u, v, pDestination + size_t(x) * 3);
+    }
+
+    YuvPlanarRowTail<Layout>(pLuma, pChroma, pSecondChroma, pDestination, width, x);
+}
+
+#endif // PIXELKERNELS_X86
+
+#if defined(PIXELKERNELS_NEON)
+
+// This function computes 8 pixel pairs of one colour channel half
+inline void Yuv422HalfNeon(uint8x8_t y0, uint8x8_t y1, int16x8_t term, bool subtract,
+                           uint8x8_t &even, uint8x8_t &odd)
+{
+    int16x8_t const luma0 = vreinterpretq_s16_u16(vmovl_u8(y0));
+    int16x8_t const luma1 = vreinterpretq_s16_u16(vmovl_u8(y1));
+    even = vqmovun_s16(subtract ? vsubq_s16(luma0, term) : vaddq_s16(luma0, term));
+    odd = vqmovun_s16(subtract ? vsubq_s16(luma1, term) : vaddq_s16(luma1, term));
+}
+
+// 32 pixels per iteration, the structure loads and stores do the (de)interleaving
+template <YUV422_LAYOUT Layout>
+void Yuv422RowNeon(const uint8_t *pSource, uint8_t *pDestination, uint32_t pairs)
+{
+    typedef Yuv422Order<Layout> Order;
+    int16x8_t const offset = vdupq_n_s16(128);
+
+    for (; pairs >= 16; pairs -= 16, pSource += 64, pDestination += 96)
+    {
+        uint8x16x4_t const source = vld4q_u8(pSource);
+        uint8x16_t const y0 = source.val[Order::Y0];
+        uint8x16_t const y1 = source.val[Order::Y1];
+        uint8x16_t const u = source.val[Order::U];
+        uint8x16_t const v = source.val[Order::V];
+
+        uint8x8_t r[4], g[4], b[4];
+        for (int half = 0; half < 2; ++half)
+        {
+            uint8x8_t const u8 = half ? vget_high_u8(u) : vget_low_u8(u);
+            uint8x8_t const v8 = half ? vget_high_u8(v) : vget_low_u8(v);
+            uint8x8_t const y08 = half ? vget_high_u8(y0) : vget_low_u8(y0);
+            uint8x8_t const y18 = half ? vget_high_u8(y1) : vget_low_u8(y1);
+            int16x8_t const du = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u8)), offset);
+            int16x8_t const dv = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v8)), offset);
+
+            int16x8_t const u1 = vshrq_n_s16(vmulq_n_s16(du, 129), 6);
+            int16x8_t const rg = vshrq_n_s16(vaddq_s16(vmulq_n_s16(du, 3), vmulq_n_s16(dv, 6)), 3);
+            int16x8_t const v1 = vshrq_n_s16(vmulq_n_s16(dv, 3), 1);
+
+            Yuv422HalfNeon(y08, y18, v1, false, r[half * 2], r[half * 2 + 1]);
+            Yuv422HalfNeon(y08, y18, rg, true, g[half * 2], g[half * 2 + 1]);
+            Yuv422HalfNeon(y08, y18, u1, false, b[half * 2], b[half * 2 + 1]);
+        }
+
+        // even and odd pixels back in order
+        uint8x16x2_t const red = vzipq_u8(vcombine_u8(r[0], r[2]), vcombine_u8(r[1], r[3]));
+        uint8x16x2_t const green = vzipq_u8(vcombine_u8(g[0], g[2]), vcombine_u8(g[1], g[3]));
+        uint8x16x2_t const blue = vzipq_u8(vcombine_u8(b[0], b[2]), vcombine_u8(b[1], b[3]));
+
+        uint8x16x3_t first = { { red.val[0], green.val[0], blue.val[0] } };
+        uint8x16x3_t second = { { red.val[1], green.val[1], blue.val[1] } };
+        vst3q_u8(pDestination, first);
+        vst3q_u8(pDestination + 48, second);
+    }
+
+    Yuv422RowScalar<Layout>(pSource, pDestination, pairs);
+}
+
+// 16 pixels per iteration
+template <YUV_CHROMA_LAYOUT Layout>
+void YuvPlanarRowNeon(const uint8_t *pLuma, const uint8_t *pChroma, const uint8_t *pSecondChroma,
+                      uint8_t *pDestination, uint32_t width)
+{
+    typedef YuvChromaOrder<Layout> Order;
+    int16x8_t const offset = vdupq_n_s16(128);
+
+    uint32_t x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        // even and odd pixels
+        uint8x8x2_t const luma = vld2_u8(pLuma + x);
+        uint8x8_t u8, v8;
+        if (Layout == YUV_CHROMA_LAYOUT_PLANAR)
+        {
+            u8 = vld1_u8(pChroma + x / 2);
+            v8 = vld1_u8(pSecondChroma + x / 2);
+        }
+        else
+        {
+            uint8x8x2_t const chroma = vld2_u8(pChroma + x);
+            u8 = chroma.val[Order::U];
+            v8 = chroma.val[Order::V];
+        }
+        int16x8_t const du = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u8)), offset);
+        int16x8_t const dv = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v8)), offset);
+
+        int16x8_t const u1 = vshrq_n_s16(vmulq_n_s16(du, 129), 6);
+        int16x8_t const rg = vshrq_n_s16(vaddq_s16(vmulq_n_s16(du, 3), vmulq_n_s16(dv, 6)), 3);
+        int16x8_t const v1 = vshrq_n_s16(vmulq_n_s16(dv, 3), 1);
+
+        uint8x8_t r[2], g[2], b[2];
+        Yuv422HalfNeon(luma.val[0], luma.val[1], v1, false, r[0], r[1]);
+        Yuv422HalfNeon(luma.val[0], luma.val[1], rg, true, g[0], g[1]);
+        Yuv422HalfNeon(luma.val[0], luma.val[1], u1, false, b[0], b[1]);
+
+        // even and odd pixels back in order
+        uint8x8x2_t const red = vzip_u8(r[0], r[1]);
+        uint8x8x2_t const green = vzip_u8(g[0], g[1]);
+        uint8x8x2_t const blue = vzip_u8(b[0], b[1]);
+
+        uint8x16x3_t const rgb = { { vcombine_u8(red.val[0], red.val[1]), vcombine_u8(green.val[0], green.val[1]),
+                                     vcombine_u8(blue.val[0], blue.val[1]) } };
+        vst3q_u8(pDestination + size_t(x) * 3, rgb);
+    }
+
+    YuvPlanarRowTail<Layout>(pLuma, pChroma, pSecondChroma, pDestination, width, x);
+}
+
+#endif // PIXELKERNELS_NEON
+
+typedef void (*Yuv422RowFunc)(const uint8_t *pSource, uint8_t *pDestination, uint32_t pairs);
+
+template <YUV422_LAYOUT Layout>
+Yuv422RowFunc GetYuv422Row(KERNEL_ISA isa)
+{
+    switch (isa)
+    {
+#if defined(PIXELKERNELS_X86)
+        case KERNEL_ISA_AVX2:
+            return Yuv422RowAvx2<Layout>;
+        case KERNEL_ISA_SSE41:
+            return Yuv422RowSse41<Layout>;
+#endif
+#if defined(PIXELKERNELS_NEON)
+        case KERNEL_ISA_NEON:
+            return Yuv422RowNeon<Layout>;
+#endif
+        default:
+            return Yuv422RowScalar<Layout>;
+    }
+}
+
+typedef void (*YuvPlanarRowFunc)(const uint8_t *pLuma, const uint8_t *pChroma, const uint8_t *pSecondChroma,
+                                 uint8_t *pDestination, uint32_t width);
+
+template <YUV_CHROMA_LAYOUT Layout>
+YuvPlanarRowFunc GetYuvPlanarRow(KERNEL_ISA isa)
+{
+    switch (isa)
+    {
+#if defined(PIXELKERNELS_X86)
+        case KERNEL_ISA_AVX2:
+            return YuvPlanarRowAvx2<Layout>;
+        case KERNEL_ISA_SSE41:
+            return YuvPlanarRowSse41<Layout>;
+#endif
+#if defined(PIXELKERNELS_NEON)
+        case KERNEL_ISA_NEON:
+            return YuvPlanarRowNeon<Layout>;
+#endif
+        default:
+            return YuvPlanarRowScalar<Layout>;
+    }
+}
+
+
+// Bayer demosaicing, bilinear as in libv4lconvert. bayer8_to_rgbbgr24 is the
+// scalar version. The vectorized version computes the rows between the two
+// border lines column by column with the same formulas, so both give the same bytes.
+//
+// In the rows between the borders a colour pixel at x takes the mean of its
+// diagonal neighbours and of its cross neighbours (green), a green pixel the
+// mean of the vertical and of the horizontal neighbours, all rounded.
+// The first and the last column have neighbours on one side only.
+
+/* inspired by OpenCV's Bayer decoding */
+void v4lconvert_border_bayer8_line_to_bgr24(const unsigned char *bayer, const unsigned char *adjacent_bayer,
+                                                   unsigned char *bgr, int width, const int start_with_green,
+                                                   const int blue_line)
+{
+    int t0, t1;
+
+    if (start_with_green)
+    {
+        /* First pixel */
+        if (blue_line)
+        {
+            *bgr++ = bayer[1];
+            *bgr++ = bayer[0];
+            *bgr++ = adjacent_bayer[0];
+        }
+        else
+        {
+            *bgr++ = adjacent_bayer[0];
+            *bgr++ = bayer[0];
+            *bgr++ = bayer[1];
+        }
+        /* Second pixel */
+        t0 = (bayer[0] + bayer[2] + adjacent_bayer[1] + 1) / 3;
+        t1 = (adjacent_bayer[0] + adjacent_bayer[2] + 1) >> 1;
+        if (blue_line)
+        {
+            *bgr++ = bayer[1];
+            *bgr++ = t0;
+            *bgr++ = t1;
+        }
+        else
+        {
+            *bgr++ = t1;
+            *bgr++ = t0;
+            *bgr++ = bayer[1];
+        }
+        bayer++;
+        adjacent_bayer++;
+        width -= 2;
+    }
+    else
+    {
+        /* First pixel */
+        t0 = (bayer[1] + adjacent_bayer[0] + 1) >> 1;
+        if (blue_line)
+        {
+            *bgr++ = bayer[0];
+            *bgr++ = t0;
+            *bgr++ = adjacent_bayer[1];
+        }
+        else
+        {
+            *bgr++ = adjacent_bayer[1];
+            *bgr++ = t0;
+            *bgr++ = bayer[0];
+        }
+        width--;
+    }
+
+    if (blue_line)
+    {
+        for (; width > 2; width -= 2)
+        {
+            t0 = (bayer[0] + bayer[2] + 1) >> 1;
+            *bgr++ = t0;
+            *bgr++ = bayer[1];
+            *bgr++ = adjacent_bayer[1];
+            bayer++;
+            adjacent_bayer++;
+
+            t0 = (bayer[0] + bayer[2] + adjacent_bayer[1] + 1) / 3;
+            t1 = (adjacent_bayer[0] + adjacent_bayer[2] + 1) >> 1;
+            *bgr++ = bayer[1];
+            *bgr++ = t0;
+            *bgr++ = t1;
+            bayer++;
+            adjacent_bayer++;
+        }
+    }
+    else
+    {
+        for (; width > 2; width -= 2)
+        {
+            t0 = (bayer[0] + bayer[2] + 1) >> 1;
+            *bgr++ = adjacent_bayer[1];
+            *bgr++ = bayer[1];
+            *bgr++ = t0;
+            bayer++;
+            adjacent_bayer++;
+
+            t0 = (bayer[0] + bayer[2] + adjacent_bayer[1] + 1) / 3;
+            t1 = (adjacent_bayer[0] + adjacent_bayer[2] + 1) >> 1;
+            *bgr++ = t1;
+            *bgr++ = t0;
+            *bgr++ = bayer[1];
+            bayer++;
+            adjacent_bayer++;
+        }
+    }
+
+    if (width == 2)
+    {
+        /* Second to last pixel */
+        t0 = (bayer[0] + bayer[2] + 1) >> 1;
+        if (blue_line)
+        {
+            *bgr++ = t0;
+            *bgr++ = bayer[1];
+            *bgr++ = adjacent_bayer[1];
+        }
+        else
+        {
+            *bgr++ = adjacent_bayer[1];
+            *bgr++ = bayer[1];
+            *bgr++ = t0;
+        }
+        /* Last pixel */
+        t0 = (bayer[1] + adjacent_bayer[2] + 1) >> 1;
+        if (blue_line)
+        {
+            *bgr++ = bayer[2];
+            *bgr++ = t0;
+            *bgr++ = adjacent_bayer[1];
+        }
+        else
+        {
+            *bgr++ = adjacent_bayer[1];
+            *bgr++ = t0;
+            *bgr++ = bayer[2];
+        }
+    }
+    else
+    {
+        /* Last pixel */
+        if (blue_line)
+        {
+            *bgr++ = bayer[0];
+            *bgr++ = bayer[1];
+            *bgr++ = adjacent_bayer[1];
+        }
+        else
+        {
+            *bgr++ = adjacent_bayer[1];
+            *bgr++ = bayer[1];
+            *bgr++ = bayer[0];
+        }
+    }
+}
+
+/* From libdc1394, which on turn was based on OpenCV's Bayer decoding */
+void bayer8_to_rgbbgr24(const unsigned char *bayer, unsigned char *bgr,
+                        int width, int height, const unsigned int stride,
+                        const unsigned int bgr_stride, int start_with_green,
+                        int blue_line)
+{
+    /* render the first line */
+    v4lconvert_border_bayer8_line_to_bgr24(bayer, bayer + stride, bgr, width,
+                                           start_with_green, blue_line);
+    bgr += bgr_stride;
+
+    /* reduce height by 2 because of the special case top/bottom line */
+    for (height -= 2; height; height--)
+    {
+        int t0, t1;
+        unsigned char *const bgr_line = bgr;
+        /* (width - 2) because of the border */
+        const unsigned char *bayer_end = bayer + (width - 2);
+
+        if (start_with_green)
+        {
+
+            t0 = (bayer[1] + bayer[stride * 2 + 1] + 1) >> 1;
+            /* Write first pixel */
+            t1 = (bayer[0] + bayer[stride * 2] + bayer[stride + 1] + 1) / 3;
+            if (blue_line)
+            {
+                *bgr++ = t0;
+                *bgr++ = t1;
+                *bgr++ = bayer[stride];
+            }
+            else
+            {
+                *bgr++ = bayer[stride];
+                *bgr++ = t1;
+                *bgr++ = t0;
+            }
+
+            /* Write second pixel */
+            t1 = (bayer[stride] + bayer[stride + 2] + 1) >> 1;
+            if (blue_line)
+            {
+                *bgr++ = t0;
+                *bgr++ = bayer[stride + 1];
+                *bgr++ = t1;
+            }
+            else
+            {
+                *bgr++ = t1;
+                *bgr++ = bayer[stride + 1];
+                *bgr++ = t0;
+            }
+            bayer++;
+        }
+        else
+        {
+            /* Write first pixel */
+            t0 = (bayer[0] + bayer[stride * 2] + 1) >> 1;
+            if (blue_line)
+            {
+                *bgr++ = t0;
+                *bgr++ = bayer[stride];
+                *bgr++ = bayer[stride + 1];
+            }
+            else
+            {
+                *bgr++ = bayer[stride + 1];
+                *bgr++ = bayer[stride];
+                *bgr++ = t0;
+            }
+        }
+
+        if (blue_line)
+        {
+            for (; bayer <= bayer_end - 2; bayer += 2)
+            {
+                t0 = (bayer[0] + bayer[2] + bayer[stride * 2] +
+                      bayer[stride * 2 + 2] + 2) >>
+                     2;
+                t1 = (bayer[1] + bayer[stride] + bayer[stride + 2] +
+                      bayer[stride * 2 + 1] + 2) >>
+                     2;
+                *bgr++ = t0;
+                *bgr++ = t1;
+                *bgr++ = bayer[stride + 1];
+
+                t0 = (bayer[2] + bayer[stride * 2 + 2] + 1) >> 1;
+                t1 = (bayer[stride + 1] + bayer[stride + 3] + 1) >> 1;
+                *bgr++ = t0;
+                *bgr++ = bayer[stride + 2];
+                *bgr++ = t1;
+            }
+        }
+        else
+        {
+            for (; bayer <= bayer_end - 2; bayer += 2)
+            {
+                t0 = (bayer[0] + bayer[2] + bayer[stride * 2] +
+                      bayer[stride * 2 + 2] + 2) >>
+                     2;
+                t1 = (bayer[1] + bayer[stride] + bayer[stride + 2] +
+                      bayer[stride * 2 + 1] + 2) >>
+                     2;
+                *bgr++ = bayer[stride + 1];
+                *bgr++ = t1;
+                *bgr++ = t0;
+
+                t0 = (bayer[2] + bayer[stride * 2 + 2] + 1) >> 1;
+                t1 = (bayer[stride + 1] + bayer[stride + 3] + 1) >> 1;
+                *bgr++ = t1;
+                *bgr++ = bayer[stride + 2];
+                *bgr++ = t0;
+            }
+        }
+
+        if (bayer < bayer_end)
+        {
+            /* write second to last pixel */
+            t0 = (bayer[0] + bayer[2] + bayer[stride * 2] +
+                  bayer[stride * 2 + 2] + 2) >>
+                 2;
+            t1 = (bayer[1] + bayer[stride] + bayer[stride + 2] +
+                  bayer[stride * 2 + 1] + 2) >>
+                 2;
+            if (blue_line)
+            {
+                *bgr++ = t0;
+                *bgr++ = t1;
+                *bgr++ = bayer[stride + 1];
+            }
+            else
+            {
+                *bgr++ = bayer[stride + 1];
+                *bgr++ = t1;
+                *bgr++ = t0;
+            }
+            /* write last pixel */
+            t0 = (bayer[2] + bayer[stride * 2 + 2] + 1) >> 1;
+            if (blue_line)
+            {
+                *bgr++ = t0;
+                *bgr++ = bayer[stride + 2];
+                *bgr++ = bayer[stride + 1];
+            }
+            else
+            {
+                *bgr++ = bayer[stride + 1];
+                *bgr++ = bayer[stride + 2];
+                *bgr++ = t0;
+            }
+
+            bayer++;
+        }
+        else
+        {
+            /* write last pixel */
+            t0 = (bayer[0] + bayer[stride * 2] + 1) >> 1;
+            t1 = (bayer[1] + bayer[stride * 2 + 1] + bayer[stride] + 1) / 3;
+            if (blue_line)
+            {
+                *bgr++ = t0;
+                *bgr++ = t1;
+                *bgr++ = bayer[stride + 1];
+            }
+            else
+            {
+                *bgr++ = bayer[stride + 1];
+                *bgr++ = t1;
+                *bgr++ = t0;
+            }
+        }
+
+        /* skip 2 border pixels and padding */
+        bayer += (stride - width) + 2;
+        bgr = bgr_line + bgr_stride;
+
+        blue_line = !blue_line;
+        start_with_green = !start_with_green;
+    }
+
+    /* render the last line */
+    v4lconvert_border_bayer8_line_to_bgr24(bayer + stride, bayer, bgr, width,
+                                           !start_with_green, !blue_line);
+}
+
+// Rows of an interior line: above, the line itself and below
+struct BayerRows
+{
+    const uint8_t *pAbove;
+    const uint8_t *pLine;
+    const uint8_t *pBelow;
+};
+
+inline void StorePixel(uint8_t *pDestination, bool blueLine, int first, int green, int last)
+{
+    pDestination[0] = static_cast<uint8_t>(blueLine ? first : last);
+    pDestination[1] = static_cast<uint8_t>(green);
+    pDestination[2] = static_cast<uint8_t>(blueLine ? last : first);
+}
+
+// This function writes the interior columns from..to-1 of an interior line
+void BayerColumnsScalar(const BayerRows &rows, uint8_t *pDestination, uint32_t from, uint32_t to,
+                        uint32_t colourParity, bool blueLine)
+{
+    const uint8_t *a = rows.pAbove;
+    const uint8_t *c = rows.pLine;
+    const uint8_t *b = rows.pBelow;
+
+    for (uint32_t x = from; x < to; ++x)
+    {
+        if ((x & 1) == colourParity)
+        {
+            int const diagonal = (a[x - 1] + a[x + 1] + b[x - 1] + b[x + 1] + 2) >> 2;
+            int const cross = (a[x] + c[x - 1] + c[x + 1] + b[x] + 2) >> 2;
+            StorePixel(pDestination + 3 * x, blueLine, diagonal, cross, c[x]);
+        }
+        else
+        {
+            int const vertical = (a[x] + b[x] + 1) >> 1;
+            int const horizontal = (c[x - 1] + c[x + 1] + 1) >> 1;
+            StorePixel(pDestination + 3 * x, blueLine, vertical, c[x], horizontal);
+        }
+    }
+}
+
+// This function writes the first and the last column of an interior line
+void BayerEdgesScalar(const BayerRows &rows, uint8_t *pDestination, uint32_t width,
+                      uint32_t colourParity, bool blueLine)
+{
+    const uint8_t *a = rows.pAbove;
+    const uint8_t *c = rows.pLine;
+    const uint8_t *b = rows.pBelow;
+
+    if (colourParity == 0)
+    {
+        StorePixel(pDestination, blueLine, (a[1] + b[1] + 1) >> 1, (a[0] + b[0] + c[1] + 1) / 3, c[0]);
+    }
+    else
+    {
+        StorePixel(pDestination, blueLine, (a[0] + b[0] + 1) >> 1, c[0], c[1]);
+    }
+
+    uint32_t const x = width - 1;
+    if ((x & 1) == colourParity)
+    {
+        StorePixel(pDestination + 3 * x, blueLine, (a[x - 1] + b[x - 1] + 1) >> 1, (a[x] + b[x] + c[x - 1] + 1) / 3, c[x]);
+    }
+    else
+    {
+        StorePixel(pDestination + 3 * x, blueLine, (a[x] + b[x] + 1) >> 1, c[x], c[x - 1]);
+    }
+}
+
+// Vectorized interior columns, returns the first column left for BayerColumnsScalar
+typedef uint32_t (*BayerColumnsFunc)(const BayerRows &rows, uint8_t *pDestination, uint32_t from,
+                                     uint32_t width, uint32_t colourParity, bool blueLine);
+
+#if defined(PIXELKERNELS_X86)
+
+// (p + q + r + s + 2) >> 2 of 16 bytes
+TARGET_SSE41 inline __m128i Average4(__m128i p, __m128i q, __m128i r, __m128i s)
+{
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const two = _mm_set1_epi16(2);
+    __m128i const low = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(p, zero), _mm_unpacklo_epi8(q, zero)),
+                                      _mm_add_epi16(_mm_unpacklo_epi8(r, zero), _mm_unpacklo_epi8(s, zero)));
+    __m128i const high = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(p, zero), _mm_unpackhi_epi8(q, zero)),
+                                       _mm_add_epi16(_mm_unpackhi_epi8(r, zero), _mm_unpackhi_epi8(s, zero)));
+    return _mm_packus_epi16(_mm_srli_epi16(_mm_add_epi16(low, two), 2), _mm_srli_epi16(_mm_add_epi16(high, two), 2));
+}
+
+// 16 pixels per iteration, from is odd so the colour pixels are at the same lanes in every iteration
+TARGET_SSE41 uint32_t BayerColumnsSse41(const BayerRows &rows, uint8_t *pDestination, uint32_t from,
+                                        uint32_t width, uint32_t colourParity, bool blueLine)
+{
+    __m128i const colourLanes = (((from & 1) ^ colourParity) == 0) ? _mm_set1_epi16(0x00FF) : _mm_set1_epi16(-256);
+    uint32_t x = from;
+
+    for (; x + 16 <= width - 1; x += 16)
+    {
+        __m128i const am = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows.pAbove + x - 1));
+        __m128i const a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows.pAbove + x));
+        __m128i const ap = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows.pAbove + x + 1));
+        __m128i const cm = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows.pLine + x - 1));
+        __m128i const c0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows.pLine + x));
+        __m128i const cp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows.pLine + x + 1));
+        __m128i const bm = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows.pBelow + x - 1));
+        __m128i const b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows.pBelow + x));
+        __m128i const bp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows.pBelow + x + 1));
+
+        __m128i const diagonal = Average4(am, ap, bm, bp);
+        __m128i const cross = Average4(a0, b0, cm, cp);
+        __m128i const vertical = _mm_avg_epu8(a0, b0);
+        __m128i const horizontal = _mm_avg_epu8(cm, cp);
+
+        __m128i const first = _mm_blendv_epi8(vertical, diagonal, colourLanes);
+        __m128i const green = _mm_blendv_epi8(c0, cross, colourLanes);
+        __m128i const last = _mm_blendv_epi8(horizontal, c0, colourLanes);
+        if (blueLine)
+        {
+            StoreRgb24(pDestination + 3 * x, first, green, last);
+        }
+        else
+        {
+            StoreRgb24(pDestination + 3 * x, last, green, first);
+        }
+    }
+
+    return x;
+}
+
+TARGET_AVX2 inline __m256i Average4(__m256i p, __m256i q, __m256i r, __m256i s)
+{
+    __m256i const zero = _mm256_setzero_si256();
+    __m256i const two = _mm256_set1_epi16(2);
+    __m256i const low = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpacklo_epi8(p, zero), _mm256_unpacklo_epi8(q, zero)),
+                                         _mm256_add_epi16(_mm256_unpacklo_epi8(r, zero), _mm256_unpacklo_epi8(s, zero)));
+    __m256i const high = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpackhi_epi8(p, zero), _mm256_unpackhi_epi8(q, zero)),
+                                          _mm256_add_epi16(_mm256_unpackhi_epi8(r, zero), _mm256_unpackhi_epi8(s, zero)));
+    // unpacking and packing within the same lanes keeps the order
+    return _mm256_packus_epi16(_mm256_srli_epi16(_mm256_add_epi16(low, two), 2),
+                               _mm256_srli_epi16(_mm256_add_epi16(high, two), 2));
+}
+
+// 32 pixels per iteration, the rest of 16 or more pixels is left to the SSE4.1 kernel
+TARGET_AVX2 uint32_t BayerColumnsAvx2(const BayerRows &rows, uint8_t *pDestination, uint32_t from,
+                                      uint32_t width, uint32_t colourParity, bool blueLine)
+{
+    __m256i const colourLanes = (((from & 1) ^ colourParity) == 0) ? _mm256_set1_epi16(0x00FF) : _mm256_set1_epi16(-256);
+    uint32_t x = from;
+
+    for (; x + 32 <= width - 1; x += 32)
+    {
+        __m256i const am = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows.pAbove + x - 1));
+        __m256i const a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows.pAbove + x));
+        __m256i const ap = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows.pAbove + x + 1));
+        __m256i const cm = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows.pLine + x - 1));
+        __m256i const c0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows.pLine + x));
+        __m256i const cp = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows.pLine + x + 1));
+        __m256i const bm = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows.pBelow + x - 1));
+        __m256i const b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows.pBelow + x));
+        __m256i const bp = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows.pBelow + x + 1));
+
+        __m256i const diagonal = Average4(am, ap, bm, bp);
+        __m256i const cross = Average4(a0, b0, cm, cp);
+        __m256i const vertical = _mm256_avg_epu8(a0, b0);
+        __m256i const horizontal = _mm256_avg_epu8(cm, cp);
+
+        __m256i const first = _mm256_blendv_epi8(vertical, diagonal, colourLanes);
+        __m256i const green = _mm256_blendv_epi8(c0, cross, colourLanes);
+        __m256i const last = _mm256_blendv_epi8(horizontal, c0, colourLanes);
+        __m256i const red = blueLine ? first : last;
+        __m256i const blue = blueLine ? last : first;
+        StoreRgb24(pDestination + 3 * x, _mm256_castsi256_si128(red), _mm256_castsi256_si128(green),
+                   _mm256_castsi256_si128(blue));
+        StoreRgb24(pDestination + 3 * x + 48, _mm256_extracti128_si256(red, 1), _mm256_extracti128_si256(green, 1),
+                   _mm256_extracti128_si256(blue, 1));
+    }
+
+    return BayerColumnsSse41(rows, pDestination, x, width, colourParity, blueLine);
+}
+
+#endif // PIXELKERNELS_X86
+
+#if defined(PIXELKERNELS_NEON)
+
+// (p + q + r + s + 2) >> 2 of 16 bytes
+inline uint8x16_t Average4(uint8x16_t p, uint8x16_t q, uint8x16_t r, uint8x16_t s)
+{
+    uint16x8_t const low = vaddq_u16(vaddl_u8(vget_low_u8(p), vget_low_u8(q)), vaddl_u8(vget_low_u8(r), vget_low_u8(s)));
+    uint16x8_t const high = vaddq_u16(vaddl_u8(vget_high_u8(p), vget_high_u8(q)), vaddl_u8(vget_high_u8(r), vget_high_u8(s)));
+    return vcombine_u8(vrshrn_n_u16(low, 2), vrshrn_n_u16(high, 2));
+}
+
+// 16 pixels per iteration
+uint32_t BayerColumnsNeon(const BayerRows &rows, uint8_t *pDestination, uint32_t from,
+                          uint32_t width, uint32_t colourParity, bool blueLine)
+{
+    uint8x16_t const colourLanes = vreinterpretq_u8_u16(vdupq_n_u16((((from & 1) ^ colourParity) == 0) ? 0x00FF : 0xFF00));
+    uint32_t x = from;
+
+    for (; x + 16 <= width - 1; x += 16)
+    {
+        uint8x16_t const am = vld1q_u8(rows.pAbove + x - 1);
+        uint8x16_t const a0 = vld1q_u8(rows.pAbove + x);
+        uint8x16_t const ap = vld1q_u8(rows.pAbove + x + 1);
+        uint8x16_t const cm = vld1q_u8(rows.pLine + x - 1);
+        uint8x16_t const c0 = vld1q_u8(rows.pLine + x);
+        uint8x16_t const cp = vld1q_u8(rows.pLine + x + 1);
+        uint8x16_t const bm = vld1q_u8(rows.pBelow + x - 1);
+        uint8x16_t const b0 = vld1q_u8(rows.pBelow + x);
+        uint8x16_t const bp = vld1q_u8(rows.pBelow + x + 1);
+
+        uint8x16_t const diagonal = Average4(am, ap, bm, bp);
+        uint8x16_t const cross = Average4(a0, b0, cm, cp);
+        uint8x16_t const vertical = vrhaddq_u8(a0, b0);
+        uint8x16_t const horizontal = vrhaddq_u8(cm, cp);
+
+        uint8x16_t const first = vbslq_u8(colourLanes, diagonal, vertical);
+        uint8x16_t const green = vbslq_u8(colourLanes, cross, c0);
+        uint8x16_t const last = vbslq_u8(colourLanes, c0, horizontal);
+        uint8x16x3_t const pixels = { { blueLine ? first : last, green, blueLine ? last : first } };
+        vst3q_u8(pDestination + 3 * x, pixels);
+    }
+
+    return x;
+}
+
+#endif // PIXELKERNELS_NEON
+
+BayerColumnsFunc GetBayerColumns(KERNEL_ISA isa)
+{
+    switch (isa)
+    {
+#if defined(PIXELKERNELS_X86)
+        case KERNEL_ISA_AVX2:
+            return BayerColumnsAvx2;
+        case KERNEL_ISA_SSE41:
+            return BayerColumnsSse41;
+#endif
+#if defined(PIXELKERNELS_NEON)
+        case KERNEL_ISA_NEON:
+            return BayerColumnsNeon;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+} // namespace
+
+KERNEL_ISA GetDetectedIsa()
+{
+    static KERNEL_ISA const detected = DetectIsa();
+    return detected;
+}
+
+KERNEL_ISA GetActiveIsa()
+{
+    int isa = s_ActiveIsa.load(std::memory_order_relaxed);
+    if (isa < 0)
+    {
+        // several threads may select at once, they all come to the same result
+        int expected = -1;
+        s_ActiveIsa.compare_exchange_strong(expected, SelectIsa());
+        isa = s_ActiveIsa.load(std::memory_order_relaxed);
+    }
+
+    return static_cast<KERNEL_ISA>(isa);
+}
+
+int SetActiveIsa(KERNEL_ISA isa)
+{
+    if (!IsSupported(isa))
+    {
+        return -1;
+    }
+
+    s_ActiveIsa = isa;
+
+    return 0;
+}
+
+const char* GetIsaName(KERNEL_ISA isa)
+{
+    if (isa < 0 || isa >= KERNEL_ISA_COUNT)
+    {
+        return "unknown";
+    }
+
+    return ISA_NAMES[isa];
+}
+
+void Yuv422ToRgb24(const uint8_t *pSource, uint32_t sourceBytesPerLine,
+                   uint8_t *pDestination, uint32_t destinationBytesPerLine,
+                   uint32_t width, uint32_t height, YUV422_LAYOUT layout)
+{
+    KERNEL_ISA const isa = GetActiveIsa();
+    Yuv422RowFunc row;
+    switch (layout)
+    {
+        case YUV422_LAYOUT_UYVY:
+            row = GetYuv422Row<YUV422_LAYOUT_UYVY>(isa);
+            break;
+        case YUV422_LAYOUT_VYUY:
+            row = GetYuv422Row<YUV422_LAYOUT_VYUY>(isa);
+            break;
+        default:
+            row = GetYuv422Row<YUV422_LAYOUT_YUYV>(isa);
+            break;
+    }
+
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        row(pSource + size_t(y) * sourceBytesPerLine, pDestination + size_t(y) * destinationBytesPerLine, width / 2);
+    }
+}
+
+void YuvPlanarLineToRgb24(const uint8_t *pLuma, const uint8_t *pChroma, const uint8_t *pSecondChroma,
+                          uint8_t *pDestination, uint32_t width, YUV_CHROMA_LAYOUT layout)
+{
+    KERNEL_ISA const isa = GetActiveIsa();
+    switch (layout)
+    {
+        case YUV_CHROMA_LAYOUT_UV:
+            GetYuvPlanarRow<YUV_CHROMA_LAYOUT_UV>(isa)(pLuma, pChroma, pSecondChroma, pDestination, width);
+            break;
+        case YUV_CHROMA_LAYOUT_VU:
+            GetYuvPlanarRow<YUV_CHROMA_LAYOUT_VU>(isa)(pLuma, pChroma, pSecondChroma, pDestination, width);
+            break;
+        default:
+            GetYuvPlanarRow<YUV_CHROMA_LAYOUT_PLANAR>(isa)(pLuma, pChroma, pSecondChroma, pDestination, width);
+            break;
+    }
+}
+
+void Bayer8ToRgb24(const uint8_t *pSource, uint32_t sourceBytesPerLine,
+                   uint8_t *pDestination, uint32_t destinationBytesPerLine,
+                   uint32_t width, uint32_t height, BAYER_ORDER order)
+{
+    // the border lines need three columns
+    if (width < 3 || height < 2)
+    {
+        return;
+    }
+
+    if (GetBayerColumns(GetActiveIsa()) == nullptr || width < 4 || height < 3)
+    {
+        bayer8_to_rgbbgr24(pSource, pDestination, width, height, sourceBytesPerLine, destinationBytesPerLine,
+                           order == BAYER_ORDER_GBRG || order == BAYER_ORDER_GRBG,
+                           order != BAYER_ORDER_BGGR && order != BAYER_ORDER_GBRG);
+        return;
+    }
+
+    Bayer8ToRgb24Lines(pSource, sourceBytesPerLine, pDestination, destinationBytesPerLine, width, height, order, 0, height);
+}
+
+void Bayer8ToRgb24Lines(const uint8_t *pSource, uint32_t sourceBytesPerLine,
+                        uint8_t *pDestination, uint32_t destinationBytesPerLine,
+                        uint32_t width, uint32_t height, BAYER_ORDER order,
+                        uint32_t firstLine, uint32_t lineCount)
+{
+    if (firstLine >= height)
+    {
+        return;
+    }
+    uint32_t const endLine = firstLine + std::min(lineCount, height - firstLine);
+
+    for (uint32_t y = firstLine; y < endLine; ++y)
+    {
+        const uint8_t *const pLine = pSource + size_t(y) * sourceBytesPerLine;
+        Bayer8LineToRgb24((y > 0) ? pLine - sourceBytesPerLine : nullptr, pLine,
+                          (y + 1 < height) ? pLine + sourceBytesPerLine : nullptr,
+                          pDestination + size_t(y) * destinationBytesPerLine, width, height, y, order);
+    }
+}
+
+void Bayer8LineToRgb24(const uint8_t *pAbove, const uint8_t *pLine, const uint8_t *pBelow,
+                       uint8_t *pDestination, uint32_t width, uint32_t height,
+                       uint32_t line, BAYER_ORDER order)
+{
+    // the border lines need three columns
+    if (width < 3 || height < 2 || line >= height)
+    {
+        return;
+    }
+
+    // flags of the first line, every further line toggles them as bayer8_to_rgbbgr24 does
+    bool const startWithGreen = (order == BAYER_ORDER_GBRG || order == BAYER_ORDER_GRBG);
+    bool const blueLine = (order != BAYER_ORDER_BGGR && order != BAYER_ORDER_GBRG);
+
+    if (line == 0)
+    {
+        v4lconvert_border_bayer8_line_to_bgr24(pLine, pBelow, pDestination, width, startWithGreen, blueLine);
+        return;
+    }
+    if (line == height - 1)
+    {
+        bool const toggled = ((height - 2) & 1) != 0;
+        v4lconvert_border_bayer8_line_to_bgr24(pLine, pAbove, pDestination, width,
+                                               startWithGreen == toggled, blueLine == toggled);
+        return;
+    }
+
+    BayerRows const rows = { pAbove, pLine, pBelow };
+    // the flags of the line above, a line below a line starting with green starts with a colour
+    bool const toggled = ((line - 1) & 1) != 0;
+    uint32_t const colourParity = (startWithGreen != toggled) ? 0 : 1;
+    bool const lineBlue = (blueLine != toggled);
+
+    BayerColumnsFunc const columns = GetBayerColumns(GetActiveIsa());
+    BayerEdgesScalar(rows, pDestination, width, colourParity, lineBlue);
+    uint32_t const x = (columns != nullptr) ? columns(rows, pDestination, 1, width, colourParity, lineBlue) : 1;
+    BayerColumnsScalar(rows, pDestination, x, width - 1, colourParity, lineBlue);
+}
+
+} // namespace pixelkernels
@@ -0,0 +1,120 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#include "PlaneLayout.h"
+
+#include <linux/videodev2.h>
+
+namespace planelayout
+{
+
+bool GetPlanarFormat(uint32_t pixelFormat, PlanarFormat &format)
+{
+    switch (pixelFormat)
+    {
+        case V4L2_PIX_FMT_NV12:    format = { 2, 1, 1, false }; return true;
+        case V4L2_PIX_FMT_NV21:    format = { 2, 1, 1, true };  return true;
+        case V4L2_PIX_FMT_NV16:    format = { 2, 1, 0, false }; return true;
+        case V4L2_PIX_FMT_NV61:    format = { 2, 1, 0, true };  return true;
+        // YUV420 stores U before V, the former v4lconvert call passed it as yvu
+        // and thereby swapped the chroma planes
+        case V4L2_PIX_FMT_YUV420:  format = { 3, 1, 1, false }; return true;
+        case V4L2_PIX_FMT_YVU420:  format = { 3, 1, 1, true };  return true;
+        case V4L2_PIX_FMT_NV12M:   format = { 2, 2, 1, false }; return true;
+        case V4L2_PIX_FMT_NV21M:   format = { 2, 2, 1, true };  return true;
+        case V4L2_PIX_FMT_NV16M:   format = { 2, 2, 0, false }; return true;
+        case V4L2_PIX_FMT_NV61M:   format = { 2, 2, 0, true };  return true;
+        case V4L2_PIX_FMT_YUV420M: format = { 3, 3, 1, false }; return true;
+        case V4L2_PIX_FMT_YVU420M: format = { 3, 3, 1, true };  return true;
+        default:
+            return false;
+    }
+}
+
+uint32_t GetSinglePlaneFormat(uint32_t pixelFormat)
+{
+    switch (pixelFormat)
+    {
+        case V4L2_PIX_FMT_NV12M:   return V4L2_PIX_FMT_NV12;
+        case V4L2_PIX_FMT_NV21M:   return V4L2_PIX_FMT_NV21;
+        case V4L2_PIX_FMT_NV16M:   return V4L2_PIX_FMT_NV16;
+        case V4L2_PIX_FMT_NV61M:   return V4L2_PIX_FMT_NV61;
+        case V4L2_PIX_FMT_YUV420M: return V4L2_PIX_FMT_YUV420;
+        case V4L2_PIX_FMT_YVU420M: return V4L2_PIX_FMT_YVU420;
+        default:
+            return pixelFormat;
+    }
+}
+
+int Split(uint32_t pixelFormat, uint32_t height,
+          const FramePlane *pMemoryPlanes, uint32_t memoryPlaneCount,
+          FramePlane *pPlanes, uint32_t &planeCount)
+{
+    PlanarFormat format;
+    if (memoryPlaneCount == 0)
+    {
+        return -1;
+    }
+    if (!GetPlanarFormat(pixelFormat, format))
+    {
+        pPlanes[0] = pMemoryPlanes[0];
+        planeCount = 1;
+        return 0;
+    }
+
+    // every colour plane in its own memory plane, the driver knows the strides
+    if (format.memoryPlaneCount > 1)
+    {
+        if (memoryPlaneCount < format.planeCount)
+        {
+            return -1;
+        }
+        for (uint32_t i = 0; i < format.planeCount; ++i)
+        {
+            pPlanes[i] = pMemoryPlanes[i];
+        }
+        planeCount = format.planeCount;
+        return 0;
+    }
+
+    // all colour planes in one buffer, the chroma strides follow from the luma stride
+    uint32_t const lumaBytesPerLine = pMemoryPlanes[0].bytesPerLine;
+    uint32_t const chromaHeight = (height + (1u << format.chromaVerticalShift) - 1) >> format.chromaVerticalShift;
+    uint32_t const chromaBytesPerLine = (format.planeCount == 2) ? lumaBytesPerLine : lumaBytesPerLine / 2;
+
+    size_t const lumaLength = size_t(lumaBytesPerLine) * height;
+    size_t const chromaLength = size_t(chromaBytesPerLine) * chromaHeight;
+    if (lumaBytesPerLine == 0 || lumaLength + (format.planeCount - 1) * chromaLength > pMemoryPlanes[0].length)
+    {
+        return -1;
+    }
+
+    uint8_t const* pData = pMemoryPlanes[0].data;
+    pPlanes[0] = { pData, lumaLength, lumaBytesPerLine };
+    pData += lumaLength;
+    for (uint32_t i = 1; i < format.planeCount; ++i)
+    {
+        pPlanes[i] = { pData, chromaLength, chromaBytesPerLine };
+        pData += chromaLength;
+    }
+    planeCount = format.planeCount;
+
+    return 0;
+}
+
+} // namespace planelayout
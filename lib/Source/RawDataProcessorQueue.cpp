@@ -0,0 +1,180 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#include "RawDataProcessorQueue.h"
+#include "ThreadConfig.h"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+
+RawDataProcessorQueue::RawDataProcessorQueue(ProcessorFunc processor, PROCESSOR_QUEUE_POLICY policy, uint32_t capacity)
+    : m_Processor(std::move(processor))
+    , m_Policy(policy)
+    , m_Capacity(policy == PROCESSOR_QUEUE_LATEST_ONLY ? 1 : std::max<uint32_t>(capacity, 1))
+    , m_StopWorker(false)
+    , m_Interrupted(false)
+    , m_MaxQueueDepth(0)
+    , m_Processed(0)
+    , m_Dropped(0)
+{
+    if (m_Policy != PROCESSOR_QUEUE_SYNCHRONOUS)
+    {
+        m_pWorkerThread = std::make_unique<std::thread>([this] {
+            WorkerMain();
+        });
+    }
+}
+
+RawDataProcessorQueue::~RawDataProcessorQueue()
+{
+    if (m_pWorkerThread)
+    {
+        {
+            QMutexLocker locker(&m_QueueMutex);
+            m_StopWorker = true;
+            m_FrameAvailable.wakeAll();
+            m_SpaceAvailable.wakeAll();
+        }
+        m_pWorkerThread->join();
+    }
+
+    Flush();
+}
+
+void RawDataProcessorQueue::Push(BufferWrapper const& buffer, FrameLease lease)
+{
+    if (m_Policy == PROCESSOR_QUEUE_SYNCHRONOUS)
+    {
+        m_Processor(buffer, std::move(lease));
+        m_Processed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // released outside of the lock, requeuing a buffer may take a while
+    FrameLease droppedLease;
+    {
+        QMutexLocker locker(&m_QueueMutex);
+
+        if (m_Queue.size() >= m_Capacity)
+        {
+            if (m_Policy == PROCESSOR_QUEUE_BLOCK)
+            {
+                while (m_Queue.size() >= m_Capacity && !m_StopWorker && !m_Interrupted)
+                {
+                    m_SpaceAvailable.wait(&m_QueueMutex);
+                }
+            }
+            else
+            {
+                droppedLease = std::move(m_Queue.front().lease);
+                m_Queue.pop_front();
+                m_Dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        if (m_StopWorker || m_Interrupted)
+        {
+            m_Dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        m_Queue.push_back(QueuedFrame { buffer, std::move(lease) });
+
+        uint32_t const depth = static_cast<uint32_t>(m_Queue.size());
+        if (depth > m_MaxQueueDepth.load(std::memory_order_relaxed))
+        {
+            m_MaxQueueDepth.store(depth, std::memory_order_relaxed);
+        }
+
+        m_FrameAvailable.wakeOne();
+    }
+}
+
+void RawDataProcessorQueue::Flush()
+{
+    std::deque<QueuedFrame> dropped;
+    {
+        QMutexLocker locker(&m_QueueMutex);
+        dropped.swap(m_Queue);
+        m_Dropped.fetch_add(dropped.size(), std::memory_order_relaxed);
+        m_SpaceAvailable.wakeAll();
+    }
+}
+
+void RawDataProcessorQueue::Interrupt()
+{
+    QMutexLocker locker(&m_QueueMutex);
+    m_Interrupted = true;
+    m_SpaceAvailable.wakeAll();
+}
+
+void RawDataProcessorQueue::Resume()
+{
+    QMutexLocker locker(&m_QueueMutex);
+    m_Interrupted = false;
+}
+
+void RawDataProcessorQueue::WorkerMain()
+{
+    threadconfig::ApplyToCurrentThread(THREAD_ROLE_PROCESSOR);
+
+    m_QueueMutex.lock();
+    while (!m_StopWorker)
+    {
+        if (m_Queue.empty())
+        {
+            m_FrameAvailable.wait(&m_QueueMutex);
+            continue;
+        }
+
+        QueuedFrame frame = std::move(m_Queue.front());
+        m_Queue.pop_front();
+        m_SpaceAvailable.wakeOne();
+        m_QueueMutex.unlock();
+
+        m_Processor(frame.buffer, std::move(frame.lease));
+        m_Processed.fetch_add(1, std::memory_order_relaxed);
+
+        m_QueueMutex.lock();
+    }
+    m_QueueMutex.unlock();
+}
+
+RawDataProcessorStatistics RawDataProcessorQueue::GetStatistics() const
+{
+    RawDataProcessorStatistics statistics;
+    statistics.policy = m_Policy;
+    statistics.capacity = (m_Policy == PROCESSOR_QUEUE_SYNCHRONOUS) ? 0 : m_Capacity;
+    {
+        QMutexLocker locker(&m_QueueMutex);
+        statistics.queueDepth = static_cast<uint32_t>(m_Queue.size());
+    }
+    statistics.maxQueueDepth = m_MaxQueueDepth.load(std::memory_order_relaxed);
+    statistics.processed = m_Processed.load(std::memory_order_relaxed);
+    statistics.dropped = m_Dropped.load(std::memory_order_relaxed);
+
+    return statistics;
+}
+
+void RawDataProcessorQueue::ResetStatistics()
+{
+    m_MaxQueueDepth.store(0, std::memory_order_relaxed);
+    m_Processed.store(0, std::memory_order_relaxed);
+    m_Dropped.store(0, std::memory_order_relaxed);
+}
@@ -1,19 +1,17 @@
 #include "SoftwareRenderSystem.h"
 #include "ImageTransform.h"
+#include "ThreadConfig.h"
 #include <QWheelEvent>
 #include <QGraphicsPixmapItem>
 #include <QToolTip>
 #include <QMutexLocker>
 
 
-static void DoNothing() {}
-
 
 SoftwareRenderSystem::SoftwareRenderSystem()
   : scrollArea(new QScrollArea)
   , layout(new QBoxLayout(QBoxLayout::LeftToRight))
   , widget(new SoftwareRenderWidget)
-  , nextDoneCallback(&DoNothing)
 {
     scrollArea->setLayout(layout);
     scrollArea->setStyleSheet("QScrollArea{border:none;}");
@@ -33,6 +31,8 @@ SoftwareRenderSystem::~SoftwareRenderSystem() {
     stopConversionThread = true;
     newFrameAvailable.wakeAll();
     conversionThread->join();
+    // the widget is deleted after the lease slots, its image must not wrap a buffer anymore
+    widget->DetachImage();
 }
 
 void SoftwareRenderSystem::ZoomRequestedByWidget(QPointF center, bool zoomIn) {
@@ -44,6 +44,8 @@ void SoftwareRenderSystem::ImageClicked(QPointF point) {
 }
 
 void SoftwareRenderSystem::ConversionThreadMain() {
+    threadconfig::ApplyToCurrentThread(THREAD_ROLE_CONVERSION);
+
     while(!stopConversionThread) {
         frameAvailableMutex.lock();
         while(!bufferAvailable) { // avoid lost or spurious wakeup
@@ -55,22 +57,59 @@ void SoftwareRenderSystem::ConversionThreadMain() {
         }
 
         BufferWrapper const buffer = nextBuffer;
-        auto doneCallback = nextDoneCallback;
-        nextDoneCallback = &DoNothing;
+        FrameLease lease = std::move(nextLease);
         bufferAvailable = false;
+        converting = true;
         frameAvailableMutex.unlock();
 
-        QImage convertedImage;
-        int result = ImageTransform::ConvertFrame(buffer.data, buffer.length,
-                                              buffer.width, buffer.height, buffer.pixelFormat,
-                                              buffer.payloadSize, buffer.bytesPerLine, convertedImage);
+        uint64_t const conversionStart = LatencyStatistics::Now();
+
+        // formats Qt shows as they are are painted from the buffer itself,
+        // the image holds the lease until the next frame replaces it
+        QImage &convertedImage = NextConvertedImage();
+        uint32_t const index = lease.GetIndex();
+        bool const wrapped = (index < VIDEO_MAX_FRAME &&
+                              ImageTransform::WrapFrame(buffer, lease, wrappedLeases[index], convertedImage) == 0);
+        if (!wrapped) {
+            ImageTransform::ConvertFrame(buffer, convertedImage);
+        }
+        lease.Release();
+
+        uint64_t const conversionEnd = LatencyStatistics::Now();
+        if(buffer.latencyStatistics) {
+            buffer.latencyStatistics->Record(LATENCY_DISPATCH_TO_CONVERSION, buffer.timestamps.dispatched, conversionStart);
+            buffer.latencyStatistics->Record(LATENCY_CONVERSION, conversionStart, conversionEnd);
+        }
 
-        auto pixmap = QPixmap::fromImage(convertedImage);
-        widget->SetPixmap(pixmap);
-        renderFPS.trigger();
+        frameAvailableMutex.lock();
+        // ReleaseFrames ran meanwhile, the image must not keep the buffer
+        if (!releasingFrames) {
+            widget->SetImage(convertedImage);
+            renderFPS.trigger();
+            if(buffer.latencyStatistics) {
+                buffer.latencyStatistics->Record(LATENCY_DRIVER_TO_DISPLAY, buffer.timestamps.Origin(), LatencyStatistics::Now());
+            }
+        }
+        // a wrapped frame must not keep its buffer, a converted image is kept for reuse
+        if (wrapped) {
+            convertedImage = QImage();
+        }
+        converting = false;
+        frameConverted.wakeAll();
+        frameAvailableMutex.unlock();
+    }
+}
 
-        doneCallback();
+QImage& SoftwareRenderSystem::NextConvertedImage() {
+    for (auto &image : convertedImages) {
+        if (image.isDetached()) {
+            return image;
+        }
     }
+
+    // all are held by the widget or not yet allocated, ConvertFrame allocates a new one
+    nextConvertedImage = (nextConvertedImage + 1) % CONVERTED_IMAGE_COUNT;
+    return convertedImages[nextConvertedImage];
 }
 
 void SoftwareRenderSystem::ApplyScale() {
@@ -100,16 +139,32 @@ QWidget* SoftwareRenderSystem::GetWidget() const {
     return scrollArea;
 }
 
-void SoftwareRenderSystem::PassFrame(BufferWrapper const& buffer, std::function<void()> doneCallback) {
+void SoftwareRenderSystem::PassFrame(BufferWrapper const& buffer, FrameLease lease) {
     QMutexLocker locker(&frameAvailableMutex);
+    releasingFrames = false;
     nextBuffer = buffer;
-    // always invoke callback, worker sets it to doNothing if it took ownership of the buffer 
-    nextDoneCallback();
-    nextDoneCallback = doneCallback;
+    // replaces (and thereby releases) a frame the worker has not picked up yet
+    nextLease = std::move(lease);
     bufferAvailable = true;
     newFrameAvailable.wakeAll();
 }
 
+void SoftwareRenderSystem::ReleaseFrames() {
+    {
+        QMutexLocker locker(&frameAvailableMutex);
+        nextLease.Release();
+        bufferAvailable = false;
+        // a frame in conversion is dropped, it may wrap its buffer
+        releasingFrames = true;
+        while (converting) {
+            frameConverted.wait(&frameAvailableMutex);
+        }
+    }
+
+    // the shown image may still wrap a buffer, the stream waits for its lease
+    widget->DetachImage();
+}
+
 bool SoftwareRenderSystem::CanRender(uint32_t pixelFormat) const {
     return ImageTransform::CanConvert(pixelFormat);
 }
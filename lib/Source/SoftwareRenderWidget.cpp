@@ -1,13 +1,37 @@
 #include "SoftwareRenderSystem.h"
 #include <QWheelEvent>
+#include <QMutexLocker>
+#include <QPainter>
+
+void FrameImageItem::SetImage(const QImage &image) {
+    prepareGeometryChange();
+    m_Image = image;
+    update();
+}
+
+const QImage& FrameImageItem::GetImage() const {
+    return m_Image;
+}
+
+QRectF FrameImageItem::boundingRect() const {
+    return QRectF(0, 0, m_Image.width(), m_Image.height());
+}
+
+void FrameImageItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) {
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+    if (!m_Image.isNull()) {
+        painter->drawImage(QPointF(0, 0), m_Image);
+    }
+}
 
 SoftwareRenderWidget::SoftwareRenderWidget(QWidget *parent)
   : QGraphicsView(parent) 
   , m_Scene(new QGraphicsScene)
   {
     setScene(m_Scene);
-    m_Scene->addItem(&m_PixmapItem);
-    connect(this, SIGNAL(SetPixmapSignal(QPixmap)), this, SLOT(OnSetPixmap(QPixmap)));
+    m_Scene->addItem(&m_ImageItem);
+    connect(this, SIGNAL(ImageAvailable()), this, SLOT(OnImageAvailable()));
     setStyleSheet("QGraphicsView {"
                   "  background-color: rgb(19,20,21);"
                   "  border:20px;"
@@ -15,17 +39,46 @@ SoftwareRenderWidget::SoftwareRenderWidget(QWidget *parent)
   }
 
 SoftwareRenderWidget::~SoftwareRenderWidget() {
-    delete m_CurrentPixmap;
 }
 
-void SoftwareRenderWidget::OnSetPixmap(QPixmap pixmap) {
-    m_PixmapItem.setPixmap(pixmap);
-    m_Scene->setSceneRect(0, 0, pixmap.width(), pixmap.height());
+void SoftwareRenderWidget::OnImageAvailable() {
+    QImage image;
+    {
+        QMutexLocker locker(&m_PendingImageMutex);
+        image = std::move(m_PendingImage);
+        m_PendingImage = QImage();
+    }
+    // taken by an earlier signal or dropped by DetachImage
+    if (image.isNull()) {
+        return;
+    }
+
+    // the previous image and with it its buffer lease is released here
+    m_ImageItem.SetImage(image);
+    m_Scene->setSceneRect(0, 0, image.width(), image.height());
     show();
 }
 
-void SoftwareRenderWidget::SetPixmap(QPixmap pixmap) {
-  emit SetPixmapSignal(pixmap);
+void SoftwareRenderWidget::SetImage(const QImage &image) {
+    bool signal;
+    {
+        QMutexLocker locker(&m_PendingImageMutex);
+        signal = m_PendingImage.isNull();
+        m_PendingImage = image;
+    }
+    // one queued signal takes whatever is pending when it is delivered
+    if (signal) {
+        emit ImageAvailable();
+    }
+}
+
+void SoftwareRenderWidget::DetachImage() {
+    {
+        QMutexLocker locker(&m_PendingImageMutex);
+        m_PendingImage = QImage();
+    }
+    // a deep copy, the shown image stays while the stream is stopped
+    m_ImageItem.SetImage(m_ImageItem.GetImage().copy());
 }
 
 void SoftwareRenderWidget::wheelEvent(QWheelEvent *event)
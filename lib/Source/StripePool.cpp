@@ -0,0 +1,171 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#include "StripePool.h"
+#include "ThreadConfig.h"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+
+StripePool::StripePool(uint32_t threadCount)
+    : m_Stop(false)
+{
+    if (threadCount == 0)
+    {
+        threadCount = DefaultThreadCount();
+    }
+
+    // the calling thread of Run is the first one
+    for (uint32_t i = 1; i < threadCount; ++i)
+    {
+        m_Threads.push_back(std::make_unique<std::thread>([this] {
+            WorkerMain();
+        }));
+    }
+}
+
+StripePool::~StripePool()
+{
+    {
+        QMutexLocker locker(&m_Mutex);
+        m_Stop = true;
+        m_JobAvailable.wakeAll();
+    }
+    for (auto &pThread : m_Threads)
+    {
+        pThread->join();
+    }
+}
+
+uint32_t StripePool::DefaultThreadCount()
+{
+    unsigned int const cpuCount = std::thread::hardware_concurrency();
+    return std::max(cpuCount, 2u) - 1;
+}
+
+void StripePool::Run(uint32_t rowCount, uint32_t rowAlignment, const StripeFunc &stripe)
+{
+    uint32_t const threadCount = GetThreadCount();
+    rowAlignment = std::max<uint32_t>(rowAlignment, 1);
+
+    uint32_t stripeCount = std::min(threadCount * STRIPES_PER_THREAD, rowCount / MINIMUM_STRIPE_ROWS);
+    uint32_t stripeRows = 0;
+    if (stripeCount > 1)
+    {
+        stripeRows = (rowCount + stripeCount - 1) / stripeCount;
+        stripeRows = (stripeRows + rowAlignment - 1) / rowAlignment * rowAlignment;
+        stripeCount = (rowCount + stripeRows - 1) / stripeRows;
+    }
+
+    // small frames and a pool without threads are converted in one piece
+    if (threadCount < 2 || stripeCount < 2)
+    {
+        if (rowCount != 0)
+        {
+            stripe(0, rowCount);
+        }
+        return;
+    }
+
+    Job job = { &stripe, rowCount, stripeRows, stripeCount, 0, 0 };
+    uint32_t ownStripes = 0;
+
+    m_Mutex.lock();
+    m_Jobs.push_back(&job);
+    ++m_Statistics.frames;
+    m_Statistics.stripes += stripeCount;
+    for (uint32_t i = 1; i < std::min(stripeCount, threadCount); ++i)
+    {
+        m_JobAvailable.wakeOne();
+    }
+
+    while (job.nextStripe < job.stripeCount)
+    {
+        uint32_t const index = job.nextStripe++;
+        if (job.nextStripe == job.stripeCount)
+        {
+            m_Jobs.erase(std::find(m_Jobs.begin(), m_Jobs.end(), &job));
+        }
+        m_Mutex.unlock();
+
+        RunStripe(job, index);
+
+        m_Mutex.lock();
+        ++job.doneStripes;
+        ++ownStripes;
+    }
+
+    // the job lives on this stack, the pool threads must be done with it
+    while (job.doneStripes < job.stripeCount)
+    {
+        m_StripeDone.wait(&m_Mutex);
+    }
+    m_Statistics.pooledStripes += stripeCount - ownStripes;
+    m_Mutex.unlock();
+}
+
+uint32_t StripePool::GetThreadCount() const
+{
+    return static_cast<uint32_t>(m_Threads.size()) + 1;
+}
+
+StripePoolStatistics StripePool::GetStatistics() const
+{
+    QMutexLocker locker(&m_Mutex);
+    return m_Statistics;
+}
+
+void StripePool::RunStripe(const Job &job, uint32_t stripe)
+{
+    uint32_t const firstRow = stripe * job.stripeRows;
+    (*job.pStripe)(firstRow, std::min(job.stripeRows, job.rowCount - firstRow));
+}
+
+void StripePool::WorkerMain()
+{
+    threadconfig::ApplyToCurrentThread(THREAD_ROLE_CONVERSION);
+
+    m_Mutex.lock();
+    while (!m_Stop)
+    {
+        if (m_Jobs.empty())
+        {
+            m_JobAvailable.wait(&m_Mutex);
+            continue;
+        }
+
+        // every job in the queue has a stripe left
+        Job *pJob = m_Jobs.front();
+        uint32_t const index = pJob->nextStripe++;
+        if (pJob->nextStripe == pJob->stripeCount)
+        {
+            m_Jobs.erase(m_Jobs.begin());
+        }
+        m_Mutex.unlock();
+
+        RunStripe(*pJob, index);
+
+        m_Mutex.lock();
+        if (++pJob->doneStripes == pJob->stripeCount)
+        {
+            m_StripeDone.wakeAll();
+        }
+    }
+    m_Mutex.unlock();
+}
@@ -0,0 +1,443 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#include "ThreadConfig.h"
+#include "LocalMutex.h"
+#include "LocalMutexLockGuard.h"
+#include "Logger.h"
+#include "V4L2Helper.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+namespace threadconfig
+{
+
+namespace
+{
+
+const char* const ROLE_NAMES[THREAD_ROLE_COUNT] = {
+    "capture", "conversion", "events", "logging", "control-polling", "processor"
+};
+
+// shown by top and ps, at most 15 characters
+const char* const THREAD_NAMES[THREAD_ROLE_COUNT] = {
+    "v4l2-capture", "v4l2-convert", "v4l2-events", "v4l2-logger", "v4l2-ctrlpoll", "v4l2-processor"
+};
+
+base::LocalMutex s_Mutex;
+ThreadRoleSettings s_Settings[THREAD_ROLE_COUNT];
+std::string s_EffectiveSettings[THREAD_ROLE_COUNT];
+std::string s_EnvironmentError;
+bool s_EnvironmentLoaded = false;
+std::atomic<bool> s_MemoryLocked{false};
+
+std::vector<std::string> Split(const std::string &text, char separator)
+{
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    std::string part;
+
+    while (std::getline(stream, part, separator))
+    {
+        parts.push_back(part);
+    }
+
+    return parts;
+}
+
+bool ParseInteger(const std::string &text, int &value)
+{
+    char *pEnd = NULL;
+    long const parsed = strtol(text.c_str(), &pEnd, 10);
+    if (text.empty() || *pEnd != '\0')
+    {
+        return false;
+    }
+
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+bool ParseCpuList(const std::string &text, cpu_set_t &cpus)
+{
+    CPU_ZERO(&cpus);
+
+    for (auto const &range : Split(text, ','))
+    {
+        int first = 0;
+        int last = 0;
+        size_t const dash = range.find('-');
+        if (dash == std::string::npos)
+        {
+            if (!ParseInteger(range, first))
+            {
+                return false;
+            }
+            last = first;
+        }
+        else if (!ParseInteger(range.substr(0, dash), first) || !ParseInteger(range.substr(dash + 1), last))
+        {
+            return false;
+        }
+
+        if (first < 0 || last < first || last >= CPU_SETSIZE)
+        {
+            return false;
+        }
+
+        for (int cpu = first; cpu <= last; ++cpu)
+        {
+            CPU_SET(cpu, &cpus);
+        }
+    }
+
+    return true;
+}
+
+std::string FormatCpuList(const cpu_set_t &cpus)
+{
+    std::ostringstream text;
+    int cpu = 0;
+
+    while (cpu < CPU_SETSIZE)
+    {
+        if (!CPU_ISSET(cpu, &cpus))
+        {
+            ++cpu;
+            continue;
+        }
+
+        int last = cpu;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, &cpus))
+        {
+            ++last;
+        }
+
+        text << (text.tellp() > 0 ? "," : "") << cpu;
+        if (last > cpu)
+        {
+            text << "-" << last;
+        }
+        cpu = last + 1;
+    }
+
+    return text.str();
+}
+
+const char* GetPolicyName(int policy)
+{
+    switch (policy)
+    {
+        case SCHED_FIFO:
+            return "SCHED_FIFO";
+        case SCHED_RR:
+            return "SCHED_RR";
+        case SCHED_OTHER:
+            return "SCHED_OTHER";
+        default:
+            return "unknown";
+    }
+}
+
+bool ParseRole(const std::string &text, THREAD_ROLE &role, ThreadRoleSettings &settings, std::string &error)
+{
+    size_t const equals = text.find('=');
+    std::string const name = text.substr(0, equals);
+
+    int index = 0;
+    while (index < THREAD_ROLE_COUNT && name != ROLE_NAMES[index])
+    {
+        ++index;
+    }
+    if (index == THREAD_ROLE_COUNT || equals == std::string::npos)
+    {
+        error = "unknown role '" + name + "'";
+        return false;
+    }
+    role = static_cast<THREAD_ROLE>(index);
+
+    std::vector<std::string> const fields = Split(text.substr(equals + 1), ':');
+    if (fields.empty())
+    {
+        error = "no policy for " + name;
+        return false;
+    }
+
+    settings = ThreadRoleSettings();
+    settings.configured = true;
+
+    if (fields[0] == "fifo")
+    {
+        settings.policy = SCHED_FIFO;
+    }
+    else if (fields[0] == "rr")
+    {
+        settings.policy = SCHED_RR;
+    }
+    else if (fields[0] == "other")
+    {
+        settings.policy = SCHED_OTHER;
+    }
+    else
+    {
+        error = "unknown policy '" + fields[0] + "' for " + name;
+        return false;
+    }
+
+    if (fields.size() > 1 && !fields[1].empty())
+    {
+        int const minimum = settings.policy == SCHED_OTHER ? -20 : sched_get_priority_min(settings.policy);
+        int const maximum = settings.policy == SCHED_OTHER ? 19 : sched_get_priority_max(settings.policy);
+        if (!ParseInteger(fields[1], settings.priority) || settings.priority < minimum || settings.priority > maximum)
+        {
+            error = "priority of " + name + " must be between " + std::to_string(minimum) + " and " + std::to_string(maximum);
+            return false;
+        }
+    }
+    else if (settings.policy != SCHED_OTHER)
+    {
+        settings.priority = sched_get_priority_min(settings.policy);
+    }
+
+    if (fields.size() > 2 && !fields[2].empty() && !ParseCpuList(fields[2], settings.cpus))
+    {
+        error = "invalid cpu list '" + fields[2] + "' for " + name;
+        return false;
+    }
+
+    if (fields.size() > 3)
+    {
+        if (fields[3] != "mlock")
+        {
+            error = "unknown option '" + fields[3] + "' for " + name;
+            return false;
+        }
+        settings.lockMemory = true;
+    }
+
+    if (fields.size() > 4)
+    {
+        error = "too many fields for " + name;
+        return false;
+    }
+
+    return true;
+}
+
+// s_Mutex has to be locked
+int ParseLocked(const std::string &configuration, std::string &error)
+{
+    ThreadRoleSettings settings[THREAD_ROLE_COUNT];
+    std::copy(s_Settings, s_Settings + THREAD_ROLE_COUNT, settings);
+
+    for (auto const &entry : Split(configuration, ';'))
+    {
+        if (entry.empty())
+        {
+            continue;
+        }
+
+        THREAD_ROLE role;
+        ThreadRoleSettings roleSettings;
+        if (!ParseRole(entry, role, roleSettings, error))
+        {
+            return -1;
+        }
+        settings[role] = roleSettings;
+    }
+
+    std::copy(settings, settings + THREAD_ROLE_COUNT, s_Settings);
+
+    return 0;
+}
+
+// s_Mutex has to be locked
+void LoadEnvironmentLocked()
+{
+    if (s_EnvironmentLoaded)
+    {
+        return;
+    }
+    s_EnvironmentLoaded = true;
+
+    if (const char *pConfiguration = getenv("V4L2VIEWER_THREADS"))
+    {
+        std::string error;
+        if (ParseLocked(pConfiguration, error) < 0)
+        {
+            s_EnvironmentError = "V4L2VIEWER_THREADS ignored, " + error;
+        }
+    }
+}
+
+} // namespace
+
+int Parse(const std::string &configuration)
+{
+    std::string error;
+    int result = 0;
+    {
+        base::LocalMutexLockGuard guard(s_Mutex);
+        // explicit settings take precedence over the environment
+        LoadEnvironmentLocked();
+        result = ParseLocked(configuration, error);
+    }
+
+    if (result < 0)
+    {
+        LOG_EX("threadconfig::Parse %s", error.c_str());
+    }
+
+    return result;
+}
+
+ThreadRoleSettings GetSettings(THREAD_ROLE role)
+{
+    base::LocalMutexLockGuard guard(s_Mutex);
+    LoadEnvironmentLocked();
+
+    return s_Settings[role];
+}
+
+int ApplyToCurrentThread(THREAD_ROLE role)
+{
+    std::string report;
+    int const result = ApplyToCurrentThread(role, report);
+
+    LOG_EX("threadconfig::ApplyToCurrentThread %s", report.c_str());
+
+    return result;
+}
+
+int ApplyToCurrentThread(THREAD_ROLE role, std::string &report)
+{
+    ThreadRoleSettings settings;
+    std::string environmentError;
+    {
+        base::LocalMutexLockGuard guard(s_Mutex);
+        LoadEnvironmentLocked();
+        settings = s_Settings[role];
+        environmentError = s_EnvironmentError;
+    }
+
+    int result = 0;
+    std::ostringstream errors;
+    pthread_t const thread = pthread_self();
+    pid_t const threadId = static_cast<pid_t>(syscall(SYS_gettid));
+
+    pthread_setname_np(thread, THREAD_NAMES[role]);
+
+    if (settings.configured)
+    {
+        if (CPU_COUNT(&settings.cpus) > 0)
+        {
+            int const error = pthread_setaffinity_np(thread, sizeof(settings.cpus), &settings.cpus);
+            if (error != 0)
+            {
+                errors << " affinity failed: " << v4l2helper::ConvertErrno2String(error);
+                result = -1;
+            }
+        }
+
+        sched_param parameter;
+        memset(&parameter, 0, sizeof(parameter));
+        parameter.sched_priority = settings.policy == SCHED_OTHER ? 0 : settings.priority;
+        int const error = pthread_setschedparam(thread, settings.policy, &parameter);
+        if (error != 0)
+        {
+            errors << " scheduling failed: " << v4l2helper::ConvertErrno2String(error);
+            result = -1;
+        }
+
+        // on Linux the nice value belongs to the thread, not to the process
+        if (settings.policy == SCHED_OTHER && setpriority(PRIO_PROCESS, threadId, settings.priority) != 0)
+        {
+            errors << " nice failed: " << v4l2helper::ConvertErrno2String(errno);
+            result = -1;
+        }
+
+        if (settings.lockMemory && !s_MemoryLocked.exchange(true))
+        {
+            if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+            {
+                errors << " mlockall failed: " << v4l2helper::ConvertErrno2String(errno);
+                s_MemoryLocked = false;
+                result = -1;
+            }
+        }
+    }
+
+    int policy = SCHED_OTHER;
+    sched_param parameter;
+    memset(&parameter, 0, sizeof(parameter));
+    pthread_getschedparam(thread, &policy, &parameter);
+
+    errno = 0;
+    int const niceValue = getpriority(PRIO_PROCESS, threadId);
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    pthread_getaffinity_np(thread, sizeof(cpus), &cpus);
+
+    std::ostringstream text;
+    text << ROLE_NAMES[role] << " thread " << threadId
+         << (settings.configured ? "" : " (not configured)")
+         << ": policy=" << GetPolicyName(policy)
+         << " priority=" << parameter.sched_priority
+         << " nice=" << niceValue
+         << " cpus=" << FormatCpuList(cpus)
+         << " memory locked=" << (s_MemoryLocked ? "yes" : "no")
+         << errors.str();
+    if (!environmentError.empty())
+    {
+        text << " (" << environmentError << ")";
+    }
+    report = text.str();
+
+    {
+        base::LocalMutexLockGuard guard(s_Mutex);
+        s_EffectiveSettings[role] = report;
+    }
+
+    return result;
+}
+
+std::string GetEffectiveSettings(THREAD_ROLE role)
+{
+    base::LocalMutexLockGuard guard(s_Mutex);
+
+    return s_EffectiveSettings[role];
+}
+
+const char* GetRoleName(THREAD_ROLE role)
+{
+    return role < THREAD_ROLE_COUNT ? ROLE_NAMES[role] : "unknown";
+}
+
+} // namespace threadconfig
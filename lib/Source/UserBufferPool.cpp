@@ -0,0 +1,304 @@
+/* Allied Vision V4L2Viewer - Graphical Video4Linux Viewer Example
+   Copyright (C) 2026 Allied Vision Technologies GmbH
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.  */
+
+
+#include "UserBufferPool.h"
+#include "Logger.h"
+#include "V4L2Helper.h"
+
+#include <errno.h>
+#include <linux/mempolicy.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+namespace
+{
+
+// used if /proc/meminfo can't be read
+const size_t DEFAULT_HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+size_t GetHugePageSize()
+{
+    size_t hugePageSize = DEFAULT_HUGE_PAGE_SIZE;
+
+    FILE *pFile = fopen("/proc/meminfo", "r");
+    if (pFile != NULL)
+    {
+        char line[128];
+        unsigned long kiloBytes = 0;
+        while (fgets(line, sizeof(line), pFile) != NULL)
+        {
+            if (sscanf(line, "Hugepagesize: %lu kB", &kiloBytes) == 1)
+            {
+                hugePageSize = kiloBytes * 1024;
+                break;
+            }
+        }
+        fclose(pFile);
+    }
+
+    return hugePageSize;
+}
+
+size_t RoundUp(size_t value, size_t alignment)
+{
+    return ((value + alignment - 1) / alignment) * alignment;
+}
+
+} // namespace
+
+UserBufferPool::UserBufferPool()
+    : m_HugePages(false)
+    , m_LockMemory(false)
+    , m_NumaNode(-1)
+    , m_BufferStride(0)
+{
+}
+
+UserBufferPool::~UserBufferPool()
+{
+    Free();
+}
+
+void UserBufferPool::SetHugePages(bool hugePages)
+{
+    m_HugePages = hugePages;
+}
+
+void UserBufferPool::SetLockMemory(bool lockMemory)
+{
+    m_LockMemory = lockMemory;
+}
+
+void UserBufferPool::SetNumaNode(int numaNode)
+{
+    m_NumaNode = numaNode;
+}
+
+int UserBufferPool::Allocate(uint32_t bufferCount, size_t bufferSize)
+{
+    Free();
+
+    if (bufferCount == 0 || bufferSize == 0)
+    {
+        return -1;
+    }
+
+    size_t const pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    // page aligned buffers also satisfy the 128 byte alignment the drivers ask for
+    m_BufferStride = RoundUp(bufferSize, pageSize);
+
+    return MapBuffers(bufferCount);
+}
+
+int UserBufferPool::Reserve(uint32_t bufferCount)
+{
+    if (m_BufferStride == 0)
+    {
+        return -1;
+    }
+    if (bufferCount <= m_Buffers.size())
+    {
+        return 0;
+    }
+
+    return MapBuffers(bufferCount - static_cast<uint32_t>(m_Buffers.size()));
+}
+
+int UserBufferPool::MapBuffers(uint32_t bufferCount)
+{
+    size_t const totalSize = m_BufferStride * bufferCount;
+    Mapping mapping = { NULL, 0, false, false };
+
+    void *pMemory = MAP_FAILED;
+    if (m_HugePages)
+    {
+        size_t const hugeSize = RoundUp(totalSize, GetHugePageSize());
+        pMemory = mmap(NULL, hugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (pMemory != MAP_FAILED)
+        {
+            mapping.size = hugeSize;
+            mapping.hugePages = true;
+        }
+        else
+        {
+            LOG_EX("UserBufferPool::MapBuffers no huge pages reserved for %zu bytes, errno=%d=%s, using transparent huge pages",
+                   hugeSize, errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        }
+    }
+
+    if (pMemory == MAP_FAILED)
+    {
+        pMemory = mmap(NULL, totalSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (pMemory == MAP_FAILED)
+        {
+            LOG_EX("UserBufferPool::MapBuffers mmap of %zu bytes failed, errno=%d=%s",
+                   totalSize, errno, v4l2helper::ConvertErrno2String(errno).c_str());
+            return -1;
+        }
+        mapping.size = totalSize;
+
+        if (m_HugePages)
+        {
+            madvise(pMemory, mapping.size, MADV_HUGEPAGE);
+        }
+    }
+
+    mapping.pMemory = static_cast<uint8_t*>(pMemory);
+
+    // has to happen before the first touch, which places the pages
+    if (m_NumaNode >= 0 && m_NumaNode < static_cast<int>(8 * sizeof(unsigned long)))
+    {
+        unsigned long nodeMask = 1UL << m_NumaNode;
+        if (syscall(SYS_mbind, mapping.pMemory, mapping.size, MPOL_PREFERRED, &nodeMask, 8 * sizeof(nodeMask), 0) != 0)
+        {
+            LOG_EX("UserBufferPool::MapBuffers binding to NUMA node %d failed, errno=%d=%s",
+                   m_NumaNode, errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        }
+    }
+
+    // prefault now instead of on the first frames
+    memset(mapping.pMemory, 0, mapping.size);
+
+    if (m_LockMemory)
+    {
+        if (mlock(mapping.pMemory, mapping.size) == 0)
+        {
+            mapping.locked = true;
+        }
+        else
+        {
+            LOG_EX("UserBufferPool::MapBuffers mlock of %zu bytes failed, errno=%d=%s",
+                   mapping.size, errno, v4l2helper::ConvertErrno2String(errno).c_str());
+        }
+    }
+
+    m_Mappings.push_back(mapping);
+    for (uint32_t i = 0; i < bufferCount; ++i)
+    {
+        m_Buffers.push_back(mapping.pMemory + i * m_BufferStride);
+        m_BufferMappings.push_back(m_Mappings.size() - 1);
+    }
+
+    LOG_EX("UserBufferPool::MapBuffers %u buffers of %zu bytes, mapped %zu bytes, huge pages=%d, locked=%d, NUMA node=%d",
+           bufferCount, m_BufferStride, mapping.size, mapping.hugePages, mapping.locked, m_NumaNode);
+
+    return 0;
+}
+
+void UserBufferPool::Discard(uint32_t index)
+{
+    if (index >= m_Buffers.size())
+    {
+        return;
+    }
+
+    Mapping const &mapping = m_Mappings[m_BufferMappings[index]];
+    // huge pages can only be dropped as a whole
+    if (mapping.locked || mapping.hugePages)
+    {
+        return;
+    }
+
+    if (madvise(m_Buffers[index], m_BufferStride, MADV_DONTNEED) != 0)
+    {
+        LOG_EX("UserBufferPool::Discard buffer %u failed, errno=%d=%s", index, errno, v4l2helper::ConvertErrno2String(errno).c_str());
+    }
+}
+
+void UserBufferPool::Free()
+{
+    for (auto const &mapping : m_Mappings)
+    {
+        if (mapping.locked)
+        {
+            munlock(mapping.pMemory, mapping.size);
+        }
+        munmap(mapping.pMemory, mapping.size);
+    }
+
+    m_Mappings.clear();
+    m_Buffers.clear();
+    m_BufferMappings.clear();
+    m_BufferStride = 0;
+}
+
+uint8_t* UserBufferPool::GetBuffer(uint32_t index) const
+{
+    if (index >= m_Buffers.size())
+    {
+        return NULL;
+    }
+
+    return m_Buffers[index];
+}
+
+bool UserBufferPool::IsHugePageBacked() const
+{
+    for (auto const &mapping : m_Mappings)
+    {
+        if (mapping.hugePages)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool UserBufferPool::IsLocked() const
+{
+    for (auto const &mapping : m_Mappings)
+    {
+        if (!mapping.locked)
+        {
+            return false;
+        }
+    }
+
+    return !m_Mappings.empty();
+}
+
+int UserBufferPool::GetDeviceNumaNode(int fileDescriptor)
+{
+    struct stat status;
+    if (fstat(fileDescriptor, &status) != 0 || !S_ISCHR(status.st_mode))
+    {
+        return -1;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/dev/char/%u:%u/device/numa_node", major(status.st_rdev), minor(status.st_rdev));
+
+    int numaNode = -1;
+    FILE *pFile = fopen(path, "r");
+    if (pFile != NULL)
+    {
+        if (fscanf(pFile, "%d", &numaNode) != 1)
+        {
+            numaNode = -1;
+        }
+        fclose(pFile);
+    }
+
+    return numaNode;
+}
@@ -24,6 +24,7 @@
 
 #include "V4L2EventHandler.h"
 #include "Logger.h"
+#include "ThreadConfig.h"
 
 V4L2EventHandler::V4L2EventHandler(const std::vector<int>  & fds) : m_Fds(fds)
 {
@@ -67,6 +68,8 @@ void V4L2EventHandler::UnsubscribeControl(int id)
 
 void V4L2EventHandler::run()
 {
+    threadconfig::ApplyToCurrentThread(THREAD_ROLE_EVENTS);
+
     while (!isInterruptionRequested())
     {
         std::vector<pollfd> pfds;
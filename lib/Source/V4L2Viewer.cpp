@@ -33,6 +33,9 @@
 #include "CustomDialog.h"
 #include "GitRevision.h"
 #include "ImageTransform.h"
+#include "PixelKernels.h"
+#include "PlaneLayout.h"
+#include "StripePool.h"
 #include "Version.h"
 
 #include <QtCore>
@@ -41,6 +44,7 @@
 #include <QFontDatabase>
 #include <QTextStream>
 
+#include <cstdio>
 #include <ctime>
 #include <limits>
 #include <sstream>
@@ -128,6 +132,59 @@ V4L2Viewer::V4L2Viewer(QWidget *parent, Qt::WindowFlags flags)
         return atoi(var) == 1;
     }();
 
+    // V4L2VIEWER_IO_METHOD=mmap|userptr|dmabuf|dmabuf-import selects the preferred buffer I/O
+    if (auto const var = getenv("V4L2VIEWER_IO_METHOD")) {
+        std::string const method(var);
+        if (method == "mmap") {
+            m_BUFFER_TYPE = IO_METHOD_MMAP;
+        } else if (method == "userptr") {
+            m_BUFFER_TYPE = IO_METHOD_USERPTR;
+        } else if (method == "dmabuf") {
+            m_BUFFER_TYPE = IO_METHOD_DMABUF;
+        } else if (method == "dmabuf-import") {
+            m_BUFFER_TYPE = IO_METHOD_DMABUF_IMPORT;
+        }
+    }
+
+    // V4L2VIEWER_MMAP_CACHE=coherent|non-coherent|no-sync selects the cache behaviour of MMAP buffers
+    if (auto const var = getenv("V4L2VIEWER_MMAP_CACHE")) {
+        MMAP_CACHE_MODE mode = MMAP_CACHE_COHERENT;
+        if (FrameObserverMMAP::ParseCacheMode(var, mode) == 0) {
+            m_Camera.SetMmapCacheMode(mode);
+        }
+    }
+
+    // V4L2VIEWER_READ_BANDWIDTH=1 measures how fast the CPU reads the captured frames
+    if (auto const var = getenv("V4L2VIEWER_READ_BANDWIDTH")) {
+        m_Camera.SetReadBandwidthSampling(atoi(var) == 1);
+    }
+
+    // V4L2VIEWER_REQUEUE_BATCH=<buffers>[:<max delay in us>] requeues released buffers in batches
+    if (auto const var = getenv("V4L2VIEWER_REQUEUE_BATCH")) {
+        BufferRequeuePolicy policy;
+        unsigned int batchSize = 0;
+        unsigned int maximumDelay = policy.maximumDelayMicroseconds;
+        if (sscanf(var, "%u:%u", &batchSize, &maximumDelay) >= 1 && batchSize > 1) {
+            policy.batching = true;
+            policy.batchSize = batchSize;
+            policy.maximumDelayMicroseconds = maximumDelay;
+            m_Camera.SetBufferRequeuePolicy(policy);
+        }
+    }
+
+    // V4L2VIEWER_WATCHDOG=1 restarts the stream after stalls and error storms. It is off by
+    // default, a camera in trigger mode legitimately gets no frames between the triggers.
+    if (auto const var = getenv("V4L2VIEWER_WATCHDOG")) {
+        CaptureWatchdogPolicy policy;
+        policy.enabled = (atoi(var) == 1);
+        m_Camera.SetCaptureWatchdogPolicy(policy);
+    }
+
+    // V4L2VIEWER_CONVERSION_THREADS=<threads> converts every frame in stripes on this many threads, 1 on one thread
+    if (auto const var = getenv("V4L2VIEWER_CONVERSION_THREADS")) {
+        ImageTransform::SetConversionThreads(static_cast<uint32_t>(atoi(var)));
+    }
+
     if(forceSoftware) {
         m_RenderSystem = std::make_unique<SoftwareRenderSystem>();
     } else {
@@ -158,6 +215,12 @@ V4L2Viewer::V4L2Viewer(QWidget *parent, Qt::WindowFlags flags)
 
     SetTitleText();
 
+    // The configured buffer count is the floor, bursts may add more buffers
+    BufferPoolPolicy bufferPoolPolicy;
+    bufferPoolPolicy.adaptive = true;
+    bufferPoolPolicy.minimumCount = m_NUMBER_OF_USED_FRAMES;
+    m_Camera.SetBufferPoolPolicy(bufferPoolPolicy);
+
     // Start Camera
     connect(&m_Camera, SIGNAL(OnCameraListChanged_Signal(const int &, unsigned int, unsigned long long, const QString &, const QString &)), this, SLOT(OnCameraListChanged(const int &, unsigned int, unsigned long long, const QString &, const QString &)));
     connect(&m_Camera, SIGNAL(OnSubDeviceListChanged_Signal(const int &, unsigned int, unsigned long long, const QString &, const QString &)), this, SLOT(OnSubDeviceListChanged(const int &, unsigned int, unsigned long long, const QString &, const QString &)));
@@ -1084,7 +1147,6 @@ void V4L2Viewer::StartStreaming(uint32_t pixelFormat, uint32_t payloadSize, uint
     LOG_EX("V4L2Viewer::StartStreaming pixelFormat=%d,payloadSize=%d,width=%d,height=%d,bytesPerLine=%d", pixelFormat, payloadSize, width, height, bytesPerLine);
 
     // start streaming
-    ImageTransform::Init(width, height);
     if (m_Camera.CreateUserBuffer(m_NUMBER_OF_USED_FRAMES, payloadSize) == 0)
     {
         LOG_EX("V4L2Viewer::StartStreaming streaming will be started");
@@ -1188,9 +1250,22 @@ void V4L2Viewer::OnStopButtonClicked()
         }
 
 
-        if (lastDoneCallback) {
-            lastDoneCallback();
-            lastDoneCallback = nullptr;
+        // The processors check the state under these locks, so no
+        // new lease can arrive once the held ones are released
+        {
+            QMutexLocker locker(&lastFrameMutex);
+            lastFrameLease.Release();
+        }
+        {
+            QMutexLocker locker(&renderFrameMutex);
+            m_RenderSystem->ReleaseFrames();
+        }
+
+        // V4L2VIEWER_LATENCY_DUMP=<file> writes the latency histograms of every stream when it is stopped
+        if (auto const latencyDumpFile = getenv("V4L2VIEWER_LATENCY_DUMP")) {
+            if (m_Camera.GetLatencyStatistics().DumpToFile(latencyDumpFile) != 0) {
+                LOG_EX("V4L2Viewer::OnStopButtonClicked writing latency statistics to %s failed", latencyDumpFile);
+            }
         }
 
         m_Camera.StopStreamChannel();
@@ -1207,7 +1282,7 @@ void V4L2Viewer::OnStopButtonClicked()
 
         m_Camera.DeleteUserBuffer();
         QMutexLocker locker(&lastFrameMutex);
-        lastDoneCallback = nullptr;
+        lastFrameLease.Release();
     }
 
 }
@@ -1215,7 +1290,7 @@ void V4L2Viewer::OnStopButtonClicked()
 void V4L2Viewer::OnSaveImageClicked()
 {
     QMutexLocker locker(&lastFrameMutex);
-    if(!lastDoneCallback) {
+    if(!lastFrameLease) {
         return;
     }
 
@@ -1231,9 +1306,7 @@ void V4L2Viewer::OnSaveImageClicked()
         // RenderSystem interface and doesn't require render-to-texture in case of hardware
         // accelerated rendering
         QImage convertedImage;
-        ImageTransform::ConvertFrame(lastFrame.data, lastFrame.length,
-                                     lastFrame.width, lastFrame.height, lastFrame.pixelFormat,
-                                     lastFrame.payloadSize, lastFrame.bytesPerLine, convertedImage);
+        ImageTransform::ConvertFrame(lastFrame, convertedImage);
         locker.unlock();
         std::thread saveThread{[convertedImage,fullPath,this] {
             convertedImage.save(fullPath,"png");
@@ -1248,6 +1321,16 @@ void V4L2Viewer::OnSaveImageClicked()
         m_LastImageSaveFormat = ".raw";
 
         QByteArray data(reinterpret_cast<const char*>(lastFrame.data), lastFrame.length);
+        PlanarFormat format;
+        if (planelayout::GetPlanarFormat(lastFrame.pixelFormat, format) && format.memoryPlaneCount > 1)
+        {
+            // the planes were captured to separate buffers, store them one after the other
+            data.clear();
+            for (uint32_t i = 0; i < lastFrame.planeCount; ++i)
+            {
+                data.append(reinterpret_cast<const char*>(lastFrame.planes[i].data), lastFrame.planes[i].length);
+            }
+        }
         locker.unlock();
         QFile file(fullPath);
         file.open(QIODevice::WriteOnly);
@@ -1394,7 +1477,7 @@ void V4L2Viewer::OnImageClicked(QPointF point) {
     }
 
     QMutexLocker locker(&lastFrameMutex);
-    if(!lastDoneCallback) {
+    if(!lastFrameLease) {
         return;
     }
 
@@ -1407,9 +1490,7 @@ void V4L2Viewer::OnImageClicked(QPointF point) {
     QImage convertedImage;
     // converting entire image is overkill, but this is not performance-relevant,
     // so let's go with simple for now.
-    ImageTransform::ConvertFrame(lastFrame.data, lastFrame.length,
-                                 lastFrame.width, lastFrame.height, lastFrame.pixelFormat,
-                                 lastFrame.payloadSize, lastFrame.bytesPerLine, convertedImage);
+    ImageTransform::ConvertFrame(lastFrame, convertedImage);
     locker.unlock();
     QColor const myPixel = convertedImage.pixel(x, y);
 
@@ -1508,14 +1589,13 @@ int V4L2Viewer::OpenAndSetupCamera(const uint32_t cardNumber, const QString &dev
         CustomDialog::Error( this, tr("Video4Linux"), tr("The camera cannot be opened because it is in use by another application or it has been disconnected!"));
     } else {
       // Data processor for updating UI according to received data
-      m_Camera.GetFrameObserver()->AddRawDataProcessor([this] (auto const& buf, auto doneCallback) {
+      m_Camera.GetFrameObserver()->AddRawDataProcessor([this] (auto const& buf, auto lease) {
         emit UpdateFrameInfo(buf.frameID,buf.width,buf.height);
-
-        doneCallback();
-      });
+      }, PROCESSOR_QUEUE_LATEST_ONLY);
 
       // Separate raw data processor for rendering
-      m_Camera.GetFrameObserver()->AddRawDataProcessor([&] (auto const& buf, auto doneCallback) {
+      m_Camera.GetFrameObserver()->AddRawDataProcessor([&] (auto const& buf, auto lease) {
+        QMutexLocker locker(&renderFrameMutex);
         if (m_StreamingState.load(std::memory_order_acquire) == StreamingState::Streaming && m_ShowFrames) {
             if (ui.m_LogoScrollArea->isVisible()) {
 
@@ -1525,38 +1605,27 @@ int V4L2Viewer::OpenAndSetupCamera(const uint32_t cardNumber, const QString &dev
                 m_pImageView->show();
             }
 
-            m_RenderSystem->PassFrame(buf, [this,doneCallback] {
-                if(!m_bIsImageFitByFirstImage) {
+            if(!m_bIsImageFitByFirstImage) {
+                m_bIsImageFitByFirstImage = true;
+                QMetaObject::invokeMethod(this, [this] {
                     ui.m_ZoomFitButton->setChecked(true);
                     OnZoomFitButtonClicked();
-                    m_bIsImageFitByFirstImage = true;
-                }
-
-                doneCallback();
-          });
-
-
+                }, Qt::QueuedConnection);
+            }
 
-        } else {
-          doneCallback();
+            m_RenderSystem->PassFrame(buf, std::move(lease));
         }
-      });
+      }, PROCESSOR_QUEUE_LATEST_ONLY);
 
       // Extra data processor for retaining the buffer for one frame
       // so we still have it in case we need to save a file or pick a pixel's color
-      m_Camera.GetFrameObserver()->AddRawDataProcessor([&] (auto const& buf, auto doneCallback) {
+      m_Camera.GetFrameObserver()->AddRawDataProcessor([&] (auto const& buf, auto lease) {
+        QMutexLocker locker(&lastFrameMutex);
         if (m_StreamingState.load(std::memory_order_acquire) == StreamingState::Streaming && m_ShowFrames) {
-            QMutexLocker locker(&lastFrameMutex);
-            if(lastDoneCallback) {
-                lastDoneCallback();
-            }
-            lastDoneCallback = doneCallback;
+            lastFrameLease = std::move(lease);
             lastFrame = buf;
         }
-        else {
-            doneCallback();
-        }
-      });
+      }, PROCESSOR_QUEUE_LATEST_ONLY);
     }
 
     return err;
@@ -1578,7 +1647,96 @@ void V4L2Viewer::OnUpdateFramesReceived()
 {
     auto const fpsReceived = m_Camera.GetReceivedFPS();
     auto const fpsRendered = m_RenderSystem->GetRenderedFPS();
-    ui.m_FramesPerSecondLabel->setText(QString::asprintf("%.2f received/ %.2f rendered", fpsReceived, fpsRendered));
+    FrameDropCounters totals;
+    FrameDropCounters lastSecond;
+    m_Camera.GetFrameDropCounters(totals, lastSecond);
+
+    LatencySummary const latency = m_Camera.GetLatencyStatistics().GetSummary(LATENCY_DRIVER_TO_DISPLAY);
+
+    // Sequence gaps and errors are lost in the driver, starvation means we held the buffers too long
+    ui.m_FramesPerSecondLabel->setText(QString::asprintf("%.2f received/ %.2f rendered | dropped %llu (+%llu) errors %llu (+%llu) starved %llu (+%llu) | latency p50 %.1f p99 %.1f max %.1f ms",
+                                                         fpsReceived, fpsRendered,
+                                                         (unsigned long long)totals.sequenceGaps, (unsigned long long)lastSecond.sequenceGaps,
+                                                         (unsigned long long)totals.errorFrames, (unsigned long long)lastSecond.errorFrames,
+                                                         (unsigned long long)totals.starvations, (unsigned long long)lastSecond.starvations,
+                                                         latency.p50Microseconds / 1000.0, latency.p99Microseconds / 1000.0, latency.maxMicroseconds / 1000.0));
+
+    CaptureWatchdogStatistics const watchdog = m_Camera.GetCaptureWatchdogStatistics();
+    if (watchdog.gaveUp)
+    {
+        ui.m_FramesPerSecondLabel->setText(ui.m_FramesPerSecondLabel->text() + QString::asprintf(" | NO FRAMES, %u restarts failed", watchdog.failedRecoveries));
+    }
+    else if (watchdog.stalls + watchdog.errorStorms != 0)
+    {
+        ui.m_FramesPerSecondLabel->setText(ui.m_FramesPerSecondLabel->text() + QString::asprintf(" | restarts %u (%.1f s lost)",
+                                                                                                  watchdog.stalls + watchdog.errorStorms,
+                                                                                                  watchdog.lostMicroseconds / 1e6));
+    }
+
+    BufferPoolStatistics const bufferPool = m_Camera.GetBufferPoolStatistics();
+
+    QString toolTip = QString::asprintf("Driver sequence gaps, error flagged buffers and the times the driver had no buffer queued "
+                                        "since stream start (+ within the last second). Starved for %.1f ms in total.\n"
+                                        "Buffers: %u in use, %u at most, %u allocated.",
+                                        totals.starvedMicroseconds / 1000.0,
+                                        bufferPool.activeCount, bufferPool.peakCount, bufferPool.allocatedCount);
+    BufferReadStatistics const bufferRead = m_Camera.GetBufferReadStatistics();
+    if (bufferRead.samples != 0)
+    {
+        // the requested I/O method may have been replaced by a fallback
+        bool const mmap = m_Camera.UsesMmap();
+        toolTip += QString::asprintf("\nReading the buffers: %.0f MB/s, best %.0f MB/s%s%s.",
+                                     bufferRead.lastMegabytesPerSecond, bufferRead.bestMegabytesPerSecond,
+                                     mmap ? ", MMAP " : "",
+                                     mmap ? FrameObserverMMAP::GetCacheModeName(m_Camera.GetMmapCacheMode()) : "");
+    }
+    CaptureLoopStatistics const captureLoop = m_Camera.GetCaptureLoopStatistics();
+    toolTip += QString::asprintf("\nCapture thread: %.0f wakeups/s, %.2f syscalls per frame, %.1f buffers per requeue.",
+                                 captureLoop.wakeupsPerSecond, captureLoop.syscallsPerFrame,
+                                 captureLoop.requeueBatches != 0 ? double(captureLoop.queueCalls) / captureLoop.requeueBatches : 0.0);
+    std::shared_ptr<StripePool> const pStripePool = ImageTransform::GetStripePool();
+    StripePoolStatistics const stripes = pStripePool->GetStatistics();
+    toolTip += QString::asprintf("\nConversion: %u threads per frame, %llu frames in %llu stripes, %s kernels.",
+                                 pStripePool->GetThreadCount(), (unsigned long long)stripes.frames,
+                                 (unsigned long long)stripes.stripes, pixelkernels::GetIsaName(pixelkernels::GetActiveIsa()));
+    toolTip += "\n\nLatency in ms (p50 / p99 / max):";
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; ++stage)
+    {
+        LatencySummary const summary = m_Camera.GetLatencyStatistics().GetSummary(static_cast<LATENCY_STAGE>(stage));
+        toolTip += QString::asprintf("\n%s: %.2f / %.2f / %.2f", LatencyStatistics::GetStageName(static_cast<LATENCY_STAGE>(stage)),
+                                     summary.p50Microseconds / 1000.0, summary.p99Microseconds / 1000.0, summary.maxMicroseconds / 1000.0);
+    }
+
+    toolTip += QString::asprintf("\n\nStream restarts after %.0f ms without frames or a series of bad buffers: %u stalls, %u error storms, "
+                                 "%u recovered, %u failed, %llu dequeue errors (last errno %d)",
+                                 watchdog.stallTimeoutMicroseconds / 1000.0,
+                                 watchdog.stalls, watchdog.errorStorms, watchdog.recoveries, watchdog.failedRecoveries,
+                                 (unsigned long long)watchdog.dequeueErrors, watchdog.lastErrno);
+    // the newest incidents, the log has all of them
+    const size_t SHOWN_INCIDENTS = 5;
+    std::vector<CaptureIncident> const incidents = m_Camera.GetCaptureIncidents();
+    for (size_t i = incidents.size() > SHOWN_INCIDENTS ? incidents.size() - SHOWN_INCIDENTS : 0; i < incidents.size(); ++i)
+    {
+        CaptureIncident const &incident = incidents[i];
+        uint64_t const lastFrame = incident.lastFrameTimestamp != 0 ? incident.lastFrameTimestamp : incident.detectedTimestamp;
+        toolTip += QString::asprintf("\n%s #%u: detected after %.1f ms, ", CaptureWatchdog::GetIncidentName(incident.type), incident.attempt,
+                                     (incident.detectedTimestamp - lastFrame) / 1000.0);
+        if (incident.restartedTimestamp == 0)
+        {
+            toolTip += "restart failed";
+        }
+        else if (incident.firstFrameTimestamp == 0)
+        {
+            toolTip += QString::asprintf("restarted in %.1f ms, no frame yet", (incident.restartedTimestamp - incident.detectedTimestamp) / 1000.0);
+        }
+        else
+        {
+            toolTip += QString::asprintf("restarted in %.1f ms, first frame after %.1f ms",
+                                         (incident.restartedTimestamp - incident.detectedTimestamp) / 1000.0,
+                                         (incident.firstFrameTimestamp - incident.detectedTimestamp) / 1000.0);
+        }
+    }
+    ui.m_FramesPerSecondLabel->setToolTip(toolTip);
 }
 
 void V4L2Viewer::OnWidth()